@@ -1,86 +1,462 @@
 #include "Crox.h"
 #include "platform/Platform.h"
 #include "framework_crt.h"
+#include "framework_opengl.h"
+#include "capture.h"
+#include "bench.h"
+#include "profiler.h"
+#include "programcache.h"
+#include "compilequeue.h"
+#include "programlibrary.h"
+#include "hotreload.h"
+#include "streambuffer.h"
+#include "drawbatch.h"
+#include "culling.h"
+#include "rendergraph.h"
+#include "materials.h"
+#include "texturestream.h"
+#include "spirv.h"
+#include "vulkanbackend.h"
+#include "scheduler.h"
+#include "framepackets.h"
+#include "overlay.h"
+#include "platform/Threads.h"
 
-#include <glad/gl.h>
+#ifdef _WIN32
 #include <glad/wgl.h>
+#endif // _WIN32
 #include <stb_ds.h>
 #include <stb_image.h>
-#include <stb_include.h>
+#include <math.h>
 
 
-#define NAME_OBJECT(type, obj, name) glObjectLabel(type, obj, -(signed)strlen(name),name);
-
 typedef _In_z_ const char* Path;
 
-GLuint makeShader(GLenum type, const char* path)
+//programs are shared, asking for the same stages and defines again returns the same request.
+ProgramRequest* makeProgramGLSL(
+	_Inout_		ProgramLibrary*	library,
+	_In_		Path		vertex, 
+	_In_opt_	Path		tessEval, 
+	_In_opt_	Path		tessCtrl, 
+	_In_opt_	Path		geometry, 
+	_In_		Path		fragment,
+	_In_opt_z_	const char*	defines)
 {
-	char error[256];
-	char* source = stb_include_file(path, NULL, NULL, error);
-	if (source == NULL)
-	{
-		glDebugMessageInsert(GL_DEBUG_SOURCE_THIRD_PARTY, GL_DEBUG_TYPE_ERROR, 1, GL_DEBUG_SEVERITY_HIGH, -(signed)strlen(error), error); 
+	struct ProgramDesc desc = { .defines = defines, .separable = false };
+	desc.paths[PIPELINE_STAGE_VERTEX] = vertex;
+	desc.paths[PIPELINE_STAGE_TESS_CONTROL] = tessCtrl;
+	desc.paths[PIPELINE_STAGE_TESS_EVALUATION] = tessEval;
+	desc.paths[PIPELINE_STAGE_GEOMETRY] = geometry;
+	desc.paths[PIPELINE_STAGE_FRAGMENT] = fragment;
+	return programlibrary_program(library, &desc);
+}
+
+static void printInfoLog(_In_ GLuint object, _In_ bool isProgram)
+{
+	GLint len = 0;
+	if (isProgram)
+		glGetProgramiv(object, GL_INFO_LOG_LENGTH, &len);
+	else
+		glGetShaderiv(object, GL_INFO_LOG_LENGTH, &len);
+	if (len <= 1)
+		return;
+
+	char* msg = malloc(len * sizeof * msg);
+	if (msg == NULL)
+		return;
+	if (isProgram)
+		glGetProgramInfoLog(object, len, NULL, msg);
+	else
+		glGetShaderInfoLog(object, len, NULL, msg);
+	OutputDebugStringA(msg);
+	free(msg);
+}
+
+//links a program from precompiled SPIR-V, each stage specialized with its own constants. Returns 0 on failure.
+GLuint makeProgramSPIRV(_In_ uint32_t count, _In_reads_(count) const struct SpirvStage* stages)
+{
+	if (!GLAD_GL_VERSION_4_6 && !GLAD_GL_ARB_gl_spirv)
 		return 0;
+
+	GLuint program = glCreateProgram();
+	GLuint shaders[6] = { 0 };
+	uint32_t attached = 0;
+	assert(count <= sizeof shaders / sizeof * shaders);
+	bool success = count <= sizeof shaders / sizeof * shaders;
+
+	for (uint32_t i = 0; success && i < count; i++)
+	{
+		const struct SpirvStage* stage = &stages[i];
+
+		MappedFile module;
+		if (!spirv_map(&module, stage->path))
+		{
+			const char* msg = "Not a SPIR-V module";
+			glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 2, GL_DEBUG_SEVERITY_HIGH, -(signed)strlen(msg), msg);
+			success = false;
+			break;
+		}
+
+		shaders[i] = glCreateShader(stage->type);
+		NAME_OBJECT(GL_SHADER, shaders[i], stage->path);
+		// The driver copies the module, it is unmapped again right away.
+		glShaderBinary(1, &shaders[i], GL_SHADER_BINARY_FORMAT_SPIR_V, module.data, (GLsizei)module.size);
+		mappedfile_close(&module);
+
+		// Nothing to allocate without constants, both arrays may be NULL then.
+		GLuint* ids = NULL;
+		GLuint* values = NULL;
+		if (stage->constantCount > 0)
+		{
+			ids = malloc(2 * stage->constantCount * sizeof * ids);
+			if (ids == NULL)
+			{
+				success = false;
+				break;
+			}
+			values = ids + stage->constantCount;
+		}
+		for (uint32_t c = 0; c < stage->constantCount; c++)
+		{
+			ids[c] = stage->constants[c].id;
+			values[c] = stage->constants[c].value;
+		}
+
+		const char* entryPoint = stage->entryPoint ? stage->entryPoint : "main";
+		if (GLAD_GL_VERSION_4_6)
+			glSpecializeShader(shaders[i], entryPoint, stage->constantCount, ids, values);
+		else
+			glSpecializeShaderARB(shaders[i], entryPoint, stage->constantCount, ids, values);
+		free(ids);
+
+		GLint isCompiled = false;
+		glGetShaderiv(shaders[i], GL_COMPILE_STATUS, &isCompiled);
+		if (!isCompiled)
+		{
+			printInfoLog(shaders[i], false);
+			success = false;
+			break;
+		}
+		glAttachShader(program, shaders[i]);
+		attached++;
 	}
-	size_t length = strlen(source);
 
-	GLuint shader = glCreateShader(type);
-	NAME_OBJECT(GL_SHADER, shader, path);
+	if (success)
+	{
+		glLinkProgram(program);
 
-	glShaderSource(shader, 1, &source, &length);
-	glCompileShader(shader);
+		GLint isLinked = false;
+		glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+		if (!isLinked)
+			printInfoLog(program, true);
+		success = isLinked;
+	}
 
-	GLint isCompiled = false;
-	glGetShaderiv(shader, GL_COMPILE_STATUS, &isCompiled);
+	// Always delete after linkage
+	for (uint32_t i = 0; i < sizeof shaders / sizeof * shaders; i++)
+	{
+		if (i < attached)
+			glDetachShader(program, shaders[i]);
+		if (shaders[i])
+			glDeleteShader(shaders[i]);
+	}
 
-#ifndef glDebugMessageCallback
-	if (!isCompiled)
+	if (!success)
 	{
-		GLuint len = 0;
-		glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &len);
-		assert(len != 0);
-		const char* msg = malloc(len * sizeof * msg);
-		glGetShaderInfoLog(shader, len, NULL, msg);
-		OutputDebugStringA(msg);
-		free(msg);
+		glDeleteProgram(program);
+		program = 0;
+	}
+	return program;
+}
+
+// Rows of triangles sliding sideways, most of them off screen at any time.
+#define SCENE_ROWS		4
+#define SCENE_COLUMNS	16
+#define SCENE_INSTANCES	(SCENE_ROWS * SCENE_COLUMNS)
+#define SCENE_RADIUS	0.15f
+
+// A perspective camera looking down -Z at the plane of the scene, the rows just fit vertically.
+#define CAMERA_FOV_Y	1.0471976f	// 60 degrees
+#define CAMERA_DISTANCE	1.75f
+#define CAMERA_NEAR		0.1f
+#define CAMERA_FAR		10.0f
+
+// Uniform location in default.vert.
+#define SCENE_VIEW_PROJ	0
+
+// Checkerboards of increasing frequency, the instances cycle through them.
+#define SCENE_MATERIALS	4
+#define SCENE_TEXTURE_SIZE	64
+
+// Decoded pixels in flight and uploaded per frame.
+#define TEXTURE_STAGING_SIZE	(16 << 20)
+#define TEXTURE_UPLOAD_BUDGET	(1 << 20)
+
+// Matches default.vert, streamed every frame.
+struct SceneVertex
+{
+	float pos[2];
+	float rgb[3];
+	float uv[2];
+};
+
+static GLuint makeSceneLayout(_In_ GLuint stream)
+//
+// Vertices, indices and instances all come from the stream buffer, draws locate them with base vertex, first index and base instance.
+//
+{
+	GLuint vao = 0;
+	glCreateVertexArrays(1, &vao);
+	NAME_OBJECT(GL_VERTEX_ARRAY, vao, "Scene Layout");
+	glVertexArrayVertexBuffer(vao, 0, stream, 0, sizeof(struct SceneVertex));
+	glVertexArrayElementBuffer(vao, stream);
+	glEnableVertexArrayAttrib(vao, 0);
+	glVertexArrayAttribFormat(vao, 0, 2, GL_FLOAT, GL_FALSE, offsetof(struct SceneVertex, pos));
+	glVertexArrayAttribBinding(vao, 0, 0);
+	glEnableVertexArrayAttrib(vao, 1);
+	glVertexArrayAttribFormat(vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(struct SceneVertex, rgb));
+	glVertexArrayAttribBinding(vao, 1, 0);
+	glEnableVertexArrayAttrib(vao, 3);
+	glVertexArrayAttribFormat(vao, 3, 2, GL_FLOAT, GL_FALSE, offsetof(struct SceneVertex, uv));
+	glVertexArrayAttribBinding(vao, 3, 0);
 
-		glDeleteShader(shader);
-		shader = 0;
+	// The instance's bounding sphere center doubles as its offset.
+	glVertexArrayVertexBuffer(vao, 1, stream, 0, sizeof(struct CullInstance));
+	glVertexArrayBindingDivisor(vao, 1, 1);
+	glEnableVertexArrayAttrib(vao, 2);
+	glVertexArrayAttribFormat(vao, 2, 2, GL_FLOAT, GL_FALSE, offsetof(struct CullInstance, sphere));
+	glVertexArrayAttribBinding(vao, 2, 1);
+	glEnableVertexArrayAttrib(vao, 4);
+	glVertexArrayAttribIFormat(vao, 4, 1, GL_UNSIGNED_INT, offsetof(struct CullInstance, material));
+	glVertexArrayAttribBinding(vao, 4, 1);
+	return vao;
+}
+
+static GLuint makeCheckerTexture(_In_ uint32_t cells)
+{
+	static uint8_t texels[SCENE_TEXTURE_SIZE * SCENE_TEXTURE_SIZE * 4];
+	const uint32_t cellSize = SCENE_TEXTURE_SIZE / cells;
+	for (uint32_t y = 0; y < SCENE_TEXTURE_SIZE; y++)
+	{
+		for (uint32_t x = 0; x < SCENE_TEXTURE_SIZE; x++)
+		{
+			const uint8_t value = (x / cellSize + y / cellSize) % 2 ? 255 : 96;
+			uint8_t* texel = texels + (y * SCENE_TEXTURE_SIZE + x) * 4;
+			texel[0] = texel[1] = texel[2] = value;
+			texel[3] = 255;
+		}
 	}
-#endif // glDebugMessageCallback
-	
-	if (!isCompiled)
+
+	GLuint texture = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+	NAME_OBJECT(GL_TEXTURE, texture, "Checker");
+	glTextureStorage2D(texture, 7, GL_RGBA8, SCENE_TEXTURE_SIZE, SCENE_TEXTURE_SIZE); // down to 1x1
+	glTextureSubImage2D(texture, 0, 0, 0, SCENE_TEXTURE_SIZE, SCENE_TEXTURE_SIZE, GL_RGBA, GL_UNSIGNED_BYTE, texels);
+	glGenerateTextureMipmap(texture);
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return texture;
+}
+
+// Everything the update thread decides about a frame. The render thread draws it a frame later and neither changes it while the other has it.
+struct FramePacket
+{
+	uint32_t frame;
+	uint32_t width;		// of the window when the update ran, 0 while minimized
+	uint32_t height;
+	float viewProj[16];	// column major
+	struct PlatformInput input;	// since the previous packet, replayed into Nuklear on the render thread
+	struct SceneVertex vertices[3];
+	struct CullInstance instances[SCENE_INSTANCES];	// materials wrap around the ones loaded when drawn
+};
+
+static void updateCamera(_Out_writes_(16) float* viewProj, _In_ uint32_t width, _In_ uint32_t height)
+//
+// The projection times a translation by -CAMERA_DISTANCE along Z.
+//
+{
+	const float f = 1.0f / tanf(CAMERA_FOV_Y * 0.5f);
+	const float aspect = height ? (float)width / (float)height : 1.0f;
+	const float depth = (CAMERA_FAR + CAMERA_NEAR) / (CAMERA_NEAR - CAMERA_FAR);
+	const float offset = 2.0f * CAMERA_FAR * CAMERA_NEAR / (CAMERA_NEAR - CAMERA_FAR);
+
+	memset(viewProj, 0, 16 * sizeof * viewProj);
+	viewProj[0] = f / aspect;
+	viewProj[5] = f;
+	viewProj[10] = depth;
+	viewProj[11] = -1.0f;
+	viewProj[14] = offset - CAMERA_DISTANCE * depth;
+	viewProj[15] = CAMERA_DISTANCE;
+}
+
+static void updateScene(_Inout_ struct FramePacket* packet, _In_ uint32_t frame)
+//
+// Animated by frame rather than time, so captures stay reproducible. The packet's size has to be set already.
+//
+{
+	packet->frame = frame;
+	updateCamera(packet->viewProj, packet->width, packet->height);
+
+	const float angle = (float)frame * 0.01f;
+	for (uint32_t i = 0; i < 3; i++)
 	{
-		glDeleteShader(shader);
-		shader = 0;
+		const float corner = angle + (float)i * 2.0943951f; // 120 degrees apart
+		packet->vertices[i] = (struct SceneVertex){
+			.pos = { SCENE_RADIUS * sinf(corner), SCENE_RADIUS * cosf(corner) },
+			.rgb = { i == 0, i == 1, i == 2 },
+			.uv = { 0.5f + 0.5f * sinf((float)i * 2.0943951f), 0.5f + 0.5f * cosf((float)i * 2.0943951f) },
+		};
 	}
 
-	free(source);
-	return shader;
+	// Each row spans four screen widths and wraps around.
+	struct CullInstance* instance = packet->instances;
+	for (uint32_t row = 0; row < SCENE_ROWS; row++)
+	{
+		for (uint32_t column = 0; column < SCENE_COLUMNS; column++)
+		{
+			float x = fmodf((float)column * 0.5f + (float)frame * 0.004f * (float)(row + 1), 8.0f) - 4.0f;
+			float y = -0.75f + (float)row * 0.5f;
+			*instance++ = (struct CullInstance){
+				.sphere = { x, y, 0.0f, SCENE_RADIUS },
+				.mesh = 0,
+				.material = row + column,
+			};
+		}
+	}
 }
 
-GLuint makeProgramGLSL(
-	_In_		Path		vertex, 
-	_In_opt_	Path		tessEval, 
-	_In_opt_	Path		tessCtrl, 
-	_In_opt_	Path		geometry, 
-	_In_		Path		fragment)
+// What the scene passes share within a frame.
+struct Scene
+{
+	DrawBatch* batch;
+	Culler* culler;
+	StreamBuffer* stream;
+	Bench* bench;
+	MaterialLibrary* materials;
+	uint32_t materialCount;
+	GLuint vao;
+	GLuint program;
+	GLuint compositeSource;	// read framebuffer the scene color is blitted from
+	const struct FramePacket* packet;
+	uint32_t width;
+	uint32_t height;
+	RenderResource color;
+	RenderResource depth;
+	RenderResource backbuffer;
+	bool isCulled;			// the cull pass dispatched, otherwise the batch holds every instance
+};
+
+static void cullScene(_Inout_ RenderGraph* graph, _In_opt_ void* user)
 {
+	static const GLushort TRIANGLE[] = { 0, 1, 2 };
+	(void)graph;
+
+	struct Scene* scene = user;
+	const struct FramePacket* packet = scene->packet;
+	scene->isCulled = false;
+
+	struct StreamAllocation vertices, indices, instances, meshes;
+	if (!streambuffer_allocate(scene->stream, sizeof packet->vertices, sizeof(struct SceneVertex), &vertices) ||
+		!streambuffer_allocate(scene->stream, sizeof TRIANGLE, sizeof * TRIANGLE, &indices) ||
+		!streambuffer_allocateStorage(scene->stream, sizeof packet->instances, sizeof(struct CullInstance), &instances) ||
+		!streambuffer_allocateStorage(scene->stream, sizeof(struct CullMesh), sizeof(struct CullMesh), &meshes))
+		return;
+	memcpy(indices.data, TRIANGLE, sizeof TRIANGLE);
+	memcpy(vertices.data, packet->vertices, sizeof packet->vertices);
 
+	struct CullMesh* mesh = meshes.data;
+	*mesh = (struct CullMesh){
+		.count = 3,
+		.firstIndex = (GLuint)(indices.offset / sizeof * TRIANGLE),
+		.baseVertex = (GLint)(vertices.offset / sizeof(struct SceneVertex)),
+	};
+
+	struct CullInstance* instance = instances.data;
+	for (uint32_t i = 0; i < SCENE_INSTANCES; i++)
+	{
+		instance[i] = packet->instances[i];
+		instance[i].material %= scene->materialCount;
+	}
+
+	scene->isCulled = culling_dispatch(scene->culler, packet->viewProj, &instances, SCENE_INSTANCES, &meshes);
+	if (scene->isCulled)
+		return;
+
+	// Until the culling programs are ready, everything is drawn.
+	const struct DrawKey key = { .program = scene->program, .vao = scene->vao, .mode = GL_TRIANGLES, .indexType = GL_UNSIGNED_SHORT };
+	const GLuint firstInstance = (GLuint)(instances.offset / sizeof(struct CullInstance));
+	for (uint32_t i = 0; i < SCENE_INSTANCES; i++)
+	{
+		drawbatch_add(scene->batch, &key, &(DrawElementsIndirectCommand){
+			.count = mesh->count,
+			.instanceCount = 1,
+			.firstIndex = mesh->firstIndex,
+			.baseVertex = mesh->baseVertex,
+			.baseInstance = firstInstance + i,
+		});
+	}
 }
 
-GLuint makeProgramSPIRV()
+static void drawScene(_Inout_ RenderGraph* graph, _In_opt_ void* user)
+//
+// The graph has bound the scene targets already.
+//
 {
+	(void)graph;
+	struct Scene* scene = user;
+	glEnable(GL_DEPTH_TEST);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+	// Instances carry their material ID, the batch never has to switch textures.
+	materials_bind(scene->materials);
+	glProgramUniformMatrix4fv(scene->program, SCENE_VIEW_PROJ, 1, GL_FALSE, scene->packet->viewProj);
 
+	if (!scene->isCulled)
+		drawbatch_submit(scene->batch, scene->stream, NULL, NULL);
+	else
+	{
+		glUseProgram(scene->program);
+		glBindVertexArray(scene->vao);
+		culling_draw(scene->culler, GL_TRIANGLES, GL_UNSIGNED_SHORT);
+		glBindVertexArray(0);
+	}
+	glDisable(GL_DEPTH_TEST);
+}
 
-	GLuint program = glCreateProgram();
+static void buildPyramid(_Inout_ RenderGraph* graph, _In_opt_ void* user)
+//
+// Next frame's cull pass tests occlusion against this frame's depth.
+//
+{
+	struct Scene* scene = user;
+	culling_buildPyramid(scene->culler, rendergraph_texture(graph, scene->depth), scene->width, scene->height, scene->packet->viewProj);
+}
 
-	//glShaderBinary();
-	//glSpecializeShader();
+static void compositeScene(_Inout_ RenderGraph* graph, _In_opt_ void* user)
+{
+	struct Scene* scene = user;
+	glNamedFramebufferTexture(scene->compositeSource, GL_COLOR_ATTACHMENT0, rendergraph_texture(graph, scene->color), 0);
+	glBlitNamedFramebuffer(scene->compositeSource, rendergraph_framebuffer(graph, scene->backbuffer),
+		0, 0, (GLint)scene->width, (GLint)scene->height, 0, 0, (GLint)scene->width, (GLint)scene->height, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+}
 
+static void drawBenchScene(_Inout_ RenderGraph* graph, _In_opt_ void* user)
+{
+	// The bench scenes are laid out in clip space.
+	static const float IDENTITY[16] = { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	(void)graph;
 
+	struct Scene* scene = user;
+	glClear(GL_COLOR_BUFFER_BIT);
+	materials_bind(scene->materials);
+	glProgramUniformMatrix4fv(scene->program, SCENE_VIEW_PROJ, 1, GL_FALSE, IDENTITY);
+	glUseProgram(scene->program);
+	bench_drawScene(scene->bench);
+}
 
-	return program;
+static void captureFrame(_Inout_ RenderGraph* graph, _In_opt_ void* user)
+{
+	(void)graph;
+	capture_endFrame(user);
 }
 
 
@@ -100,17 +476,423 @@ void GLAD_API_PTR GLDebugProc(
 }
 
 
+#define BENCH_DEFAULT_FRAMES	300
+#define BENCH_WARMUP_FRAMES		30
+#define PROFILER_HISTORY		120
+#define PROGRAM_CACHE_DIRECTORY	"shader_cache"
+#define STREAM_FRAME_SIZE		(1 << 20)
+
+struct Options
+{
+	char* capturePattern;	// --capture <pattern>, render offscreen and write every frame to disk
+	char* benchReport;		// --bench <report.json>, measure every benchmark scene
+	char* tracePath;		// --trace <trace.json>, profile and dump a Chrome trace on exit or on demand
+	bool profileOverlay;	// --profile, show the profiler tree
+	bool hotReload;			// --hot-reload, rebuild programs when their shader files change
+	char* texturePath;		// --texture <image>, streamed in and added to the scene's materials
+	uint32_t frameCount;	// --frames <N>, 0 runs until the platform asks to quit. Per scene when benchmarking.
+	bool vulkan;			// --vulkan, render with the Vulkan backend, only capturing and --frames carry over
+	uint32_t drawCount;		// --draws <N>, draws per frame in the Vulkan backend, 0 for the default scene
+	uint32_t threads;		// --threads <N>, threads running tasks, the main one included. 0 for one per core.
+};
+
+static char* narrow(_In_z_ const wchar_t* wide)
+{
+	size_t len = wcstombs(NULL, wide, 0);
+	if (len == (size_t)-1)
+		return NULL;
+
+	char* str = malloc(len + 1);
+	if (str)
+		wcstombs(str, wide, len + 1);
+	return str;
+}
+
+static void freeOptions(_Inout_ struct Options* options)
+{
+	free(options->capturePattern);
+	free(options->benchReport);
+	free(options->tracePath);
+	free(options->texturePath);
+}
+
+static bool parseOptions(_In_ uint32_t argC, _In_ wchar_t** argV, _Out_ struct Options* options)
+{
+	*options = (struct Options){
+		.capturePattern = NULL,
+		.benchReport = NULL,
+		.tracePath = NULL,
+		.profileOverlay = false,
+		.hotReload = false,
+		.texturePath = NULL,
+		.frameCount = 0,
+		.vulkan = false,
+		.drawCount = 0,
+		.threads = 0,
+	};
+
+	for (uint32_t i = 0; i < argC; i++)
+	{
+		const bool hasValue = i + 1 < argC;
+
+		if (wcscmp(argV[i], L"--capture") == 0 && hasValue)
+		{
+			free(options->capturePattern);
+			options->capturePattern = narrow(argV[++i]);
+			if (options->capturePattern == NULL)
+				return false;
+		}
+		else if (wcscmp(argV[i], L"--bench") == 0 && hasValue)
+		{
+			free(options->benchReport);
+			options->benchReport = narrow(argV[++i]);
+			if (options->benchReport == NULL)
+				return false;
+		}
+		else if (wcscmp(argV[i], L"--trace") == 0 && hasValue)
+		{
+			free(options->tracePath);
+			options->tracePath = narrow(argV[++i]);
+			if (options->tracePath == NULL)
+				return false;
+		}
+		else if (wcscmp(argV[i], L"--texture") == 0 && hasValue)
+		{
+			free(options->texturePath);
+			options->texturePath = narrow(argV[++i]);
+			if (options->texturePath == NULL)
+				return false;
+		}
+		else if (wcscmp(argV[i], L"--profile") == 0)
+			options->profileOverlay = true;
+		else if (wcscmp(argV[i], L"--hot-reload") == 0)
+			options->hotReload = true;
+		else if (wcscmp(argV[i], L"--vulkan") == 0)
+			options->vulkan = true;
+		else if (wcscmp(argV[i], L"--frames") == 0 && hasValue)
+		{
+			wchar_t* end = NULL;
+			options->frameCount = (uint32_t)wcstoul(argV[++i], &end, 10);
+			if (*end != L'\0')
+				return false;
+		}
+		else if (wcscmp(argV[i], L"--draws") == 0 && hasValue)
+		{
+			wchar_t* end = NULL;
+			options->drawCount = (uint32_t)wcstoul(argV[++i], &end, 10);
+			if (*end != L'\0')
+				return false;
+		}
+		else if (wcscmp(argV[i], L"--threads") == 0 && hasValue)
+		{
+			wchar_t* end = NULL;
+			options->threads = (uint32_t)wcstoul(argV[++i], &end, 10);
+			if (*end != L'\0')
+				return false;
+		}
+	}
+
+#ifdef CROX_BENCH
+	// crox_bench is the same program, only benchmarking by default.
+	if (options->benchReport == NULL)
+	{
+		options->benchReport = malloc(sizeof "crox_bench.json");
+		if (options->benchReport == NULL)
+			return false;
+		strcpy(options->benchReport, "crox_bench.json");
+	}
+#endif // CROX_BENCH
+
+	if (options->benchReport && options->frameCount == 0)
+		options->frameCount = BENCH_DEFAULT_FRAMES;
+
+	// A capture always terminates, default to a single still.
+	if (options->capturePattern && options->frameCount == 0)
+		options->frameCount = 1;
+
+	return true;
+}
+
+// What the render thread draws with. main sets it up before the thread starts and tears it down after it joined.
+struct Renderer
+{
+	NkContext* ctx;
+	FramePackets* packets;
+	CompileQueue* compileQueue;
+	HotReload* hotReload;
+	ProgramRequest* defaultProgram;
+	ProgramRequest* fallbackProgram;
+	Scheduler* scheduler;	// its GL tasks are run here
+	TextureStream* textureStream;
+	TextureRequest* streamedTexture;
+	uint32_t streamedMaterial;
+	MaterialLibrary* materials;
+	StreamBuffer* streamBuffer;
+	DrawBatch* drawBatch;
+	Culler* culler;
+	RenderGraph* renderGraph;
+	Capture* capture;
+	Bench* bench;
+	Profiler* profiler;
+	const char* tracePath;
+	Overlay* overlay;		// only with the profiler overlay, the one UI there is
+	GLuint sceneLayout;
+	GLuint compositeSource;
+	GLuint backbuffer;
+	uint32_t width;
+	uint32_t height;
+	int result;
+};
+
+static void replayInput(_Inout_ NkContext* ctx, _In_ const struct PlatformInput* input)
+//
+// A button that went both ways within one packet was clicked, or released and pressed again when it is still down.
+//
+{
+	const int x = input->mouseX, y = input->mouseY;
+
+	nk_input_begin(ctx);
+	nk_input_motion(ctx, x, y);
+	for (enum nk_buttons button = NK_BUTTON_LEFT; button <= NK_BUTTON_RIGHT; button++)
+	{
+		const uint32_t bit = 1u << button;
+		const bool isDown = input->down & bit;
+		if (input->pressed & input->released & bit)
+			nk_input_button(ctx, button, x, y, !isDown);
+		if ((input->pressed | input->released) & bit)
+			nk_input_button(ctx, button, x, y, isDown);
+	}
+	if (input->scroll != 0.0f)
+		nk_input_scroll(ctx, nk_vec2(0.0f, input->scroll));
+	nk_input_end(ctx);
+}
+
+static void drawOverlay(_Inout_ RenderGraph* graph, _In_opt_ void* user)
+{
+	(void)graph;
+	struct Renderer* renderer = user;
+	if (!overlay_draw(renderer->overlay, renderer->ctx, renderer->streamBuffer, renderer->width, renderer->height))
+		glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 0, GL_DEBUG_SEVERITY_MEDIUM, -1, "The overlay didn't fit into the stream buffer");
+}
+
+static bool renderFrame(_Inout_ struct Renderer* renderer, _In_ const struct FramePacket* packet)
+//
+// Returns false to stop rendering, setting the result if it failed.
+//
+{
+	Profiler* profiler = renderer->profiler;
+
+	// Only robust contexts report a reset, and only to the thread the context is current on.
+	if (glGetGraphicsResetStatus() != GL_NO_ERROR)
+	{
+		OutputDebugString(TEXT("The GL context was lost\n"));
+		renderer->result = -1;
+		return false;
+	}
+
+	// Even while minimized, so nothing waiting on them stalls.
+	scheduler_runPinned(renderer->scheduler, TASK_GL_THREAD);
+
+	// Nothing to draw to while minimized.
+	if (packet->width == 0 || packet->height == 0)
+		return true;
+	// Captures keep the size their targets were made with.
+	if (!renderer->capture && (packet->width != renderer->width || packet->height != renderer->height))
+	{
+		renderer->width = packet->width;
+		renderer->height = packet->height;
+		glViewport(0, 0, renderer->width, renderer->height);
+	}
+
+	if (renderer->bench && !bench_beginFrame(renderer->bench))
+		return false;
+
+	compilequeue_poll(renderer->compileQueue);
+	hotreload_update(renderer->hotReload);
+	// While reloading a broken shader can still be fixed, the fallback draws until then.
+	ProgramRequest* defaultProgram = renderer->defaultProgram;
+	if (defaultProgram == NULL || (compilequeue_state(defaultProgram) == PROGRAM_FAILED && renderer->hotReload == NULL))
+	{
+		renderer->result = -1;
+		return false;
+	}
+	GLuint program = compilequeue_program(defaultProgram, compilequeue_program(renderer->fallbackProgram, 0));
+
+	profiler_beginFrame(profiler);
+	profiler_push(profiler, "Frame");
+	streambuffer_beginFrame(renderer->streamBuffer);
+
+	profiler_push(profiler, "Texture Uploads");
+	texturestream_update(renderer->textureStream);
+	if (renderer->streamedTexture && renderer->streamedMaterial == MATERIAL_NONE && texturestream_state(renderer->streamedTexture) == TEXTURE_READY)
+	{
+		renderer->streamedMaterial = materials_add(renderer->materials, &(struct MaterialDesc){
+			.albedo = texturestream_texture(renderer->streamedTexture, 0),
+			.tint = { 1.0f, 1.0f, 1.0f, 1.0f },
+		});
+	}
+	profiler_pop(profiler);
+
+	// The overlay reads the GPU timings, so the UI is built here rather than on the update thread. Drawn by the Overlay pass.
+	replayInput(renderer->ctx, &packet->input);
+	if (renderer->overlay)
+		profiler_drawOverlay(profiler, renderer->ctx, renderer->tracePath);
+
+	struct Scene scene = {
+		.batch = renderer->drawBatch,
+		.culler = renderer->culler,
+		.stream = renderer->streamBuffer,
+		.bench = renderer->bench,
+		.materials = renderer->materials,
+		.materialCount = renderer->streamedMaterial != MATERIAL_NONE ? SCENE_MATERIALS + 1 : SCENE_MATERIALS,
+		.vao = renderer->sceneLayout,
+		.program = program,
+		.compositeSource = renderer->compositeSource,
+		.packet = packet,
+		.width = renderer->width,
+		.height = renderer->height,
+	};
+	RenderGraph* renderGraph = renderer->renderGraph;
+	rendergraph_begin(renderGraph);
+	RenderResource backbufferResource = rendergraph_importFramebuffer(renderGraph, "Backbuffer", renderer->backbuffer, renderer->width, renderer->height);
+	if (renderer->bench)
+	{
+		uint32_t pass = rendergraph_addPass(renderGraph, "Bench Scene", drawBenchScene, &scene);
+		rendergraph_write(renderGraph, pass, backbufferResource, RENDER_ACCESS_ATTACHMENT);
+	}
+	else if (renderer->streamBuffer && renderer->drawBatch)
+	{
+		// Drawn off screen at the window's size, the pool replaces the targets when it changes.
+		scene.color = rendergraph_createTexture(renderGraph, "Scene Color", &(struct RenderTextureDesc){
+			.width = renderer->width, .height = renderer->height, .format = GL_RGBA8 });
+		scene.depth = rendergraph_createTexture(renderGraph, "Scene Depth", &(struct RenderTextureDesc){
+			.width = renderer->width, .height = renderer->height, .format = GL_DEPTH_COMPONENT32F });
+		scene.backbuffer = backbufferResource;
+
+		RenderResource commands = rendergraph_importBuffer(renderGraph, "Culled Commands", culling_commands(renderer->culler));
+		uint32_t cull = rendergraph_addPass(renderGraph, "Cull", cullScene, &scene);
+		rendergraph_write(renderGraph, cull, commands, RENDER_ACCESS_STORAGE);
+		uint32_t draw = rendergraph_addPass(renderGraph, "Scene", drawScene, &scene);
+		rendergraph_read(renderGraph, draw, commands, RENDER_ACCESS_INDIRECT);
+		rendergraph_attach(renderGraph, draw, scene.color, GL_COLOR_ATTACHMENT0);
+		rendergraph_attach(renderGraph, draw, scene.depth, GL_DEPTH_ATTACHMENT);
+		uint32_t pyramid = rendergraph_addPass(renderGraph, "Hi-Z Pyramid", buildPyramid, &scene);
+		rendergraph_read(renderGraph, pyramid, scene.depth, RENDER_ACCESS_SAMPLED);
+		rendergraph_keep(renderGraph, pyramid);
+		uint32_t composite = rendergraph_addPass(renderGraph, "Composite", compositeScene, &scene);
+		rendergraph_read(renderGraph, composite, scene.color, RENDER_ACCESS_TRANSFER);
+		rendergraph_write(renderGraph, composite, backbufferResource, RENDER_ACCESS_TRANSFER);
+	}
+	if (renderer->overlay && renderer->streamBuffer)
+	{
+		// Writes to the backbuffer keep their order, the UI ends up on top of the scene and in the capture.
+		uint32_t pass = rendergraph_addPass(renderGraph, "Overlay", drawOverlay, renderer);
+		rendergraph_write(renderGraph, pass, backbufferResource, RENDER_ACCESS_ATTACHMENT);
+	}
+	if (renderer->capture)
+	{
+		uint32_t pass = rendergraph_addPass(renderGraph, "Capture", captureFrame, renderer->capture);
+		rendergraph_read(renderGraph, pass, backbufferResource, RENDER_ACCESS_TRANSFER);
+		rendergraph_keep(renderGraph, pass);
+	}
+	rendergraph_execute(renderGraph, profiler);
+	streambuffer_endFrame(renderer->streamBuffer);
+
+	if (!renderer->capture)
+	{
+		profiler_push(profiler, "Swap");
+		bool swapSuccess = platform_swapBuffers(renderer->ctx);
+		assert(swapSuccess);
+		profiler_pop(profiler);
+	}
+
+	profiler_pop(profiler);
+	profiler_endFrame(profiler);
+
+	if (renderer->bench)
+		bench_endFrame(renderer->bench);
+
+	nk_clear(renderer->ctx);
+	return true;
+}
+
+static int renderMain(void* arg)
+//
+// Holds the window's context until it returns. Draws each packet while the update thread writes the next one.
+//
+{
+	struct Renderer* renderer = arg;
+	if (!platform_makeWindowCurrent(renderer->ctx, true))
+	{
+		renderer->result = -1;
+		framepackets_close(renderer->packets);
+		return 0;
+	}
+
+	for (const struct FramePacket* packet; (packet = framepackets_beginRead(renderer->packets)) != NULL;)
+	{
+		const bool isRendering = renderFrame(renderer, packet);
+		framepackets_endRead(renderer->packets);
+		if (!isRendering)
+		{
+			framepackets_close(renderer->packets);
+			break;
+		}
+	}
+
+	platform_makeWindowCurrent(renderer->ctx, false);
+	return 0;
+}
+
+
 int main(
 	_In_ NkContext* ctx, _In_ uint32_t argC, _In_ wchar_t** argV, _In_ wchar_t** penv)
 {
 	bool running = true;
+
+	struct Options options;
+	if (!parseOptions(argC, argV, &options))
+	{
+		OutputDebugString(TEXT("Usage: [--capture <file%04u.png>] [--bench <report.json>] [--frames <N>] [--profile] [--trace <trace.json>] [--hot-reload] [--texture <image>] [--threads <N>] [--vulkan [--draws <N>]]\n"));
+		freeOptions(&options);
+		return -1;
+	}
 #ifdef _DEBUG
 	glDebugMessageCallback(GLDebugProc, ctx);
 	glEnable(GL_DEBUG_OUTPUT);
-#else
-	glEnable(GL_NO_ERROR);
 #endif // _DEBUG
 
+	// Every subsystem's tasks share it, the main thread helps whenever it waits.
+	Scheduler* scheduler = scheduler_create(options.threads);
+	assert(scheduler != NULL);
+	if (scheduler == NULL)
+	{
+		freeOptions(&options);
+		return -1;
+	}
+
+	if (options.vulkan)
+	{
+#ifdef CROX_NO_VULKAN
+		OutputDebugString(TEXT("Built without the Vulkan backend, --vulkan is unavailable\n"));
+		int result = -1;
+#else
+		if (options.benchReport || options.profileOverlay || options.tracePath || options.hotReload || options.texturePath)
+			OutputDebugString(TEXT("The Vulkan backend only renders the scene, --bench, --profile, --trace, --hot-reload and --texture are ignored\n"));
+
+		int result = vulkanbackend_run(ctx, &(struct VulkanOptions){
+			.capturePattern = options.capturePattern,
+			.cacheDirectory = PROGRAM_CACHE_DIRECTORY,
+			.frameCount = options.frameCount,
+			.drawCount = options.drawCount,
+			.scheduler = scheduler,
+		});
+#endif // CROX_NO_VULKAN
+		scheduler_destroy(scheduler);
+		freeOptions(&options);
+		return result;
+	}
+
 	uint32_t width = 0;
 	uint32_t height = 0;
 	platform_getDimensions(ctx, &width, &height);
@@ -118,67 +900,229 @@ int main(
 	
 	glViewport(0, 0, width, height);
 
-	GLuint program = glCreateProgram();
-	NAME_OBJECT(GL_PROGRAM, program, "Default Progam");
+	ProgramCache* programCache = programcache_create(PROGRAM_CACHE_DIRECTORY);
+	IncludeCache* includeCache = includecache_create();
+	CompileQueue* compileQueue = includeCache ? compilequeue_create(programCache, includeCache, 0) : NULL;
+	assert(compileQueue != NULL);
+	if (compileQueue == NULL)
+	{
+		includecache_destroy(includeCache);
+		programcache_destroy(programCache);
+		scheduler_destroy(scheduler);
+		freeOptions(&options);
+		return -1;
+	}
 
+	// Tiny enough to be ready within a frame or two, drawn with until the real programs have linked.
+	static const char FALLBACK_VERT[] =
+		"#version 450 core\n"
+		"layout(location = 0) in vec2 aPos;\n"
+		"layout(location = 2) in vec2 aOffset;\n"
+		"layout(location = 0) uniform mat4 viewProj;\n"
+		"void main() { gl_Position = viewProj * vec4(aPos + aOffset, 0, 1.0f); }\n";
+	static const char FALLBACK_FRAG[] =
+		"#version 450 core\n"
+		"layout(location = 0) out vec4 fragColor;\n"
+		"void main() { fragColor = vec4(1.0f, 0, 1.0f, 1.0f); }\n";
 
-	GLuint
-		vShader = makeShader(GL_VERTEX_SHADER,  "default.vert"),
-		fShader = makeShader(GL_FRAGMENT_SHADER,"default.frag");
-	assert(vShader != 0);
-	assert(fShader != 0);
+	ProgramRequest* fallbackProgram = compilequeue_submit(compileQueue, "Fallback Program", 2, (struct ShaderStage[]) {
+		{ GL_VERTEX_SHADER,		.source = FALLBACK_VERT },
+		{ GL_FRAGMENT_SHADER,	.source = FALLBACK_FRAG },
+	}, false);
+	assert(fallbackProgram != NULL);
 
-	glAttachShader(program, vShader);
-	glAttachShader(program, fShader);
-	
-	glLinkProgram(program);
+	// One spare material for the streamed texture.
+	MaterialLibrary* materials = materials_create(SCENE_MATERIALS + 1, SCENE_TEXTURE_SIZE, SCENE_TEXTURE_SIZE);
+	assert(materials != NULL);
+	GLuint materialTextures[SCENE_MATERIALS] = { 0 };
+	for (uint32_t i = 0; materials && i < SCENE_MATERIALS; i++)
+	{
+		materialTextures[i] = makeCheckerTexture(2u << i);
+		materials_add(materials, &(struct MaterialDesc){
+			.albedo = materialTextures[i],
+			.tint = { 1.0f, 1.0f - 0.2f * (float)i, 0.6f + 0.1f * (float)i, 1.0f },
+		});
+	}
+	// Layouts without per instance materials, like the bench's, read material 0.
+	glVertexAttribI4ui(4, 0, 0, 0, 0);
+
+	ProgramLibrary* programLibrary = programlibrary_create(compileQueue);
+	assert(programLibrary != NULL);
+	ProgramRequest* defaultProgram = programLibrary && materials
+		? makeProgramGLSL(programLibrary, "default.vert", NULL, NULL, NULL, "default.frag", materials_defines(materials))
+		: NULL;
+	assert(defaultProgram != NULL);
+
+	glClearColor(0, 0, 0, 1.0f);
 
-	GLint isLinked = false;
-	glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
-#ifndef glDebugMessageCallback
-	if (!isLinked)
+	// All dynamic geometry and uniforms go through here, never glBufferData per draw.
+	StreamBuffer* streamBuffer = streambuffer_create(STREAM_FRAME_SIZE, 0);
+	assert(streamBuffer != NULL);
+	GLuint sceneLayout = streamBuffer ? makeSceneLayout(streambuffer_buffer(streamBuffer)) : 0;
+	DrawBatch* drawBatch = drawbatch_create();
+	assert(drawBatch != NULL);
+	Culler* culler = culling_create(compileQueue, SCENE_INSTANCES);
+	assert(culler != NULL);
+	RenderGraph* renderGraph = rendergraph_create();
+	assert(renderGraph != NULL);
+	GLuint compositeSource = 0;
+	glCreateFramebuffers(1, &compositeSource);
+	NAME_OBJECT(GL_FRAMEBUFFER, compositeSource, "Composite Source");
+	Overlay* overlay = NULL;
+	if (options.profileOverlay && streamBuffer)
 	{
-		GLuint len = 0;
-		glGetProgramiv(program, GL_INFO_LOG_LENGTH, &len);
-		assert(len != 0);
-		const char* msg = malloc(len * sizeof * msg);
-		glGetProgramInfoLog(program, len, NULL, msg);
+		overlay = overlay_create(compileQueue, streambuffer_buffer(streamBuffer), platform_getNullTexture(ctx));
+		assert(overlay != NULL);
+	}
 
-		OutputDebugStringA(msg);
-		free(msg);
+	Capture* capture = NULL;
+	Bench* bench = NULL;
+	if (options.capturePattern)
+	{
+		capture = capture_create(width, height, options.capturePattern, 0);
+		assert(capture != NULL);
+		running = capture != NULL;
+		if (capture)
+			glBindFramebuffer(GL_FRAMEBUFFER, capture_framebuffer(capture));
 	}
-#endif // !glDebugMessageCallback
-	if (!isLinked)
+	if (options.benchReport)
 	{
-		glDeleteProgram(program);
-		return -1;
+		// Each scene runs the requested number of frames, the bench decides when it is done.
+		bench = bench_create(options.frameCount, BENCH_WARMUP_FRAMES);
+		assert(bench != NULL);
+		running = running && bench != NULL;
+		options.frameCount = 0;
+	}
+	Profiler* profiler = NULL;
+	if (options.profileOverlay || options.tracePath)
+		profiler = profiler_create(PROFILER_HISTORY);
+	HotReload* hotReload = NULL;
+	if (options.hotReload)
+	{
+		hotReload = hotreload_create(ctx, compileQueue, includeCache);
+		assert(hotReload != NULL);
 	}
 
-	// Always delete after successful linkage
-	glDetachShader(program, vShader);
-	glDeleteShader(vShader);
-	glDetachShader(program, fShader);
-	glDeleteShader(fShader);
+	TextureStream* textureStream = texturestream_create(TEXTURE_STAGING_SIZE, TEXTURE_UPLOAD_BUDGET, scheduler, 0);
+	assert(textureStream != NULL);
+	TextureRequest* streamedTexture = textureStream && options.texturePath ? texturestream_load(textureStream, options.texturePath) : NULL;
 
-	glClearColor(0, 0, 0, 1.0f);
-	glUseProgram(program);
+	// Whatever ends up bound here is what the frame presents, surfaceless contexts bring their own framebuffer.
+	GLint backbuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &backbuffer);
+
+	// Measurements and captures have to see the real programs from the first frame.
+	if ((capture || bench) && !compilequeue_finish(compileQueue))
+		running = false;
+	if ((capture || bench) && textureStream && !texturestream_finish(textureStream))
+		running = false;
+
+	if (!capture && !bench)
+		platform_show(ctx);
 
-	platform_show(ctx);
+	// Two packets, the update thread writes one while the render thread draws the other.
+	FramePackets* packets = framepackets_create(sizeof(struct FramePacket));
+	assert(packets != NULL);
+	running = running && packets != NULL;
 
-	int result = 0;
-	while (running)
+	struct Renderer renderer = {
+		.ctx = ctx,
+		.packets = packets,
+		.compileQueue = compileQueue,
+		.hotReload = hotReload,
+		.defaultProgram = defaultProgram,
+		.fallbackProgram = fallbackProgram,
+		.scheduler = scheduler,
+		.textureStream = textureStream,
+		.streamedTexture = streamedTexture,
+		.streamedMaterial = MATERIAL_NONE,
+		.materials = materials,
+		.streamBuffer = streamBuffer,
+		.drawBatch = drawBatch,
+		.culler = culler,
+		.renderGraph = renderGraph,
+		.capture = capture,
+		.bench = bench,
+		.profiler = profiler,
+		.tracePath = options.tracePath,
+		.overlay = overlay,
+		.sceneLayout = sceneLayout,
+		.compositeSource = compositeSource,
+		.backbuffer = (GLuint)backbuffer,
+		.width = width,
+		.height = height,
+		.result = 0,
+	};
+
+	// The window's context moves to the render thread for the frame loop and comes back for teardown.
+	Thread renderThread = { 0 };
+	if (running)
 	{
-		running = platform_pollMessages(ctx, &result);
-		if (!running) break; // Avoid swapping deleted buffers
+		platform_makeWindowCurrent(ctx, false);
+		running = thread_create(&renderThread, renderMain, &renderer);
+		if (!running)
+			platform_makeWindowCurrent(ctx, true);
+	}
+	const bool isRendering = running;
 
-		glClear(GL_COLOR_BUFFER_BIT);
+	// Messages, window tasks and the scene update run here, a frame ahead of what is drawn. GL tasks run on the render thread.
+	int result = running ? 0 : -1;
+	for (uint32_t frame = 0; running; frame++)
+	{
+		running = platform_pollMessages(ctx, &result);
+		if (!running) break;
+		scheduler_runPinned(scheduler, TASK_CREATOR_THREAD);
 
+		// Taken back only once the render thread is done with the packet before last, or stopped.
+		struct FramePacket* packet = framepackets_beginWrite(packets);
+		if (packet == NULL)
+			break;
+		// Resizes and input arrive with the messages, the render thread picks them up with the packet.
+		platform_getDimensions(ctx, &packet->width, &packet->height);
+		platform_takeInput(ctx, &packet->input);
+		updateScene(packet, frame);
+		framepackets_endWrite(packets);
 
+		if (options.frameCount != 0 && frame + 1 >= options.frameCount)
+			running = false;
+	}
 
-		BOOL swapSuccess = platform_swapBuffers(ctx);
-		assert(swapSuccess);
+	if (isRendering)
+	{
+		// The render thread draws what was published before it stops.
+		framepackets_close(packets);
+		thread_join(renderThread);
+		platform_makeWindowCurrent(ctx, true);
+		if (renderer.result != 0)
+			result = renderer.result;
 	}
-	glDeleteProgram(program);
+	framepackets_destroy(packets);
+
+	if (bench && !bench_writeReport(bench, options.benchReport) && result == 0)
+		result = -1;
+	bench_destroy(bench);
+	if (capture && !capture_destroy(capture) && result == 0)
+		result = -1;
+	if (options.tracePath && !profiler_writeTrace(profiler, options.tracePath) && result == 0)
+		result = -1;
+	profiler_destroy(profiler);
+	hotreload_destroy(hotReload);
+	overlay_destroy(overlay);
+	glDeleteFramebuffers(1, &compositeSource);
+	rendergraph_destroy(renderGraph);
+	culling_destroy(culler);
+	drawbatch_destroy(drawBatch);
+	glDeleteVertexArrays(1, &sceneLayout);
+	materials_destroy(materials);
+	glDeleteTextures(SCENE_MATERIALS, materialTextures);
+	texturestream_destroy(textureStream);
+	streambuffer_destroy(streamBuffer);
+	programlibrary_destroy(programLibrary);
+	compilequeue_destroy(compileQueue);
+	includecache_destroy(includeCache);
+	programcache_destroy(programCache);
+	scheduler_destroy(scheduler);
+	freeOptions(&options);
 
 	return result;
 }
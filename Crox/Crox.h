@@ -1,7 +1,12 @@
 #pragma once
+#include "framework_crt.h"
 #include "framework_nuklear.h"
 #include <stdint.h>
 #include <wchar.h>
 
+#ifndef _WIN32
+// The C runtime owns main() outside of Windows, the platform layer forwards to Crox under this name instead.
+#define main croxMain
+#endif // !_WIN32
 
 int main(_In_ NkContext* ctx, _In_ uint32_t argC, _In_ wchar_t** argV, _In_ wchar_t** penv);
\ No newline at end of file
@@ -0,0 +1,413 @@
+/**
+
+    @file      atlas.c
+    @brief     Many small images packed into the layers of one array texture
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "atlas.h"
+
+#include <stb_rect_pack.h>
+#include <string.h>
+
+
+#define NO_SLOT UINT32_MAX
+
+struct AtlasImage
+{
+	uint16_t generation;	// bumped on eviction, stale IDs stop matching
+	uint16_t layer;
+	uint16_t x;				// of the padded rectangle
+	uint16_t y;
+	uint16_t width;			// padded
+	uint16_t height;
+	bool isLive;
+	bool isDirty;			// listed in Atlas::dirty
+	uint64_t lastUsed;		// frame
+	uint32_t older;			// LRU list, or the free list through newer
+	uint32_t newer;
+	uint8_t* pixels;		// padded RGBA8
+};
+
+// A skyline, its nodes must stay where they are for as long as it's in use.
+struct PackTarget
+{
+	stbrp_context context;
+	stbrp_node nodes[];		// one per column
+};
+
+struct AtlasPage
+{
+	struct PackTarget* target;
+	uint64_t usedArea;		// of the live images on it
+	bool hasHoles;			// images left space the skyline can't reuse
+};
+
+struct Atlas
+{
+	GLuint texture;
+	uint32_t size;
+	uint32_t layerCount;
+	struct AtlasPage* pages;
+	struct PackTarget* spare;	// repacks go here and swap with the page on success
+
+	struct AtlasImage* images;
+	uint32_t imageCount;
+	uint32_t imageCapacity;
+	uint32_t freeSlot;
+	uint32_t oldest;
+	uint32_t newest;
+
+	uint32_t* dirty;
+	uint32_t dirtyCount;
+	uint32_t dirtyCapacity;
+
+	stbrp_rect* rects;
+	uint32_t rectCapacity;
+
+	uint64_t frame;
+};
+
+
+static bool grow(_Inout_ void** array, _Inout_ uint32_t* capacity, _In_ uint32_t count, _In_ size_t elementSize)
+{
+	if (count < *capacity)
+		return true;
+	uint32_t newCapacity = *capacity ? *capacity * 2 : 16;
+	void* newArray = realloc(*array, newCapacity * elementSize);
+	if (newArray == NULL)
+		return false;
+	*array = newArray;
+	*capacity = newCapacity;
+	return true;
+}
+
+static struct PackTarget* createTarget(_In_ uint32_t size)
+{
+	struct PackTarget* target = malloc(sizeof * target + size * sizeof(stbrp_node));
+	if (target)
+		stbrp_init_target(&target->context, (int)size, (int)size, target->nodes, (int)size);
+	return target;
+}
+
+static struct AtlasImage* lookup(_In_ const Atlas* atlas, _In_ uint32_t id)
+{
+	const uint32_t slot = (id & 0xffff) - 1;
+	if (id == ATLAS_NONE || slot >= atlas->imageCount)
+		return NULL;
+	struct AtlasImage* image = &atlas->images[slot];
+	return image->isLive && image->generation == id >> 16 ? image : NULL;
+}
+
+static void unlinkImage(_Inout_ Atlas* atlas, _In_ uint32_t slot)
+{
+	struct AtlasImage* image = &atlas->images[slot];
+	if (image->older != NO_SLOT)
+		atlas->images[image->older].newer = image->newer;
+	else
+		atlas->oldest = image->newer;
+	if (image->newer != NO_SLOT)
+		atlas->images[image->newer].older = image->older;
+	else
+		atlas->newest = image->older;
+}
+
+static void linkImage(_Inout_ Atlas* atlas, _In_ uint32_t slot)
+{
+	struct AtlasImage* image = &atlas->images[slot];
+	image->older = atlas->newest;
+	image->newer = NO_SLOT;
+	if (atlas->newest != NO_SLOT)
+		atlas->images[atlas->newest].newer = slot;
+	else
+		atlas->oldest = slot;
+	atlas->newest = slot;
+}
+
+static void markDirty(_Inout_ Atlas* atlas, _In_ uint32_t slot)
+{
+	struct AtlasImage* image = &atlas->images[slot];
+	if (image->isDirty)
+		return;
+	// Without room in the list the image isn't uploaded, it shows whatever was there before.
+	if (!grow((void**)&atlas->dirty, &atlas->dirtyCapacity, atlas->dirtyCount, sizeof * atlas->dirty))
+		return;
+	atlas->dirty[atlas->dirtyCount++] = slot;
+	image->isDirty = true;
+}
+
+static void evict(_Inout_ Atlas* atlas, _In_ uint32_t slot)
+{
+	struct AtlasImage* image = &atlas->images[slot];
+	unlinkImage(atlas, slot);
+	struct AtlasPage* page = &atlas->pages[image->layer];
+	page->usedArea -= (uint64_t)image->width * image->height;
+	page->hasHoles = true;
+
+	free(image->pixels);
+	image->pixels = NULL;
+	image->isLive = false;
+	image->generation++;
+	image->newer = atlas->freeSlot;
+	atlas->freeSlot = slot;
+}
+
+static bool repack(_Inout_ Atlas* atlas, _In_ uint32_t layer, _In_ uint32_t pending)
+//
+// Packs the page's live images and the pending one into the spare skyline. Nothing changes unless all of them fit.
+//
+{
+	uint32_t count = 0;
+	for (uint32_t slot = 0; slot <= atlas->imageCount; slot++)
+	{
+		const bool isPending = slot == atlas->imageCount;
+		const struct AtlasImage* image = &atlas->images[isPending ? pending : slot];
+		if (!isPending && !(image->isLive && image->layer == layer))
+			continue;
+		if (!grow((void**)&atlas->rects, &atlas->rectCapacity, count, sizeof * atlas->rects))
+			return false;
+		atlas->rects[count++] = (stbrp_rect){ .id = (int)(isPending ? pending : slot), .w = image->width, .h = image->height };
+	}
+
+	struct PackTarget* target = atlas->spare;
+	stbrp_init_target(&target->context, (int)atlas->size, (int)atlas->size, target->nodes, (int)atlas->size);
+	if (!stbrp_pack_rects(&target->context, atlas->rects, (int)count))
+		return false;
+
+	// Only what moved is uploaded again.
+	for (uint32_t i = 0; i < count; i++)
+	{
+		const uint32_t slot = (uint32_t)atlas->rects[i].id;
+		struct AtlasImage* image = &atlas->images[slot];
+		if (slot == pending || image->x != atlas->rects[i].x || image->y != atlas->rects[i].y)
+		{
+			image->x = (uint16_t)atlas->rects[i].x;
+			image->y = (uint16_t)atlas->rects[i].y;
+			markDirty(atlas, slot);
+		}
+	}
+
+	struct AtlasPage* page = &atlas->pages[layer];
+	atlas->spare = page->target;
+	page->target = target;
+	page->hasHoles = false;
+	return true;
+}
+
+static bool place(_Inout_ Atlas* atlas, _In_ uint32_t slot)
+{
+	struct AtlasImage* image = &atlas->images[slot];
+	const uint64_t area = (uint64_t)image->width * image->height;
+	const uint64_t pageArea = (uint64_t)atlas->size * atlas->size;
+	uint32_t placed = NO_SLOT;
+
+	// Cheapest first, what the skylines have left.
+	for (uint32_t layer = 0; placed == NO_SLOT && layer < atlas->layerCount; layer++)
+	{
+		stbrp_rect rect = { .id = (int)slot, .w = image->width, .h = image->height };
+		if (stbrp_pack_rects(&atlas->pages[layer].target->context, &rect, 1))
+		{
+			image->x = (uint16_t)rect.x;
+			image->y = (uint16_t)rect.y;
+			placed = layer;
+		}
+	}
+	// Then the space removed images left behind.
+	for (uint32_t layer = 0; placed == NO_SLOT && layer < atlas->layerCount; layer++)
+		if (atlas->pages[layer].hasHoles && pageArea - atlas->pages[layer].usedArea >= area && repack(atlas, layer, slot))
+			placed = layer;
+	// Then the space of images nobody used this frame, oldest first.
+	while (placed == NO_SLOT && atlas->oldest != NO_SLOT && atlas->images[atlas->oldest].lastUsed < atlas->frame)
+	{
+		const uint32_t layer = atlas->images[atlas->oldest].layer;
+		evict(atlas, atlas->oldest);
+		if (pageArea - atlas->pages[layer].usedArea >= area && repack(atlas, layer, slot))
+			placed = layer;
+	}
+	if (placed == NO_SLOT)
+		return false;
+
+	image->layer = (uint16_t)placed;
+	atlas->pages[placed].usedArea += area;
+	return true;
+}
+
+static uint8_t* padImage(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height)
+{
+	const uint32_t paddedWidth = width + 2 * ATLAS_PADDING;
+	const uint32_t paddedHeight = height + 2 * ATLAS_PADDING;
+	uint8_t* padded = malloc((size_t)paddedWidth * paddedHeight * 4);
+	if (padded == NULL)
+		return NULL;
+
+	for (uint32_t y = 0; y < paddedHeight; y++)
+	{
+		const uint32_t sy = y < ATLAS_PADDING ? 0 : y - ATLAS_PADDING < height ? y - ATLAS_PADDING : height - 1;
+		const uint8_t* row = pixels + (size_t)sy * width * 4;
+		uint8_t* out = padded + (size_t)y * paddedWidth * 4;
+		for (uint32_t x = 0; x < ATLAS_PADDING; x++)
+		{
+			memcpy(out + x * 4, row, 4);
+			memcpy(out + (ATLAS_PADDING + width + x) * 4, row + (size_t)(width - 1) * 4, 4);
+		}
+		memcpy(out + ATLAS_PADDING * 4, row, (size_t)width * 4);
+	}
+	return padded;
+}
+
+
+Atlas* atlas_create(_In_ uint32_t size, _In_ uint32_t layers)
+{
+	// Placements are kept in 16 bits.
+	if (size == 0 || size > UINT16_MAX || layers == 0 || layers > UINT16_MAX)
+		return NULL;
+	Atlas* atlas = calloc(1, sizeof * atlas);
+	if (atlas == NULL)
+		return NULL;
+
+	atlas->size = size;
+	atlas->layerCount = layers;
+	atlas->freeSlot = NO_SLOT;
+	atlas->oldest = NO_SLOT;
+	atlas->newest = NO_SLOT;
+	atlas->pages = calloc(layers, sizeof * atlas->pages);
+	atlas->spare = createTarget(size);
+	bool success = atlas->pages && atlas->spare;
+	for (uint32_t i = 0; success && i < layers; i++)
+		success = (atlas->pages[i].target = createTarget(size)) != NULL;
+	if (!success)
+	{
+		atlas_destroy(atlas);
+		return NULL;
+	}
+
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &atlas->texture);
+	NAME_OBJECT(GL_TEXTURE, atlas->texture, "Atlas");
+	glTextureStorage3D(atlas->texture, 1, GL_RGBA8, (GLsizei)size, (GLsizei)size, (GLsizei)layers);
+	glTextureParameteri(atlas->texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(atlas->texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTextureParameteri(atlas->texture, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+	glTextureParameteri(atlas->texture, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+	return atlas;
+}
+
+void atlas_destroy(_In_opt_ Atlas* atlas)
+{
+	if (atlas == NULL)
+		return;
+
+	if (atlas->texture)
+		glDeleteTextures(1, &atlas->texture);
+	for (uint32_t i = 0; i < atlas->imageCount; i++)
+		free(atlas->images[i].pixels);
+	if (atlas->pages)
+		for (uint32_t i = 0; i < atlas->layerCount; i++)
+			free(atlas->pages[i].target);
+	free(atlas->pages);
+	free(atlas->spare);
+	free(atlas->images);
+	free(atlas->dirty);
+	free(atlas->rects);
+	free(atlas);
+}
+
+uint32_t atlas_add(_Inout_ Atlas* atlas, _In_ const void* pixels, _In_ uint32_t width, _In_ uint32_t height)
+{
+	if (width == 0 || height == 0 || width + 2 * ATLAS_PADDING > atlas->size || height + 2 * ATLAS_PADDING > atlas->size)
+		return ATLAS_NONE;
+
+	uint32_t slot = atlas->freeSlot;
+	if (slot == NO_SLOT)
+	{
+		if (atlas->imageCount == ATLAS_MAX_IMAGES
+			|| !grow((void**)&atlas->images, &atlas->imageCapacity, atlas->imageCount, sizeof * atlas->images))
+			return ATLAS_NONE;
+		slot = atlas->imageCount++;
+		atlas->images[slot] = (struct AtlasImage){ .generation = 0, .isDirty = false };
+	}
+	else
+		// An evicted image may still be listed as dirty, the slot then stays listed for the new one.
+		atlas->freeSlot = atlas->images[slot].newer;
+
+	struct AtlasImage* image = &atlas->images[slot];
+	image->width = (uint16_t)(width + 2 * ATLAS_PADDING);
+	image->height = (uint16_t)(height + 2 * ATLAS_PADDING);
+	image->pixels = padImage(pixels, width, height);
+	if (image->pixels == NULL || !place(atlas, slot))
+	{
+		free(image->pixels);
+		image->pixels = NULL;
+		image->newer = atlas->freeSlot;
+		atlas->freeSlot = slot;
+		return ATLAS_NONE;
+	}
+
+	image->isLive = true;
+	image->lastUsed = atlas->frame;
+	linkImage(atlas, slot);
+	markDirty(atlas, slot);
+	return (uint32_t)image->generation << 16 | (slot + 1);
+}
+
+void atlas_remove(_Inout_ Atlas* atlas, _In_ uint32_t id)
+{
+	struct AtlasImage* image = lookup(atlas, id);
+	if (image)
+		evict(atlas, (uint32_t)(image - atlas->images));
+}
+
+bool atlas_use(_Inout_ Atlas* atlas, _In_ uint32_t id)
+{
+	struct AtlasImage* image = lookup(atlas, id);
+	if (image == NULL)
+		return false;
+
+	const uint32_t slot = (uint32_t)(image - atlas->images);
+	if (atlas->newest != slot)
+	{
+		unlinkImage(atlas, slot);
+		linkImage(atlas, slot);
+	}
+	image->lastUsed = atlas->frame;
+	return true;
+}
+
+void atlas_update(_Inout_opt_ Atlas* atlas)
+{
+	if (atlas == NULL)
+		return;
+
+	for (uint32_t i = 0; i < atlas->dirtyCount; i++)
+	{
+		struct AtlasImage* image = &atlas->images[atlas->dirty[i]];
+		image->isDirty = false;
+		if (image->isLive)
+			glTextureSubImage3D(atlas->texture, 0, image->x, image->y, image->layer, image->width, image->height, 1,
+				GL_RGBA, GL_UNSIGNED_BYTE, image->pixels);
+	}
+	atlas->dirtyCount = 0;
+	atlas->frame++;
+}
+
+bool atlas_rect(_In_ const Atlas* atlas, _In_ uint32_t id, _Out_ struct AtlasRect* rect)
+{
+	const struct AtlasImage* image = lookup(atlas, id);
+	if (image == NULL)
+		return false;
+
+	const float texel = 1.0f / (float)atlas->size;
+	*rect = (struct AtlasRect){
+		.offset = { (float)(image->x + ATLAS_PADDING) * texel, (float)(image->y + ATLAS_PADDING) * texel },
+		.scale = { (float)(image->width - 2 * ATLAS_PADDING) * texel, (float)(image->height - 2 * ATLAS_PADDING) * texel },
+		.layer = image->layer,
+	};
+	return true;
+}
+
+GLuint atlas_texture(_In_ const Atlas* atlas)
+{
+	return atlas->texture;
+}
@@ -0,0 +1,73 @@
+/**
+
+    @file      atlas.h
+    @brief     Many small images packed into the layers of one array texture
+    @details   Every layer is a page filled incrementally by stb_rect_pack's
+               skyline packer. A skyline can't give single rectangles back, so
+               once nothing fits anymore the least recently used images are
+               evicted and a page is repacked from scratch with whatever is
+               left on it. Images keep a CPU copy, which lets a repack move
+               them without reading the texture back, and only the regions of
+               images that were added or moved are uploaded, by atlas_update.
+               Every image is padded by ATLAS_PADDING repeated edge texels so
+               bilinear filtering doesn't bleed between neighbours. The
+               texture has a single level.
+
+               A frame resolves its images first with atlas_use, re-adding the
+               ones that were evicted, then calls atlas_update and only then
+               asks for rects to draw with, since adding can move any image
+               not drawn yet. Images used or added in the current frame are
+               never evicted.
+
+               Nothing uses it yet: the renderer draws no atlased images and
+               Nuklear bakes its font into a texture of its own.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+
+
+#define ATLAS_NONE			0
+#define ATLAS_PADDING		1		// texels around every image
+#define ATLAS_MAX_IMAGES	0xffff
+
+typedef struct Atlas Atlas;
+
+// Where an image ended up, uv = offset + uv * scale in the layer.
+struct AtlasRect
+{
+	float offset[2];
+	float scale[2];
+	uint32_t layer;
+};
+
+/**
+	@brief  Creates the RGBA8 array texture, size by size texels per layer.
+	@retval - NULL on failure
+**/
+Atlas* atlas_create(_In_ uint32_t size, _In_ uint32_t layers);
+
+void atlas_destroy(_In_opt_ Atlas* atlas);
+
+/**
+	@brief  Copies an RGBA8 image in, evicting what it has to. It is uploaded by the next atlas_update.
+	@retval - ID counting as used this frame, ATLAS_NONE if it doesn't fit even after evicting, what was evicted stays evicted
+**/
+uint32_t atlas_add(_Inout_ Atlas* atlas, _In_ const void* pixels, _In_ uint32_t width, _In_ uint32_t height);
+
+//frees the image's space for the next repack. Stale IDs are ignored.
+void atlas_remove(_Inout_ Atlas* atlas, _In_ uint32_t id);
+
+//marks the image as used this frame. False if it was evicted or removed, it has to be added again then.
+bool atlas_use(_Inout_ Atlas* atlas, _In_ uint32_t id);
+
+//uploads the regions of added and moved images and starts the next frame. Call once per frame from the GL thread.
+void atlas_update(_Inout_opt_ Atlas* atlas);
+
+//false if the ID is stale.
+bool atlas_rect(_In_ const Atlas* atlas, _In_ uint32_t id, _Out_ struct AtlasRect* rect);
+
+GLuint atlas_texture(_In_ const Atlas* atlas);
@@ -0,0 +1,400 @@
+/**
+
+    @file      bench.c
+    @brief     Frame-time benchmark over a fixed set of deterministic scenes
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "platform/Platform.h"
+#include "bench.h"
+
+#include <string.h>
+#include <cJSON.h>
+
+
+// Results are read this many frames late, by then the GPU has long finished them.
+#define QUERY_RING_SIZE 4
+
+#define NO_SAMPLE UINT32_MAX
+
+struct BenchScene
+{
+	const char* name;
+	uint32_t triangles;
+};
+
+// Geometry is generated from a fixed seed, so every run of a scene draws exactly the same thing.
+static const struct BenchScene SCENES[] = {
+	{ "clear",			0 },
+	{ "triangles_1k",	1u << 10 },
+	{ "triangles_16k",	1u << 14 },
+	{ "triangles_64k",	1u << 16 },
+};
+#define SCENE_COUNT (sizeof SCENES / sizeof * SCENES)
+
+struct FrameSample
+{
+	uint64_t cpu;			// ns
+	uint64_t gpu;			// ns
+	uint64_t allocations;
+};
+
+struct Vertex
+{
+	float pos[2];
+	float rgb[3];
+};
+
+struct Bench
+{
+	uint32_t frames;
+	uint32_t warmup;
+
+	uint32_t scene;
+	uint32_t frame;			// within the current scene, warmup included
+	uint64_t totalFrames;
+
+	GLuint vao;
+	GLuint vbo;
+	GLsizei vertexCount;
+
+	GLuint queries[QUERY_RING_SIZE];
+	bool queryPending[QUERY_RING_SIZE];
+	uint32_t queryScene[QUERY_RING_SIZE];
+	uint32_t querySample[QUERY_RING_SIZE];	// NO_SAMPLE during warmup
+
+	uint64_t frameStart;
+	uint64_t allocationStart;
+	bool allocationsTracked;
+
+	char* renderer;
+	char* vendor;
+	char* version;
+
+	struct FrameSample* samples[SCENE_COUNT];
+};
+
+
+static char* copyString(_In_opt_ const GLubyte* str)
+{
+	const char* s = str ? (const char*)str : "";
+	char* copy = malloc(strlen(s) + 1);
+	if (copy)
+		strcpy(copy, s);
+	return copy;
+}
+
+static uint32_t nextRandom(_Inout_ uint32_t* state)
+{
+	// xorshift32, good enough for scattering triangles and identical on every platform.
+	uint32_t x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	return *state = x;
+}
+
+static float randomUnit(_Inout_ uint32_t* state)
+{
+	return (float)(nextRandom(state) >> 8) / (float)(1u << 24);
+}
+
+static void unloadScene(_Inout_ Bench* bench)
+{
+	if (bench->vao)
+		glDeleteVertexArrays(1, &bench->vao);
+	if (bench->vbo)
+		glDeleteBuffers(1, &bench->vbo);
+	bench->vao = 0;
+	bench->vbo = 0;
+	bench->vertexCount = 0;
+}
+
+static bool loadScene(_Inout_ Bench* bench)
+{
+	unloadScene(bench);
+
+	const struct BenchScene* scene = &SCENES[bench->scene];
+	if (scene->triangles == 0)
+		return true;
+
+	const size_t vertexCount = (size_t)scene->triangles * 3;
+	struct Vertex* vertices = malloc(vertexCount * sizeof * vertices);
+	if (vertices == NULL)
+		return false;
+
+	uint32_t seed = 0x9E3779B9u ^ scene->triangles;
+	const float extent = 0.05f;
+	for (size_t i = 0; i < scene->triangles; i++)
+	{
+		const float cx = randomUnit(&seed) * 2.0f - 1.0f;
+		const float cy = randomUnit(&seed) * 2.0f - 1.0f;
+		for (size_t v = 0; v < 3; v++)
+		{
+			struct Vertex* vertex = &vertices[i * 3 + v];
+			vertex->pos[0] = cx + (randomUnit(&seed) - 0.5f) * extent;
+			vertex->pos[1] = cy + (randomUnit(&seed) - 0.5f) * extent;
+			vertex->rgb[0] = randomUnit(&seed);
+			vertex->rgb[1] = randomUnit(&seed);
+			vertex->rgb[2] = randomUnit(&seed);
+		}
+	}
+
+	glCreateBuffers(1, &bench->vbo);
+	glNamedBufferStorage(bench->vbo, vertexCount * sizeof * vertices, vertices, 0);
+	free(vertices);
+	NAME_OBJECT(GL_BUFFER, bench->vbo, scene->name);
+
+	glCreateVertexArrays(1, &bench->vao);
+	glVertexArrayVertexBuffer(bench->vao, 0, bench->vbo, 0, sizeof(struct Vertex));
+	glEnableVertexArrayAttrib(bench->vao, 0);
+	glVertexArrayAttribFormat(bench->vao, 0, 2, GL_FLOAT, GL_FALSE, offsetof(struct Vertex, pos));
+	glVertexArrayAttribBinding(bench->vao, 0, 0);
+	glEnableVertexArrayAttrib(bench->vao, 1);
+	glVertexArrayAttribFormat(bench->vao, 1, 3, GL_FLOAT, GL_FALSE, offsetof(struct Vertex, rgb));
+	glVertexArrayAttribBinding(bench->vao, 1, 0);
+
+	bench->vertexCount = (GLsizei)vertexCount;
+	return true;
+}
+
+static bool collectQuery(_Inout_ Bench* bench, _In_ uint32_t slot, _In_ bool wait)
+{
+	if (!bench->queryPending[slot])
+		return true;
+
+	if (!wait)
+	{
+		GLuint available = GL_FALSE;
+		glGetQueryObjectuiv(bench->queries[slot], GL_QUERY_RESULT_AVAILABLE, &available);
+		if (!available)
+			return false;
+	}
+
+	GLuint64 elapsed = 0;
+	glGetQueryObjectui64v(bench->queries[slot], GL_QUERY_RESULT, &elapsed);
+	bench->queryPending[slot] = false;
+
+	if (bench->querySample[slot] != NO_SAMPLE)
+		bench->samples[bench->queryScene[slot]][bench->querySample[slot]].gpu = elapsed;
+	return true;
+}
+
+static int compareDoubles(const void* a, const void* b)
+{
+	double x = *(const double*)a, y = *(const double*)b;
+	return (x > y) - (x < y);
+}
+
+static cJSON* makeStatistics(_Inout_ double* values, _In_ uint32_t count)
+//
+// Nearest-rank percentiles, values get sorted in place.
+//
+{
+	cJSON* stats = cJSON_CreateObject();
+	if (count == 0)
+		return stats;
+
+	qsort(values, count, sizeof * values, compareDoubles);
+
+	double sum = 0;
+	for (uint32_t i = 0; i < count; i++)
+		sum += values[i];
+
+	const double percentiles[] = { 50, 95, 99 };
+	const char* names[] = { "p50", "p95", "p99" };
+
+	cJSON_AddNumberToObject(stats, "mean", sum / count);
+	cJSON_AddNumberToObject(stats, "min", values[0]);
+	cJSON_AddNumberToObject(stats, "max", values[count - 1]);
+	for (size_t i = 0; i < sizeof percentiles / sizeof * percentiles; i++)
+	{
+		uint32_t rank = (uint32_t)(percentiles[i] / 100.0 * count + 0.999999);
+		cJSON_AddNumberToObject(stats, names[i], values[rank == 0 ? 0 : rank - 1]);
+	}
+	return stats;
+}
+
+
+Bench* bench_create(_In_ uint32_t frames, _In_ uint32_t warmup)
+{
+	if (frames == 0)
+		return NULL;
+
+	Bench* bench = calloc(1, sizeof * bench);
+	if (bench == NULL)
+		return NULL;
+
+	bench->frames = frames;
+	bench->warmup = warmup;
+
+	bool success = true;
+	for (size_t i = 0; i < SCENE_COUNT; i++)
+		success = success && (bench->samples[i] = calloc(frames, sizeof * bench->samples[i])) != NULL;
+
+	uint64_t unused;
+	bench->allocationsTracked = platform_getAllocationCount(&unused);
+
+	bench->renderer = copyString(glGetString(GL_RENDERER));
+	bench->vendor = copyString(glGetString(GL_VENDOR));
+	bench->version = copyString(glGetString(GL_VERSION));
+
+	glCreateQueries(GL_TIME_ELAPSED, QUERY_RING_SIZE, bench->queries);
+
+	if (!success || !loadScene(bench))
+	{
+		bench_destroy(bench);
+		return NULL;
+	}
+	return bench;
+}
+
+bool bench_beginFrame(_Inout_ Bench* bench)
+{
+	if (bench->scene == SCENE_COUNT)
+		return false;
+
+	if (bench->frame == bench->warmup + bench->frames)
+	{
+		bench->scene++;
+		bench->frame = 0;
+		if (bench->scene == SCENE_COUNT)
+		{
+			unloadScene(bench);
+			return false;
+		}
+		if (!loadScene(bench))
+		{
+			bench->scene = SCENE_COUNT;
+			return false;
+		}
+	}
+
+	const uint32_t slot = bench->totalFrames % QUERY_RING_SIZE;
+	collectQuery(bench, slot, true);
+
+	bench->queryPending[slot] = true;
+	bench->queryScene[slot] = bench->scene;
+	bench->querySample[slot] = bench->frame < bench->warmup ? NO_SAMPLE : bench->frame - bench->warmup;
+	glBeginQuery(GL_TIME_ELAPSED, bench->queries[slot]);
+
+	platform_getAllocationCount(&bench->allocationStart);
+	bench->frameStart = platform_getTime();
+	return true;
+}
+
+void bench_drawScene(_In_ Bench* bench)
+{
+	if (bench->vertexCount == 0)
+		return;
+
+	glBindVertexArray(bench->vao);
+	glDrawArrays(GL_TRIANGLES, 0, bench->vertexCount);
+	glBindVertexArray(0);
+}
+
+void bench_endFrame(_Inout_ Bench* bench)
+{
+	glEndQuery(GL_TIME_ELAPSED);
+
+	const uint64_t frameEnd = platform_getTime();
+	uint64_t allocations = 0;
+	platform_getAllocationCount(&allocations);
+
+	if (bench->frame >= bench->warmup)
+	{
+		struct FrameSample* sample = &bench->samples[bench->scene][bench->frame - bench->warmup];
+		sample->cpu = frameEnd - bench->frameStart;
+		sample->allocations = allocations - bench->allocationStart;
+	}
+
+	bench->frame++;
+	bench->totalFrames++;
+
+	// Oldest first, stop at the first one the GPU has not finished yet.
+	for (uint32_t i = 0; i < QUERY_RING_SIZE; i++)
+		if (!collectQuery(bench, (bench->totalFrames + i) % QUERY_RING_SIZE, false))
+			break;
+}
+
+bool bench_writeReport(_In_ Bench* bench, _In_z_ const char* path)
+{
+	for (uint32_t i = 0; i < QUERY_RING_SIZE; i++)
+		collectQuery(bench, i, true);
+
+	double* values = malloc(bench->frames * sizeof * values);
+	cJSON* report = cJSON_CreateObject();
+	if (values == NULL || report == NULL)
+	{
+		free(values);
+		cJSON_Delete(report);
+		return false;
+	}
+
+	cJSON_AddNumberToObject(report, "version", 1);
+	cJSON_AddStringToObject(report, "renderer", bench->renderer ? bench->renderer : "");
+	cJSON_AddStringToObject(report, "vendor", bench->vendor ? bench->vendor : "");
+	cJSON_AddStringToObject(report, "gl_version", bench->version ? bench->version : "");
+	cJSON_AddNumberToObject(report, "frames", bench->frames);
+	cJSON_AddNumberToObject(report, "warmup", bench->warmup);
+	cJSON_AddBoolToObject(report, "allocations_tracked", bench->allocationsTracked);
+
+	cJSON* scenes = cJSON_AddArrayToObject(report, "scenes");
+	for (uint32_t s = 0; s < SCENE_COUNT; s++)
+	{
+		const struct FrameSample* samples = bench->samples[s];
+		cJSON* scene = cJSON_CreateObject();
+		cJSON_AddStringToObject(scene, "name", SCENES[s].name);
+		cJSON_AddNumberToObject(scene, "triangles", SCENES[s].triangles);
+
+		for (uint32_t i = 0; i < bench->frames; i++)
+			values[i] = samples[i].cpu / 1e6;
+		cJSON_AddItemToObject(scene, "cpu_ms", makeStatistics(values, bench->frames));
+
+		for (uint32_t i = 0; i < bench->frames; i++)
+			values[i] = samples[i].gpu / 1e6;
+		cJSON_AddItemToObject(scene, "gpu_ms", makeStatistics(values, bench->frames));
+
+		if (bench->allocationsTracked)
+		{
+			for (uint32_t i = 0; i < bench->frames; i++)
+				values[i] = (double)samples[i].allocations;
+			cJSON_AddItemToObject(scene, "allocations_per_frame", makeStatistics(values, bench->frames));
+		}
+
+		cJSON_AddItemToArray(scenes, scene);
+	}
+	free(values);
+
+	char* json = cJSON_Print(report);
+	cJSON_Delete(report);
+	if (json == NULL)
+		return false;
+
+	FILE* file = fopen(path, "wb");
+	bool success = file != NULL && fputs(json, file) >= 0;
+	if (file)
+		success = fclose(file) == 0 && success;
+	cJSON_free(json);
+
+	return success;
+}
+
+void bench_destroy(_In_opt_ Bench* bench)
+{
+	if (bench == NULL)
+		return;
+
+	unloadScene(bench);
+	glDeleteQueries(QUERY_RING_SIZE, bench->queries);
+
+	for (size_t i = 0; i < SCENE_COUNT; i++)
+		free(bench->samples[i]);
+	free(bench->renderer);
+	free(bench->vendor);
+	free(bench->version);
+	free(bench);
+}
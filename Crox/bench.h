@@ -0,0 +1,40 @@
+/**
+
+    @file      bench.h
+    @brief     Frame-time benchmark over a fixed set of deterministic scenes
+    @details   Drives the render loop for a fixed number of frames per scene and
+               records CPU frame time, GPU time from GL_TIME_ELAPSED queries and
+               heap allocations per frame. Timer queries are read back a few
+               frames late so that measuring does not stall the pipeline.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+
+
+typedef struct Bench Bench;
+
+/**
+	@brief  Prepares the benchmark, scene geometry is created lazily.
+	@param  frames - measured frames per scene
+	@param  warmup - unmeasured frames rendered before each scene
+	@retval        - NULL on failure
+**/
+Bench* bench_create(_In_ uint32_t frames, _In_ uint32_t warmup);
+
+//starts a frame, switching scenes as needed. Returns false once every scene has been measured.
+bool bench_beginFrame(_Inout_ Bench* bench);
+
+//issues the draws of the current scene with whatever program is bound.
+void bench_drawScene(_In_ Bench* bench);
+
+//ends the frame started by bench_beginFrame, call after presenting.
+void bench_endFrame(_Inout_ Bench* bench);
+
+//writes the JSON report of all measured scenes to path.
+bool bench_writeReport(_In_ Bench* bench, _In_z_ const char* path);
+
+void bench_destroy(_In_opt_ Bench* bench);
\ No newline at end of file
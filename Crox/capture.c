@@ -0,0 +1,380 @@
+/**
+
+    @file      capture.c
+    @brief     Offscreen rendering with asynchronous readback to image files
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "platform/Threads.h"
+#include "capture.h"
+
+#include <string.h>
+#include <ctype.h>
+#include <stb_image_write.h>
+
+
+// Deep enough that the oldest readback has finished by the time its slot comes around again.
+#define CAPTURE_RING_SIZE 3
+
+enum ImageFormat
+{
+	IMAGE_FORMAT_PNG,
+	IMAGE_FORMAT_TGA,
+	IMAGE_FORMAT_BMP,
+	IMAGE_FORMAT_JPG,
+};
+
+struct EncodeTask
+{
+	struct EncodeTask* next;
+	char* path;
+	uint8_t* pixels;
+};
+
+struct Capture
+{
+	uint32_t width;
+	uint32_t height;
+	char* pattern;
+	enum ImageFormat format;
+
+	GLuint framebuffer;
+	GLuint renderbuffers[2];
+
+	GLuint pixelBuffers[CAPTURE_RING_SIZE];
+	const uint8_t* mapped[CAPTURE_RING_SIZE];
+	GLsync fences[CAPTURE_RING_SIZE];
+	uint64_t submitted;
+	uint64_t retired;
+
+	Mutex mutex;
+	CondVar workAvailable;
+	CondVar spaceAvailable;
+	struct EncodeTask* head;
+	struct EncodeTask* tail;
+	uint32_t queued;
+	uint32_t queueLimit;
+	uint32_t failures;
+	bool quitting;
+
+	uint32_t workerCount;
+	Thread* workers;
+};
+
+
+static bool parseFormat(_In_z_ const char* pattern, _Out_ enum ImageFormat* format)
+{
+	static const struct { const char* ext; enum ImageFormat format; } FORMATS[] = {
+		{ "png", IMAGE_FORMAT_PNG }, { "tga", IMAGE_FORMAT_TGA }, { "bmp", IMAGE_FORMAT_BMP },
+		{ "jpg", IMAGE_FORMAT_JPG }, { "jpeg",IMAGE_FORMAT_JPG },
+	};
+
+	const char* dot = strrchr(pattern, '.');
+	if (dot == NULL)
+		return false;
+
+	char ext[8] = { 0 };
+	for (size_t i = 0; dot[i + 1] != '\0'; i++)
+	{
+		if (i + 1 >= sizeof ext)
+			return false;
+		ext[i] = (char)tolower((unsigned char)dot[i + 1]);
+	}
+
+	for (size_t i = 0; i < sizeof FORMATS / sizeof * FORMATS; i++)
+	{
+		if (strcmp(ext, FORMATS[i].ext) == 0)
+		{
+			*format = FORMATS[i].format;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool validatePattern(_In_z_ const char* pattern)
+//
+// The pattern goes straight into snprintf, so only allow a single integer conversion.
+//
+{
+	uint32_t conversions = 0;
+	for (const char* p = pattern; *p; p++)
+	{
+		if (*p != '%')
+			continue;
+		if (p[1] == '%')
+		{
+			p++;
+			continue;
+		}
+
+		p++;
+		while (*p && strchr("-+ #0", *p))
+			p++;
+		while (*p && isdigit((unsigned char)*p))
+			p++;
+		if (*p == '\0' || !strchr("diuxX", *p))
+			return false;
+		conversions++;
+	}
+	return conversions <= 1;
+}
+
+static bool encode(_In_ const Capture* capture, _In_ const struct EncodeTask* task)
+{
+	const int w = (int)capture->width;
+	const int h = (int)capture->height;
+
+	switch (capture->format)
+	{
+	case IMAGE_FORMAT_PNG: return stbi_write_png(task->path, w, h, 4, task->pixels, w * 4);
+	case IMAGE_FORMAT_TGA: return stbi_write_tga(task->path, w, h, 4, task->pixels);
+	case IMAGE_FORMAT_BMP: return stbi_write_bmp(task->path, w, h, 4, task->pixels);
+	case IMAGE_FORMAT_JPG: return stbi_write_jpg(task->path, w, h, 4, task->pixels, 90);
+	default: return false;
+	}
+}
+
+static int encoderMain(void* arg)
+{
+	Capture* capture = arg;
+
+	for (;;)
+	{
+		mutex_lock(&capture->mutex);
+		while (capture->head == NULL && !capture->quitting)
+			condvar_wait(&capture->workAvailable, &capture->mutex);
+
+		struct EncodeTask* task = capture->head;
+		if (task == NULL)
+		{
+			mutex_unlock(&capture->mutex);
+			break;
+		}
+		capture->head = task->next;
+		if (capture->head == NULL)
+			capture->tail = NULL;
+		capture->queued--;
+		condvar_signal(&capture->spaceAvailable);
+		mutex_unlock(&capture->mutex);
+
+		if (!encode(capture, task))
+		{
+			mutex_lock(&capture->mutex);
+			capture->failures++;
+			mutex_unlock(&capture->mutex);
+		}
+
+		free(task->path);
+		free(task->pixels);
+		free(task);
+	}
+	return 0;
+}
+
+static void enqueue(_Inout_ Capture* capture, _In_ struct EncodeTask* task)
+{
+	mutex_lock(&capture->mutex);
+	// Back pressure: when encoding cannot keep up, rather stall rendering than grow without bound.
+	while (capture->queued >= capture->queueLimit)
+		condvar_wait(&capture->spaceAvailable, &capture->mutex);
+
+	task->next = NULL;
+	if (capture->tail)
+		capture->tail->next = task;
+	else
+		capture->head = task;
+	capture->tail = task;
+	capture->queued++;
+
+	condvar_signal(&capture->workAvailable);
+	mutex_unlock(&capture->mutex);
+}
+
+static bool retireOldest(_Inout_ Capture* capture, _In_ bool wait)
+{
+	if (capture->retired == capture->submitted)
+		return false;
+
+	const uint32_t slot = capture->retired % CAPTURE_RING_SIZE;
+	GLenum status = glClientWaitSync(capture->fences[slot],
+		wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? UINT64_MAX : 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+		return false;
+	assert(status != GL_WAIT_FAILED);
+
+	glDeleteSync(capture->fences[slot]);
+	capture->fences[slot] = NULL;
+
+	const size_t size = (size_t)capture->width * capture->height * 4;
+	struct EncodeTask* task = calloc(1, sizeof * task);
+	int pathLength = snprintf(NULL, 0, capture->pattern, (unsigned)capture->retired);
+	if (task && pathLength >= 0 &&
+		(task->path = malloc((size_t)pathLength + 1)) &&
+		(task->pixels = malloc(size)))
+	{
+		snprintf(task->path, (size_t)pathLength + 1, capture->pattern, (unsigned)capture->retired);
+		memcpy(task->pixels, capture->mapped[slot], size);
+		enqueue(capture, task);
+	}
+	else
+	{
+		if (task)
+			free(task->path);
+		free(task);
+		// The encoders count theirs too.
+		mutex_lock(&capture->mutex);
+		capture->failures++;
+		mutex_unlock(&capture->mutex);
+	}
+
+	capture->retired++;
+	return true;
+}
+
+
+Capture* capture_create(_In_ uint32_t width, _In_ uint32_t height, _In_z_ const char* pattern, _In_ uint32_t workers)
+{
+	enum ImageFormat format;
+	if (width == 0 || height == 0 || !validatePattern(pattern) || !parseFormat(pattern, &format))
+		return NULL;
+
+	Capture* capture = calloc(1, sizeof * capture);
+	if (capture == NULL)
+		return NULL;
+
+	capture->width = width;
+	capture->height = height;
+	capture->format = format;
+	capture->pattern = malloc(strlen(pattern) + 1);
+	if (capture->pattern)
+		strcpy(capture->pattern, pattern);
+
+	glCreateRenderbuffers(2, capture->renderbuffers);
+	glNamedRenderbufferStorage(capture->renderbuffers[0], GL_RGBA8, width, height);
+	glNamedRenderbufferStorage(capture->renderbuffers[1], GL_DEPTH24_STENCIL8, width, height);
+
+	glCreateFramebuffers(1, &capture->framebuffer);
+	glNamedFramebufferRenderbuffer(capture->framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, capture->renderbuffers[0]);
+	glNamedFramebufferRenderbuffer(capture->framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, capture->renderbuffers[1]);
+	glNamedFramebufferReadBuffer(capture->framebuffer, GL_COLOR_ATTACHMENT0);
+
+	const GLbitfield storageFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT | GL_CLIENT_STORAGE_BIT;
+	const GLbitfield mapFlags = GL_MAP_READ_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const GLsizeiptr size = (GLsizeiptr)width * height * 4;
+
+	glCreateBuffers(CAPTURE_RING_SIZE, capture->pixelBuffers);
+	bool mapped = true;
+	for (uint32_t i = 0; i < CAPTURE_RING_SIZE; i++)
+	{
+		glNamedBufferStorage(capture->pixelBuffers[i], size, NULL, storageFlags);
+		capture->mapped[i] = glMapNamedBufferRange(capture->pixelBuffers[i], 0, size, mapFlags);
+		mapped = mapped && capture->mapped[i] != NULL;
+	}
+
+	if (workers == 0)
+		workers = thread_hardwareConcurrency();
+	capture->queueLimit = 2 * workers;
+
+	mutex_init(&capture->mutex);
+	condvar_init(&capture->workAvailable);
+	condvar_init(&capture->spaceAvailable);
+
+	// glReadPixels delivers the bottom row first.
+	stbi_flip_vertically_on_write(1);
+
+	capture->workers = malloc(workers * sizeof * capture->workers);
+	for (uint32_t i = 0; capture->workers && i < workers; i++)
+	{
+		if (!thread_create(&capture->workers[i], encoderMain, capture))
+			break;
+		capture->workerCount++;
+	}
+
+	bool success =
+		capture->pattern != NULL &&
+		glCheckNamedFramebufferStatus(capture->framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE &&
+		mapped &&
+		capture->workerCount != 0;
+	if (!success)
+	{
+		capture_destroy(capture);
+		return NULL;
+	}
+
+	NAME_OBJECT(GL_FRAMEBUFFER, capture->framebuffer, "Capture Framebuffer");
+	return capture;
+}
+
+GLuint capture_framebuffer(_In_ Capture* capture)
+{
+	return capture->framebuffer;
+}
+
+void capture_endFrame(_Inout_ Capture* capture)
+{
+	if (capture->submitted - capture->retired == CAPTURE_RING_SIZE)
+		retireOldest(capture, true);
+
+	const uint32_t slot = capture->submitted % CAPTURE_RING_SIZE;
+
+	GLint previousRead = 0;
+	glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &previousRead);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, capture->framebuffer);
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, capture->pixelBuffers[slot]);
+
+	glReadPixels(0, 0, capture->width, capture->height, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	capture->fences[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, previousRead);
+	glFlush();
+
+	capture->submitted++;
+
+	// Hand over whatever the GPU already finished, without waiting on the frame just queued.
+	while (retireOldest(capture, false))
+		;
+}
+
+bool capture_destroy(_In_opt_ Capture* capture)
+{
+	if (capture == NULL)
+		return true;
+
+	while (retireOldest(capture, true))
+		;
+
+	mutex_lock(&capture->mutex);
+	capture->quitting = true;
+	condvar_broadcast(&capture->workAvailable);
+	mutex_unlock(&capture->mutex);
+
+	for (uint32_t i = 0; i < capture->workerCount; i++)
+		thread_join(capture->workers[i]);
+
+	bool success = capture->failures == 0;
+
+	for (uint32_t i = 0; i < CAPTURE_RING_SIZE; i++)
+	{
+		if (capture->mapped[i])
+			glUnmapNamedBuffer(capture->pixelBuffers[i]);
+		if (capture->fences[i])
+			glDeleteSync(capture->fences[i]);
+	}
+	glDeleteBuffers(CAPTURE_RING_SIZE, capture->pixelBuffers);
+	glDeleteFramebuffers(1, &capture->framebuffer);
+	glDeleteRenderbuffers(2, capture->renderbuffers);
+
+	condvar_destroy(&capture->spaceAvailable);
+	condvar_destroy(&capture->workAvailable);
+	mutex_destroy(&capture->mutex);
+
+	free(capture->workers);
+	free(capture->pattern);
+	free(capture);
+	return success;
+}
@@ -0,0 +1,36 @@
+/**
+
+    @file      capture.h
+    @brief     Offscreen rendering with asynchronous readback to image files
+    @details   Frames are rendered into an FBO, read back into a ring of pixel
+               pack buffers guarded by fences and encoded by worker threads, so
+               neither the readback nor the encoding stalls the next frame.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+
+
+typedef struct Capture Capture;
+
+/**
+	@brief  Creates the capture framebuffer, readback ring and encoder threads.
+	@param  width   - width of the captured frames
+	@param  height  - height of the captured frames
+	@param  pattern - printf style file name taking the frame index, the extension (png, tga, bmp, jpg) selects the encoder
+	@param  workers - number of encoder threads, 0 picks one per core
+	@retval         - NULL on failure
+**/
+Capture* capture_create(_In_ uint32_t width, _In_ uint32_t height, _In_z_ const char* pattern, _In_ uint32_t workers);
+
+//framebuffer that frames to be captured must be rendered into.
+GLuint capture_framebuffer(_In_ Capture* capture);
+
+//queues readback of the current framebuffer contents and hands finished readbacks over to the encoders.
+void capture_endFrame(_Inout_ Capture* capture);
+
+//waits for all outstanding readbacks and encodes, then releases everything. Returns false if any file failed to write.
+bool capture_destroy(_In_opt_ Capture* capture);
\ No newline at end of file
@@ -0,0 +1,593 @@
+/**
+
+    @file      compilequeue.c
+    @brief     Asynchronous shader preprocessing, compilation and linking
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "platform/Threads.h"
+#include "compilequeue.h"
+
+#include <string.h>
+
+
+// Preprocessing is mostly file IO, a few threads are plenty.
+#define COMPILE_DEFAULT_WORKERS 4
+
+enum RequestState
+{
+	REQUEST_QUEUED,			// waiting for a worker
+	REQUEST_PREPROCESSED,	// sources resolved, waiting for the GL thread
+	REQUEST_COMPILING,		// handed to the driver
+	REQUEST_READY,
+	REQUEST_FAILED,
+};
+
+struct CompileStage
+{
+	GLenum type;
+	char* path;
+	char* source;
+	char* defines;
+	GLuint shader;
+};
+
+struct ProgramRequest
+{
+	struct ProgramRequest* next;		// every request of the queue
+	struct ProgramRequest* nextWork;	// requests waiting for a worker
+	char* name;
+	uint32_t stageCount;
+	struct CompileStage stages[COMPILE_MAX_STAGES];
+	bool separable;
+	volatile int64_t state;				// enum RequestState, atomic as the GL thread polls it while workers preprocess
+	uint64_t key;
+	GLuint program;
+};
+
+struct CompileQueue
+{
+	ProgramCache* cache;
+	IncludeCache* includes;
+	bool parallel;
+
+	Mutex mutex;
+	CondVar workAvailable;
+	CondVar preprocessed;
+	struct ProgramRequest* head;
+	struct ProgramRequest* tail;
+	bool quitting;
+
+	struct ProgramRequest* requests;
+
+	uint32_t workerCount;
+	Thread* workers;
+};
+
+
+static enum RequestState loadState(_In_ const struct ProgramRequest* request)
+{
+	return (enum RequestState)atomic_load64(&request->state);
+}
+
+static void storeState(_Inout_ struct ProgramRequest* request, _In_ enum RequestState state)
+{
+	atomic_store64(&request->state, state);
+}
+
+static char* duplicate(_In_opt_z_ const char* s)
+{
+	if (s == NULL)
+		return NULL;
+	char* copy = malloc(strlen(s) + 1);
+	if (copy)
+		strcpy(copy, s);
+	return copy;
+}
+
+static char* injectDefines(_In_z_ char* source, _In_z_ const char* defines)
+//
+// GLSL wants #version before anything else, so the defines go on the line after it.
+//
+{
+	const char* version = strstr(source, "#version");
+	const char* split = version ? strchr(version, '\n') : NULL;
+	size_t head = split ? (size_t)(split + 1 - source) : 0;
+	size_t definesLength = strlen(defines);
+	size_t tailLength = strlen(source + head);
+
+	char* result = malloc(head + definesLength + tailLength + 1);
+	if (result)
+	{
+		memcpy(result, source, head);
+		memcpy(result + head, defines, definesLength);
+		memcpy(result + head + definesLength, source + head, tailLength + 1);
+	}
+	free(source);
+	return result;
+}
+
+static char* resolveStage(_In_ CompileQueue* queue, _In_ const struct CompileStage* stage)
+{
+	char error[256];
+	char* source = includecache_resolve(queue->includes, stage->path, error);
+	if (source == NULL)
+	{
+		// Not on the GL thread, so no glDebugMessageInsert here.
+		OutputDebugStringA(error);
+		OutputDebugStringA("\n");
+	}
+	else if (stage->defines)
+		source = injectDefines(source, stage->defines);
+	return source;
+}
+
+static void preprocess(_Inout_ CompileQueue* queue, _Inout_ struct ProgramRequest* request)
+{
+	for (uint32_t i = 0; i < request->stageCount; i++)
+	{
+		struct CompileStage* stage = &request->stages[i];
+		if (stage->path)
+			stage->source = resolveStage(queue, stage);
+		// else an inline source, copied at submission
+		else if (stage->source && stage->defines)
+			stage->source = injectDefines(stage->source, stage->defines);
+	}
+}
+
+static int preprocessWorker(void* arg)
+{
+	CompileQueue* queue = arg;
+
+	mutex_lock(&queue->mutex);
+	for (;;)
+	{
+		while (queue->head == NULL && !queue->quitting)
+			condvar_wait(&queue->workAvailable, &queue->mutex);
+		if (queue->quitting)
+			break;
+
+		struct ProgramRequest* request = queue->head;
+		queue->head = request->nextWork;
+		if (queue->head == NULL)
+			queue->tail = NULL;
+		mutex_unlock(&queue->mutex);
+
+		preprocess(queue, request);
+
+		mutex_lock(&queue->mutex);
+		storeState(request, REQUEST_PREPROCESSED);
+		condvar_broadcast(&queue->preprocessed);
+	}
+	mutex_unlock(&queue->mutex);
+	return 0;
+}
+
+static void freeSources(_Inout_ struct ProgramRequest* request)
+{
+	for (uint32_t i = 0; i < request->stageCount; i++)
+	{
+		free(request->stages[i].source);
+		request->stages[i].source = NULL;
+	}
+}
+
+static void deleteShaders(_Inout_ struct ProgramRequest* request)
+{
+	for (uint32_t i = 0; i < request->stageCount; i++)
+	{
+		if (request->stages[i].shader == 0)
+			continue;
+		glDetachShader(request->program, request->stages[i].shader);
+		glDeleteShader(request->stages[i].shader);
+		request->stages[i].shader = 0;
+	}
+}
+
+static void printInfoLog(_In_ GLuint object, _In_ bool isProgram)
+{
+	GLint len = 0;
+	if (isProgram)
+		glGetProgramiv(object, GL_INFO_LOG_LENGTH, &len);
+	else
+		glGetShaderiv(object, GL_INFO_LOG_LENGTH, &len);
+	if (len <= 1)
+		return;
+
+	char* msg = malloc(len * sizeof * msg);
+	if (msg == NULL)
+		return;
+	if (isProgram)
+		glGetProgramInfoLog(object, len, NULL, msg);
+	else
+		glGetShaderInfoLog(object, len, NULL, msg);
+	OutputDebugStringA(msg);
+	free(msg);
+}
+
+static uint64_t programKey(_In_ const CompileQueue* queue, _In_ const struct ProgramRequest* request, _In_reads_(request->stageCount) const char* const* sources)
+{
+	// The sources alone don't tell a separable program from a monolithic one.
+	uint64_t key = programcache_key(queue->cache, request->stageCount, sources);
+	if (request->separable)
+		key ^= 0x9E3779B97F4A7C15ull;
+	return key;
+}
+
+static void submitProgram(_Inout_ CompileQueue* queue, _Inout_ struct ProgramRequest* request)
+{
+	const char* sources[COMPILE_MAX_STAGES];
+	for (uint32_t i = 0; i < request->stageCount; i++)
+	{
+		sources[i] = request->stages[i].source;
+		if (sources[i] == NULL)
+		{
+			freeSources(request);
+			storeState(request, REQUEST_FAILED);
+			return;
+		}
+	}
+
+	request->program = glCreateProgram();
+	NAME_OBJECT(GL_PROGRAM, request->program, request->name);
+
+	request->key = programKey(queue, request, sources);
+
+	glProgramParameteri(request->program, GL_PROGRAM_SEPARABLE, request->separable);
+	if (programcache_load(queue->cache, request->key, request->program))
+	{
+		freeSources(request);
+		storeState(request, REQUEST_READY);
+		return;
+	}
+
+	// With parallel compilation none of these block, the driver works on them in the background.
+	for (uint32_t i = 0; i < request->stageCount; i++)
+	{
+		struct CompileStage* stage = &request->stages[i];
+		stage->shader = glCreateShader(stage->type);
+		NAME_OBJECT(GL_SHADER, stage->shader, stage->path ? stage->path : request->name);
+		glShaderSource(stage->shader, 1, &sources[i], NULL);
+		glCompileShader(stage->shader);
+		glAttachShader(request->program, stage->shader);
+	}
+	freeSources(request);
+
+	glProgramParameteri(request->program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+	glLinkProgram(request->program);
+	storeState(request, REQUEST_COMPILING);
+}
+
+static void collectProgram(_Inout_ CompileQueue* queue, _Inout_ struct ProgramRequest* request, _In_ bool wait)
+{
+	if (!wait && queue->parallel)
+	{
+		GLint isComplete = false;
+		glGetProgramiv(request->program, GL_COMPLETION_STATUS_KHR, &isComplete);
+		if (!isComplete)
+			return;
+	}
+
+	GLint isLinked = false;
+	glGetProgramiv(request->program, GL_LINK_STATUS, &isLinked);
+	if (!isLinked)
+	{
+		for (uint32_t i = 0; i < request->stageCount; i++)
+			printInfoLog(request->stages[i].shader, false);
+		printInfoLog(request->program, true);
+	}
+
+	// Always delete after linkage
+	deleteShaders(request);
+
+	if (isLinked)
+	{
+		programcache_store(queue->cache, request->key, request->program);
+		storeState(request, REQUEST_READY);
+	}
+	else
+	{
+		glDeleteProgram(request->program);
+		request->program = 0;
+		storeState(request, REQUEST_FAILED);
+	}
+}
+
+static void freeRequest(_In_ struct ProgramRequest* request)
+{
+	deleteShaders(request);
+	if (request->program)
+		glDeleteProgram(request->program);
+	for (uint32_t i = 0; i < request->stageCount; i++)
+	{
+		free(request->stages[i].path);
+		free(request->stages[i].source);
+		free(request->stages[i].defines);
+	}
+	free(request->name);
+	free(request);
+}
+
+
+CompileQueue* compilequeue_create(_In_opt_ ProgramCache* cache, _In_ IncludeCache* includes, _In_ uint32_t workers)
+{
+	CompileQueue* queue = calloc(1, sizeof * queue);
+	if (queue == NULL)
+		return NULL;
+
+	queue->cache = cache;
+	queue->includes = includes;
+
+	if (GLAD_GL_KHR_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsKHR(0xFFFFFFFF); // let the driver decide
+		queue->parallel = true;
+	}
+	else if (GLAD_GL_ARB_parallel_shader_compile)
+	{
+		glMaxShaderCompilerThreadsARB(0xFFFFFFFF);
+		queue->parallel = true;
+	}
+
+	mutex_init(&queue->mutex);
+	condvar_init(&queue->workAvailable);
+	condvar_init(&queue->preprocessed);
+
+	if (workers == 0)
+	{
+		workers = thread_hardwareConcurrency();
+		if (workers > COMPILE_DEFAULT_WORKERS)
+			workers = COMPILE_DEFAULT_WORKERS;
+	}
+	queue->workerCount = workers;
+	queue->workers = calloc(queue->workerCount, sizeof * queue->workers);
+	if (queue->workers == NULL)
+	{
+		queue->workerCount = 0;
+		compilequeue_destroy(queue);
+		return NULL;
+	}
+	for (uint32_t i = 0; i < queue->workerCount; i++)
+	{
+		if (!thread_create(&queue->workers[i], preprocessWorker, queue))
+		{
+			queue->workerCount = i;
+			compilequeue_destroy(queue);
+			return NULL;
+		}
+	}
+
+	return queue;
+}
+
+void compilequeue_destroy(_In_opt_ CompileQueue* queue)
+{
+	if (queue == NULL)
+		return;
+
+	mutex_lock(&queue->mutex);
+	queue->quitting = true;
+	condvar_broadcast(&queue->workAvailable);
+	mutex_unlock(&queue->mutex);
+
+	for (uint32_t i = 0; i < queue->workerCount; i++)
+		thread_join(queue->workers[i]);
+	free(queue->workers);
+
+	while (queue->requests)
+	{
+		struct ProgramRequest* next = queue->requests->next;
+		freeRequest(queue->requests);
+		queue->requests = next;
+	}
+
+	condvar_destroy(&queue->preprocessed);
+	condvar_destroy(&queue->workAvailable);
+	mutex_destroy(&queue->mutex);
+	free(queue);
+}
+
+ProgramRequest* compilequeue_submit(_Inout_ CompileQueue* queue, _In_z_ const char* name, _In_ uint32_t count, _In_reads_(count) const struct ShaderStage* stages, _In_ bool separable)
+{
+	if (count == 0 || count > COMPILE_MAX_STAGES)
+		return NULL;
+
+	struct ProgramRequest* request = calloc(1, sizeof * request);
+	if (request == NULL)
+		return NULL;
+
+	request->name = duplicate(name);
+	request->stageCount = count;
+	request->separable = separable;
+	bool success = request->name != NULL;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		struct CompileStage* stage = &request->stages[i];
+		stage->type = stages[i].type;
+		if (stages[i].path)
+		{
+			stage->path = duplicate(stages[i].path);
+			success = success && stage->path != NULL;
+		}
+		else
+		{
+			stage->source = duplicate(stages[i].source);
+			success = success && stage->source != NULL;
+		}
+		if (stages[i].defines)
+		{
+			stage->defines = duplicate(stages[i].defines);
+			success = success && stage->defines != NULL;
+		}
+	}
+	if (!success)
+	{
+		freeRequest(request);
+		return NULL;
+	}
+
+	request->next = queue->requests;
+	queue->requests = request;
+
+	mutex_lock(&queue->mutex);
+	storeState(request, REQUEST_QUEUED);
+	if (queue->tail)
+		queue->tail->nextWork = request;
+	else
+		queue->head = request;
+	queue->tail = request;
+	condvar_signal(&queue->workAvailable);
+	mutex_unlock(&queue->mutex);
+
+	return request;
+}
+
+void compilequeue_poll(_Inout_ CompileQueue* queue)
+{
+	for (struct ProgramRequest* request = queue->requests; request; request = request->next)
+	{
+		enum RequestState state = loadState(request);
+		if (state == REQUEST_PREPROCESSED)
+		{
+			submitProgram(queue, request);
+			state = loadState(request);
+		}
+		if (state == REQUEST_COMPILING)
+			collectProgram(queue, request, false);
+	}
+}
+
+bool compilequeue_finish(_Inout_ CompileQueue* queue)
+{
+	// Hand everything to the driver first so the links still overlap each other.
+	for (struct ProgramRequest* request = queue->requests; request; request = request->next)
+	{
+		mutex_lock(&queue->mutex);
+		while (loadState(request) == REQUEST_QUEUED)
+			condvar_wait(&queue->preprocessed, &queue->mutex);
+		mutex_unlock(&queue->mutex);
+
+		if (loadState(request) == REQUEST_PREPROCESSED)
+			submitProgram(queue, request);
+	}
+
+	bool success = true;
+	for (struct ProgramRequest* request = queue->requests; request; request = request->next)
+	{
+		if (loadState(request) == REQUEST_COMPILING)
+			collectProgram(queue, request, true);
+		success = success && loadState(request) == REQUEST_READY;
+	}
+	return success;
+}
+
+enum ProgramState compilequeue_state(_In_ const ProgramRequest* request)
+{
+	// Workers only ever move a request between the two pending states, ready and failed are set by the GL thread.
+	// The load is atomic as a worker may be storing preprocessed right now.
+	switch (loadState(request))
+	{
+	case REQUEST_READY:		return PROGRAM_READY;
+	case REQUEST_FAILED:	return PROGRAM_FAILED;
+	default:				return PROGRAM_PENDING;
+	}
+}
+
+GLuint compilequeue_program(_In_opt_ const ProgramRequest* request, _In_ GLuint fallback)
+{
+	if (request == NULL || loadState(request) != REQUEST_READY)
+		return fallback;
+	return request->program;
+}
+
+void compilequeue_forEachUser(_In_ CompileQueue* queue, _In_z_ const char* path, _In_ ProgramRequestProc proc, _In_opt_ void* user)
+{
+	for (struct ProgramRequest* request = queue->requests; request; request = request->next)
+	{
+		for (uint32_t i = 0; i < request->stageCount; i++)
+		{
+			if (request->stages[i].path && strcmp(request->stages[i].path, path) == 0)
+			{
+				proc(request, user);
+				break;
+			}
+		}
+	}
+}
+
+GLuint compilequeue_build(_In_ CompileQueue* queue, _In_ const ProgramRequest* request)
+{
+	char* sources[COMPILE_MAX_STAGES] = { NULL };
+	bool success = true;
+	for (uint32_t i = 0; success && i < request->stageCount; i++)
+	{
+		// Inline sources are gone once submitted, there is nothing to rebuild them from.
+		success = request->stages[i].path != NULL
+			&& (sources[i] = resolveStage(queue, &request->stages[i])) != NULL;
+	}
+
+	GLuint program = 0;
+	if (success)
+	{
+		program = glCreateProgram();
+		NAME_OBJECT(GL_PROGRAM, program, request->name);
+		glProgramParameteri(program, GL_PROGRAM_SEPARABLE, request->separable);
+
+		uint64_t key = programKey(queue, request, (const char* const*)sources);
+		if (!programcache_load(queue->cache, key, program))
+		{
+			GLuint shaders[COMPILE_MAX_STAGES] = { 0 };
+			for (uint32_t i = 0; i < request->stageCount; i++)
+			{
+				shaders[i] = glCreateShader(request->stages[i].type);
+				NAME_OBJECT(GL_SHADER, shaders[i], request->stages[i].path);
+				glShaderSource(shaders[i], 1, (const char* const*)&sources[i], NULL);
+				glCompileShader(shaders[i]);
+				glAttachShader(program, shaders[i]);
+			}
+			glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+			glLinkProgram(program);
+
+			GLint isLinked = false;
+			glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+			if (!isLinked)
+			{
+				for (uint32_t i = 0; i < request->stageCount; i++)
+					printInfoLog(shaders[i], false);
+				printInfoLog(program, true);
+			}
+
+			for (uint32_t i = 0; i < request->stageCount; i++)
+			{
+				glDetachShader(program, shaders[i]);
+				glDeleteShader(shaders[i]);
+			}
+
+			if (isLinked)
+				programcache_store(queue->cache, key, program);
+			else
+			{
+				glDeleteProgram(program);
+				program = 0;
+			}
+		}
+	}
+
+	for (uint32_t i = 0; i < request->stageCount; i++)
+		free(sources[i]);
+	return program;
+}
+
+void compilequeue_replace(_Inout_ CompileQueue* queue, _Inout_ ProgramRequest* request, _In_ GLuint program)
+{
+	(void)queue;
+	assert(loadState(request) == REQUEST_READY || loadState(request) == REQUEST_FAILED);
+
+	if (request->program)
+		glDeleteProgram(request->program);
+	request->program = program;
+	storeState(request, REQUEST_READY);
+}
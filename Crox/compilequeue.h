@@ -0,0 +1,87 @@
+/**
+
+    @file      compilequeue.h
+    @brief     Asynchronous shader preprocessing, compilation and linking
+    @details   Includes are resolved by worker threads, compiling and linking is
+               handed to the driver up front and only polled for completion
+               (KHR_parallel_shader_compile), so startup work overlaps with
+               rendering instead of stalling it. Programs are looked up in the
+               program cache before anything is compiled.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "programcache.h"
+#include "includecache.h"
+
+
+#define COMPILE_MAX_STAGES 6
+
+typedef struct CompileQueue CompileQueue;
+typedef struct ProgramRequest ProgramRequest;
+
+typedef void (*ProgramRequestProc)(_In_ ProgramRequest* request, _In_opt_ void* user);
+
+enum ProgramState
+{
+	PROGRAM_PENDING,
+	PROGRAM_READY,
+	PROGRAM_FAILED,
+};
+
+struct ShaderStage
+{
+	GLenum type;
+	_In_opt_z_ const char* path;	// file to preprocess through the include cache
+	_In_opt_z_ const char* source;	// used verbatim when there is no path
+	_In_opt_z_ const char* defines;	// lines inserted right after #version, e.g. "#define SKINNED 1\n"
+};
+
+/**
+	@brief  Starts the preprocessing workers and enables parallel compilation in the driver when available.
+	@param  cache    - optional, consulted before compiling and filled after linking. Must outlive the queue.
+	@param  includes - resolves the #includes of every stage read from a file. Must outlive the queue.
+	@param  workers  - number of preprocessing threads, 0 picks one per core up to a small limit
+	@retval         - NULL on failure
+**/
+CompileQueue* compilequeue_create(_In_opt_ ProgramCache* cache, _In_ IncludeCache* includes, _In_ uint32_t workers);
+
+//joins the workers and deletes every program the queue created.
+void compilequeue_destroy(_In_opt_ CompileQueue* queue);
+
+/**
+	@brief  Queues a program for preprocessing, the GL side is issued by a later poll.
+	@param  name   - debug label of the program
+	@param  count  - number of stages, at most COMPILE_MAX_STAGES
+	@param  stages    - shader stages in pipeline order, all strings are copied
+	@param  separable - link with GL_PROGRAM_SEPARABLE so it can be bound to a program pipeline
+	@retval           - handle owned by the queue, NULL on failure
+**/
+ProgramRequest* compilequeue_submit(_Inout_ CompileQueue* queue, _In_z_ const char* name, _In_ uint32_t count, _In_reads_(count) const struct ShaderStage* stages, _In_ bool separable);
+
+//issues compiles for preprocessed requests and collects finished links, never blocks when parallel compilation is supported. Call from the GL thread.
+void compilequeue_poll(_Inout_ CompileQueue* queue);
+
+//blocks until every submitted request is ready or failed. Returns false if any failed.
+bool compilequeue_finish(_Inout_ CompileQueue* queue);
+
+enum ProgramState compilequeue_state(_In_ const ProgramRequest* request);
+
+//the linked program once ready, fallback until then or if it failed.
+GLuint compilequeue_program(_In_opt_ const ProgramRequest* request, _In_ GLuint fallback);
+
+//calls proc for every request with a stage read from path. Call from the GL thread.
+void compilequeue_forEachUser(_In_ CompileQueue* queue, _In_z_ const char* path, _In_ ProgramRequestProc proc, _In_opt_ void* user);
+
+/**
+	@brief  Compiles and links a request again from its files, blocking, on whatever context is current.
+	@details Only reads what a request never changes after submission, so it may run on a thread with a shared context while the GL thread keeps polling.
+	@retval - a new program, 0 if it failed or the request has inline stages
+**/
+GLuint compilequeue_build(_In_ CompileQueue* queue, _In_ const ProgramRequest* request);
+
+//swaps in a program made by compilequeue_build and deletes the old one. Only for requests that are no longer pending, call from the GL thread.
+void compilequeue_replace(_Inout_ CompileQueue* queue, _Inout_ ProgramRequest* request, _In_ GLuint program);
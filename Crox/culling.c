@@ -0,0 +1,237 @@
+/**
+
+    @file      culling.c
+    @brief     GPU frustum and hierarchical-Z occlusion culling
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "culling.h"
+
+#include <string.h>
+#include <math.h>
+
+
+// Must match local_size in cull.comp and hiz.comp.
+#define CULL_GROUP_SIZE		64
+#define PYRAMID_GROUP_SIZE	8
+
+// Explicit uniform locations of cull.comp.
+#define CULL_INSTANCE_COUNT		0
+#define CULL_INSTANCE_BASE		1
+#define CULL_FRUSTUM			2
+#define CULL_HAS_PYRAMID		8
+#define CULL_PYRAMID_VIEW_PROJ	9
+
+#define PYRAMID_SOURCE_LEVEL	0
+
+struct Culler
+{
+	ProgramRequest* cull;
+	ProgramRequest* pyramidBuild;
+	bool compact;					// indirect parameters, visible instances are packed and counted on the GPU
+	uint32_t capacity;
+
+	GLuint commands;				// written by the GPU only
+	GLuint drawCount;
+	uint32_t dispatched;			// instances of the last dispatch, the upper bound for the draw
+
+	GLuint pyramid;
+	uint32_t pyramidWidth;
+	uint32_t pyramidHeight;
+	uint32_t pyramidLevels;
+	bool hasPyramid;
+	float pyramidViewProj[16];
+};
+
+
+static void extractFrustum(_In_reads_(16) const float* m, _Out_writes_(24) float* planes)
+//
+// Gribb and Hartmann, the planes are sums and differences of the matrix rows.
+//
+{
+	for (uint32_t i = 0; i < 6; i++)
+	{
+		const uint32_t row = i / 2;
+		const float sign = i % 2 ? -1.0f : 1.0f;
+		float* plane = planes + i * 4;
+		for (uint32_t column = 0; column < 4; column++)
+			plane[column] = m[column * 4 + 3] + sign * m[column * 4 + row];
+
+		// Normalized so the distance compares against the radius directly.
+		float length = sqrtf(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+		if (length > 0.0f)
+			for (uint32_t j = 0; j < 4; j++)
+				plane[j] /= length;
+	}
+}
+
+static GLuint dispatchGroups(_In_ uint32_t size, _In_ uint32_t group)
+{
+	return (size + group - 1) / group;
+}
+
+
+Culler* culling_create(_Inout_ CompileQueue* queue, _In_ uint32_t capacity)
+{
+	Culler* culler = calloc(1, sizeof * culler);
+	if (culler == NULL)
+		return NULL;
+
+	culler->capacity = capacity;
+	culler->compact = GLAD_GL_VERSION_4_6 || GLAD_GL_ARB_indirect_parameters;
+
+	culler->cull = compilequeue_submit(queue, "Cull", 1, &(struct ShaderStage){
+		.type = GL_COMPUTE_SHADER,
+		.path = "cull.comp",
+		.defines = culler->compact ? "#define COMPACT 1\n" : NULL,
+	}, false);
+	culler->pyramidBuild = compilequeue_submit(queue, "Hi-Z Pyramid", 1, &(struct ShaderStage){
+		.type = GL_COMPUTE_SHADER,
+		.path = "hiz.comp",
+	}, false);
+	if (culler->cull == NULL || culler->pyramidBuild == NULL)
+	{
+		// Requests belong to the queue, nothing to release for them.
+		free(culler);
+		return NULL;
+	}
+
+	glCreateBuffers(1, &culler->commands);
+	NAME_OBJECT(GL_BUFFER, culler->commands, "Culled Commands");
+	glNamedBufferStorage(culler->commands, (GLsizeiptr)capacity * 5 * sizeof(GLuint), NULL, 0);
+	glCreateBuffers(1, &culler->drawCount);
+	NAME_OBJECT(GL_BUFFER, culler->drawCount, "Culled Draw Count");
+	glNamedBufferStorage(culler->drawCount, sizeof(GLuint), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+	return culler;
+}
+
+void culling_destroy(_In_opt_ Culler* culler)
+{
+	if (culler == NULL)
+		return;
+	glDeleteBuffers(1, &culler->commands);
+	glDeleteBuffers(1, &culler->drawCount);
+	if (culler->pyramid)
+		glDeleteTextures(1, &culler->pyramid);
+	free(culler);
+}
+
+bool culling_isReady(_In_opt_ const Culler* culler)
+{
+	return culler
+		&& compilequeue_state(culler->cull) == PROGRAM_READY
+		&& compilequeue_state(culler->pyramidBuild) == PROGRAM_READY;
+}
+
+bool culling_dispatch(_Inout_opt_ Culler* culler, _In_reads_(16) const float* viewProj,
+	_In_ const struct StreamAllocation* instances, _In_ uint32_t instanceCount,
+	_In_ const struct StreamAllocation* meshes)
+{
+	if (!culling_isReady(culler))
+		return false;
+	culler->dispatched = 0;
+	if (instanceCount > culler->capacity)
+		return false;
+	if (instanceCount == 0)
+		return true;
+	assert(instances->offset % sizeof(struct CullInstance) == 0);
+
+	float frustum[24];
+	extractFrustum(viewProj, frustum);
+
+	GLuint program = compilequeue_program(culler->cull, 0);
+	glUseProgram(program);
+	glProgramUniform1ui(program, CULL_INSTANCE_COUNT, instanceCount);
+	glProgramUniform1ui(program, CULL_INSTANCE_BASE, (GLuint)(instances->offset / sizeof(struct CullInstance)));
+	glProgramUniform4fv(program, CULL_FRUSTUM, 6, frustum);
+	glProgramUniform1i(program, CULL_HAS_PYRAMID, culler->hasPyramid);
+	glProgramUniformMatrix4fv(program, CULL_PYRAMID_VIEW_PROJ, 1, GL_FALSE, culler->pyramidViewProj);
+	if (culler->hasPyramid)
+		glBindTextureUnit(0, culler->pyramid);
+
+	glClearNamedBufferSubData(culler->drawCount, GL_R32UI, 0, sizeof(GLuint), GL_RED_INTEGER, GL_UNSIGNED_INT, NULL);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 0, instances->buffer, instances->offset, instances->size);
+	glBindBufferRange(GL_SHADER_STORAGE_BUFFER, 1, meshes->buffer, meshes->offset, meshes->size);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 2, culler->commands);
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, 3, culler->drawCount);
+
+	glDispatchCompute(dispatchGroups(instanceCount, CULL_GROUP_SIZE), 1, 1);
+
+	culler->dispatched = instanceCount;
+	return true;
+}
+
+GLuint culling_commands(_In_opt_ const Culler* culler)
+{
+	return culler ? culler->commands : 0;
+}
+
+void culling_draw(_In_ const Culler* culler, _In_ GLenum mode, _In_ GLenum indexType)
+{
+	if (culler->dispatched == 0)
+		return;
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, culler->commands);
+	if (culler->compact)
+	{
+		glBindBuffer(GL_PARAMETER_BUFFER, culler->drawCount);
+		if (GLAD_GL_VERSION_4_6)
+			glMultiDrawElementsIndirectCount(mode, indexType, NULL, 0, (GLsizei)culler->dispatched, 0);
+		else
+			glMultiDrawElementsIndirectCountARB(mode, indexType, NULL, 0, (GLsizei)culler->dispatched, 0);
+		glBindBuffer(GL_PARAMETER_BUFFER, 0);
+	}
+	else
+		glMultiDrawElementsIndirect(mode, indexType, NULL, (GLsizei)culler->dispatched, 0);
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+}
+
+void culling_buildPyramid(_Inout_ Culler* culler, _In_ GLuint depth, _In_ uint32_t width, _In_ uint32_t height, _In_reads_(16) const float* viewProj)
+{
+	if (!culling_isReady(culler) || width == 0 || height == 0)
+		return;
+
+	if (culler->pyramid == 0 || culler->pyramidWidth != width || culler->pyramidHeight != height)
+	{
+		if (culler->pyramid)
+			glDeleteTextures(1, &culler->pyramid);
+
+		uint32_t levels = 1;
+		for (uint32_t size = width > height ? width : height; size > 1; size /= 2)
+			levels++;
+
+		glCreateTextures(GL_TEXTURE_2D, 1, &culler->pyramid);
+		NAME_OBJECT(GL_TEXTURE, culler->pyramid, "Hi-Z Pyramid");
+		glTextureStorage2D(culler->pyramid, levels, GL_R32F, width, height);
+		glTextureParameteri(culler->pyramid, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_NEAREST);
+		glTextureParameteri(culler->pyramid, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+		culler->pyramidWidth = width;
+		culler->pyramidHeight = height;
+		culler->pyramidLevels = levels;
+	}
+
+	GLuint program = compilequeue_program(culler->pyramidBuild, 0);
+	glUseProgram(program);
+
+	// Level 0 straight from the depth buffer, every further level from the one above it.
+	uint32_t levelWidth = width, levelHeight = height;
+	for (uint32_t level = 0; level < culler->pyramidLevels; level++)
+	{
+		glProgramUniform1i(program, PYRAMID_SOURCE_LEVEL, (GLint)level - 1);
+		glBindTextureUnit(0, level == 0 ? depth : culler->pyramid);
+		glBindImageTexture(0, culler->pyramid, level, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+		glDispatchCompute(dispatchGroups(levelWidth, PYRAMID_GROUP_SIZE), dispatchGroups(levelHeight, PYRAMID_GROUP_SIZE), 1);
+		glMemoryBarrier(GL_TEXTURE_FETCH_BARRIER_BIT);
+
+		levelWidth = levelWidth > 1 ? levelWidth / 2 : 1;
+		levelHeight = levelHeight > 1 ? levelHeight / 2 : 1;
+	}
+	glBindImageTexture(0, 0, 0, GL_FALSE, 0, GL_WRITE_ONLY, GL_R32F);
+
+	memcpy(culler->pyramidViewProj, viewProj, sizeof culler->pyramidViewProj);
+	culler->hasPyramid = true;
+}
@@ -0,0 +1,77 @@
+/**
+
+    @file      culling.h
+    @brief     GPU frustum and hierarchical-Z occlusion culling
+    @details   A compute pass tests every instance's bounding sphere against the
+               view frustum and against a depth pyramid built from the previous
+               frame, then writes one indirect command per visible instance.
+               With indirect parameters the survivors are compacted and counted
+               on the GPU, the CPU never learns or waits for what is visible.
+               Occlusion is only tested once a pyramid has been built.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "compilequeue.h"
+#include "streambuffer.h"
+
+
+// std430 layout shared with cull.comp.
+struct CullInstance
+{
+	float sphere[4];		// world space center and radius
+	uint32_t mesh;			// index into the meshes of the dispatch
+	uint32_t material;		// not read by culling, for the vertex shader
+	uint32_t padding[2];
+};
+
+// The parts of a DrawElementsIndirectCommand that come from the mesh, std430.
+struct CullMesh
+{
+	GLuint count;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint padding;
+};
+
+typedef struct Culler Culler;
+
+/**
+	@brief  Submits the culling and pyramid programs, cull.comp and hiz.comp.
+	@param  capacity - most instances a single dispatch can cull
+	@retval          - NULL on failure
+**/
+Culler* culling_create(_Inout_ CompileQueue* queue, _In_ uint32_t capacity);
+
+void culling_destroy(_In_opt_ Culler* culler);
+
+//false until both programs have linked, the caller draws everything unculled meanwhile.
+bool culling_isReady(_In_opt_ const Culler* culler);
+
+/**
+	@brief  Culls instances into the culler's indirect buffer.
+	@param  viewProj  - column major, the frustum to test against
+	@param  instances - CullInstances allocated with streambuffer_allocateStorage, their index in the buffer becomes the base instance
+	@param  meshes    - CullMeshes, storage aligned as well
+	@retval           - false if there is no culler, it isn't ready or over capacity. Nothing was dispatched then.
+**/
+bool culling_dispatch(_Inout_opt_ Culler* culler, _In_reads_(16) const float* viewProj,
+	_In_ const struct StreamAllocation* instances, _In_ uint32_t instanceCount,
+	_In_ const struct StreamAllocation* meshes);
+
+//the indirect buffer dispatches write, 0 without a culler. The draw count lives next to it and is covered by the same barrier.
+GLuint culling_commands(_In_opt_ const Culler* culler);
+
+//draws what the last dispatch let through with the bound program and vertex array.
+//The dispatch's writes need a GL_COMMAND_BARRIER_BIT in between, which the render graph inserts for an indirect read.
+void culling_draw(_In_ const Culler* culler, _In_ GLenum mode, _In_ GLenum indexType);
+
+/**
+	@brief  Builds the depth pyramid the next dispatches test occlusion against.
+	@param  depth    - depth texture of the frame just rendered
+	@param  viewProj - column major, the view that frame was rendered with
+**/
+void culling_buildPyramid(_Inout_ Culler* culler, _In_ GLuint depth, _In_ uint32_t width, _In_ uint32_t height, _In_reads_(16) const float* viewProj);
@@ -1,10 +1,13 @@
-#version 460 core
+#version 450 core
+#include "materials.glsl"
 
 layout(location = 0) out vec4 fragColor;
 
 in vec3 color;
+in vec2 uv;
+flat in uint material;
 
 void main()
 {
-	fragColor = vec4(color, 1.0f);
+	fragColor = vec4(color, 1.0f) * material_albedo(material, uv);
 }
\ No newline at end of file
@@ -1,11 +1,20 @@
-#version 460 core
+#version 450 core
 
 layout(location = 0) in vec2 aPos;
 layout(location = 1) in vec3 aRGB;
+layout(location = 2) in vec2 aOffset;	// per instance, (0, 0) when not bound
+layout(location = 3) in vec2 aUV;		// (0, 0) when not bound
+layout(location = 4) in uint aMaterial;	// per instance, 0 when not bound
+
+layout(location = 0) uniform mat4 viewProj;
 
 out vec3 color;
+out vec2 uv;
+flat out uint material;
 
 void main(){
-	gl_Position = vec4(aPos, 0, 1.0f);
+	gl_Position = viewProj * vec4(aPos + aOffset, 0, 1.0f);
 	color = aRGB;
+	uv = aUV;
+	material = aMaterial;
 }
\ No newline at end of file
@@ -0,0 +1,135 @@
+/**
+
+    @file      drawbatch.c
+    @brief     Sorted multi-draw-indirect submission
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "drawbatch.h"
+
+#include <string.h>
+
+
+struct DrawEntry
+{
+	struct DrawKey key;
+	uint32_t index;			// into commands, keeps the sort stable
+};
+
+struct DrawBatch
+{
+	struct DrawEntry* entries;
+	DrawElementsIndirectCommand* commands;
+	uint32_t count;
+	uint32_t capacity;
+};
+
+
+static int compareKey(_In_ const struct DrawKey* a, _In_ const struct DrawKey* b)
+{
+	if (a->program != b->program)		return a->program < b->program ? -1 : 1;
+	if (a->material != b->material)		return a->material < b->material ? -1 : 1;
+	if (a->vao != b->vao)				return a->vao < b->vao ? -1 : 1;
+	if (a->mode != b->mode)				return a->mode < b->mode ? -1 : 1;
+	if (a->indexType != b->indexType)	return a->indexType < b->indexType ? -1 : 1;
+	return 0;
+}
+
+static int compareEntry(const void* a, const void* b)
+{
+	const struct DrawEntry* x = a, * y = b;
+	int order = compareKey(&x->key, &y->key);
+	if (order != 0)
+		return order;
+	// qsort isn't stable, submission order breaks ties so overlapping draws keep their order.
+	return x->index < y->index ? -1 : x->index > y->index;
+}
+
+
+DrawBatch* drawbatch_create(void)
+{
+	return calloc(1, sizeof(DrawBatch));
+}
+
+void drawbatch_destroy(_In_opt_ DrawBatch* batch)
+{
+	if (batch == NULL)
+		return;
+	free(batch->entries);
+	free(batch->commands);
+	free(batch);
+}
+
+bool drawbatch_add(_Inout_ DrawBatch* batch, _In_ const struct DrawKey* key, _In_ const DrawElementsIndirectCommand* command)
+{
+	if (batch->count == batch->capacity)
+	{
+		uint32_t capacity = batch->capacity ? batch->capacity * 2 : 256;
+		struct DrawEntry* entries = realloc(batch->entries, capacity * sizeof * entries);
+		if (entries == NULL)
+			return false;
+		batch->entries = entries;
+		DrawElementsIndirectCommand* commands = realloc(batch->commands, capacity * sizeof * commands);
+		if (commands == NULL)
+			return false;
+		batch->commands = commands;
+		batch->capacity = capacity;
+	}
+
+	batch->entries[batch->count] = (struct DrawEntry){ .key = *key, .index = batch->count };
+	batch->commands[batch->count] = *command;
+	batch->count++;
+	return true;
+}
+
+uint32_t drawbatch_submit(_Inout_ DrawBatch* batch, _Inout_ StreamBuffer* stream, _In_opt_ MaterialBindProc bind, _In_opt_ void* user)
+{
+	const uint32_t count = batch->count;
+	batch->count = 0;
+	if (count == 0)
+		return 0;
+
+	qsort(batch->entries, count, sizeof * batch->entries, compareEntry);
+
+	// Commands must be 4 byte aligned, tightly packed so one run is one contiguous range.
+	struct StreamAllocation commands;
+	if (!streambuffer_allocate(stream, count * sizeof(DrawElementsIndirectCommand), sizeof(GLuint), &commands))
+		return 0;
+	DrawElementsIndirectCommand* mapped = commands.data;
+	for (uint32_t i = 0; i < count; i++)
+		mapped[i] = batch->commands[batch->entries[i].index];
+
+	// Run lengths are known here, the count variants only pay off for counts the GPU writes, see culling_draw.
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, commands.buffer);
+
+	uint32_t calls = 0;
+	const struct DrawKey* bound = NULL;
+	for (uint32_t first = 0; first < count;)
+	{
+		const struct DrawKey* key = &batch->entries[first].key;
+		uint32_t last = first + 1;
+		while (last < count && compareKey(key, &batch->entries[last].key) == 0)
+			last++;
+
+		if (bound == NULL || bound->program != key->program)
+			glUseProgram(key->program);
+		if (bind && (bound == NULL || bound->material != key->material))
+			bind(key->material, user);
+		if (bound == NULL || bound->vao != key->vao)
+			glBindVertexArray(key->vao);
+		bound = key;
+
+		const GLintptr offset = commands.offset + (GLintptr)first * sizeof(DrawElementsIndirectCommand);
+		const GLsizei runLength = (GLsizei)(last - first);
+		glMultiDrawElementsIndirect(key->mode, key->indexType, (const void*)offset, runLength, 0);
+
+		calls++;
+		first = last;
+	}
+
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+	return calls;
+}
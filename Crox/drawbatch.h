@@ -0,0 +1,58 @@
+/**
+
+    @file      drawbatch.h
+    @brief     Sorted multi-draw-indirect submission
+    @details   Draws are collected as indirect commands together with the state
+               they need, sorted so that equal state is adjacent and issued with
+               one glMultiDrawElementsIndirect per run of equal state. The
+               commands live in the stream buffer, the GPU reads them from there
+               directly.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "streambuffer.h"
+
+
+// Layout fixed by GL, see glMultiDrawElementsIndirect.
+typedef struct DrawElementsIndirectCommand
+{
+	GLuint count;
+	GLuint instanceCount;
+	GLuint firstIndex;
+	GLint baseVertex;
+	GLuint baseInstance;
+} DrawElementsIndirectCommand;
+
+// Sorted on in field order, the most expensive state change first.
+struct DrawKey
+{
+	GLuint program;
+	uint32_t material;		// opaque to the batch, handed to the bind callback
+	GLuint vao;				// with its element buffer
+	GLenum mode;			// GL_TRIANGLES, ...
+	GLenum indexType;		// GL_UNSIGNED_SHORT or GL_UNSIGNED_INT
+};
+
+typedef struct DrawBatch DrawBatch;
+
+typedef void (*MaterialBindProc)(_In_ uint32_t material, _In_opt_ void* user);
+
+DrawBatch* drawbatch_create(void);
+
+void drawbatch_destroy(_In_opt_ DrawBatch* batch);
+
+//queues one indirect command, both structures are copied.
+bool drawbatch_add(_Inout_ DrawBatch* batch, _In_ const struct DrawKey* key, _In_ const DrawElementsIndirectCommand* command);
+
+/**
+	@brief  Sorts and issues everything queued since the last submit, then empties the batch.
+	@details Leaves the last program and vertex array bound.
+	@param  stream - receives this frame's commands
+	@param  bind   - optional, called whenever the material changes between runs
+	@retval        - multi-draw calls issued
+**/
+uint32_t drawbatch_submit(_Inout_ DrawBatch* batch, _Inout_ StreamBuffer* stream, _In_opt_ MaterialBindProc bind, _In_opt_ void* user);
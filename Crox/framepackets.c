@@ -0,0 +1,119 @@
+/**
+
+    @file      framepackets.c
+    @brief     Double-buffered hand-off of frame packets between two threads
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "framepackets.h"
+#include "platform/Threads.h"
+
+
+#define PACKET_COUNT 2
+
+struct FramePackets
+{
+	void* packets[PACKET_COUNT];
+
+	Mutex mutex;
+	CondVar written;
+	CondVar read;
+	uint32_t writeIndex;	// producer only
+	uint32_t readIndex;		// consumer only
+	uint32_t taken;			// published and not handed back yet
+	uint32_t published;		// not read yet, the oldest at readIndex
+	bool closed;
+};
+
+
+FramePackets* framepackets_create(_In_ size_t packetSize)
+{
+	FramePackets* packets = calloc(1, sizeof * packets);
+	if (packets == NULL)
+		return NULL;
+	mutex_init(&packets->mutex);
+	condvar_init(&packets->written);
+	condvar_init(&packets->read);
+
+	for (uint32_t i = 0; i < PACKET_COUNT; i++)
+	{
+		packets->packets[i] = calloc(1, packetSize);
+		if (packets->packets[i] == NULL)
+		{
+			framepackets_destroy(packets);
+			return NULL;
+		}
+	}
+	return packets;
+}
+
+void framepackets_destroy(_In_opt_ FramePackets* packets)
+{
+	if (packets == NULL)
+		return;
+
+	for (uint32_t i = 0; i < PACKET_COUNT; i++)
+		free(packets->packets[i]);
+	condvar_destroy(&packets->read);
+	condvar_destroy(&packets->written);
+	mutex_destroy(&packets->mutex);
+	free(packets);
+}
+
+void* framepackets_beginWrite(_Inout_ FramePackets* packets)
+{
+	mutex_lock(&packets->mutex);
+	while (!packets->closed && packets->taken == PACKET_COUNT)
+		condvar_wait(&packets->read, &packets->mutex);
+	const bool closed = packets->closed;
+	mutex_unlock(&packets->mutex);
+
+	// Nobody else touches a packet that isn't taken.
+	return closed ? NULL : packets->packets[packets->writeIndex];
+}
+
+void framepackets_endWrite(_Inout_ FramePackets* packets)
+{
+	packets->writeIndex = (packets->writeIndex + 1) % PACKET_COUNT;
+
+	mutex_lock(&packets->mutex);
+	packets->taken++;
+	packets->published++;
+	condvar_signal(&packets->written);
+	mutex_unlock(&packets->mutex);
+}
+
+const void* framepackets_beginRead(_Inout_ FramePackets* packets)
+{
+	mutex_lock(&packets->mutex);
+	while (!packets->closed && packets->published == 0)
+		condvar_wait(&packets->written, &packets->mutex);
+	const bool isEmpty = packets->published == 0;
+	if (!isEmpty)
+		packets->published--;
+	mutex_unlock(&packets->mutex);
+
+	return isEmpty ? NULL : packets->packets[packets->readIndex];
+}
+
+void framepackets_endRead(_Inout_ FramePackets* packets)
+{
+	packets->readIndex = (packets->readIndex + 1) % PACKET_COUNT;
+
+	mutex_lock(&packets->mutex);
+	packets->taken--;
+	condvar_signal(&packets->read);
+	mutex_unlock(&packets->mutex);
+}
+
+void framepackets_close(_Inout_ FramePackets* packets)
+{
+	mutex_lock(&packets->mutex);
+	packets->closed = true;
+	condvar_broadcast(&packets->written);
+	condvar_broadcast(&packets->read);
+	mutex_unlock(&packets->mutex);
+}
@@ -0,0 +1,42 @@
+/**
+
+    @file      framepackets.h
+    @brief     Double-buffered hand-off of frame packets between two threads
+    @details   The producing thread fills one packet while the consuming one
+               reads the other, a packet is only written between beginWrite
+               and endWrite and only read between beginRead and endRead. Each
+               side therefore sees the other's packets complete and unchanging,
+               and nothing is copied. The producer stays at most one packet
+               ahead, beginWrite blocks while both packets are taken.
+               Closing wakes both sides, the consumer still gets everything
+               published before.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+
+typedef struct FramePackets FramePackets;
+
+//both packets are zero initialized. NULL on failure.
+FramePackets* framepackets_create(_In_ size_t packetSize);
+
+//neither side may still be using a packet.
+void framepackets_destroy(_In_opt_ FramePackets* packets);
+
+//producer only. Blocks until a packet is free, it holds whatever was written to it two packets ago. NULL once closed.
+void* framepackets_beginWrite(_Inout_ FramePackets* packets);
+
+//producer only, publishes the packet beginWrite returned.
+void framepackets_endWrite(_Inout_ FramePackets* packets);
+
+//consumer only. Blocks until a packet is published, oldest first. NULL once closed and every published packet was read.
+const void* framepackets_beginRead(_Inout_ FramePackets* packets);
+
+//consumer only, hands the packet beginRead returned back to the producer.
+void framepackets_endRead(_Inout_ FramePackets* packets);
+
+//from either side, nothing more is written. Wakes whoever is waiting.
+void framepackets_close(_Inout_ FramePackets* packets);
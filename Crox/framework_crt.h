@@ -9,8 +9,15 @@
 *******************************************************************************/
 #pragma once
 #define _CRT_USE_WINAPI_FAMILY_DESKTOP_APP
+#ifndef _CRT_SECURE_NO_WARNINGS
+#define _CRT_SECURE_NO_WARNINGS
+#endif // !_CRT_SECURE_NO_WARNINGS
 
-#ifdef _DEBUG
+#ifndef _WIN32
+#include "framework_posix.h"
+#endif // !_WIN32
+
+#if defined(_DEBUG) && defined(_WIN32)
 #define _CRTDBG_MAP_ALLOC
 #include <crtdbg.h>
 #else 
@@ -27,7 +34,9 @@
 
 #include <uchar.h>
 #include <wchar.h>
+#ifdef _WIN32
 #include <tchar.h>
+#endif // _WIN32
 #include <float.h>
 
 #include <assert.h>
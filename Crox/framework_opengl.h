@@ -0,0 +1,16 @@
+/*******************************************************************************
+
+    @file    framework_opengl.h
+    @brief   OpenGL includes and helpers shared by all GL code
+    @details ~
+    @author  Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date    16.10.2026
+
+*******************************************************************************/
+#pragma once
+#include <string.h>
+
+#include <glad/gl.h>
+
+
+#define NAME_OBJECT(type, obj, name) glObjectLabel(type, obj, -(signed)strlen(name),name);
\ No newline at end of file
@@ -0,0 +1,37 @@
+/*******************************************************************************
+
+    @file    framework_posix.h
+    @brief   Includes and defines for POSIX platforms
+    @details Stubs out the MSVC source annotations and the handful of winapi
+             debugging calls the platform independent code relies on.
+    @author  Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date    16.10.2026
+
+*******************************************************************************/
+#pragma once
+
+#ifndef _POSIX_C_SOURCE
+#define _POSIX_C_SOURCE 200809L
+#endif
+
+#include <stdio.h>
+#include <unistd.h>
+
+// SAL annotations are only understood by MSVC
+#define _In_
+#define _In_z_
+#define _In_opt_
+#define _In_opt_z_
+#define _In_reads_(n)
+#define _In_reads_opt_(n)
+#define _In_reads_bytes_(n)
+#define _In_reads_bytes_opt_(n)
+#define _Out_
+#define _Out_opt_
+#define _Out_writes_(n)
+#define _Inout_
+#define _Inout_opt_
+
+#define TEXT(s) s
+#define OutputDebugStringA(msg) fputs((msg), stderr)
+#define OutputDebugString OutputDebugStringA
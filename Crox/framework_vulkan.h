@@ -1,10 +1,9 @@
 #pragma once
 
-#ifndef _WIN32
+#ifdef _WIN32
 #include "framework_winapi.h"
-#endif
-
 #define VK_USE_PLATFORM_WIN32_KHR
+#endif // _WIN32
 
 
 #include <Volk/volk.h>
@@ -0,0 +1,315 @@
+/**
+
+    @file      hotreload.c
+    @brief     Rebuilds programs whose shader files change on disk
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "platform/Platform.h"
+#include "platform/Threads.h"
+#include "platform/FileWatcher.h"
+#include "hotreload.h"
+
+
+struct ReloadJob
+{
+	struct ReloadJob* next;
+	ProgramRequest* request;
+	GLuint program;			// 0 when the rebuild failed
+	GLsync fence;			// signals once the worker's commands for program have completed
+};
+
+struct HotReload
+{
+	NkContext* ctx;
+	CompileQueue* queue;
+	IncludeCache* includes;
+
+	FileWatcher watcher;
+	uint32_t watchedCount;	// include cache ids below this are being watched
+
+	// GL thread only
+	ProgramRequest** stale;	// changed since their last build, waiting to be handed out
+	uint32_t staleCount;
+	uint32_t staleCapacity;
+	ProgramRequest** busy;	// handed out, their result hasn't been applied yet
+	uint32_t busyCount;
+	uint32_t busyCapacity;
+	struct ReloadJob* fencing;	// built, waiting for their fence
+
+	PlatformContext* context;	// NULL rebuilds on the GL thread
+	Thread worker;
+	Mutex mutex;
+	CondVar workAvailable;
+	struct ReloadJob* todo;
+	struct ReloadJob* done;
+	bool quitting;
+};
+
+
+static bool contains(_In_reads_(count) ProgramRequest* const* requests, _In_ uint32_t count, _In_ const ProgramRequest* request)
+{
+	for (uint32_t i = 0; i < count; i++)
+		if (requests[i] == request)
+			return true;
+	return false;
+}
+
+static bool add(_Inout_ ProgramRequest*** requests, _Inout_ uint32_t* count, _Inout_ uint32_t* capacity, _In_ ProgramRequest* request)
+{
+	if (contains(*requests, *count, request))
+		return true;
+	if (*count == *capacity)
+	{
+		uint32_t newCapacity = *capacity ? *capacity * 2 : 8;
+		ProgramRequest** grown = realloc(*requests, newCapacity * sizeof * grown);
+		if (grown == NULL)
+			return false;
+		*requests = grown;
+		*capacity = newCapacity;
+	}
+	(*requests)[(*count)++] = request;
+	return true;
+}
+
+static void removeAt(_Inout_ ProgramRequest** requests, _Inout_ uint32_t* count, _In_ uint32_t index)
+{
+	requests[index] = requests[--*count];
+}
+
+static void onStaleProgram(_In_ ProgramRequest* request, _In_opt_ void* user)
+{
+	HotReload* reload = user;
+	add(&reload->stale, &reload->staleCount, &reload->staleCapacity, request);
+}
+
+static void onStaleShader(_In_z_ const char* shader, _In_opt_ void* user)
+{
+	HotReload* reload = user;
+	compilequeue_forEachUser(reload->queue, shader, onStaleProgram, reload);
+}
+
+static void onFileChanged(_In_z_ const char* path, _In_opt_ void* user)
+{
+	HotReload* reload = user;
+	OutputDebugStringA("Reloading '");
+	OutputDebugStringA(path);
+	OutputDebugStringA("'\n");
+	includecache_invalidate(reload->includes, path, onStaleShader, reload);
+}
+
+static int reloadWorker(void* arg)
+{
+	HotReload* reload = arg;
+
+	bool isCurrent = platform_makeCurrent(reload->ctx, reload->context);
+	if (!isCurrent)
+		OutputDebugStringA("Hot reload: couldn't make the shared context current\n");
+
+	mutex_lock(&reload->mutex);
+	for (;;)
+	{
+		while (reload->todo == NULL && !reload->quitting)
+			condvar_wait(&reload->workAvailable, &reload->mutex);
+		if (reload->quitting)
+			break;
+
+		struct ReloadJob* job = reload->todo;
+		reload->todo = job->next;
+		mutex_unlock(&reload->mutex);
+
+		job->program = isCurrent ? compilequeue_build(reload->queue, job->request) : 0;
+		if (job->program)
+		{
+			// The program is only safe to use on the GL thread once this has signaled.
+			job->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+			glFlush();
+		}
+
+		mutex_lock(&reload->mutex);
+		job->next = reload->done;
+		reload->done = job;
+	}
+	mutex_unlock(&reload->mutex);
+
+	if (isCurrent)
+		platform_makeCurrent(reload->ctx, NULL);
+	return 0;
+}
+
+static void apply(_Inout_ HotReload* reload, _In_ struct ReloadJob* job)
+{
+	if (job->program)
+		compilequeue_replace(reload->queue, job->request, job->program);
+	else
+		OutputDebugStringA("Hot reload failed, keeping the last working program\n");
+
+	for (uint32_t i = 0; i < reload->busyCount; i++)
+	{
+		if (reload->busy[i] == job->request)
+		{
+			removeAt(reload->busy, &reload->busyCount, i);
+			break;
+		}
+	}
+	if (job->fence)
+		glDeleteSync(job->fence);
+	free(job);
+}
+
+static void freeJobs(_In_opt_ struct ReloadJob* job)
+{
+	while (job)
+	{
+		struct ReloadJob* next = job->next;
+		if (job->program)
+			glDeleteProgram(job->program);
+		if (job->fence)
+			glDeleteSync(job->fence);
+		free(job);
+		job = next;
+	}
+}
+
+
+HotReload* hotreload_create(_In_ NkContext* ctx, _In_ CompileQueue* queue, _In_ IncludeCache* includes)
+{
+	HotReload* reload = calloc(1, sizeof * reload);
+	if (reload == NULL)
+		return NULL;
+
+	reload->ctx = ctx;
+	reload->queue = queue;
+	reload->includes = includes;
+	if (!filewatcher_init(&reload->watcher))
+	{
+		free(reload);
+		return NULL;
+	}
+
+	mutex_init(&reload->mutex);
+	condvar_init(&reload->workAvailable);
+
+	reload->context = platform_createSharedContext(ctx);
+	if (reload->context && !thread_create(&reload->worker, reloadWorker, reload))
+	{
+		platform_destroySharedContext(ctx, reload->context);
+		reload->context = NULL;
+	}
+	if (reload->context == NULL)
+		OutputDebugStringA("Hot reload: no shared context, rebuilding on the main thread\n");
+
+	return reload;
+}
+
+void hotreload_destroy(_In_opt_ HotReload* reload)
+{
+	if (reload == NULL)
+		return;
+
+	if (reload->context)
+	{
+		mutex_lock(&reload->mutex);
+		reload->quitting = true;
+		condvar_broadcast(&reload->workAvailable);
+		mutex_unlock(&reload->mutex);
+
+		thread_join(reload->worker);
+		platform_destroySharedContext(reload->ctx, reload->context);
+	}
+
+	freeJobs(reload->todo);
+	freeJobs(reload->done);
+	freeJobs(reload->fencing);
+	free(reload->stale);
+	free(reload->busy);
+	filewatcher_destroy(&reload->watcher);
+	condvar_destroy(&reload->workAvailable);
+	mutex_destroy(&reload->mutex);
+	free(reload);
+}
+
+void hotreload_update(_In_opt_ HotReload* reload)
+{
+	if (reload == NULL)
+		return;
+
+	// Swap in what the worker finished, but only once the driver is done with it on the other context.
+	mutex_lock(&reload->mutex);
+	struct ReloadJob* done = reload->done;
+	reload->done = NULL;
+	mutex_unlock(&reload->mutex);
+	while (done)
+	{
+		struct ReloadJob* next = done->next;
+		done->next = reload->fencing;
+		reload->fencing = done;
+		done = next;
+	}
+	for (struct ReloadJob** link = &reload->fencing; *link;)
+	{
+		struct ReloadJob* job = *link;
+		if (job->fence && glClientWaitSync(job->fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+		{
+			link = &job->next;
+			continue;
+		}
+		*link = job->next;
+		apply(reload, job);
+	}
+
+	// Files are discovered as programs get preprocessed, new includes included.
+	uint32_t fileCount = includecache_fileCount(reload->includes);
+	for (; reload->watchedCount < fileCount; reload->watchedCount++)
+	{
+		const char* path = includecache_fileName(reload->includes, reload->watchedCount);
+		if (!filewatcher_add(&reload->watcher, path))
+		{
+			OutputDebugStringA("Hot reload: couldn't watch '");
+			OutputDebugStringA(path);
+			OutputDebugStringA("'\n");
+		}
+	}
+
+	filewatcher_poll(&reload->watcher, onFileChanged, reload);
+
+	// A program still on its first compile or already being rebuilt waits, its turn comes once that result is in.
+	for (uint32_t i = 0; i < reload->staleCount;)
+	{
+		ProgramRequest* request = reload->stale[i];
+		if (compilequeue_state(request) == PROGRAM_PENDING || contains(reload->busy, reload->busyCount, request))
+		{
+			i++;
+			continue;
+		}
+
+		if (reload->context == NULL)
+		{
+			GLuint program = compilequeue_build(reload->queue, request);
+			if (program)
+				compilequeue_replace(reload->queue, request, program);
+			else
+				OutputDebugStringA("Hot reload failed, keeping the last working program\n");
+			removeAt(reload->stale, &reload->staleCount, i);
+			continue;
+		}
+
+		struct ReloadJob* job = calloc(1, sizeof * job);
+		if (job == NULL || !add(&reload->busy, &reload->busyCount, &reload->busyCapacity, request))
+		{
+			free(job);
+			break; // stays stale, tried again next frame
+		}
+		job->request = request;
+		removeAt(reload->stale, &reload->staleCount, i);
+
+		mutex_lock(&reload->mutex);
+		job->next = reload->todo;
+		reload->todo = job;
+		condvar_signal(&reload->workAvailable);
+		mutex_unlock(&reload->mutex);
+	}
+}
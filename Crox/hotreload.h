@@ -0,0 +1,37 @@
+/**
+
+    @file      hotreload.h
+    @brief     Rebuilds programs whose shader files change on disk
+    @details   Every file the include cache has seen is watched. A change
+               invalidates it and everything including it, the affected
+               programs are rebuilt by a worker thread on a shared context
+               while the old ones keep drawing. A finished program is swapped
+               in at a frame boundary once its fence has signaled, one that
+               fails to compile leaves the last working program in place.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_nuklear.h"
+#include "compilequeue.h"
+#include "includecache.h"
+
+
+typedef struct HotReload HotReload;
+
+/**
+	@brief  Starts watching shader files. Call from the GL thread.
+	@details Falls back to rebuilding on the GL thread when the platform can't share a context.
+	@param  queue    - owns the programs to rebuild, must outlive the reloader
+	@param  includes - the include cache queue resolves through, must outlive the reloader
+	@retval          - NULL on failure
+**/
+HotReload* hotreload_create(_In_ NkContext* ctx, _In_ CompileQueue* queue, _In_ IncludeCache* includes);
+
+//stops the worker, programs still being rebuilt are thrown away.
+void hotreload_destroy(_In_opt_ HotReload* reload);
+
+//picks up changed files and swaps in rebuilt programs, once per frame before choosing programs.
+void hotreload_update(_In_opt_ HotReload* reload);
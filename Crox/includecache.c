@@ -0,0 +1,406 @@
+/**
+
+    @file      includecache.c
+    @brief     Memoizing #include resolution on top of stb_include
+    @details   Owns the stb_include implementation so its directive scanner
+               can be reused, only the expansion itself is done here.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "platform/Threads.h"
+#include "includecache.h"
+
+#include <string.h>
+#include <hashmap.h>
+
+#define STB_INCLUDE_IMPLEMENTATION
+#include <stb_include.h>
+
+
+// Deeper than any sane header chain, only there to stop runaway recursion.
+#define INCLUDE_MAX_DEPTH 32
+
+struct IncludeFile
+{
+	char* path;
+	uint32_t id;				// #line source string number
+	bool isShader;				// resolved directly, a root of the graph
+
+	char* expanded;				// NULL until resolved or after invalidation
+	size_t length;
+
+	struct IncludeFile** includes;
+	uint32_t includeCount;
+	uint32_t includeCapacity;
+};
+
+struct IncludeEntry
+{
+	const char* path;
+	struct IncludeFile* file;
+};
+
+struct IncludeCache
+{
+	Mutex mutex;
+	struct hashmap* lookup;
+	struct IncludeFile** files;	// indexed by id
+	uint64_t generation;		// bumped by every invalidation
+	uint32_t fileCount;
+	uint32_t fileCapacity;
+};
+
+struct TextBuilder
+{
+	char* text;
+	size_t length;
+	size_t capacity;
+};
+
+
+static uint64_t hashEntry(const void* item, uint64_t seed0, uint64_t seed1)
+{
+	const struct IncludeEntry* entry = item;
+	return hashmap_sip(entry->path, strlen(entry->path), seed0, seed1);
+}
+
+static int compareEntry(const void* a, const void* b, void* udata)
+{
+	(void)udata;
+	return strcmp(((const struct IncludeEntry*)a)->path, ((const struct IncludeEntry*)b)->path);
+}
+
+static bool grow(_Inout_ void** array, _Inout_ uint32_t* capacity, _In_ uint32_t count, _In_ size_t elementSize)
+{
+	if (count < *capacity)
+		return true;
+	uint32_t newCapacity = *capacity ? *capacity * 2 : 8;
+	void* newArray = realloc(*array, newCapacity * elementSize);
+	if (newArray == NULL)
+		return false;
+	*array = newArray;
+	*capacity = newCapacity;
+	return true;
+}
+
+static bool append(_Inout_ struct TextBuilder* builder, _In_reads_(length) const char* text, _In_ size_t length)
+//
+// Amortized growth, stb_include reallocates on every single append.
+//
+{
+	if (builder->length + length + 1 > builder->capacity)
+	{
+		size_t capacity = builder->capacity ? builder->capacity : 1024;
+		while (builder->length + length + 1 > capacity)
+			capacity *= 2;
+		char* grown = realloc(builder->text, capacity);
+		if (grown == NULL)
+			return false;
+		builder->text = grown;
+		builder->capacity = capacity;
+	}
+	memcpy(builder->text + builder->length, text, length);
+	builder->length += length;
+	builder->text[builder->length] = '\0';
+	return true;
+}
+
+static bool appendLine(_Inout_ struct TextBuilder* builder, _In_ int line, _In_ uint32_t source)
+{
+	char directive[48];
+	int length = snprintf(directive, sizeof directive, "#line %d %u", line, source);
+	return append(builder, directive, (size_t)length);
+}
+
+static struct IncludeFile* findFile(_Inout_ IncludeCache* cache, _In_z_ const char* path)
+{
+	const struct IncludeEntry* found = hashmap_get(cache->lookup, &(struct IncludeEntry){ .path = path });
+	if (found)
+		return found->file;
+
+	if (!grow((void**)&cache->files, &cache->fileCapacity, cache->fileCount, sizeof * cache->files))
+		return NULL;
+
+	struct IncludeFile* file = calloc(1, sizeof * file);
+	if (file == NULL)
+		return NULL;
+	file->path = malloc(strlen(path) + 1);
+	if (file->path == NULL)
+	{
+		free(file);
+		return NULL;
+	}
+	strcpy(file->path, path);
+	file->id = cache->fileCount;
+
+	hashmap_set(cache->lookup, &(struct IncludeEntry){ .path = file->path, .file = file });
+	if (hashmap_oom(cache->lookup))
+	{
+		free(file->path);
+		free(file);
+		return NULL;
+	}
+	cache->files[cache->fileCount++] = file;
+	return file;
+}
+
+static char* siblingPath(_In_z_ const char* includer, _In_z_ const char* name)
+//
+// "shaders/lit.frag" including "common.glsl" resolves to "shaders/common.glsl".
+//
+{
+	const char* slash = strrchr(includer, '/');
+	const char* backslash = strrchr(includer, '\\');
+	if (backslash > slash)
+		slash = backslash;
+	size_t directory = slash ? (size_t)(slash + 1 - includer) : 0;
+
+	char* path = malloc(directory + strlen(name) + 1);
+	if (path)
+	{
+		memcpy(path, includer, directory);
+		strcpy(path + directory, name);
+	}
+	return path;
+}
+
+static bool expand(_Inout_ IncludeCache* cache, _Inout_ struct IncludeFile* file, _Inout_ struct IncludeFile** visiting, _In_ uint32_t depth, _Out_writes_(256) char error[256])
+//
+// Called and returns with the mutex held, it is only dropped while the file is read. visiting is this expansion's
+// include stack, other threads may be expanding the same files at the same time.
+//
+{
+	for (;;)
+	{
+		if (file->expanded)
+			return true;
+		bool isCycle = depth > INCLUDE_MAX_DEPTH;
+		for (uint32_t i = 0; !isCycle && i < depth; i++)
+			isCycle = visiting[i] == file;
+		if (isCycle)
+		{
+			snprintf(error, 256, "Error: '%s' includes itself", file->path);
+			return false;
+		}
+
+		const uint64_t generation = cache->generation;
+		mutex_unlock(&cache->mutex);
+		char* text = stb_include_load_file(file->path, NULL);
+		mutex_lock(&cache->mutex);
+		if (text == NULL)
+		{
+			snprintf(error, 256, "Error: couldn't load '%s'", file->path);
+			return false;
+		}
+
+		include_info* list = NULL;
+		int count = stb_include_find_includes(text, &list);
+
+		visiting[depth] = file;
+		struct IncludeFile** includes = NULL;
+		uint32_t includeCount = 0;
+		uint32_t includeCapacity = 0;
+
+		struct TextBuilder out = { NULL };
+		bool success = true;
+		size_t last = 0;
+		for (int i = 0; success && i < count; i++)
+		{
+			success = append(&out, text + last, (size_t)list[i].offset - last);
+			last = (size_t)list[i].end;
+
+			// #inject has no meaning here, the compile queue injects its defines itself.
+			if (list[i].filename == NULL)
+				continue;
+
+			char* path = siblingPath(file->path, list[i].filename);
+			struct IncludeFile* included = path ? findFile(cache, path) : NULL;
+			free(path);
+			if (included == NULL)
+			{
+				snprintf(error, 256, "Error: out of memory including '%s'", list[i].filename);
+				success = false;
+				break;
+			}
+
+			success = expand(cache, included, visiting, depth + 1, error)
+				&& grow((void**)&includes, &includeCapacity, includeCount, sizeof * includes)
+				&& appendLine(&out, 1, included->id)
+				&& append(&out, "\n", 1)
+				&& append(&out, included->expanded, included->length)
+				&& append(&out, "\n", 1)
+				&& appendLine(&out, list[i].next_line_after, file->id);
+			if (success)
+				includes[includeCount++] = included;
+			// the newline after the directive is kept, the #line above takes effect on it
+		}
+		if (success)
+			success = append(&out, text + last, strlen(text + last));
+
+		stb_include_free_includes(list, count);
+		free(text);
+
+		// An empty file still has to count as resolved.
+		if (success && out.text == NULL)
+			success = append(&out, "", 0);
+		if (!success)
+		{
+			free(out.text);
+			free(includes);
+			return false;
+		}
+
+		// Kept unless another thread got there first or something was invalidated since the file was read, then it is read again.
+		if (file->expanded == NULL && cache->generation == generation)
+		{
+			free(file->includes);
+			file->includes = includes;
+			file->includeCount = includeCount;
+			file->includeCapacity = includeCapacity;
+			file->expanded = out.text;
+			file->length = out.length;
+			return true;
+		}
+		free(out.text);
+		free(includes);
+	}
+}
+
+
+IncludeCache* includecache_create(void)
+{
+	IncludeCache* cache = calloc(1, sizeof * cache);
+	if (cache == NULL)
+		return NULL;
+
+	cache->lookup = hashmap_new(sizeof(struct IncludeEntry), 0, 0, 0, hashEntry, compareEntry, NULL, NULL);
+	if (cache->lookup == NULL)
+	{
+		free(cache);
+		return NULL;
+	}
+	mutex_init(&cache->mutex);
+	return cache;
+}
+
+void includecache_destroy(_In_opt_ IncludeCache* cache)
+{
+	if (cache == NULL)
+		return;
+
+	for (uint32_t i = 0; i < cache->fileCount; i++)
+	{
+		free(cache->files[i]->path);
+		free(cache->files[i]->expanded);
+		free(cache->files[i]->includes);
+		free(cache->files[i]);
+	}
+	free(cache->files);
+	hashmap_free(cache->lookup);
+	mutex_destroy(&cache->mutex);
+	free(cache);
+}
+
+char* includecache_resolve(_Inout_ IncludeCache* cache, _In_z_ const char* path, _Out_writes_(256) char error[256])
+{
+	char* result = NULL;
+	struct IncludeFile* visiting[INCLUDE_MAX_DEPTH + 1];
+
+	mutex_lock(&cache->mutex);
+	struct IncludeFile* file = findFile(cache, path);
+	if (file == NULL)
+		snprintf(error, 256, "Error: out of memory loading '%s'", path);
+	else if (expand(cache, file, visiting, 0, error))
+	{
+		file->isShader = true;
+		result = malloc(file->length + 1);
+		if (result)
+			memcpy(result, file->expanded, file->length + 1);
+		else
+			snprintf(error, 256, "Error: out of memory loading '%s'", path);
+	}
+	mutex_unlock(&cache->mutex);
+
+	return result;
+}
+
+uint32_t includecache_invalidate(_Inout_ IncludeCache* cache, _In_z_ const char* path, _In_opt_ IncludeDependentProc dependent, _In_opt_ void* user)
+{
+	mutex_lock(&cache->mutex);
+
+	const struct IncludeEntry* found = hashmap_get(cache->lookup, &(struct IncludeEntry){ .path = path });
+	if (found == NULL)
+	{
+		mutex_unlock(&cache->mutex);
+		return 0;
+	}
+
+	// Only what goes stale now is reported, not shaders that already failed or were invalidated before.
+	bool* wasResolved = malloc(cache->fileCount * sizeof * wasResolved);
+	for (uint32_t i = 0; wasResolved && i < cache->fileCount; i++)
+		wasResolved[i] = cache->files[i]->expanded != NULL;
+
+	// Stale files are the ones without an expansion, spread that to every includer until nothing changes.
+	struct IncludeFile* changed = found->file;
+	cache->generation++;
+	free(changed->expanded);
+	changed->expanded = NULL;
+
+	bool spreading = true;
+	while (spreading)
+	{
+		spreading = false;
+		for (uint32_t i = 0; i < cache->fileCount; i++)
+		{
+			struct IncludeFile* file = cache->files[i];
+			if (file->expanded == NULL)
+				continue;
+			for (uint32_t j = 0; j < file->includeCount; j++)
+			{
+				if (file->includes[j]->expanded == NULL)
+				{
+					free(file->expanded);
+					file->expanded = NULL;
+					spreading = true;
+					break;
+				}
+			}
+		}
+	}
+
+	// Copied out first, the callback is free to resolve again.
+	uint32_t affectedCount = 0;
+	char** affected = malloc(cache->fileCount * sizeof * affected);
+	for (uint32_t i = 0; affected && wasResolved && i < cache->fileCount; i++)
+	{
+		const struct IncludeFile* file = cache->files[i];
+		if (file->isShader && file->expanded == NULL && (wasResolved[i] || file == changed))
+			affected[affectedCount++] = file->path; // files are never freed before the cache is
+	}
+	mutex_unlock(&cache->mutex);
+	free(wasResolved);
+
+	if (dependent)
+		for (uint32_t i = 0; i < affectedCount; i++)
+			dependent(affected[i], user);
+	free(affected);
+	return affectedCount;
+}
+
+const char* includecache_fileName(_In_ IncludeCache* cache, _In_ uint32_t id)
+{
+	mutex_lock(&cache->mutex);
+	const char* path = id < cache->fileCount ? cache->files[id]->path : NULL;
+	mutex_unlock(&cache->mutex);
+	return path;
+}
+
+uint32_t includecache_fileCount(_In_ IncludeCache* cache)
+{
+	mutex_lock(&cache->mutex);
+	uint32_t count = cache->fileCount;
+	mutex_unlock(&cache->mutex);
+	return count;
+}
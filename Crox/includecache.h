@@ -0,0 +1,45 @@
+/**
+
+    @file      includecache.h
+    @brief     Memoizing #include resolution on top of stb_include
+    @details   Every file is read and expanded once, shared headers are spliced
+               in from memory afterwards. The include graph is kept so a change
+               to one file only invalidates the files and shaders that
+               transitively include it. Thread safe.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+
+typedef struct IncludeCache IncludeCache;
+
+typedef void (*IncludeDependentProc)(_In_z_ const char* shader, _In_opt_ void* user);
+
+IncludeCache* includecache_create(void);
+
+void includecache_destroy(_In_opt_ IncludeCache* cache);
+
+/**
+	@brief  Expands all #include "file" directives of a shader, includes are looked up relative to the including file.
+	@details GLSL style #line directives are emitted, the source string number of each file is stable for the lifetime of the cache.
+	@param  path  - shader file, remembered as a root of the include graph
+	@param  error - receives a message on failure
+	@retval       - expanded source to be released with free(), NULL on failure
+**/
+char* includecache_resolve(_Inout_ IncludeCache* cache, _In_z_ const char* path, _Out_writes_(256) char error[256]);
+
+/**
+	@brief  Forgets the contents of path and of every file that includes it, directly or not.
+	@param  dependent - called for every shader passed to includecache_resolve that was affected, including path itself
+	@retval           - number of affected shaders
+**/
+uint32_t includecache_invalidate(_Inout_ IncludeCache* cache, _In_z_ const char* path, _In_opt_ IncludeDependentProc dependent, _In_opt_ void* user);
+
+//the file behind a #line source string number, NULL if unknown.
+const char* includecache_fileName(_In_ IncludeCache* cache, _In_ uint32_t id);
+
+//number of files seen so far, ids run from 0 to one below it. Grows as new includes are discovered.
+uint32_t includecache_fileCount(_In_ IncludeCache* cache);
@@ -0,0 +1,211 @@
+/**
+
+    @file      materials.c
+    @brief     Material table indexed by material ID in shaders
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "materials.h"
+
+#include <string.h>
+
+
+// std430 layout of Material in materials.glsl.
+struct MaterialEntry
+{
+	GLuint64 albedo;		// resident handle, 0 without bindless textures
+	uint32_t layer;
+	uint32_t padding;
+	float tint[4];
+};
+
+struct MaterialLibrary
+{
+	bool isBindless;
+	uint32_t capacity;
+	uint32_t count;
+	GLuint table;
+
+	GLuint64* handles;		// to make non-resident again
+
+	GLuint array;
+	uint32_t width;
+	uint32_t height;
+	uint32_t levels;
+};
+
+
+static uint32_t mipLevels(_In_ uint32_t width, _In_ uint32_t height)
+{
+	uint32_t levels = 1;
+	for (uint32_t size = width > height ? width : height; size > 1; size /= 2)
+		levels++;
+	return levels;
+}
+
+static bool fitsArray(_In_ const MaterialLibrary* library, _In_ GLuint texture, _Out_ GLint* width, _Out_ GLint* height)
+{
+	GLint format = 0;
+	glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_WIDTH, width);
+	glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_HEIGHT, height);
+	glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_INTERNAL_FORMAT, &format);
+	return (uint32_t)*width == library->width && (uint32_t)*height == library->height && format == GL_RGBA8;
+}
+
+static GLuint decompress(_In_ const MaterialLibrary* library, _In_ GLuint texture, _Inout_ GLint* width, _Inout_ GLint* height)
+//
+// Compressed formats can't be attached to a framebuffer, the driver decodes the smallest level that still covers a layer instead.
+//
+{
+	GLint levels = 1, level = 0;
+	glGetTextureParameteriv(texture, GL_TEXTURE_IMMUTABLE_LEVELS, &levels);
+	while (level + 1 < levels && *width / 2 >= (GLint)library->width && *height / 2 >= (GLint)library->height)
+	{
+		level++;
+		*width /= 2;
+		*height /= 2;
+	}
+
+	const GLsizei size = *width * *height * 4;
+	void* pixels = malloc(size);
+	if (pixels == NULL)
+		return 0;
+	glGetTextureImage(texture, level, GL_RGBA, GL_UNSIGNED_BYTE, size, pixels);
+
+	GLuint decompressed = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &decompressed);
+	glTextureStorage2D(decompressed, 1, GL_RGBA8, *width, *height);
+	glTextureSubImage2D(decompressed, 0, 0, 0, *width, *height, GL_RGBA, GL_UNSIGNED_BYTE, pixels);
+	free(pixels);
+	return decompressed;
+}
+
+static void blitLayer(_In_ const MaterialLibrary* library, _In_ GLuint texture, _In_ GLint width, _In_ GLint height, _In_ uint32_t layer)
+//
+// Scales and converts whatever doesn't match the array's shape, only the first level is read.
+//
+{
+	GLint isCompressed = GL_FALSE;
+	glGetTextureLevelParameteriv(texture, 0, GL_TEXTURE_COMPRESSED, &isCompressed);
+	GLuint source = isCompressed ? decompress(library, texture, &width, &height) : texture;
+	if (source == 0)
+		return;
+
+	GLuint framebuffers[2];
+	glCreateFramebuffers(2, framebuffers);
+	glNamedFramebufferTexture(framebuffers[0], GL_COLOR_ATTACHMENT0, source, 0);
+	glNamedFramebufferTextureLayer(framebuffers[1], GL_COLOR_ATTACHMENT0, library->array, 0, (GLint)layer);
+	glBlitNamedFramebuffer(framebuffers[0], framebuffers[1], 0, 0, width, height,
+		0, 0, (GLint)library->width, (GLint)library->height, GL_COLOR_BUFFER_BIT, GL_LINEAR);
+	glDeleteFramebuffers(2, framebuffers);
+	if (source != texture)
+		glDeleteTextures(1, &source);
+}
+
+
+MaterialLibrary* materials_create(_In_ uint32_t capacity, _In_ uint32_t width, _In_ uint32_t height)
+{
+	MaterialLibrary* library = calloc(1, sizeof * library);
+	if (library == NULL || capacity == 0)
+	{
+		free(library);
+		return NULL;
+	}
+
+	library->isBindless = GLAD_GL_ARB_bindless_texture;
+	library->capacity = capacity;
+
+	glCreateBuffers(1, &library->table);
+	NAME_OBJECT(GL_BUFFER, library->table, "Material Table");
+	glNamedBufferStorage(library->table, (GLsizeiptr)capacity * sizeof(struct MaterialEntry), NULL, GL_DYNAMIC_STORAGE_BIT);
+
+	if (library->isBindless)
+	{
+		library->handles = calloc(capacity, sizeof * library->handles);
+		if (library->handles == NULL)
+		{
+			materials_destroy(library);
+			return NULL;
+		}
+		return library;
+	}
+
+	// Layers can't differ in size or format, everything is converted to the one shape up front.
+	library->width = width;
+	library->height = height;
+	library->levels = mipLevels(width, height);
+	glCreateTextures(GL_TEXTURE_2D_ARRAY, 1, &library->array);
+	NAME_OBJECT(GL_TEXTURE, library->array, "Material Textures");
+	glTextureStorage3D(library->array, library->levels, GL_RGBA8, width, height, capacity);
+	glTextureParameteri(library->array, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTextureParameteri(library->array, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	return library;
+}
+
+void materials_destroy(_In_opt_ MaterialLibrary* library)
+{
+	if (library == NULL)
+		return;
+
+	if (library->handles)
+		for (uint32_t i = 0; i < library->count; i++)
+			if (library->handles[i])
+				glMakeTextureHandleNonResidentARB(library->handles[i]);
+	free(library->handles);
+	glDeleteBuffers(1, &library->table);
+	if (library->array)
+		glDeleteTextures(1, &library->array);
+	free(library);
+}
+
+const char* materials_defines(_In_ const MaterialLibrary* library)
+{
+	return library->isBindless ? "#define MATERIALS_BINDLESS 1\n" : NULL;
+}
+
+uint32_t materials_add(_Inout_ MaterialLibrary* library, _In_ const struct MaterialDesc* desc)
+{
+	if (library->count == library->capacity)
+		return MATERIAL_NONE;
+
+	const uint32_t id = library->count;
+	struct MaterialEntry entry = { .layer = id };
+	memcpy(entry.tint, desc->tint, sizeof entry.tint);
+
+	if (library->isBindless)
+	{
+		entry.albedo = glGetTextureHandleARB(desc->albedo);
+		if (entry.albedo == 0)
+			return MATERIAL_NONE;
+		glMakeTextureHandleResidentARB(entry.albedo);
+		library->handles[id] = entry.albedo;
+	}
+	else
+	{
+		GLint width = 0, height = 0;
+		if (fitsArray(library, desc->albedo, &width, &height))
+			glCopyImageSubData(desc->albedo, GL_TEXTURE_2D, 0, 0, 0, 0,
+				library->array, GL_TEXTURE_2D_ARRAY, 0, 0, 0, (GLint)id,
+				(GLsizei)library->width, (GLsizei)library->height, 1);
+		else
+			blitLayer(library, desc->albedo, width, height, id);
+		// Regenerates every layer's chain, materials are added rarely.
+		glGenerateTextureMipmap(library->array);
+	}
+
+	glNamedBufferSubData(library->table, (GLintptr)id * sizeof entry, sizeof entry, &entry);
+	library->count++;
+	return id;
+}
+
+void materials_bind(_In_opt_ const MaterialLibrary* library)
+{
+	if (library == NULL)
+		return;
+	glBindBufferBase(GL_SHADER_STORAGE_BUFFER, MATERIALS_BINDING, library->table);
+	if (library->array)
+		glBindTextureUnit(MATERIALS_TEXTURE_UNIT, library->array);
+}
@@ -0,0 +1,32 @@
+// Material table, see materials.h. Include before any declaration, the
+// extension directive has to come first.
+#ifdef MATERIALS_BINDLESS
+#extension GL_ARB_bindless_texture : require
+#endif
+
+struct Material
+{
+#ifdef MATERIALS_BINDLESS
+	sampler2D albedo;	// resident handle
+#else
+	uvec2 albedo;		// unused, keeps the layout
+#endif
+	uint layer;			// into materialTextures without bindless textures
+	uint padding;
+	vec4 tint;
+};
+
+layout(std430, binding = 4) readonly buffer Materials { Material materials[]; };
+
+#ifndef MATERIALS_BINDLESS
+layout(binding = 1) uniform sampler2DArray materialTextures;
+#endif
+
+vec4 material_albedo(uint id, vec2 uv)
+{
+#ifdef MATERIALS_BINDLESS
+	return texture(materials[id].albedo, uv) * materials[id].tint;
+#else
+	return texture(materialTextures, vec3(uv, materials[id].layer)) * materials[id].tint;
+#endif
+}
@@ -0,0 +1,59 @@
+/**
+
+    @file      materials.h
+    @brief     Material table indexed by material ID in shaders
+    @details   Every material is one entry of a shader storage buffer that stays
+               bound, shaders look a material up by an ID that comes with the
+               instance. With ARB_bindless_texture the entry holds a resident
+               texture handle, so no texture unit is ever rebound between
+               draws. Without it (llvmpipe) the textures are copied into the
+               layers of one texture array and the entry holds the layer.
+               Shaders include materials.glsl and are built with
+               materials_defines.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+
+
+#define MATERIAL_NONE UINT32_MAX
+
+// Must match materials.glsl.
+#define MATERIALS_BINDING		4	// shader storage binding of the table
+#define MATERIALS_TEXTURE_UNIT	1	// texture array without bindless textures
+
+struct MaterialDesc
+{
+	GLuint albedo;		// 2D texture, sampler state is taken from it
+	float tint[4];		// multiplied with the albedo
+};
+
+typedef struct MaterialLibrary MaterialLibrary;
+
+/**
+	@brief  Creates the table and, without bindless textures, the texture array.
+	@param  capacity - most materials the library can hold
+	@param  width    - size of the array layers without bindless textures, other albedos are scaled to it
+	@retval          - NULL on failure
+**/
+MaterialLibrary* materials_create(_In_ uint32_t capacity, _In_ uint32_t width, _In_ uint32_t height);
+
+//makes the handles non-resident, the albedo textures stay with the caller.
+void materials_destroy(_In_opt_ MaterialLibrary* library);
+
+//defines for every program that includes materials.glsl, NULL without bindless textures.
+const char* materials_defines(_In_ const MaterialLibrary* library);
+
+/**
+	@brief  Adds a material.
+	@details With bindless textures the albedo is referenced and has to outlive the library, it can't change its sampler state anymore.
+	         Otherwise it is copied, or scaled if it doesn't match, into the array and may be deleted right away.
+	@retval - material ID, MATERIAL_NONE when full
+**/
+uint32_t materials_add(_Inout_ MaterialLibrary* library, _In_ const struct MaterialDesc* desc);
+
+//binds the table and the array, once for any number of draws.
+void materials_bind(_In_opt_ const MaterialLibrary* library);
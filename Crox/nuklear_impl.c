@@ -8,5 +8,14 @@
 
 **/
 #define _CRT_SECURE_NO_WARNINGS
+// Font baking compiles stb_rect_pack in unconditionally, static keeps it from clashing with stb_impl.c's.
+#define STBRP_STATIC
 #define NK_IMPLEMENTATION
+#ifdef __GNUC__
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wunused-function"	// font baking never calls stbrp_setup_heuristic
+#endif // __GNUC__
 #include "framework_nuklear.h"
+#ifdef __GNUC__
+#pragma GCC diagnostic pop
+#endif // __GNUC__
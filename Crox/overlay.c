@@ -0,0 +1,176 @@
+/**
+
+    @file      overlay.c
+    @brief     Draws the Nuklear UI on top of the frame
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "overlay.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+// Explicit uniform location of ui.vert.
+#define OVERLAY_PROJECTION 0
+
+#define OVERLAY_SEGMENTS 22
+
+struct OverlayVertex
+{
+	float pos[2];
+	float uv[2];
+	nk_byte rgba[4];
+};
+
+static const struct nk_draw_vertex_layout_element VERTEX_LAYOUT[] = {
+	{ NK_VERTEX_POSITION,	NK_FORMAT_FLOAT,		offsetof(struct OverlayVertex, pos) },
+	{ NK_VERTEX_TEXCOORD,	NK_FORMAT_FLOAT,		offsetof(struct OverlayVertex, uv) },
+	{ NK_VERTEX_COLOR,		NK_FORMAT_R8G8B8A8,		offsetof(struct OverlayVertex, rgba) },
+	{ NK_VERTEX_LAYOUT_END },
+};
+
+struct Overlay
+{
+	ProgramRequest* program;
+	GLuint vao;
+	struct nk_convert_config config;
+
+	// Converted into on the CPU, they grow to the largest UI seen and are copied to the stream once the size is known.
+	struct nk_buffer commands;
+	struct nk_buffer vertices;
+	struct nk_buffer indices;
+};
+
+
+Overlay* overlay_create(_Inout_ CompileQueue* queue, _In_ GLuint stream, _In_ struct nk_draw_null_texture nullTexture)
+{
+	Overlay* overlay = calloc(1, sizeof * overlay);
+	if (overlay == NULL)
+		return NULL;
+
+	overlay->program = compilequeue_submit(queue, "Overlay", 2, (struct ShaderStage[]) {
+		{ .type = GL_VERTEX_SHADER, .path = "ui.vert" },
+		{ .type = GL_FRAGMENT_SHADER, .path = "ui.frag" },
+	}, false);
+	if (overlay->program == NULL)
+	{
+		// The request belongs to the queue, nothing to release for it.
+		free(overlay);
+		return NULL;
+	}
+
+	overlay->config = (struct nk_convert_config){
+		.global_alpha = 1.0f,
+		.line_AA = NK_ANTI_ALIASING_ON,
+		.shape_AA = NK_ANTI_ALIASING_ON,
+		.circle_segment_count = OVERLAY_SEGMENTS,
+		.arc_segment_count = OVERLAY_SEGMENTS,
+		.curve_segment_count = OVERLAY_SEGMENTS,
+		.tex_null = nullTexture,
+		.vertex_layout = VERTEX_LAYOUT,
+		.vertex_size = sizeof(struct OverlayVertex),
+		.vertex_alignment = NK_ALIGNOF(struct OverlayVertex),
+	};
+	nk_buffer_init_default(&overlay->commands);
+	nk_buffer_init_default(&overlay->vertices);
+	nk_buffer_init_default(&overlay->indices);
+
+	// Vertices are allocated at a multiple of their size, draws locate them with a base vertex.
+	glCreateVertexArrays(1, &overlay->vao);
+	NAME_OBJECT(GL_VERTEX_ARRAY, overlay->vao, "Overlay Layout");
+	glVertexArrayVertexBuffer(overlay->vao, 0, stream, 0, sizeof(struct OverlayVertex));
+	glVertexArrayElementBuffer(overlay->vao, stream);
+	glEnableVertexArrayAttrib(overlay->vao, 0);
+	glVertexArrayAttribFormat(overlay->vao, 0, 2, GL_FLOAT, GL_FALSE, offsetof(struct OverlayVertex, pos));
+	glVertexArrayAttribBinding(overlay->vao, 0, 0);
+	glEnableVertexArrayAttrib(overlay->vao, 1);
+	glVertexArrayAttribFormat(overlay->vao, 1, 2, GL_FLOAT, GL_FALSE, offsetof(struct OverlayVertex, uv));
+	glVertexArrayAttribBinding(overlay->vao, 1, 0);
+	glEnableVertexArrayAttrib(overlay->vao, 2);
+	glVertexArrayAttribFormat(overlay->vao, 2, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(struct OverlayVertex, rgba));
+	glVertexArrayAttribBinding(overlay->vao, 2, 0);
+
+	return overlay;
+}
+
+void overlay_destroy(_In_opt_ Overlay* overlay)
+{
+	if (overlay == NULL)
+		return;
+	glDeleteVertexArrays(1, &overlay->vao);
+	nk_buffer_free(&overlay->commands);
+	nk_buffer_free(&overlay->vertices);
+	nk_buffer_free(&overlay->indices);
+	free(overlay);
+}
+
+bool overlay_draw(_Inout_ Overlay* overlay, _Inout_ NkContext* ctx, _Inout_ StreamBuffer* stream, _In_ uint32_t width, _In_ uint32_t height)
+{
+	if (compilequeue_state(overlay->program) != PROGRAM_READY || width == 0 || height == 0)
+		return true;
+
+	nk_buffer_clear(&overlay->commands);
+	nk_buffer_clear(&overlay->vertices);
+	nk_buffer_clear(&overlay->indices);
+	if (nk_convert(ctx, &overlay->commands, &overlay->vertices, &overlay->indices, &overlay->config) != NK_CONVERT_SUCCESS)
+		return false;
+
+	// Nothing was recorded, which is every frame without a window open.
+	const nk_size vertexSize = overlay->vertices.allocated;
+	const nk_size indexSize = overlay->indices.allocated;
+	if (vertexSize == 0 || indexSize == 0)
+		return true;
+
+	struct StreamAllocation vertices, indices;
+	if (!streambuffer_allocate(stream, (GLsizeiptr)vertexSize, sizeof(struct OverlayVertex), &vertices) ||
+		!streambuffer_allocate(stream, (GLsizeiptr)indexSize, sizeof(nk_draw_index), &indices))
+		return false;
+	memcpy(vertices.data, nk_buffer_memory_const(&overlay->vertices), vertexSize);
+	memcpy(indices.data, nk_buffer_memory_const(&overlay->indices), indexSize);
+
+	// Client area pixels with the origin at the top left, like Nuklear lays them out.
+	const float projection[16] = {
+		2.0f / (float)width, 0, 0, 0,
+		0, -2.0f / (float)height, 0, 0,
+		0, 0, -1.0f, 0,
+		-1.0f, 1.0f, 0, 1.0f,
+	};
+	GLuint program = compilequeue_program(overlay->program, 0);
+	glProgramUniformMatrix4fv(program, OVERLAY_PROJECTION, 1, GL_FALSE, projection);
+	glUseProgram(program);
+	glBindVertexArray(overlay->vao);
+
+	glEnable(GL_BLEND);
+	glBlendEquation(GL_FUNC_ADD);
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_SCISSOR_TEST);
+
+	const GLenum indexType = sizeof(nk_draw_index) == sizeof(GLuint) ? GL_UNSIGNED_INT : GL_UNSIGNED_SHORT;
+	const GLint baseVertex = (GLint)(vertices.offset / sizeof(struct OverlayVertex));
+	GLintptr offset = indices.offset;
+	const struct nk_draw_command* command;
+	nk_draw_foreach(command, ctx, &overlay->commands)
+	{
+		if (command->elem_count == 0)
+			continue;
+
+		// GL's scissor origin is the bottom left, empty rectangles are clamped rather than negative.
+		const GLint left = (GLint)command->clip_rect.x;
+		const GLint bottom = (GLint)height - (GLint)(command->clip_rect.y + command->clip_rect.h);
+		const GLsizei clipWidth = command->clip_rect.w > 0.0f ? (GLsizei)command->clip_rect.w : 0;
+		const GLsizei clipHeight = command->clip_rect.h > 0.0f ? (GLsizei)command->clip_rect.h : 0;
+		glScissor(left, bottom, clipWidth, clipHeight);
+
+		glBindTextureUnit(0, (GLuint)command->texture.id);
+		glDrawElementsBaseVertex(GL_TRIANGLES, (GLsizei)command->elem_count, indexType, (const void*)offset, baseVertex);
+		offset += (GLintptr)command->elem_count * sizeof(nk_draw_index);
+	}
+
+	glDisable(GL_SCISSOR_TEST);
+	glDisable(GL_BLEND);
+	return true;
+}
@@ -0,0 +1,40 @@
+/**
+
+    @file      overlay.h
+    @brief     Draws the Nuklear UI on top of the frame
+    @details   What the UI recorded during the frame is converted to triangles
+               with nk_convert, streamed through the stream buffer and drawn
+               with one indexed draw per Nuklear command, clipped to its
+               scissor rectangle. Text samples the font atlas the platform
+               layer uploaded, untextured shapes its white texel.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "framework_nuklear.h"
+#include "compilequeue.h"
+#include "streambuffer.h"
+
+
+typedef struct Overlay Overlay;
+
+/**
+	@brief  Submits the UI program and lays out the vertex array.
+	@param  stream      - the stream buffer's GL name, every vertex and index is read from it
+	@param  nullTexture - from platform_getNullTexture
+	@retval             - NULL on failure
+**/
+Overlay* overlay_create(_Inout_ CompileQueue* queue, _In_ GLuint stream, _In_ struct nk_draw_null_texture nullTexture);
+
+void overlay_destroy(_In_opt_ Overlay* overlay);
+
+/**
+	@brief  Draws the commands ctx recorded this frame, blended over the bound framebuffer.
+	@details Draws nothing until the program has linked. The commands are kept, nk_clear still empties ctx.
+	@param  stream - receives this frame's vertices and indices
+	@retval        - false when the stream ran out of space or the conversion failed
+**/
+bool overlay_draw(_Inout_ Overlay* overlay, _Inout_ NkContext* ctx, _Inout_ StreamBuffer* stream, _In_ uint32_t width, _In_ uint32_t height);
@@ -0,0 +1,208 @@
+/**
+
+    @file      FileWatcher.h
+    @brief     Change notification for individual files
+    @details   Header only, same as Threads.h. Linux gets events from inotify on
+               the parent directories, editors that save by renaming a new file
+               over the old one are caught as well. Elsewhere modification
+               times are compared a few times per second.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+#include <string.h>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+#include "framework_winapi.h"
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#else
+#include <time.h>
+#endif // _WIN32
+
+
+// How often modification times are compared where there are no change events.
+#define FILEWATCHER_POLL_MS 250
+
+typedef void (*FileChangedProc)(_In_z_ const char* path, _In_opt_ void* user);
+
+struct WatchedFile
+{
+	char* path;
+	const char* name;		// within path, after the last separator
+#if defined(__linux__)
+	int wd;					// shared by every file of the same directory
+#else
+	int64_t modified;
+#endif // __linux__
+};
+
+typedef struct FileWatcher
+{
+	struct WatchedFile* files;
+	uint32_t count;
+	uint32_t capacity;
+#if defined(__linux__)
+	int fd;
+#else
+	uint64_t lastPoll;		// milliseconds
+#endif // __linux__
+} FileWatcher;
+
+
+#if !defined(__linux__)
+static inline int64_t filewatcher_modified(_In_z_ const char* path)
+{
+#ifdef _WIN32
+	struct _stat64 st;
+	return _stat64(path, &st) == 0 ? (int64_t)st.st_mtime : -1;
+#else
+	struct stat st;
+	return stat(path, &st) == 0 ? (int64_t)st.st_mtime : -1;
+#endif // _WIN32
+}
+
+static inline uint64_t filewatcher_milliseconds(void)
+{
+#ifdef _WIN32
+	return GetTickCount64();
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000ull + (uint64_t)ts.tv_nsec / 1000000ull;
+#endif // _WIN32
+}
+#endif // !__linux__
+
+static inline bool filewatcher_init(_Out_ FileWatcher* watcher)
+{
+	*watcher = (FileWatcher){ .files = NULL, .count = 0, .capacity = 0 };
+#if defined(__linux__)
+	watcher->fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	return watcher->fd >= 0;
+#else
+	watcher->lastPoll = filewatcher_milliseconds();
+	return true;
+#endif // __linux__
+}
+
+static inline void filewatcher_destroy(_Inout_ FileWatcher* watcher)
+{
+	for (uint32_t i = 0; i < watcher->count; i++)
+		free(watcher->files[i].path);
+	free(watcher->files);
+#if defined(__linux__)
+	// Closing the descriptor drops every watch with it.
+	if (watcher->fd >= 0)
+		close(watcher->fd);
+#endif // __linux__
+	*watcher = (FileWatcher){ .files = NULL, .count = 0, .capacity = 0 };
+}
+
+//starts watching path, adding the same path twice is harmless. The file doesn't have to exist yet on Linux.
+static inline bool filewatcher_add(_Inout_ FileWatcher* watcher, _In_z_ const char* path)
+{
+	for (uint32_t i = 0; i < watcher->count; i++)
+		if (strcmp(watcher->files[i].path, path) == 0)
+			return true;
+
+	if (watcher->count == watcher->capacity)
+	{
+		uint32_t capacity = watcher->capacity ? watcher->capacity * 2 : 16;
+		struct WatchedFile* files = realloc(watcher->files, capacity * sizeof * files);
+		if (files == NULL)
+			return false;
+		watcher->files = files;
+		watcher->capacity = capacity;
+	}
+
+	struct WatchedFile file = { .path = malloc(strlen(path) + 1) };
+	if (file.path == NULL)
+		return false;
+	strcpy(file.path, path);
+
+	const char* slash = strrchr(file.path, '/');
+	const char* backslash = strrchr(file.path, '\\');
+	if (backslash > slash)
+		slash = backslash;
+	file.name = slash ? slash + 1 : file.path;
+
+#if defined(__linux__)
+	size_t directoryLength = slash ? (size_t)(slash - file.path) : 1;
+	char* directory = malloc(directoryLength + 1);
+	if (directory == NULL)
+	{
+		free(file.path);
+		return false;
+	}
+	if (slash)
+		memcpy(directory, file.path, directoryLength);
+	else
+		directory[0] = '.';
+	directory[directoryLength] = '\0';
+
+	// Whole directories are watched, saving through a temporary and a rename replaces the inode a file watch would sit on.
+	file.wd = inotify_add_watch(watcher->fd, directoryLength ? directory : "/", IN_CLOSE_WRITE | IN_MOVED_TO);
+	free(directory);
+	if (file.wd < 0)
+	{
+		free(file.path);
+		return false;
+	}
+#else
+	file.modified = filewatcher_modified(file.path);
+#endif // __linux__
+
+	watcher->files[watcher->count++] = file;
+	return true;
+}
+
+//calls changed once for every watched file written since the last poll. Never blocks.
+static inline void filewatcher_poll(_Inout_ FileWatcher* watcher, _In_ FileChangedProc changed, _In_opt_ void* user)
+{
+#if defined(__linux__)
+	_Alignas(struct inotify_event) char buffer[4096];
+	for (;;)
+	{
+		ssize_t length = read(watcher->fd, buffer, sizeof buffer);
+		if (length <= 0)
+			break; // EAGAIN once drained
+
+		for (ssize_t offset = 0; offset < length;)
+		{
+			const struct inotify_event* event = (const struct inotify_event*)(buffer + offset);
+			offset += sizeof * event + event->len;
+			if (event->len == 0)
+				continue;
+
+			for (uint32_t i = 0; i < watcher->count; i++)
+			{
+				const struct WatchedFile* file = &watcher->files[i];
+				if (file->wd == event->wd && strcmp(file->name, event->name) == 0)
+					changed(file->path, user);
+			}
+		}
+	}
+#else
+	uint64_t now = filewatcher_milliseconds();
+	if (now - watcher->lastPoll < FILEWATCHER_POLL_MS)
+		return;
+	watcher->lastPoll = now;
+
+	for (uint32_t i = 0; i < watcher->count; i++)
+	{
+		struct WatchedFile* file = &watcher->files[i];
+		int64_t modified = filewatcher_modified(file->path);
+		if (modified == file->modified)
+			continue;
+		file->modified = modified;
+		if (modified >= 0)
+			changed(file->path, user);
+	}
+#endif // __linux__
+}
@@ -0,0 +1,144 @@
+/**
+
+    @file      MappedFile.h
+    @brief     Read-only memory mapped files over winapi and POSIX
+    @details   Header only, same as Threads.h. Mapping lets large read-mostly
+               assets be consumed in place, the OS pages them in on demand and
+               no heap copy is made. The caches written next to those assets
+               are replaced whole, so a reader maps either the old file or
+               the new one.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+#include <string.h>
+
+#ifdef _WIN32
+#include "framework_winapi.h"
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif // _WIN32
+
+
+typedef struct MappedFile
+{
+	const void* data;
+	size_t size;
+#ifdef _WIN32
+	HANDLE file;
+	HANDLE mapping;
+#endif // _WIN32
+} MappedFile;
+
+
+//maps the whole file read-only. Empty files fail, there is nothing to map.
+static inline bool mappedfile_open(_Out_ MappedFile* mapped, _In_z_ const char* path)
+{
+	*mapped = (MappedFile){ .data = NULL, .size = 0 };
+
+#ifdef _WIN32
+	mapped->file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mapped->file == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mapped->file, &size) || size.QuadPart == 0)
+	{
+		CloseHandle(mapped->file);
+		return false;
+	}
+	mapped->size = (size_t)size.QuadPart;
+
+	mapped->mapping = CreateFileMappingA(mapped->file, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mapped->mapping == NULL)
+	{
+		CloseHandle(mapped->file);
+		return false;
+	}
+	mapped->data = MapViewOfFile(mapped->mapping, FILE_MAP_READ, 0, 0, 0);
+	if (mapped->data == NULL)
+	{
+		CloseHandle(mapped->mapping);
+		CloseHandle(mapped->file);
+		return false;
+	}
+#else
+	int fd = open(path, O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size <= 0)
+	{
+		close(fd);
+		return false;
+	}
+	mapped->size = (size_t)st.st_size;
+
+	void* data = mmap(NULL, mapped->size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd); // the mapping keeps its own reference
+	if (data == MAP_FAILED)
+		return false;
+	mapped->data = data;
+#endif // _WIN32
+
+	return true;
+}
+
+static inline void mappedfile_close(_Inout_ MappedFile* mapped)
+{
+	if (mapped->data == NULL)
+		return;
+
+#ifdef _WIN32
+	UnmapViewOfFile(mapped->data);
+	CloseHandle(mapped->mapping);
+	CloseHandle(mapped->file);
+#else
+	munmap((void*)mapped->data, mapped->size);
+#endif // _WIN32
+
+	mapped->data = NULL;
+	mapped->size = 0;
+}
+
+/**
+	@brief  Writes prefix then data to path.tmp and renames it over path.
+	@details Written beside the final name and moved into place, a concurrent or interrupted run never sees half a file.
+	@param  prefix - optional, e.g. a header kept apart from the data
+	@retval        - false if anything failed, the temporary is removed then
+**/
+static inline bool mappedfile_replace(_In_z_ const char* path, _In_reads_bytes_opt_(prefixSize) const void* prefix, _In_ size_t prefixSize,
+	_In_reads_bytes_(size) const void* data, _In_ size_t size)
+{
+	char* temporary = malloc(strlen(path) + sizeof ".tmp");
+	if (temporary == NULL)
+		return false;
+	strcat(strcpy(temporary, path), ".tmp");
+
+	bool success = false;
+	FILE* file = fopen(temporary, "wb");
+	if (file)
+	{
+		success =
+			(prefixSize == 0 || fwrite(prefix, 1, prefixSize, file) == prefixSize) &&
+			fwrite(data, 1, size, file) == size;
+		success = fclose(file) == 0 && success;
+
+		if (success)
+		{
+			remove(path);
+			success = rename(temporary, path) == 0;
+		}
+		if (!success)
+			remove(temporary);
+	}
+
+	free(temporary);
+	return success;
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include "framework_crt.h"
 #include "framework_nuklear.h"
 #include <stdint.h>
 #include <stdbool.h>
@@ -12,4 +13,42 @@ bool platform_show(_In_ NkContext* ctx);
 
 
 //polls messages from the message queue. returns false when a quit message is encountered.
-bool platform_pollMessages(_In_ NkContext* ctx, _Out_ int* status);
\ No newline at end of file
+bool platform_pollMessages(_In_ NkContext* ctx, _Out_ int* status);
+
+// Pointer input gathered by platform_pollMessages, positions are client area pixels from the top left.
+struct PlatformInput
+{
+	int32_t mouseX;
+	int32_t mouseY;
+	uint32_t down;			// a bit per nk_buttons, held as of the last message
+	uint32_t pressed;		// went down since the input was last taken
+	uint32_t released;		// went up since the input was last taken
+	float scroll;			// wheel notches since the input was last taken, positive away from the user
+};
+
+//hands over the input gathered since the last call and starts over. Call from the thread polling messages.
+void platform_takeInput(_In_ NkContext* ctx, _Out_ struct PlatformInput* input);
+
+//the white texel Nuklear draws untextured shapes with, in the font atlas the platform uploaded to the window's context.
+struct nk_draw_null_texture platform_getNullTexture(_In_ NkContext* ctx);
+
+
+//monotonic clock in nanoseconds, only meaningful as a difference.
+uint64_t platform_getTime(void);
+
+//number of heap allocations made by the process so far. Returns false when the build cannot track them.
+bool platform_getAllocationCount(_Out_ uint64_t* count);
+
+//binds the window's own context to the calling thread, or releases it from it. It is current on the thread main is called on, and on one thread at a time.
+bool platform_makeWindowCurrent(_In_ NkContext* ctx, _In_ bool isCurrent);
+
+typedef struct PlatformContext PlatformContext;
+
+//creates a GL context sharing objects with the main one, for a worker thread. Call from the main thread, returns NULL when unsupported.
+PlatformContext* platform_createSharedContext(_In_ NkContext* ctx);
+
+//binds a shared context to the calling thread, NULL releases the current one.
+bool platform_makeCurrent(_In_ NkContext* ctx, _In_opt_ PlatformContext* context);
+
+//the context must no longer be current on any thread.
+void platform_destroySharedContext(_In_ NkContext* ctx, _In_opt_ PlatformContext* context);
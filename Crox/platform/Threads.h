@@ -0,0 +1,272 @@
+/**
+
+    @file      Threads.h
+    @brief     Minimal threading primitives over winapi and pthreads
+    @details   Header only; the native types are exposed so that mutexes and
+               condition variables can live by value inside other structs.
+               MSVC's C compiler has no <stdatomic.h>, the few atomics needed
+               work on plain aligned 64-bit integers and pointers instead.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+#ifdef _WIN32
+#include "framework_winapi.h"
+#include <process.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif // _WIN32
+
+
+typedef int (*ThreadProc)(void* arg);
+
+#ifdef _WIN32
+#define THREAD_LOCAL __declspec(thread)
+#else
+#define THREAD_LOCAL _Thread_local
+#endif // _WIN32
+
+#ifdef _WIN32
+typedef HANDLE				Thread;
+typedef SRWLOCK				Mutex;
+typedef CONDITION_VARIABLE	CondVar;
+#else
+typedef pthread_t			Thread;
+typedef pthread_mutex_t		Mutex;
+typedef pthread_cond_t		CondVar;
+#endif // _WIN32
+
+struct ThreadStart
+{
+	ThreadProc proc;
+	void* arg;
+};
+
+#ifdef _WIN32
+static inline unsigned __stdcall threadTrampoline(void* param)
+#else
+static inline void* threadTrampoline(void* param)
+#endif // _WIN32
+{
+	struct ThreadStart start = *(struct ThreadStart*)param;
+	free(param);
+	int result = start.proc(start.arg);
+#ifdef _WIN32
+	return (unsigned)result;
+#else
+	return (void*)(intptr_t)result;
+#endif // _WIN32
+}
+
+static inline bool thread_create(_Out_ Thread* thread, _In_ ThreadProc proc, _In_opt_ void* arg)
+{
+	struct ThreadStart* start = malloc(sizeof * start);
+	if (start == NULL)
+		return false;
+	*start = (struct ThreadStart){ .proc = proc, .arg = arg };
+
+#ifdef _WIN32
+	*thread = (HANDLE)_beginthreadex(NULL, 0, threadTrampoline, start, 0, NULL);
+	bool success = *thread != NULL;
+#else
+	bool success = pthread_create(thread, NULL, threadTrampoline, start) == 0;
+#endif // _WIN32
+	if (!success)
+		free(start);
+	return success;
+}
+
+static inline int thread_join(_In_ Thread thread)
+{
+#ifdef _WIN32
+	DWORD result = 0;
+	WaitForSingleObject(thread, INFINITE);
+	GetExitCodeThread(thread, &result);
+	CloseHandle(thread);
+	return (int)result;
+#else
+	void* result = NULL;
+	pthread_join(thread, &result);
+	return (int)(intptr_t)result;
+#endif // _WIN32
+}
+
+static inline void thread_yield(void)
+{
+#ifdef _WIN32
+	SwitchToThread();
+#else
+	sched_yield();
+#endif // _WIN32
+}
+
+static inline uint32_t thread_hardwareConcurrency(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO si;
+	GetSystemInfo(&si);
+	return si.dwNumberOfProcessors;
+#else
+	long n = sysconf(_SC_NPROCESSORS_ONLN);
+	return n > 0 ? (uint32_t)n : 1;
+#endif // _WIN32
+}
+
+
+static inline void mutex_init(_Out_ Mutex* mutex)
+{
+#ifdef _WIN32
+	InitializeSRWLock(mutex);
+#else
+	pthread_mutex_init(mutex, NULL);
+#endif // _WIN32
+}
+
+static inline void mutex_destroy(_Inout_ Mutex* mutex)
+{
+#ifdef _WIN32
+	(void)mutex; // SRW locks own no resources
+#else
+	pthread_mutex_destroy(mutex);
+#endif // _WIN32
+}
+
+static inline void mutex_lock(_Inout_ Mutex* mutex)
+{
+#ifdef _WIN32
+	AcquireSRWLockExclusive(mutex);
+#else
+	pthread_mutex_lock(mutex);
+#endif // _WIN32
+}
+
+static inline void mutex_unlock(_Inout_ Mutex* mutex)
+{
+#ifdef _WIN32
+	ReleaseSRWLockExclusive(mutex);
+#else
+	pthread_mutex_unlock(mutex);
+#endif // _WIN32
+}
+
+
+static inline void condvar_init(_Out_ CondVar* cv)
+{
+#ifdef _WIN32
+	InitializeConditionVariable(cv);
+#else
+	pthread_cond_init(cv, NULL);
+#endif // _WIN32
+}
+
+static inline void condvar_destroy(_Inout_ CondVar* cv)
+{
+#ifdef _WIN32
+	(void)cv;
+#else
+	pthread_cond_destroy(cv);
+#endif // _WIN32
+}
+
+//atomically releases mutex and waits, mutex is held again on return. Spurious wakeups are possible.
+static inline void condvar_wait(_Inout_ CondVar* cv, _Inout_ Mutex* mutex)
+{
+#ifdef _WIN32
+	SleepConditionVariableSRW(cv, mutex, INFINITE, 0);
+#else
+	pthread_cond_wait(cv, mutex);
+#endif // _WIN32
+}
+
+static inline void condvar_signal(_Inout_ CondVar* cv)
+{
+#ifdef _WIN32
+	WakeConditionVariable(cv);
+#else
+	pthread_cond_signal(cv);
+#endif // _WIN32
+}
+
+static inline void condvar_broadcast(_Inout_ CondVar* cv)
+{
+#ifdef _WIN32
+	WakeAllConditionVariable(cv);
+#else
+	pthread_cond_broadcast(cv);
+#endif // _WIN32
+}
+
+
+//acquire load.
+static inline int64_t atomic_load64(_In_ const volatile int64_t* value)
+{
+#ifdef _WIN32
+	return ReadAcquire64((const volatile LONG64*)value);
+#else
+	return __atomic_load_n(value, __ATOMIC_ACQUIRE);
+#endif // _WIN32
+}
+
+//release store.
+static inline void atomic_store64(_Out_ volatile int64_t* value, _In_ int64_t desired)
+{
+#ifdef _WIN32
+	WriteRelease64((volatile LONG64*)value, desired);
+#else
+	__atomic_store_n(value, desired, __ATOMIC_RELEASE);
+#endif // _WIN32
+}
+
+//sequentially consistent, returns the new value.
+static inline int64_t atomic_add64(_Inout_ volatile int64_t* value, _In_ int64_t addend)
+{
+#ifdef _WIN32
+	return InterlockedAdd64((volatile LONG64*)value, addend);
+#else
+	return __atomic_add_fetch(value, addend, __ATOMIC_SEQ_CST);
+#endif // _WIN32
+}
+
+//sequentially consistent, stores desired only if value was expected.
+static inline bool atomic_compareExchange64(_Inout_ volatile int64_t* value, _In_ int64_t expected, _In_ int64_t desired)
+{
+#ifdef _WIN32
+	return InterlockedCompareExchange64((volatile LONG64*)value, desired, expected) == expected;
+#else
+	return __atomic_compare_exchange_n(value, &expected, desired, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+#endif // _WIN32
+}
+
+//acquire load.
+static inline void* atomic_loadPointer(_In_ void* const volatile* pointer)
+{
+#ifdef _WIN32
+	return ReadPointerAcquire((PVOID const volatile*)pointer);
+#else
+	return __atomic_load_n(pointer, __ATOMIC_ACQUIRE);
+#endif // _WIN32
+}
+
+//release store.
+static inline void atomic_storePointer(_Out_ void* volatile* pointer, _In_opt_ void* desired)
+{
+#ifdef _WIN32
+	WritePointerRelease((PVOID volatile*)pointer, desired);
+#else
+	__atomic_store_n(pointer, desired, __ATOMIC_RELEASE);
+#endif // _WIN32
+}
+
+//full barrier, nothing moves across it in either direction.
+static inline void atomic_fence(void)
+{
+#ifdef _WIN32
+	MemoryBarrier();
+#else
+	__atomic_thread_fence(__ATOMIC_SEQ_CST);
+#endif // _WIN32
+}
@@ -0,0 +1,379 @@
+/**
+
+    @file      egl_headless.c
+    @brief     Headless platform layer on top of EGL
+    @details   Creates a GL 4.6 core context without any window system, either
+               on a pbuffer or, when the display has no pbuffer configs, on a
+               surfaceless context rendering into a platform owned framebuffer.
+               Prefers the Mesa surfaceless platform so that it runs on machines
+               without a GPU or display server (llvmpipe).
+
+               Environment:
+                 CROX_WIDTH, CROX_HEIGHT - size of the back buffer, default 1280x720
+                 CROX_FRAMES             - number of frames before quitting, 0 runs until SIGINT/SIGTERM
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "framework_nuklear.h"
+
+#include <glad/gl.h>
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <signal.h>
+#include "Platform.h"
+#include "posix.h"
+#include "Threads.h"
+
+
+#define DEFAULT_WIDTH	1280
+#define DEFAULT_HEIGHT	720
+
+#ifndef EGL_CONTEXT_OPENGL_NO_ERROR_KHR
+#define EGL_CONTEXT_OPENGL_NO_ERROR_KHR 0x31B3
+#endif // !EGL_CONTEXT_OPENGL_NO_ERROR_KHR
+
+
+struct PlatformResources
+{
+	EGLDisplay display;
+	EGLConfig config;
+	EGLSurface surface;		// EGL_NO_SURFACE when running surfaceless
+	EGLContext context;
+	GLuint framebuffer;		// stands in for the default framebuffer when surfaceless
+	GLuint renderbuffers[2];
+	uint32_t width;
+	uint32_t height;
+	uint64_t frameLimit;
+	volatile int64_t frameCount;	// bumped by whichever thread swaps, read by the one polling
+	struct nk_draw_null_texture nullTexture;
+	void* aux;
+};
+static inline struct PlatformResources* getResources(NkContext* ctx)
+{
+	return (struct PlatformResources*)ctx->userdata.ptr;
+}
+
+struct PlatformContext
+{
+	EGLContext context;
+	EGLSurface surface;		// 1x1 pbuffer, unless surfaceless contexts are supported
+};
+
+static volatile sig_atomic_t quitSignal = 0;
+
+static void onQuitSignal(int sig)
+{
+	quitSignal = sig;
+}
+
+static EGLDisplay openDisplay(void)
+//
+// Surfaceless Mesa does not need a DRM node or X server, which is exactly what CI machines lack.
+//
+{
+	EGLDisplay display = EGL_NO_DISPLAY;
+	const char* clientExtensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+
+	PFNEGLGETPLATFORMDISPLAYEXTPROC getPlatformDisplay =
+		(PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+
+	if (getPlatformDisplay && posix_hasExtension(clientExtensions, "EGL_MESA_platform_surfaceless"))
+		display = getPlatformDisplay(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, NULL);
+
+	if (display == EGL_NO_DISPLAY)
+		display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+
+	return display;
+}
+
+static EGLContext createContext(EGLDisplay display, EGLConfig config, EGLContext share)
+{
+	const bool noError = posix_hasExtension(eglQueryString(display, EGL_EXTENSIONS), "EGL_KHR_create_context_no_error");
+
+	// Most specific request first, llvmpipe may lack 4.6, no-error or robustness depending on the Mesa release.
+	// No-error and robustness are mutually exclusive. Release builds want no-error, debug builds report errors and take robustness instead.
+	const struct { EGLint minor; bool robust; bool noError; } attempts[] = {
+#ifdef _DEBUG
+		{ 6, true, false }, { 6, false, false },
+		{ 5, true, false }, { 5, false, false },
+#else
+		{ 6, false, true }, { 6, true, false }, { 6, false, false },
+		{ 5, false, true }, { 5, true, false }, { 5, false, false },
+#endif // _DEBUG
+	};
+
+	for (size_t i = 0; i < sizeof attempts / sizeof * attempts; i++)
+	{
+		// Would only repeat the plain attempt ahead of the robust one.
+		if (attempts[i].noError && !noError)
+			continue;
+
+		EGLint attribs[16];
+		EGLint n = 0;
+
+		attribs[n++] = EGL_CONTEXT_MAJOR_VERSION;			attribs[n++] = 4;
+		attribs[n++] = EGL_CONTEXT_MINOR_VERSION;			attribs[n++] = attempts[i].minor;
+		attribs[n++] = EGL_CONTEXT_OPENGL_PROFILE_MASK;		attribs[n++] = EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT;
+#ifdef _DEBUG
+		attribs[n++] = EGL_CONTEXT_OPENGL_DEBUG;			attribs[n++] = EGL_TRUE;
+#endif // _DEBUG
+		if (attempts[i].noError)
+		{
+			attribs[n++] = EGL_CONTEXT_OPENGL_NO_ERROR_KHR;	attribs[n++] = EGL_TRUE;
+		}
+		if (attempts[i].robust)
+		{
+			attribs[n++] = EGL_CONTEXT_OPENGL_ROBUST_ACCESS;	attribs[n++] = EGL_TRUE;
+			attribs[n++] = EGL_CONTEXT_OPENGL_RESET_NOTIFICATION_STRATEGY; attribs[n++] = EGL_LOSE_CONTEXT_ON_RESET;
+		}
+		attribs[n++] = EGL_NONE;
+
+		EGLContext context = eglCreateContext(display, config, share, attribs);
+		if (context != EGL_NO_CONTEXT)
+			return context;
+	}
+	return EGL_NO_CONTEXT;
+}
+
+static bool createFramebuffer(_Inout_ struct PlatformResources* rsc)
+//
+// Without a surface there is no default framebuffer, bind one of our own so Crox can stay oblivious.
+//
+{
+	glCreateRenderbuffers(2, rsc->renderbuffers);
+	glNamedRenderbufferStorage(rsc->renderbuffers[0], GL_RGBA8, rsc->width, rsc->height);
+	glNamedRenderbufferStorage(rsc->renderbuffers[1], GL_DEPTH24_STENCIL8, rsc->width, rsc->height);
+
+	glCreateFramebuffers(1, &rsc->framebuffer);
+	glNamedFramebufferRenderbuffer(rsc->framebuffer, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, rsc->renderbuffers[0]);
+	glNamedFramebufferRenderbuffer(rsc->framebuffer, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rsc->renderbuffers[1]);
+	glBindFramebuffer(GL_FRAMEBUFFER, rsc->framebuffer);
+
+	return glCheckNamedFramebufferStatus(rsc->framebuffer, GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+}
+
+/**
+	@brief  Application Entry point
+	@param  argc -
+	@param  argv -
+	@param  envp -
+	@retval      - 0 on success
+**/
+int main(int argc, char** argv, char** envp)
+{
+	struct sigaction sa = { .sa_handler = onQuitSignal };
+	sigemptyset(&sa.sa_mask);
+	sigaction(SIGINT, &sa, NULL);
+	sigaction(SIGTERM, &sa, NULL);
+
+	struct PlatformResources rsc = {
+		.display = EGL_NO_DISPLAY,
+		.config = NULL,
+		.surface = EGL_NO_SURFACE,
+		.context = EGL_NO_CONTEXT,
+		.framebuffer = 0,
+		.width = (uint32_t)posix_envNumber("CROX_WIDTH", DEFAULT_WIDTH),
+		.height = (uint32_t)posix_envNumber("CROX_HEIGHT", DEFAULT_HEIGHT),
+		.frameLimit = posix_envNumber("CROX_FRAMES", 0),
+		.frameCount = 0,
+		.aux = NULL,
+	};
+
+	const EGLint pbufferConfigAttribs[] = {
+		EGL_SURFACE_TYPE,		EGL_PBUFFER_BIT,
+		EGL_RENDERABLE_TYPE,	EGL_OPENGL_BIT,
+		EGL_RED_SIZE,			8,
+		EGL_GREEN_SIZE,			8,
+		EGL_BLUE_SIZE,			8,
+		EGL_ALPHA_SIZE,			8,
+		EGL_DEPTH_SIZE,			24,
+		EGL_STENCIL_SIZE,		8,
+		EGL_NONE
+	};
+	const EGLint surfacelessConfigAttribs[] = {
+		EGL_SURFACE_TYPE,		0,
+		EGL_RENDERABLE_TYPE,	EGL_OPENGL_BIT,
+		EGL_NONE
+	};
+	const EGLint pbufferAttribs[] = {
+		EGL_WIDTH,				(EGLint)rsc.width,
+		EGL_HEIGHT,				(EGLint)rsc.height,
+		EGL_NONE
+	};
+
+	EGLint major = 0, minor = 0;
+	EGLConfig config = NULL;
+	EGLint configCount = 0;
+
+	bool displayInitialized =
+		(rsc.display = openDisplay()) != EGL_NO_DISPLAY &&
+		eglInitialize(rsc.display, &major, &minor) &&
+		eglBindAPI(EGL_OPENGL_API);
+	assert(displayInitialized);
+	if (!displayInitialized)
+		return -1;
+
+	bool usePbuffer =
+		eglChooseConfig(rsc.display, pbufferConfigAttribs, &config, 1, &configCount) && configCount > 0;
+	if (!usePbuffer)
+	{
+		bool surfaceless =
+			posix_hasExtension(eglQueryString(rsc.display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context") &&
+			eglChooseConfig(rsc.display, surfacelessConfigAttribs, &config, 1, &configCount) && configCount > 0;
+		assert(surfaceless);
+		if (!surfaceless)
+		{
+			eglTerminate(rsc.display);
+			return -1;
+		}
+	}
+
+	rsc.config = config;
+	bool ctxInitialized =
+		(!usePbuffer || (rsc.surface = eglCreatePbufferSurface(rsc.display, config, pbufferAttribs)) != EGL_NO_SURFACE) &&
+		(rsc.context = createContext(rsc.display, config, EGL_NO_CONTEXT)) != EGL_NO_CONTEXT &&
+		eglMakeCurrent(rsc.display, rsc.surface, rsc.surface, rsc.context) &&
+		gladLoadGL((GLADloadfunc)eglGetProcAddress) &&
+		(usePbuffer || createFramebuffer(&rsc));
+	assert(ctxInitialized);
+
+	if (ctxInitialized)
+#ifdef _DEBUG
+		gladInstallGLDebug();
+#else
+		gladUninstallGLDebug();
+#endif // _DEBUG
+
+	int result = ctxInitialized ? posix_runCrox(&rsc, &rsc.nullTexture, argc, argv, envp) : -1;
+
+	if (rsc.framebuffer)
+	{
+		glDeleteFramebuffers(1, &rsc.framebuffer);
+		glDeleteRenderbuffers(2, rsc.renderbuffers);
+	}
+	eglMakeCurrent(rsc.display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+	if (rsc.context != EGL_NO_CONTEXT)
+		eglDestroyContext(rsc.display, rsc.context);
+	if (rsc.surface != EGL_NO_SURFACE)
+		eglDestroySurface(rsc.display, rsc.surface);
+	eglTerminate(rsc.display);
+
+	return result;
+}
+
+
+void platform_getDimensions(_In_ NkContext* ctx, _Out_ uint32_t* width, _Out_ uint32_t* height)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	*width = rsc->width;
+	*height = rsc->height;
+}
+
+bool platform_swapBuffers(_In_ NkContext* ctx)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	atomic_add64(&rsc->frameCount, 1);
+
+	// Without a surface there is nothing to swap, only flush so that the frame actually gets executed.
+	if (rsc->surface == EGL_NO_SURFACE)
+	{
+		glFlush();
+		return true;
+	}
+	return eglSwapBuffers(rsc->display, rsc->surface);
+}
+
+bool platform_show(_In_ NkContext* ctx)
+{
+	(void)ctx;
+	return true;
+}
+
+bool platform_pollMessages(_In_ NkContext* ctx, _Out_ int* status)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+
+	*status = 0;
+	if (quitSignal)
+	{
+		*status = 128 + quitSignal;
+		return false;
+	}
+	// Context loss is the render thread's to notice, EGL errors are per thread.
+	return rsc->frameLimit == 0 || (uint64_t)atomic_load64(&rsc->frameCount) < rsc->frameLimit;
+}
+
+void platform_takeInput(_In_ NkContext* ctx, _Out_ struct PlatformInput* input)
+{
+	// No pointer without a window.
+	(void)ctx;
+	*input = (struct PlatformInput){ .mouseX = 0 };
+}
+
+struct nk_draw_null_texture platform_getNullTexture(_In_ NkContext* ctx)
+{
+	return getResources(ctx)->nullTexture;
+}
+
+bool platform_makeWindowCurrent(_In_ NkContext* ctx, _In_ bool isCurrent)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	if (!isCurrent)
+		return eglMakeCurrent(rsc->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	// The bound API is per thread and defaults to GLES.
+	return
+		eglBindAPI(EGL_OPENGL_API) &&
+		eglMakeCurrent(rsc->display, rsc->surface, rsc->surface, rsc->context);
+}
+
+PlatformContext* platform_createSharedContext(_In_ NkContext* ctx)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+
+	PlatformContext* context = malloc(sizeof * context);
+	if (context == NULL)
+		return NULL;
+	*context = (PlatformContext){ .context = EGL_NO_CONTEXT, .surface = EGL_NO_SURFACE };
+
+	const EGLint pbufferAttribs[] = { EGL_WIDTH, 1, EGL_HEIGHT, 1, EGL_NONE };
+	bool surfaceless = posix_hasExtension(eglQueryString(rsc->display, EGL_EXTENSIONS), "EGL_KHR_surfaceless_context");
+
+	bool success =
+		(context->context = createContext(rsc->display, rsc->config, rsc->context)) != EGL_NO_CONTEXT &&
+		(surfaceless || (context->surface = eglCreatePbufferSurface(rsc->display, rsc->config, pbufferAttribs)) != EGL_NO_SURFACE);
+	if (!success)
+	{
+		platform_destroySharedContext(ctx, context);
+		return NULL;
+	}
+	return context;
+}
+
+bool platform_makeCurrent(_In_ NkContext* ctx, _In_opt_ PlatformContext* context)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+
+	if (context == NULL)
+		return eglMakeCurrent(rsc->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+
+	// The bound API is per thread and defaults to GLES.
+	return
+		eglBindAPI(EGL_OPENGL_API) &&
+		eglMakeCurrent(rsc->display, context->surface, context->surface, context->context);
+}
+
+void platform_destroySharedContext(_In_ NkContext* ctx, _In_opt_ PlatformContext* context)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	if (context == NULL)
+		return;
+
+	if (context->context != EGL_NO_CONTEXT)
+		eglDestroyContext(rsc->display, context->context);
+	if (context->surface != EGL_NO_SURFACE)
+		eglDestroySurface(rsc->display, context->surface);
+	free(context);
+}
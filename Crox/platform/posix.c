@@ -0,0 +1,135 @@
+/**
+
+    @file      posix.c
+    @brief     Shared entry for the POSIX platform layers
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "framework_nuklear.h"
+
+#include <glad/gl.h>
+#include <locale.h>
+#include <string.h>
+#include <time.h>
+#include "Crox.h"
+#include "Platform.h"
+#include "posix.h"
+
+
+static wchar_t* widen(_In_z_ const char* str)
+{
+	size_t len = mbstowcs(NULL, str, 0);
+	if (len == (size_t)-1)
+		return calloc(1, sizeof(wchar_t));
+
+	wchar_t* wide = malloc((len + 1) * sizeof * wide);
+	if (wide)
+		mbstowcs(wide, str, len + 1);
+	return wide;
+}
+
+static wchar_t** widenAll(_In_ char** strs, _In_ size_t count)
+{
+	wchar_t** wide = calloc(count + 1, sizeof * wide);
+	for (size_t i = 0; wide && i < count; i++)
+		wide[i] = widen(strs[i]);
+	return wide;
+}
+
+static void freeAll(_In_opt_ wchar_t** strs)
+{
+	for (size_t i = 0; strs && strs[i]; i++)
+		free(strs[i]);
+	free(strs);
+}
+
+static GLuint uploadFontAtlas(_In_ const void* pixels, _In_ int width, _In_ int height)
+//
+// Baked as alpha only, the UI shader reads the coverage from red.
+//
+{
+	GLuint texture = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+	glObjectLabel(GL_TEXTURE, texture, -1, "Font Atlas");
+	glTextureStorage2D(texture, 1, GL_R8, width, height);
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	return texture;
+}
+
+int posix_runCrox(_In_ void* rsc, _Out_ struct nk_draw_null_texture* nullTexture, _In_ int argc, _In_ char** argv, _In_opt_ char** envp)
+{
+	setlocale(LC_ALL, "");
+
+	size_t envC = 0;
+	while (envp && envp[envC])
+		envC++;
+
+	int result = -1;
+
+	struct nk_context* ctx = malloc(sizeof * ctx);
+	struct nk_font_atlas atlas;
+	nk_font_atlas_init_default(&atlas);
+	nk_font_atlas_begin(&atlas);
+	struct nk_font* font = nk_font_atlas_add_default(&atlas, 13.0f, NULL);
+	int atlasWidth = 0, atlasHeight = 0;
+	const void* pixels = nk_font_atlas_bake(&atlas, &atlasWidth, &atlasHeight, NK_FONT_ATLAS_ALPHA8);
+	// The pixels are freed by nk_font_atlas_end, the context is current already.
+	GLuint fontTexture = uploadFontAtlas(pixels, atlasWidth, atlasHeight);
+	nk_font_atlas_end(&atlas, nk_handle_id((int)fontTexture), nullTexture);
+
+	if (ctx && nk_init_default(ctx, &font->handle))
+	{
+		nk_set_user_data(ctx, (nk_handle) { .ptr = rsc });
+
+		wchar_t** argV = widenAll(argv, (size_t)argc);
+		wchar_t** penv = widenAll(envp, envC);
+
+		result = croxMain(ctx, (uint32_t)argc, argV, penv);
+
+		freeAll(argV);
+		freeAll(penv);
+		nk_free(ctx);
+	}
+	glDeleteTextures(1, &fontTexture);
+	nk_font_atlas_clear(&atlas);
+	free(ctx);
+
+	return result;
+}
+
+uint64_t posix_envNumber(_In_z_ const char* name, _In_ uint64_t fallback)
+{
+	const char* value = getenv(name);
+	if (value == NULL || *value == '\0')
+		return fallback;
+
+	char* end = NULL;
+	unsigned long long n = strtoull(value, &end, 10);
+	return *end == '\0' ? (uint64_t)n : fallback;
+}
+
+bool posix_hasExtension(_In_opt_ const char* extensions, _In_z_ const char* name)
+{
+	if (extensions == NULL)
+		return false;
+
+	size_t len = strlen(name);
+	for (const char* p = strstr(extensions, name); p != NULL; p = strstr(p + len, name))
+		if ((p == extensions || p[-1] == ' ') && (p[len] == ' ' || p[len] == '\0'))
+			return true;
+	return false;
+}
+
+uint64_t platform_getTime(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
@@ -0,0 +1,30 @@
+/**
+
+    @file      posix.h
+    @brief     Shared entry for the POSIX platform layers
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_nuklear.h"
+
+
+/**
+	@brief  Sets up Nuklear, widens the process arguments and runs Crox.
+	@param  rsc         - platform resources, stored as the Nuklear user data
+	@param  nullTexture - receives the white texel of the font atlas, which is uploaded to the current context
+	@param  argc        - argument count as received by main()
+	@param  argv        - arguments as received by main()
+	@param  envp        - environment as received by main()
+	@retval             - exit status of Crox, -1 if it could not be started
+**/
+int posix_runCrox(_In_ void* rsc, _Out_ struct nk_draw_null_texture* nullTexture, _In_ int argc, _In_ char** argv, _In_opt_ char** envp);
+
+//reads an unsigned decimal environment variable, returns fallback when it is absent or malformed.
+uint64_t posix_envNumber(_In_z_ const char* name, _In_ uint64_t fallback);
+
+//tests for a whole word in a space separated extension string.
+bool posix_hasExtension(_In_opt_ const char* extensions, _In_z_ const char* name);
\ No newline at end of file
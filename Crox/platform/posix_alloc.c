@@ -0,0 +1,54 @@
+/**
+
+    @file      posix_alloc.c
+    @brief     Heap allocation counting for the POSIX platform layers
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+
+#include "Platform.h"
+
+
+static uint64_t allocationCount = 0;
+
+#if defined(CROX_BENCH) && defined(__GLIBC__)
+//
+// The benchmark wants allocations per frame, glibc lets the executable interpose its allocator entry points.
+// Compiled into every executable rather than the shared objects, only the bench build defines CROX_BENCH.
+//
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t count, size_t size);
+extern void* __libc_realloc(void* ptr, size_t size);
+
+void* malloc(size_t size)
+{
+	__atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+	return __libc_malloc(size);
+}
+
+void* calloc(size_t count, size_t size)
+{
+	__atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+	return __libc_calloc(count, size);
+}
+
+void* realloc(void* ptr, size_t size)
+{
+	__atomic_fetch_add(&allocationCount, 1, __ATOMIC_RELAXED);
+	return __libc_realloc(ptr, size);
+}
+#endif // CROX_BENCH && __GLIBC__
+
+
+bool platform_getAllocationCount(_Out_ uint64_t* count)
+{
+	*count = __atomic_load_n(&allocationCount, __ATOMIC_RELAXED);
+#if defined(CROX_BENCH) && defined(__GLIBC__)
+	return true;
+#else
+	return false;
+#endif // CROX_BENCH && __GLIBC__
+}
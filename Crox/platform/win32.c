@@ -45,18 +45,34 @@ static int __CRTDECL crtReportHook(_In_ int eType, _In_ LPWSTR msg, _In_ int* re
 
 static BOOL loadOpenGL(_In_ HINSTANCE hInstance);
 
+static GLuint uploadFontAtlas(_In_ const void* pixels, _In_ int width, _In_ int height);
+
+static void trackButton(_Inout_ struct nk_context* ctx, _In_ HWND hWnd, _In_ enum nk_buttons button, _In_ bool isDown, _In_ LPARAM lParam);
+
 static LRESULT APIENTRY setupWndProc(_In_ HWND hWnd, _In_ UINT msg, _In_ WPARAM, _In_ LPARAM);
 static LRESULT APIENTRY mainWndProc(_In_ HWND hWnd, _In_ UINT msg, _In_ WPARAM, _In_ LPARAM);
 
 
 
+// Only maintained by the debug CRT, which is the only one that calls crtAllocHook.
+static volatile LONG64 allocationCount = 0;
+
 struct PlatformResources
 {
 	HWND hMainWnd;
 	HINSTANCE hInstance;
 	HACCEL hAccel;
+	HGLRC hCtx;
+	const int* ctxAttribs;
+	struct PlatformInput input;		// gathered by mainWndProc while polling, taken by the same thread
+	struct nk_draw_null_texture nullTexture;
 	void* aux;
 };
+
+struct PlatformContext
+{
+	HGLRC hCtx;
+};
 inline HWND		getMainWnd(NkContext* ctx)
 {
 	return ((struct PlatformResources*)ctx->userdata.ptr)->hMainWnd;
@@ -103,6 +119,9 @@ extern APIENTRY _tWinMain(
 #ifdef _DEBUG
 	gladInstallGLDebug();
 	gladInstallWGLDebug();
+#else
+	gladUninstallGLDebug();
+	gladUninstallWGLDebug();
 #endif // _DEBUG
 
 
@@ -209,9 +228,18 @@ extern APIENTRY _tWinMain(
 
 	int result = 0;
 	
-	struct nk_user_font font;
+	struct nk_font_atlas atlas;
+	nk_font_atlas_init_default(&atlas);
+	nk_font_atlas_begin(&atlas);
+	struct nk_font* font = nk_font_atlas_add_default(&atlas, 13.0f, NULL);
+	int atlasWidth = 0, atlasHeight = 0;
+	const void* pixels = nk_font_atlas_bake(&atlas, &atlasWidth, &atlasHeight, NK_FONT_ATLAS_ALPHA8);
+	// The pixels are freed by nk_font_atlas_end, the context is current already.
+	GLuint fontTexture = uploadFontAtlas(pixels, atlasWidth, atlasHeight);
+	struct nk_draw_null_texture nullTexture;
+	nk_font_atlas_end(&atlas, nk_handle_id((int)fontTexture), &nullTexture);
 	
-	if (nk_init_default(ctx, &font))
+	if (nk_init_default(ctx, &font->handle))
 	{
 		LPTSTR pEnv = GetEnvironmentStrings();
 		int argC	= 0;
@@ -221,6 +249,10 @@ extern APIENTRY _tWinMain(
 			.hMainWnd = hMainWnd,
 			.hInstance = hInstance,
 			.hAccel = NULL,
+			.hCtx = hCtx,
+			.ctxAttribs = ctxAttribs,
+			.input = { 0 },
+			.nullTexture = nullTexture,
 			.aux = NULL,
 		};
 		nk_set_user_data(ctx, (nk_handle) { .ptr = &rsc });
@@ -232,7 +264,10 @@ extern APIENTRY _tWinMain(
 		if (argV)
 			LocalFree(argV);
 
+		nk_free(ctx);
 	}
+	glDeleteTextures(1, &fontTexture);
+	nk_font_atlas_clear(&atlas);
 
 
 
@@ -254,7 +289,10 @@ int __CRTDECL crtAllocHook(
 	if (eUsage == _CRT_BLOCK)
 		return(TRUE); //operation may proceed.
 
-	//TODO
+	if (eAllocType != _HOOK_FREE)
+		InterlockedIncrement64(&allocationCount);
+
+	return(TRUE);
 }
 
 void __CRTDECL crtDumpClientHook(
@@ -382,6 +420,23 @@ BOOL loadOpenGL(_In_ HINSTANCE hInstance)
 	return ctxInitalized;
 }
 
+GLuint uploadFontAtlas(_In_ const void* pixels, _In_ int width, _In_ int height)
+//
+// Baked as alpha only, the UI shader reads the coverage from red.
+//
+{
+	GLuint texture = 0;
+	glCreateTextures(GL_TEXTURE_2D, 1, &texture);
+	glObjectLabel(GL_TEXTURE, texture, -1, "Font Atlas");
+	glTextureStorage2D(texture, 1, GL_R8, width, height);
+	glTextureParameteri(texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+	glTextureParameteri(texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	glTextureSubImage2D(texture, 0, 0, 0, width, height, GL_RED, GL_UNSIGNED_BYTE, pixels);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	return texture;
+}
+
 LRESULT setupWndProc(_In_ HWND hWnd, _In_ UINT msg, _In_ WPARAM wParam, _In_ LPARAM lParam)
 //
 // make pointer association with the context before any useful messages can be handled.
@@ -409,12 +464,62 @@ LRESULT mainWndProc(_In_ HWND hWnd, _In_ UINT msg, _In_ WPARAM wParam, _In_ LPAR
 		PostQuitMessage(0);
 		break;
 	}
+	case WM_MOUSEMOVE:
+	{
+		struct PlatformResources* rsc = ctx->userdata.ptr;
+		rsc->input.mouseX = (short)LOWORD(lParam);
+		rsc->input.mouseY = (short)HIWORD(lParam);
+		break;
+	}
+	case WM_LBUTTONDOWN:
+	case WM_LBUTTONUP:
+		trackButton(ctx, hWnd, NK_BUTTON_LEFT, msg == WM_LBUTTONDOWN, lParam);
+		break;
+	case WM_MBUTTONDOWN:
+	case WM_MBUTTONUP:
+		trackButton(ctx, hWnd, NK_BUTTON_MIDDLE, msg == WM_MBUTTONDOWN, lParam);
+		break;
+	case WM_RBUTTONDOWN:
+	case WM_RBUTTONUP:
+		trackButton(ctx, hWnd, NK_BUTTON_RIGHT, msg == WM_RBUTTONDOWN, lParam);
+		break;
+	case WM_MOUSEWHEEL:
+	{
+		struct PlatformResources* rsc = ctx->userdata.ptr;
+		rsc->input.scroll += (float)GET_WHEEL_DELTA_WPARAM(wParam) / (float)WHEEL_DELTA;
+		break;
+	}
 	default:
 		return DefWindowProc(hWnd, msg, wParam, lParam);
 	}
 	return 0;
 }
 
+void trackButton(_Inout_ struct nk_context* ctx, _In_ HWND hWnd, _In_ enum nk_buttons button, _In_ bool isDown, _In_ LPARAM lParam)
+//
+// Captured while a button is held, so drags that leave the client area still end.
+//
+{
+	struct PlatformResources* rsc = ctx->userdata.ptr;
+	const uint32_t bit = 1u << button;
+	rsc->input.mouseX = (short)LOWORD(lParam);
+	rsc->input.mouseY = (short)HIWORD(lParam);
+	if (isDown)
+	{
+		if (rsc->input.down == 0)
+			SetCapture(hWnd);
+		rsc->input.down |= bit;
+		rsc->input.pressed |= bit;
+	}
+	else
+	{
+		rsc->input.down &= ~bit;
+		rsc->input.released |= bit;
+		if (rsc->input.down == 0)
+			ReleaseCapture();
+	}
+}
+
 
 void platform_getDimensions(_In_ NkContext* ctx, _Out_ uint32_t* width, _Out_ uint32_t* height)
 {
@@ -467,3 +572,99 @@ bool platform_pollMessages(_In_ NkContext* ctx, _Out_ int* status)
 
 	return true;
 }
+
+uint64_t platform_getTime(void)
+{
+	static LARGE_INTEGER frequency = { 0 };
+	if (frequency.QuadPart == 0)
+		QueryPerformanceFrequency(&frequency);
+
+	LARGE_INTEGER counter;
+	QueryPerformanceCounter(&counter);
+
+	// Split to avoid overflowing the multiplication with high frequency counters.
+	uint64_t seconds = counter.QuadPart / frequency.QuadPart;
+	uint64_t remainder = counter.QuadPart % frequency.QuadPart;
+	return seconds * 1000000000ull + remainder * 1000000000ull / frequency.QuadPart;
+}
+
+bool platform_getAllocationCount(_Out_ uint64_t* count)
+{
+	*count = (uint64_t)allocationCount;
+#ifdef _DEBUG
+	return true;
+#else
+	return false;
+#endif // _DEBUG
+}
+
+void platform_takeInput(_In_ NkContext* ctx, _Out_ struct PlatformInput* input)
+{
+	struct PlatformResources* rsc = ctx->userdata.ptr;
+	*input = rsc->input;
+	rsc->input.pressed = 0;
+	rsc->input.released = 0;
+	rsc->input.scroll = 0.0f;
+}
+
+struct nk_draw_null_texture platform_getNullTexture(_In_ NkContext* ctx)
+{
+	return ((struct PlatformResources*)ctx->userdata.ptr)->nullTexture;
+}
+
+bool platform_makeWindowCurrent(_In_ NkContext* ctx, _In_ bool isCurrent)
+{
+	struct PlatformResources* rsc = ctx->userdata.ptr;
+	if (!isCurrent)
+		return wglMakeCurrent(NULL, NULL);
+
+	HDC hDC = GetDC(rsc->hMainWnd);
+	bool success = hDC && wglMakeCurrent(hDC, rsc->hCtx);
+	if (hDC)
+		ReleaseDC(rsc->hMainWnd, hDC);
+	return success;
+}
+
+PlatformContext* platform_createSharedContext(_In_ NkContext* ctx)
+{
+	struct PlatformResources* rsc = ctx->userdata.ptr;
+
+	PlatformContext* context = malloc(sizeof * context);
+	if (context == NULL)
+		return NULL;
+
+	HDC hDC = GetDC(rsc->hMainWnd);
+	context->hCtx = hDC ? wglCreateContextAttribsARB(hDC, rsc->hCtx, rsc->ctxAttribs) : NULL;
+	if (hDC)
+		ReleaseDC(rsc->hMainWnd, hDC);
+
+	if (context->hCtx == NULL)
+	{
+		free(context);
+		return NULL;
+	}
+	return context;
+}
+
+bool platform_makeCurrent(_In_ NkContext* ctx, _In_opt_ PlatformContext* context)
+{
+	if (context == NULL)
+		return wglMakeCurrent(NULL, NULL);
+
+	// Any DC with the same pixel format will do, the worker never draws to it.
+	HWND hMainWnd = getMainWnd(ctx);
+	HDC hDC = GetDC(hMainWnd);
+	bool success = hDC && wglMakeCurrent(hDC, context->hCtx);
+	if (hDC)
+		ReleaseDC(hMainWnd, hDC);
+	return success;
+}
+
+void platform_destroySharedContext(_In_ NkContext* ctx, _In_opt_ PlatformContext* context)
+{
+	(void)ctx;
+	if (context == NULL)
+		return;
+	wglDeleteContext(context->hCtx);
+	free(context);
+}
@@ -0,0 +1,431 @@
+/**
+
+    @file      x11.c
+    @brief     Windowed platform layer on top of Xlib and GLX
+    @details   Counterpart of win32.c: creates a GL 4.6 core context through
+               GLX_ARB_create_context and pumps the X event queue without ever
+               blocking the render loop. Runs under Xvfb with llvmpipe.
+
+               Environment:
+                 CROX_WIDTH, CROX_HEIGHT - initial client size, default 1280x720
+                 CROX_VSYNC              - 0 disables vsync, otherwise adaptive vsync when available
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "framework_nuklear.h"
+
+#include <glad/gl.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <GL/glx.h>
+#include "Platform.h"
+#include "posix.h"
+
+
+#define DEFAULT_WIDTH	1280
+#define DEFAULT_HEIGHT	720
+
+#ifndef GLX_CONTEXT_OPENGL_NO_ERROR_ARB
+#define GLX_CONTEXT_OPENGL_NO_ERROR_ARB 0x31B3
+#endif // !GLX_CONTEXT_OPENGL_NO_ERROR_ARB
+#ifndef GLX_CONTEXT_RELEASE_BEHAVIOR_ARB
+#define GLX_CONTEXT_RELEASE_BEHAVIOR_ARB 0x2097
+#define GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB 0x2098
+#endif // !GLX_CONTEXT_RELEASE_BEHAVIOR_ARB
+
+
+struct PlatformResources
+{
+	Display* display;
+	Window window;
+	Colormap colormap;
+	GLXFBConfig config;
+	GLXContext context;
+	Atom wmDeleteWindow;
+	uint32_t width;
+	uint32_t height;
+	struct PlatformInput input;		// gathered while polling, taken by the same thread
+	struct nk_draw_null_texture nullTexture;
+	void* aux;
+};
+static inline struct PlatformResources* getResources(NkContext* ctx)
+{
+	return (struct PlatformResources*)ctx->userdata.ptr;
+}
+
+struct PlatformContext
+{
+	GLXContext context;
+};
+
+static bool contextError = false;
+
+static int onContextError(Display* display, XErrorEvent* ev)
+//
+// Failing glXCreateContextAttribsARB raises an X error, which by default terminates the process.
+//
+{
+	(void)display;
+	(void)ev;
+	contextError = true;
+	return 0;
+}
+
+static GLXContext createContext(_In_ Display* display, _In_ GLXFBConfig config, _In_opt_ GLXContext share)
+{
+	PFNGLXCREATECONTEXTATTRIBSARBPROC glXCreateContextAttribsARB =
+		(PFNGLXCREATECONTEXTATTRIBSARBPROC)glXGetProcAddressARB((const GLubyte*)"glXCreateContextAttribsARB");
+
+	const char* extensions = glXQueryExtensionsString(display, DefaultScreen(display));
+	if (glXCreateContextAttribsARB == NULL || !posix_hasExtension(extensions, "GLX_ARB_create_context_profile"))
+		return NULL;
+
+	const bool robustness	= posix_hasExtension(extensions, "GLX_ARB_create_context_robustness");
+	const bool noError		= posix_hasExtension(extensions, "GLX_ARB_create_context_no_error");
+	const bool flushControl	= posix_hasExtension(extensions, "GLX_ARB_context_flush_control");
+
+	// Most specific request first, llvmpipe may lack 4.6, no-error or robustness depending on the Mesa release.
+	// No-error and robustness are mutually exclusive, GLX_ARB_create_context_no_error rejects both at once.
+	// Release builds want no-error, debug builds report errors and take robustness instead.
+	const struct { int minor; bool robust; bool noError; } attempts[] = {
+#ifdef _DEBUG
+		{ 6, true, false }, { 6, false, false },
+		{ 5, true, false }, { 5, false, false },
+#else
+		{ 6, false, true }, { 6, true, false }, { 6, false, false },
+		{ 5, false, true }, { 5, true, false }, { 5, false, false },
+#endif // _DEBUG
+	};
+
+	XErrorHandler previousHandler = XSetErrorHandler(onContextError);
+	GLXContext context = NULL;
+
+	for (size_t i = 0; context == NULL && i < sizeof attempts / sizeof * attempts; i++)
+	{
+		// Would only repeat the plain attempt ahead of the robust one.
+		if (attempts[i].noError && !noError)
+			continue;
+
+		int ctxFlags =
+#ifdef _DEBUG
+			GLX_CONTEXT_DEBUG_BIT_ARB |
+#endif // _DEBUG
+			(attempts[i].robust && robustness ? GLX_CONTEXT_ROBUST_ACCESS_BIT_ARB : 0);
+
+		int ctxAttribs[16];
+		int n = 0;
+		ctxAttribs[n++] = GLX_CONTEXT_MAJOR_VERSION_ARB;	ctxAttribs[n++] = 4;
+		ctxAttribs[n++] = GLX_CONTEXT_MINOR_VERSION_ARB;	ctxAttribs[n++] = attempts[i].minor;
+		ctxAttribs[n++] = GLX_CONTEXT_FLAGS_ARB;			ctxAttribs[n++] = ctxFlags;
+		ctxAttribs[n++] = GLX_CONTEXT_PROFILE_MASK_ARB;		ctxAttribs[n++] = GLX_CONTEXT_CORE_PROFILE_BIT_ARB;
+		if (attempts[i].noError)
+		{
+			ctxAttribs[n++] = GLX_CONTEXT_OPENGL_NO_ERROR_ARB; ctxAttribs[n++] = True;
+		}
+		if (attempts[i].robust && robustness)
+		{
+			ctxAttribs[n++] = GLX_CONTEXT_RESET_NOTIFICATION_STRATEGY_ARB; ctxAttribs[n++] = GLX_LOSE_CONTEXT_ON_RESET_ARB;
+		}
+		if (flushControl)
+		{
+			ctxAttribs[n++] = GLX_CONTEXT_RELEASE_BEHAVIOR_ARB; ctxAttribs[n++] = GLX_CONTEXT_RELEASE_BEHAVIOR_FLUSH_ARB;
+		}
+		ctxAttribs[n++] = None;
+
+		contextError = false;
+		context = glXCreateContextAttribsARB(display, config, share, True, ctxAttribs);
+		XSync(display, False);
+		if (contextError && context)
+		{
+			glXDestroyContext(display, context);
+			context = NULL;
+		}
+	}
+
+	XSetErrorHandler(previousHandler);
+	return context;
+}
+
+static void setSwapInterval(_In_ Display* display, _In_ Window window)
+//
+// Adaptive vsync (-1) tears instead of stalling a whole refresh when a frame misses the deadline.
+//
+{
+	const char* extensions = glXQueryExtensionsString(display, DefaultScreen(display));
+	if (!posix_hasExtension(extensions, "GLX_EXT_swap_control"))
+		return;
+
+	PFNGLXSWAPINTERVALEXTPROC glXSwapIntervalEXT =
+		(PFNGLXSWAPINTERVALEXTPROC)glXGetProcAddressARB((const GLubyte*)"glXSwapIntervalEXT");
+	if (glXSwapIntervalEXT == NULL)
+		return;
+
+	int interval = 0;
+	if (posix_envNumber("CROX_VSYNC", 1) != 0)
+		interval = posix_hasExtension(extensions, "GLX_EXT_swap_control_tear") ? -1 : 1;
+
+	glXSwapIntervalEXT(display, window, interval);
+}
+
+static void trackButton(_Inout_ struct PlatformInput* input, _In_ const XButtonEvent* ev)
+//
+// The wheel arrives as presses of buttons 4 and 5, each one notch.
+//
+{
+	const bool isDown = ev->type == ButtonPress;
+	input->mouseX = ev->x;
+	input->mouseY = ev->y;
+
+	uint32_t bit = 0;
+	switch (ev->button)
+	{
+	case Button1:	bit = 1u << NK_BUTTON_LEFT;		break;
+	case Button2:	bit = 1u << NK_BUTTON_MIDDLE;	break;
+	case Button3:	bit = 1u << NK_BUTTON_RIGHT;	break;
+	case Button4:	input->scroll += isDown ? 1.0f : 0.0f;	return;
+	case Button5:	input->scroll -= isDown ? 1.0f : 0.0f;	return;
+	default:		return;
+	}
+
+	if (isDown)
+	{
+		input->down |= bit;
+		input->pressed |= bit;
+	}
+	else
+	{
+		input->down &= ~bit;
+		input->released |= bit;
+	}
+}
+
+/**
+	@brief  Application Entry point
+	@param  argc -
+	@param  argv -
+	@param  envp -
+	@retval      - 0 on success
+**/
+int main(int argc, char** argv, char** envp)
+{
+	struct PlatformResources rsc = {
+		.display = NULL,
+		.window = None,
+		.colormap = None,
+		.config = NULL,
+		.context = NULL,
+		.wmDeleteWindow = None,
+		.width = (uint32_t)posix_envNumber("CROX_WIDTH", DEFAULT_WIDTH),
+		.height = (uint32_t)posix_envNumber("CROX_HEIGHT", DEFAULT_HEIGHT),
+		.aux = NULL,
+	};
+
+	const int fbIntAttribs[] = {
+		GLX_X_RENDERABLE,		True,
+		GLX_DRAWABLE_TYPE,		GLX_WINDOW_BIT,
+		GLX_RENDER_TYPE,		GLX_RGBA_BIT,
+		GLX_X_VISUAL_TYPE,		GLX_TRUE_COLOR,
+		GLX_DOUBLEBUFFER,		True,
+
+		GLX_RED_SIZE,			8,
+		GLX_GREEN_SIZE,			8,
+		GLX_BLUE_SIZE,			8,
+		GLX_ALPHA_SIZE,			8,
+
+		GLX_DEPTH_SIZE,			24,
+		GLX_STENCIL_SIZE,		8,
+
+		None
+	};
+
+	int glxMajor = 0, glxMinor = 0;
+	int configCount = 0;
+	GLXFBConfig* configs = NULL;
+	XVisualInfo* visual = NULL;
+
+	// Shared contexts are made current from worker threads on the same connection.
+	XInitThreads();
+
+	bool ctxInitialized =
+		(rsc.display = XOpenDisplay(NULL)) &&
+		glXQueryVersion(rsc.display, &glxMajor, &glxMinor) &&
+		(glxMajor > 1 || glxMinor >= 3) &&
+		(configs = glXChooseFBConfig(rsc.display, DefaultScreen(rsc.display), fbIntAttribs, &configCount)) &&
+		configCount > 0 &&
+		(visual = glXGetVisualFromFBConfig(rsc.display, configs[0]));
+
+	if (ctxInitialized)
+	{
+		Window root = RootWindow(rsc.display, visual->screen);
+		rsc.colormap = XCreateColormap(rsc.display, root, visual->visual, AllocNone);
+
+		XSetWindowAttributes swa = {
+			.colormap = rsc.colormap,
+			.background_pixmap = None,
+			.border_pixel = 0,
+			.event_mask = StructureNotifyMask | ExposureMask | KeyPressMask | KeyReleaseMask |
+				ButtonPressMask | ButtonReleaseMask | PointerMotionMask | FocusChangeMask,
+		};
+		rsc.window = XCreateWindow(rsc.display, root, 0, 0, rsc.width, rsc.height, 0,
+			visual->depth, InputOutput, visual->visual, CWBorderPixel | CWColormap | CWEventMask, &swa);
+
+		ctxInitialized =
+			rsc.window != None &&
+			XStoreName(rsc.display, rsc.window, "Crox") &&
+			(rsc.wmDeleteWindow = XInternAtom(rsc.display, "WM_DELETE_WINDOW", False)) != None &&
+			XSetWMProtocols(rsc.display, rsc.window, &rsc.wmDeleteWindow, 1) &&
+			(rsc.context = createContext(rsc.display, rsc.config = configs[0], NULL)) &&
+			glXMakeContextCurrent(rsc.display, rsc.window, rsc.window, rsc.context) &&
+			gladLoadGL((GLADloadfunc)glXGetProcAddressARB);
+	}
+	if (visual)
+		XFree(visual);
+	if (configs)
+		XFree(configs);
+	assert(ctxInitialized);
+
+	int result = -1;
+	if (ctxInitialized)
+	{
+#ifdef _DEBUG
+		gladInstallGLDebug();
+#else
+		gladUninstallGLDebug();
+#endif // _DEBUG
+		setSwapInterval(rsc.display, rsc.window);
+
+		result = posix_runCrox(&rsc, &rsc.nullTexture, argc, argv, envp);
+
+		glXMakeContextCurrent(rsc.display, None, None, NULL);
+	}
+
+	if (rsc.context)
+		glXDestroyContext(rsc.display, rsc.context);
+	if (rsc.window != None)
+		XDestroyWindow(rsc.display, rsc.window);
+	if (rsc.colormap != None)
+		XFreeColormap(rsc.display, rsc.colormap);
+	if (rsc.display)
+		XCloseDisplay(rsc.display);
+
+	return result;
+}
+
+
+void platform_getDimensions(_In_ NkContext* ctx, _Out_ uint32_t* width, _Out_ uint32_t* height)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	*width = rsc->width;
+	*height = rsc->height;
+}
+
+bool platform_swapBuffers(_In_ NkContext* ctx)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	glXSwapBuffers(rsc->display, rsc->window);
+	return true;
+}
+
+bool platform_show(_In_ NkContext* ctx)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	XMapWindow(rsc->display, rsc->window);
+	return XFlush(rsc->display);
+}
+
+bool platform_pollMessages(_In_ NkContext* ctx, _Out_ int* status)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+
+	*status = 0;
+
+	// XPending flushes the output buffer and reads whatever already arrived, it never waits for the server.
+	while (XPending(rsc->display))
+	{
+		XEvent ev;
+		XNextEvent(rsc->display, &ev);
+
+		switch (ev.type)
+		{
+		case ClientMessage:
+			if ((Atom)ev.xclient.data.l[0] == rsc->wmDeleteWindow)
+				return false;
+			break;
+		case DestroyNotify:
+			return false;
+		case ConfigureNotify:
+			rsc->width = (uint32_t)ev.xconfigure.width;
+			rsc->height = (uint32_t)ev.xconfigure.height;
+			break;
+		case MotionNotify:
+			rsc->input.mouseX = ev.xmotion.x;
+			rsc->input.mouseY = ev.xmotion.y;
+			break;
+		case ButtonPress:
+		case ButtonRelease:
+			trackButton(&rsc->input, &ev.xbutton);
+			break;
+		default:
+			break;
+		}
+	}
+
+	return true;
+}
+
+void platform_takeInput(_In_ NkContext* ctx, _Out_ struct PlatformInput* input)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	*input = rsc->input;
+	rsc->input.pressed = 0;
+	rsc->input.released = 0;
+	rsc->input.scroll = 0.0f;
+}
+
+struct nk_draw_null_texture platform_getNullTexture(_In_ NkContext* ctx)
+{
+	return getResources(ctx)->nullTexture;
+}
+
+bool platform_makeWindowCurrent(_In_ NkContext* ctx, _In_ bool isCurrent)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+	if (!isCurrent)
+		return glXMakeContextCurrent(rsc->display, None, None, NULL);
+	return glXMakeContextCurrent(rsc->display, rsc->window, rsc->window, rsc->context);
+}
+
+PlatformContext* platform_createSharedContext(_In_ NkContext* ctx)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+
+	PlatformContext* context = malloc(sizeof * context);
+	if (context == NULL)
+		return NULL;
+
+	context->context = createContext(rsc->display, rsc->config, rsc->context);
+	if (context->context == NULL)
+	{
+		free(context);
+		return NULL;
+	}
+	return context;
+}
+
+bool platform_makeCurrent(_In_ NkContext* ctx, _In_opt_ PlatformContext* context)
+{
+	struct PlatformResources* rsc = getResources(ctx);
+
+	// 3.0+ contexts may be current without any drawable, no pbuffer needed.
+	return glXMakeContextCurrent(rsc->display, None, None, context ? context->context : NULL);
+}
+
+void platform_destroySharedContext(_In_ NkContext* ctx, _In_opt_ PlatformContext* context)
+{
+	if (context == NULL)
+		return;
+	glXDestroyContext(getResources(ctx)->display, context->context);
+	free(context);
+}
@@ -0,0 +1,360 @@
+/**
+
+    @file      profiler.c
+    @brief     Nested CPU/GPU scope profiler
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "platform/Platform.h"
+#include "profiler.h"
+
+#include <string.h>
+#include <cJSON.h>
+
+
+// Frames in flight before a frame's queries are read, three is past any driver's queue depth.
+#define PROFILER_LATENCY	3
+#define PROFILER_MAX_SCOPES	256
+#define PROFILER_MAX_DEPTH	32
+
+#define NO_PARENT UINT32_MAX
+
+struct ProfileScope
+{
+	const char* name;
+	uint32_t parent;
+	uint32_t depth;
+	uint64_t cpuBegin;	// ns, platform clock
+	uint64_t cpuEnd;
+	uint64_t gpuBegin;	// ns, GL clock until resolved, platform clock afterwards
+	uint64_t gpuEnd;
+};
+
+struct ProfileFrame
+{
+	uint64_t index;
+	uint32_t scopeCount;
+	struct ProfileScope scopes[PROFILER_MAX_SCOPES];
+};
+
+struct Profiler
+{
+	GLuint queries[PROFILER_LATENCY][PROFILER_MAX_SCOPES * 2];
+	struct ProfileFrame recording[PROFILER_LATENCY];
+
+	struct ProfileFrame* history;
+	uint32_t historySize;
+	uint32_t historyCount;
+	uint32_t historyNext;
+
+	uint32_t stack[PROFILER_MAX_DEPTH];
+	uint32_t depth;
+	uint32_t dropped;		// scopes beyond PROFILER_MAX_SCOPES or PROFILER_MAX_DEPTH in the current frame
+
+	uint64_t frame;
+	bool inFrame;
+
+	int64_t gpuToCpu;		// added to GL timestamps to move them onto the platform clock
+};
+
+
+static inline struct ProfileFrame* currentFrame(_In_ Profiler* profiler)
+{
+	return &profiler->recording[profiler->frame % PROFILER_LATENCY];
+}
+
+static inline GLuint* currentQueries(_In_ Profiler* profiler)
+{
+	return profiler->queries[profiler->frame % PROFILER_LATENCY];
+}
+
+static void resolve(_Inout_ Profiler* profiler, _In_ uint32_t slot)
+{
+	struct ProfileFrame* frame = &profiler->recording[slot];
+	if (frame->scopeCount == 0)
+		return;
+
+	for (uint32_t i = 0; i < frame->scopeCount; i++)
+	{
+		GLuint64 begin = 0, end = 0;
+		glGetQueryObjectui64v(profiler->queries[slot][2 * i + 0], GL_QUERY_RESULT, &begin);
+		glGetQueryObjectui64v(profiler->queries[slot][2 * i + 1], GL_QUERY_RESULT, &end);
+		frame->scopes[i].gpuBegin = (uint64_t)((int64_t)begin + profiler->gpuToCpu);
+		frame->scopes[i].gpuEnd = (uint64_t)((int64_t)end + profiler->gpuToCpu);
+	}
+
+	struct ProfileFrame* resolved = &profiler->history[profiler->historyNext];
+	resolved->index = frame->index;
+	resolved->scopeCount = frame->scopeCount;
+	memcpy(resolved->scopes, frame->scopes, frame->scopeCount * sizeof * frame->scopes);
+
+	profiler->historyNext = (profiler->historyNext + 1) % profiler->historySize;
+	if (profiler->historyCount < profiler->historySize)
+		profiler->historyCount++;
+
+	frame->scopeCount = 0;
+}
+
+static const struct ProfileFrame* latestResolved(_In_ const Profiler* profiler)
+{
+	if (profiler->historyCount == 0)
+		return NULL;
+	return &profiler->history[(profiler->historyNext + profiler->historySize - 1) % profiler->historySize];
+}
+
+static uint32_t drawScope(_Inout_ NkContext* ctx, _In_ const struct ProfileFrame* frame, _In_ uint32_t index)
+{
+	const struct ProfileScope* scope = &frame->scopes[index];
+	uint32_t next = index + 1;
+
+	char label[128];
+	snprintf(label, sizeof label, "%s  cpu %.3f ms  gpu %.3f ms", scope->name,
+		(scope->cpuEnd - scope->cpuBegin) / 1e6, (scope->gpuEnd - scope->gpuBegin) / 1e6);
+
+	const bool hasChildren = next < frame->scopeCount && frame->scopes[next].parent == index;
+	if (!hasChildren)
+	{
+		nk_layout_row_dynamic(ctx, 18, 1);
+		nk_label(ctx, label, NK_TEXT_LEFT);
+		return next;
+	}
+
+	if (nk_tree_push_id(ctx, NK_TREE_NODE, label, NK_MAXIMIZED, (int)index))
+	{
+		while (next < frame->scopeCount && frame->scopes[next].parent == index)
+			next = drawScope(ctx, frame, next);
+		nk_tree_pop(ctx);
+	}
+	else // collapsed, skip the subtree which follows contiguously
+	{
+		while (next < frame->scopeCount && frame->scopes[next].depth > scope->depth)
+			next++;
+	}
+	return next;
+}
+
+static cJSON* makeTraceEvent(_In_z_ const char* name, _In_z_ const char* category, _In_ int tid,
+	_In_ uint64_t begin, _In_ uint64_t end, _In_ uint64_t frame)
+{
+	cJSON* event = cJSON_CreateObject();
+	cJSON_AddStringToObject(event, "name", name);
+	cJSON_AddStringToObject(event, "cat", category);
+	cJSON_AddStringToObject(event, "ph", "X");
+	cJSON_AddNumberToObject(event, "pid", 1);
+	cJSON_AddNumberToObject(event, "tid", tid);
+	cJSON_AddNumberToObject(event, "ts", begin / 1e3);		// µs
+	cJSON_AddNumberToObject(event, "dur", (end - begin) / 1e3);
+	cJSON* args = cJSON_AddObjectToObject(event, "args");
+	cJSON_AddNumberToObject(args, "frame", (double)frame);
+	return event;
+}
+
+static cJSON* makeThreadName(_In_ int tid, _In_z_ const char* name)
+{
+	cJSON* event = cJSON_CreateObject();
+	cJSON_AddStringToObject(event, "name", "thread_name");
+	cJSON_AddStringToObject(event, "ph", "M");
+	cJSON_AddNumberToObject(event, "pid", 1);
+	cJSON_AddNumberToObject(event, "tid", tid);
+	cJSON* args = cJSON_AddObjectToObject(event, "args");
+	cJSON_AddStringToObject(args, "name", name);
+	return event;
+}
+
+
+Profiler* profiler_create(_In_ uint32_t history)
+{
+	Profiler* profiler = calloc(1, sizeof * profiler);
+	if (profiler == NULL)
+		return NULL;
+
+	profiler->historySize = history ? history : 1;
+	profiler->history = malloc(profiler->historySize * sizeof * profiler->history);
+	if (profiler->history == NULL)
+	{
+		free(profiler);
+		return NULL;
+	}
+
+	for (uint32_t i = 0; i < PROFILER_LATENCY; i++)
+		glCreateQueries(GL_TIMESTAMP, PROFILER_MAX_SCOPES * 2, profiler->queries[i]);
+
+	// every scope is also a debug group, don't echo those through the debug callback
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PUSH_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+	glDebugMessageControl(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_POP_GROUP, GL_DONT_CARE, 0, NULL, GL_FALSE);
+
+	GLint64 gpuNow = 0;
+	glGetInteger64v(GL_TIMESTAMP, &gpuNow);
+	profiler->gpuToCpu = (int64_t)platform_getTime() - gpuNow;
+
+	return profiler;
+}
+
+void profiler_destroy(_In_opt_ Profiler* profiler)
+{
+	if (profiler == NULL)
+		return;
+
+	for (uint32_t i = 0; i < PROFILER_LATENCY; i++)
+		glDeleteQueries(PROFILER_MAX_SCOPES * 2, profiler->queries[i]);
+	free(profiler->history);
+	free(profiler);
+}
+
+void profiler_beginFrame(_Inout_opt_ Profiler* profiler)
+{
+	if (profiler == NULL)
+		return;
+	assert(!profiler->inFrame);
+
+	// The slot about to be reused was recorded PROFILER_LATENCY frames ago.
+	resolve(profiler, profiler->frame % PROFILER_LATENCY);
+
+	struct ProfileFrame* frame = currentFrame(profiler);
+	frame->index = profiler->frame;
+	frame->scopeCount = 0;
+	profiler->depth = 0;
+	profiler->dropped = 0;
+	profiler->inFrame = true;
+}
+
+void profiler_endFrame(_Inout_opt_ Profiler* profiler)
+{
+	if (profiler == NULL)
+		return;
+	assert(profiler->inFrame);
+
+	while (profiler->depth > 0)
+		profiler_pop(profiler);
+
+	profiler->inFrame = false;
+	profiler->frame++;
+}
+
+void profiler_push(_Inout_opt_ Profiler* profiler, _In_z_ const char* name)
+{
+	if (profiler == NULL || !profiler->inFrame)
+		return;
+
+	struct ProfileFrame* frame = currentFrame(profiler);
+	if (frame->scopeCount == PROFILER_MAX_SCOPES || profiler->depth == PROFILER_MAX_DEPTH || profiler->dropped)
+	{
+		// Everything nested in a dropped scope is dropped too, the tree would be inconsistent otherwise.
+		profiler->dropped++;
+		return;
+	}
+
+	const uint32_t index = frame->scopeCount++;
+	struct ProfileScope* scope = &frame->scopes[index];
+	scope->name = name;
+	scope->parent = profiler->depth ? profiler->stack[profiler->depth - 1] : NO_PARENT;
+	scope->depth = profiler->depth;
+	profiler->stack[profiler->depth++] = index;
+
+	glPushDebugGroup(GL_DEBUG_SOURCE_APPLICATION, index, -1, name);
+	glQueryCounter(currentQueries(profiler)[2 * index + 0], GL_TIMESTAMP);
+	scope->cpuBegin = platform_getTime();
+}
+
+void profiler_pop(_Inout_opt_ Profiler* profiler)
+{
+	if (profiler == NULL || !profiler->inFrame)
+		return;
+
+	if (profiler->dropped)
+	{
+		profiler->dropped--;
+		return;
+	}
+	if (profiler->depth == 0)
+		return;
+
+	const uint32_t index = profiler->stack[--profiler->depth];
+	struct ProfileScope* scope = &currentFrame(profiler)->scopes[index];
+
+	scope->cpuEnd = platform_getTime();
+	glQueryCounter(currentQueries(profiler)[2 * index + 1], GL_TIMESTAMP);
+	glPopDebugGroup();
+}
+
+void profiler_drawOverlay(_In_opt_ Profiler* profiler, _Inout_ NkContext* ctx, _In_opt_z_ const char* tracePath)
+{
+	if (profiler == NULL)
+		return;
+
+	const nk_flags flags =
+		NK_WINDOW_BORDER | NK_WINDOW_MOVABLE | NK_WINDOW_SCALABLE | NK_WINDOW_TITLE | NK_WINDOW_MINIMIZABLE;
+
+	if (nk_begin(ctx, "Profiler", nk_rect(10, 10, 420, 360), flags))
+	{
+		const struct ProfileFrame* frame = latestResolved(profiler);
+		if (frame)
+		{
+			nk_layout_row_dynamic(ctx, 18, 1);
+			nk_labelf(ctx, NK_TEXT_LEFT, "frame %llu", (unsigned long long)frame->index);
+
+			for (uint32_t i = 0; i < frame->scopeCount; )
+				i = drawScope(ctx, frame, i);
+		}
+
+		if (tracePath)
+		{
+			nk_layout_row_dynamic(ctx, 24, 1);
+			if (nk_button_label(ctx, "Dump trace"))
+				profiler_writeTrace(profiler, tracePath);
+		}
+	}
+	nk_end(ctx);
+}
+
+bool profiler_writeTrace(_In_opt_ Profiler* profiler, _In_z_ const char* path)
+{
+	if (profiler == NULL)
+		return false;
+
+	enum { TID_CPU = 1, TID_GPU = 2 };
+
+	// Drain the frames still in flight, this blocks on the GPU but only happens once at exit.
+	if (!profiler->inFrame)
+		for (uint32_t i = 0; i < PROFILER_LATENCY; i++)
+			resolve(profiler, (profiler->frame + i) % PROFILER_LATENCY);
+
+	cJSON* trace = cJSON_CreateObject();
+	if (trace == NULL)
+		return false;
+	cJSON_AddStringToObject(trace, "displayTimeUnit", "ms");
+	cJSON* events = cJSON_AddArrayToObject(trace, "traceEvents");
+	cJSON_AddItemToArray(events, makeThreadName(TID_CPU, "CPU"));
+	cJSON_AddItemToArray(events, makeThreadName(TID_GPU, "GPU"));
+
+	// Oldest first, the viewers do not care but it keeps diffs of dumps readable.
+	const uint32_t first = (profiler->historyNext + profiler->historySize - profiler->historyCount) % profiler->historySize;
+	for (uint32_t f = 0; f < profiler->historyCount; f++)
+	{
+		const struct ProfileFrame* frame = &profiler->history[(first + f) % profiler->historySize];
+		for (uint32_t i = 0; i < frame->scopeCount; i++)
+		{
+			const struct ProfileScope* scope = &frame->scopes[i];
+			cJSON_AddItemToArray(events,
+				makeTraceEvent(scope->name, "cpu", TID_CPU, scope->cpuBegin, scope->cpuEnd, frame->index));
+			cJSON_AddItemToArray(events,
+				makeTraceEvent(scope->name, "gpu", TID_GPU, scope->gpuBegin, scope->gpuEnd, frame->index));
+		}
+	}
+
+	char* json = cJSON_PrintUnformatted(trace);
+	cJSON_Delete(trace);
+	if (json == NULL)
+		return false;
+
+	FILE* file = fopen(path, "wb");
+	bool success = file != NULL && fputs(json, file) >= 0;
+	if (file)
+		success = fclose(file) == 0 && success;
+	cJSON_free(json);
+
+	return success;
+}
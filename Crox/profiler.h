@@ -0,0 +1,42 @@
+/**
+
+    @file      profiler.h
+    @brief     Nested CPU/GPU scope profiler
+    @details   Every scope is wrapped in a debug group, so captures in external
+               tools show the same hierarchy, and bracketed by GL_TIMESTAMP
+               queries. Queries are buffered over several frames and only read
+               back once they are old enough to never stall the pipeline.
+               All functions accept a NULL profiler and then do nothing, so the
+               instrumentation can stay in place when profiling is disabled.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_nuklear.h"
+#include "framework_opengl.h"
+
+
+typedef struct Profiler Profiler;
+
+//history is the number of resolved frames kept for the trace dump.
+Profiler* profiler_create(_In_ uint32_t history);
+
+void profiler_destroy(_In_opt_ Profiler* profiler);
+
+//resolves the oldest buffered frame and starts recording a new one.
+void profiler_beginFrame(_Inout_opt_ Profiler* profiler);
+
+void profiler_endFrame(_Inout_opt_ Profiler* profiler);
+
+//opens a scope nested in the current one. name must outlive the profiler, typically a string literal.
+void profiler_push(_Inout_opt_ Profiler* profiler, _In_z_ const char* name);
+
+void profiler_pop(_Inout_opt_ Profiler* profiler);
+
+//shows the most recently resolved frame as a tree, with a button to dump the trace to tracePath.
+void profiler_drawOverlay(_In_opt_ Profiler* profiler, _Inout_ NkContext* ctx, _In_opt_z_ const char* tracePath);
+
+//writes the resolved history in the Chrome trace event format (chrome://tracing, Perfetto).
+bool profiler_writeTrace(_In_opt_ Profiler* profiler, _In_z_ const char* path);
\ No newline at end of file
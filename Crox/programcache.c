@@ -0,0 +1,188 @@
+/**
+
+    @file      programcache.c
+    @brief     On-disk cache of linked program binaries
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "programcache.h"
+#include "platform/MappedFile.h"
+
+#include <string.h>
+#include <errno.h>
+#include <hashmap.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define makeDirectory(path) mkdir((path), 0755)
+#endif // _WIN32
+
+
+#define PROGRAM_CACHE_MAGIC		0x50584F43u // "COXP"
+#define PROGRAM_CACHE_VERSION	1u
+
+// Arbitrary, only has to stay the same between runs.
+#define PROGRAM_CACHE_SEED0		0x43726F78u
+#define PROGRAM_CACHE_SEED1		0x50726F67u
+
+struct ProgramBinaryHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t key;		// repeated so that a renamed or truncated file can't be mistaken for another
+	uint32_t format;
+	uint32_t length;
+};
+
+struct ProgramCache
+{
+	char* directory;
+	uint64_t driverHash;
+};
+
+
+static uint64_t hashString(_In_opt_z_ const char* s, _In_ uint64_t seed)
+{
+	if (s == NULL)
+		s = "";
+	return hashmap_sip(s, strlen(s) + 1, seed, PROGRAM_CACHE_SEED1);
+}
+
+static char* makePath(_In_ const ProgramCache* cache, _In_ uint64_t key, _In_z_ const char* extension)
+{
+	int length = snprintf(NULL, 0, "%s/%016llx%s", cache->directory, (unsigned long long)key, extension);
+	char* path = malloc((size_t)length + 1);
+	if (path)
+		snprintf(path, (size_t)length + 1, "%s/%016llx%s", cache->directory, (unsigned long long)key, extension);
+	return path;
+}
+
+
+ProgramCache* programcache_create(_In_z_ const char* directory)
+{
+	GLint formatCount = 0;
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount);
+	if (formatCount <= 0)
+		return NULL;
+
+	if (makeDirectory(directory) != 0 && errno != EEXIST)
+		return NULL;
+
+	ProgramCache* cache = malloc(sizeof * cache);
+	if (cache == NULL)
+		return NULL;
+	cache->directory = malloc(strlen(directory) + 1);
+	if (cache->directory == NULL)
+	{
+		free(cache);
+		return NULL;
+	}
+	strcpy(cache->directory, directory);
+
+	uint64_t h = PROGRAM_CACHE_SEED0;
+	h = hashString((const char*)glGetString(GL_VENDOR), h);
+	h = hashString((const char*)glGetString(GL_RENDERER), h);
+	h = hashString((const char*)glGetString(GL_VERSION), h);
+	h = hashString((const char*)glGetString(GL_SHADING_LANGUAGE_VERSION), h);
+	cache->driverHash = h;
+
+	return cache;
+}
+
+void programcache_destroy(_In_opt_ ProgramCache* cache)
+{
+	if (cache == NULL)
+		return;
+	free(cache->directory);
+	free(cache);
+}
+
+uint64_t programcache_key(_In_opt_ const ProgramCache* cache, _In_ uint32_t count, _In_reads_(count) const char* const* sources)
+{
+	if (cache == NULL)
+		return 0;
+
+	uint64_t h = cache->driverHash;
+	for (uint32_t i = 0; i < count; i++)
+		h = hashString(sources[i], h);
+	return h;
+}
+
+bool programcache_load(_In_opt_ ProgramCache* cache, _In_ uint64_t key, _In_ GLuint program)
+{
+	if (cache == NULL)
+		return false;
+
+	char* path = makePath(cache, key, ".bin");
+	if (path == NULL)
+		return false;
+	FILE* file = fopen(path, "rb");
+	free(path);
+	if (file == NULL)
+		return false;
+
+	bool success = false;
+	void* binary = NULL;
+
+	struct ProgramBinaryHeader header;
+	if (fread(&header, sizeof header, 1, file) != 1)
+		goto done;
+	if (header.magic != PROGRAM_CACHE_MAGIC || header.version != PROGRAM_CACHE_VERSION || header.key != key || header.length == 0)
+		goto done;
+
+	binary = malloc(header.length);
+	if (binary == NULL || fread(binary, 1, header.length, file) != header.length)
+		goto done;
+
+	glProgramBinary(program, header.format, binary, (GLsizei)header.length);
+
+	// A driver is free to reject a binary it produced itself, the caller then compiles from source.
+	GLint isLinked = false;
+	glGetProgramiv(program, GL_LINK_STATUS, &isLinked);
+	success = isLinked;
+
+done:
+	free(binary);
+	fclose(file);
+	return success;
+}
+
+bool programcache_store(_In_opt_ ProgramCache* cache, _In_ uint64_t key, _In_ GLuint program)
+{
+	if (cache == NULL)
+		return false;
+
+	GLint length = 0;
+	glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0)
+		return false;
+
+	void* binary = malloc((size_t)length);
+	if (binary == NULL)
+		return false;
+
+	GLenum format = 0;
+	glGetProgramBinary(program, length, NULL, &format, binary);
+
+	struct ProgramBinaryHeader header =
+	{
+		.magic = PROGRAM_CACHE_MAGIC,
+		.version = PROGRAM_CACHE_VERSION,
+		.key = key,
+		.format = format,
+		.length = (uint32_t)length,
+	};
+
+	char* path = makePath(cache, key, ".bin");
+	const bool success = path && mappedfile_replace(path, &header, sizeof header, binary, (size_t)length);
+
+	free(path);
+	free(binary);
+	return success;
+}
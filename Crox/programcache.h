@@ -0,0 +1,36 @@
+/**
+
+    @file      programcache.h
+    @brief     On-disk cache of linked program binaries
+    @details   Programs are keyed by a hash of their fully preprocessed sources
+               together with the driver vendor, renderer and version strings,
+               so a driver update or an edited include silently misses instead
+               of loading a stale binary.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+
+
+typedef struct ProgramCache ProgramCache;
+
+/**
+	@brief  Opens the cache directory, creating it if necessary.
+	@param  directory - where the binaries are kept
+	@retval           - NULL if the driver exposes no binary formats or allocation failed
+**/
+ProgramCache* programcache_create(_In_z_ const char* directory);
+
+void programcache_destroy(_In_opt_ ProgramCache* cache);
+
+//hashes the preprocessed sources of one program, in stage order, into a cache key.
+uint64_t programcache_key(_In_opt_ const ProgramCache* cache, _In_ uint32_t count, _In_reads_(count) const char* const* sources);
+
+//loads the binary stored under key into program. Returns false on a miss or if the driver rejected the binary.
+bool programcache_load(_In_opt_ ProgramCache* cache, _In_ uint64_t key, _In_ GLuint program);
+
+//writes the binary of a linked program under key, the program must have been linked with GL_PROGRAM_BINARY_RETRIEVABLE_HINT.
+bool programcache_store(_In_opt_ ProgramCache* cache, _In_ uint64_t key, _In_ GLuint program);
@@ -0,0 +1,277 @@
+/**
+
+    @file      programlibrary.c
+    @brief     Deduplicating front end to the compile queue
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "programlibrary.h"
+
+#include <string.h>
+#include <hashmap.h>
+
+
+static const GLenum SHADER_TYPES[PIPELINE_STAGE_COUNT] =
+{
+	GL_VERTEX_SHADER, GL_TESS_CONTROL_SHADER, GL_TESS_EVALUATION_SHADER, GL_GEOMETRY_SHADER, GL_FRAGMENT_SHADER,
+};
+
+static const GLbitfield STAGE_BITS[PIPELINE_STAGE_COUNT] =
+{
+	GL_VERTEX_SHADER_BIT, GL_TESS_CONTROL_SHADER_BIT, GL_TESS_EVALUATION_SHADER_BIT, GL_GEOMETRY_SHADER_BIT, GL_FRAGMENT_SHADER_BIT,
+};
+
+struct ProgramEntry
+{
+	char* paths[PIPELINE_STAGE_COUNT];
+	char* defines;
+	bool separable;
+	ProgramRequest* request;
+};
+
+struct PipelineEntry
+{
+	ProgramRequest* stages[PIPELINE_STAGE_COUNT];
+	GLuint programs[PIPELINE_STAGE_COUNT];	// as bound, a stage reloaded since has to be bound again
+	GLuint pipeline;
+};
+
+struct ProgramLibrary
+{
+	CompileQueue* queue;
+	struct hashmap* programs;
+	struct hashmap* pipelines;
+};
+
+
+static uint64_t hashString(_In_opt_z_ const char* s, _In_ uint64_t seed0, _In_ uint64_t seed1)
+{
+	// NULL and "" must not collide, an empty defines string is still a different program key than none.
+	return s ? hashmap_sip(s, strlen(s) + 1, seed0, seed1) : hashmap_sip("", 0, seed0, seed1);
+}
+
+static int compareString(_In_opt_z_ const char* a, _In_opt_z_ const char* b)
+{
+	if (a == NULL || b == NULL)
+		return (a != NULL) - (b != NULL);
+	return strcmp(a, b);
+}
+
+static uint64_t hashProgram(const void* item, uint64_t seed0, uint64_t seed1)
+{
+	const struct ProgramEntry* entry = item;
+	uint64_t h = seed0 ^ entry->separable;
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+		h = hashString(entry->paths[i], h, seed1);
+	return hashString(entry->defines, h, seed1);
+}
+
+static int compareProgram(const void* a, const void* b, void* udata)
+{
+	const struct ProgramEntry* x = a, * y = b;
+	(void)udata;
+
+	if (x->separable != y->separable)
+		return x->separable - y->separable;
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+	{
+		int order = compareString(x->paths[i], y->paths[i]);
+		if (order != 0)
+			return order;
+	}
+	return compareString(x->defines, y->defines);
+}
+
+static void freeProgram(void* item)
+{
+	struct ProgramEntry* entry = item;
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+		free(entry->paths[i]);
+	free(entry->defines);
+}
+
+static uint64_t hashPipeline(const void* item, uint64_t seed0, uint64_t seed1)
+{
+	const struct PipelineEntry* entry = item;
+	return hashmap_sip(entry->stages, sizeof entry->stages, seed0, seed1);
+}
+
+static int comparePipeline(const void* a, const void* b, void* udata)
+{
+	const struct PipelineEntry* x = a, * y = b;
+	(void)udata;
+	return memcmp(x->stages, y->stages, sizeof x->stages);
+}
+
+static char* duplicate(_In_opt_z_ const char* s)
+{
+	if (s == NULL)
+		return NULL;
+	char* copy = malloc(strlen(s) + 1);
+	if (copy)
+		strcpy(copy, s);
+	return copy;
+}
+
+static char* makeName(_In_ const struct ProgramDesc* desc)
+//
+// "default.vert+default.frag", only used as debug label.
+//
+{
+	size_t length = 1;
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+		if (desc->paths[i])
+			length += strlen(desc->paths[i]) + 1;
+
+	char* name = malloc(length);
+	if (name == NULL)
+		return NULL;
+	name[0] = '\0';
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+	{
+		if (desc->paths[i] == NULL)
+			continue;
+		if (name[0] != '\0')
+			strcat(name, "+");
+		strcat(name, desc->paths[i]);
+	}
+	return name;
+}
+
+
+ProgramLibrary* programlibrary_create(_In_ CompileQueue* queue)
+{
+	ProgramLibrary* library = calloc(1, sizeof * library);
+	if (library == NULL)
+		return NULL;
+
+	library->queue = queue;
+	library->programs = hashmap_new(sizeof(struct ProgramEntry), 0, 0, 0, hashProgram, compareProgram, freeProgram, NULL);
+	library->pipelines = hashmap_new(sizeof(struct PipelineEntry), 0, 0, 0, hashPipeline, comparePipeline, NULL, NULL);
+	if (library->programs == NULL || library->pipelines == NULL)
+	{
+		programlibrary_destroy(library);
+		return NULL;
+	}
+	return library;
+}
+
+void programlibrary_destroy(_In_opt_ ProgramLibrary* library)
+{
+	if (library == NULL)
+		return;
+
+	if (library->pipelines)
+	{
+		size_t i = 0;
+		void* item = NULL;
+		while (hashmap_iter(library->pipelines, &i, &item))
+		{
+			struct PipelineEntry* entry = item;
+			glDeleteProgramPipelines(1, &entry->pipeline);
+		}
+		hashmap_free(library->pipelines);
+	}
+	if (library->programs)
+		hashmap_free(library->programs);
+	free(library);
+}
+
+ProgramRequest* programlibrary_program(_Inout_ ProgramLibrary* library, _In_ const struct ProgramDesc* desc)
+{
+	// Only looked up, so casting the borrowed strings in is fine.
+	struct ProgramEntry key = { .defines = (char*)desc->defines, .separable = desc->separable };
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+		key.paths[i] = (char*)desc->paths[i];
+
+	const struct ProgramEntry* found = hashmap_get(library->programs, &key);
+	if (found)
+		return found->request;
+
+	struct ShaderStage stages[PIPELINE_STAGE_COUNT];
+	uint32_t count = 0;
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+	{
+		if (desc->paths[i] == NULL)
+			continue;
+		stages[count++] = (struct ShaderStage){ .type = SHADER_TYPES[i], .path = desc->paths[i], .defines = desc->defines };
+	}
+	if (count == 0)
+		return NULL;
+
+	char* name = makeName(desc);
+	if (name == NULL)
+		return NULL;
+	ProgramRequest* request = compilequeue_submit(library->queue, name, count, stages, desc->separable);
+	free(name);
+	if (request == NULL)
+		return NULL;
+
+	struct ProgramEntry entry = { .defines = duplicate(desc->defines), .separable = desc->separable, .request = request };
+	bool success = desc->defines == NULL || entry.defines != NULL;
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+	{
+		entry.paths[i] = duplicate(desc->paths[i]);
+		success = success && (desc->paths[i] == NULL || entry.paths[i] != NULL);
+	}
+
+	// Still usable without the entry, it just won't be shared.
+	if (success)
+		hashmap_set(library->programs, &entry);
+	if (!success || hashmap_oom(library->programs))
+		freeProgram(&entry);
+	return request;
+}
+
+ProgramRequest* programlibrary_stage(_Inout_ ProgramLibrary* library, _In_ enum PipelineStage stage, _In_z_ const char* path, _In_opt_z_ const char* defines)
+{
+	struct ProgramDesc desc = { .defines = defines, .separable = true };
+	desc.paths[stage] = path;
+	return programlibrary_program(library, &desc);
+}
+
+GLuint programlibrary_pipeline(_Inout_ ProgramLibrary* library, _In_reads_(PIPELINE_STAGE_COUNT) ProgramRequest* const* stages)
+{
+	struct PipelineEntry entry = { .pipeline = 0 };
+	memcpy(entry.stages, stages, sizeof entry.stages);
+
+	// Only the key is hashed, the entry itself can be updated in place.
+	struct PipelineEntry* found = (struct PipelineEntry*)hashmap_get(library->pipelines, &entry);
+	if (found)
+	{
+		for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+		{
+			GLuint program = compilequeue_program(stages[i], 0);
+			if (program != found->programs[i])
+			{
+				glUseProgramStages(found->pipeline, STAGE_BITS[i], program);
+				found->programs[i] = program;
+			}
+		}
+		return found->pipeline;
+	}
+
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+		if (stages[i] && compilequeue_state(stages[i]) != PROGRAM_READY)
+			return 0;
+
+	glCreateProgramPipelines(1, &entry.pipeline);
+	for (uint32_t i = 0; i < PIPELINE_STAGE_COUNT; i++)
+	{
+		if (stages[i] == NULL)
+			continue;
+		entry.programs[i] = compilequeue_program(stages[i], 0);
+		glUseProgramStages(entry.pipeline, STAGE_BITS[i], entry.programs[i]);
+	}
+
+	hashmap_set(library->pipelines, &entry);
+	if (hashmap_oom(library->pipelines))
+	{
+		glDeleteProgramPipelines(1, &entry.pipeline);
+		return 0;
+	}
+	return entry.pipeline;
+}
@@ -0,0 +1,56 @@
+/**
+
+    @file      programlibrary.h
+    @brief     Deduplicating front end to the compile queue
+    @details   Programs are keyed on their stage paths and defines, asking for
+               the same combination twice hands back the same program. Single
+               stage separable programs can be combined into program pipelines
+               so permutations mix without relinking.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "compilequeue.h"
+
+
+typedef struct ProgramLibrary ProgramLibrary;
+
+enum PipelineStage
+{
+	PIPELINE_STAGE_VERTEX,
+	PIPELINE_STAGE_TESS_CONTROL,
+	PIPELINE_STAGE_TESS_EVALUATION,
+	PIPELINE_STAGE_GEOMETRY,
+	PIPELINE_STAGE_FRAGMENT,
+
+	PIPELINE_STAGE_COUNT
+};
+
+struct ProgramDesc
+{
+	_In_opt_z_ const char* paths[PIPELINE_STAGE_COUNT];	// NULL for unused stages
+	_In_opt_z_ const char* defines;						// see ShaderStage::defines, applied to every stage
+	bool separable;
+};
+
+//the library submits through queue, which must outlive it.
+ProgramLibrary* programlibrary_create(_In_ CompileQueue* queue);
+
+//deletes the pipelines, the programs belong to the compile queue.
+void programlibrary_destroy(_In_opt_ ProgramLibrary* library);
+
+//returns the program for this stage combination, submitting it only the first time it is asked for.
+ProgramRequest* programlibrary_program(_Inout_ ProgramLibrary* library, _In_ const struct ProgramDesc* desc);
+
+//shorthand for a separable program holding only one stage.
+ProgramRequest* programlibrary_stage(_Inout_ ProgramLibrary* library, _In_ enum PipelineStage stage, _In_z_ const char* path, _In_opt_z_ const char* defines);
+
+/**
+	@brief  Returns the program pipeline combining separable programs, one per stage.
+	@param  stages - separable programs indexed by PipelineStage, NULL for unused stages
+	@retval        - 0 until every stage has linked, or if any failed
+**/
+GLuint programlibrary_pipeline(_Inout_ ProgramLibrary* library, _In_reads_(PIPELINE_STAGE_COUNT) ProgramRequest* const* stages);
@@ -0,0 +1,689 @@
+/**
+
+    @file      rendergraph.c
+    @brief     Per-frame graph of render passes and the resources they touch
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "rendergraph.h"
+
+#include <string.h>
+
+
+#define RENDERGRAPH_MAX_ATTACHMENTS	8
+
+// Pooled textures nobody asked for in this many frames are deleted.
+#define RENDERGRAPH_IDLE_FRAMES		8
+
+// Formats other than the storage's a pooled texture is viewed as.
+#define RENDERGRAPH_MAX_VIEWS		4
+
+enum ResourceKind
+{
+	RESOURCE_TEXTURE,
+	RESOURCE_BUFFER,
+	RESOURCE_FRAMEBUFFER,
+};
+
+struct GraphResource
+{
+	const char* name;
+	enum ResourceKind kind;
+	bool isImported;
+	struct RenderTextureDesc desc;
+	GLuint object;				// physical texture, buffer or framebuffer, transient textures get theirs when executing
+
+	bool isRequired;			// read by a pass that runs
+	uint32_t firstPass;			// lifetime among the passes that run, as positions in the execution order
+	uint32_t lastPass;
+
+	bool isIncoherent;			// last written through image or storage access
+	GLbitfield barriers;		// issued since that write
+};
+
+struct GraphAccess
+{
+	uint32_t pass;
+	RenderResource resource;
+	enum RenderAccess access;
+	bool isWrite;
+	GLenum attachment;			// GL_NONE unless RENDER_ACCESS_ATTACHMENT on a texture
+};
+
+struct GraphPass
+{
+	const char* name;
+	RenderPassProc execute;
+	void* user;
+	bool keep;
+	bool isNeeded;
+	bool isScheduled;
+	uint32_t waiting;			// edges from passes not scheduled yet
+	uint32_t position;			// in the execution order
+};
+
+// The pass before has to run before the pass after.
+struct GraphEdge
+{
+	uint32_t before;
+	uint32_t after;
+};
+
+struct TextureView
+{
+	GLenum format;
+	GLuint texture;
+};
+
+struct PooledTexture
+{
+	struct RenderTextureDesc desc;
+	GLuint texture;
+	struct TextureView views[RENDERGRAPH_MAX_VIEWS];
+	uint32_t viewCount;
+	int64_t busyUntil;			// last pass of the transient using it this frame, -1 when free
+	uint64_t lastFrame;			// frame it was last used in
+};
+
+struct CachedFramebuffer
+{
+	uint32_t count;
+	GLenum attachments[RENDERGRAPH_MAX_ATTACHMENTS];
+	GLuint textures[RENDERGRAPH_MAX_ATTACHMENTS];
+	GLuint framebuffer;
+};
+
+struct RenderGraph
+{
+	struct GraphResource* resources;
+	uint32_t resourceCount;
+	uint32_t resourceCapacity;
+	struct GraphPass* passes;
+	uint32_t passCount;
+	uint32_t passCapacity;
+	struct GraphAccess* accesses;
+	uint32_t accessCount;
+	uint32_t accessCapacity;
+	struct GraphEdge* edges;
+	uint32_t edgeCount;
+	uint32_t edgeCapacity;
+	uint32_t* order;			// pass indices in execution order
+	uint32_t orderCapacity;
+
+	struct PooledTexture* pool;
+	uint32_t poolCount;
+	uint32_t poolCapacity;
+	struct CachedFramebuffer* framebuffers;
+	uint32_t framebufferCount;
+	uint32_t framebufferCapacity;
+
+	uint64_t frame;
+};
+
+
+static bool grow(_Inout_ void** array, _Inout_ uint32_t* capacity, _In_ uint32_t count, _In_ size_t elementSize)
+{
+	if (count < *capacity)
+		return true;
+	uint32_t newCapacity = *capacity ? *capacity * 2 : 16;
+	void* newArray = realloc(*array, newCapacity * elementSize);
+	if (newArray == NULL)
+		return false;
+	*array = newArray;
+	*capacity = newCapacity;
+	return true;
+}
+
+static GLbitfield barrierFor(_In_ enum RenderAccess access)
+//
+// What has to be made visible before an access can see an incoherent write.
+//
+{
+	switch (access)
+	{
+	case RENDER_ACCESS_SAMPLED:		return GL_TEXTURE_FETCH_BARRIER_BIT;
+	case RENDER_ACCESS_IMAGE:		return GL_SHADER_IMAGE_ACCESS_BARRIER_BIT;
+	case RENDER_ACCESS_STORAGE:		return GL_SHADER_STORAGE_BARRIER_BIT;
+	case RENDER_ACCESS_UNIFORM:		return GL_UNIFORM_BARRIER_BIT;
+	case RENDER_ACCESS_VERTEX:		return GL_VERTEX_ATTRIB_ARRAY_BARRIER_BIT;
+	case RENDER_ACCESS_INDEX:		return GL_ELEMENT_ARRAY_BARRIER_BIT;
+	case RENDER_ACCESS_INDIRECT:	return GL_COMMAND_BARRIER_BIT;
+	case RENDER_ACCESS_ATTACHMENT:	return GL_FRAMEBUFFER_BARRIER_BIT;
+	case RENDER_ACCESS_TRANSFER:	return GL_TEXTURE_UPDATE_BARRIER_BIT | GL_BUFFER_UPDATE_BARRIER_BIT | GL_PIXEL_BUFFER_BARRIER_BIT;
+	default:						return GL_ALL_BARRIER_BITS;
+	}
+}
+
+static uint32_t viewClass(_In_ GLenum format)
+//
+// Bits per texel of the view compatibility classes in the GL spec, formats of one class can view each other's storage.
+// 0 for formats only compatible with themselves, depth and stencil among them.
+//
+{
+	switch (format)
+	{
+	case GL_RGBA32F: case GL_RGBA32UI: case GL_RGBA32I:
+		return 128;
+	case GL_RGBA16F: case GL_RG32F: case GL_RGBA16UI: case GL_RG32UI: case GL_RGBA16I: case GL_RG32I:
+	case GL_RGBA16: case GL_RGBA16_SNORM:
+		return 64;
+	case GL_RG16F: case GL_R11F_G11F_B10F: case GL_R32F: case GL_RGB10_A2UI: case GL_RGBA8UI: case GL_RG16UI:
+	case GL_R32UI: case GL_RGBA8I: case GL_RG16I: case GL_R32I: case GL_RGB10_A2: case GL_RGBA8: case GL_RG16:
+	case GL_RGBA8_SNORM: case GL_RG16_SNORM: case GL_SRGB8_ALPHA8: case GL_RGB9_E5:
+		return 32;
+	case GL_R16F: case GL_RG8UI: case GL_R16UI: case GL_RG8I: case GL_R16I: case GL_RG8: case GL_R16:
+	case GL_RG8_SNORM: case GL_R16_SNORM:
+		return 16;
+	case GL_R8UI: case GL_R8I: case GL_R8: case GL_R8_SNORM:
+		return 8;
+	default:
+		return 0;
+	}
+}
+
+static bool isSameShape(_In_ const struct RenderTextureDesc* a, _In_ const struct RenderTextureDesc* b)
+{
+	return a->width == b->width && a->height == b->height && a->levels == b->levels;
+}
+
+static bool isViewable(_In_ GLenum storage, _In_ GLenum format)
+{
+	return storage == format || (viewClass(storage) != 0 && viewClass(storage) == viewClass(format));
+}
+
+static GLuint viewAs(_Inout_ struct PooledTexture* pooled, _In_ GLenum format)
+//
+// The pooled storage in another format of its class, views are made once and kept with the storage. 0 when out of views.
+//
+{
+	if (pooled->desc.format == format)
+		return pooled->texture;
+	for (uint32_t i = 0; i < pooled->viewCount; i++)
+		if (pooled->views[i].format == format)
+			return pooled->views[i].texture;
+	if (pooled->viewCount == RENDERGRAPH_MAX_VIEWS)
+		return 0;
+
+	// Views need a name that was never bound, glCreateTextures would already give it a target.
+	struct TextureView* view = &pooled->views[pooled->viewCount++];
+	view->format = format;
+	glGenTextures(1, &view->texture);
+	glTextureView(view->texture, GL_TEXTURE_2D, pooled->texture, format, 0, pooled->desc.levels, 0, 1);
+	return view->texture;
+}
+
+static RenderResource addResource(_Inout_ RenderGraph* graph, _In_ const struct GraphResource* resource)
+{
+	if (!grow((void**)&graph->resources, &graph->resourceCapacity, graph->resourceCount, sizeof * graph->resources))
+		return RENDER_RESOURCE_NONE;
+	graph->resources[graph->resourceCount] = *resource;
+	return graph->resourceCount++;
+}
+
+static void addAccess(_Inout_ RenderGraph* graph, _In_ const struct GraphAccess* access)
+{
+	if (access->resource >= graph->resourceCount || access->pass >= graph->passCount)
+		return;
+	if (!grow((void**)&graph->accesses, &graph->accessCapacity, graph->accessCount, sizeof * graph->accesses))
+		return;
+	graph->accesses[graph->accessCount++] = *access;
+}
+
+static bool writes(_In_ const RenderGraph* graph, _In_ uint32_t pass, _In_ RenderResource resource)
+{
+	for (uint32_t i = 0; i < graph->accessCount; i++)
+		if (graph->accesses[i].pass == pass && graph->accesses[i].resource == resource && graph->accesses[i].isWrite)
+			return true;
+	return false;
+}
+
+static void sortPasses(_Inout_ RenderGraph* graph)
+//
+// A pass that only reads a resource runs after every pass writing it, passes writing the same resource keep their declaration order.
+// Of the passes free to run the first declared goes next, a cycle falls back to declaration order for the passes on it.
+//
+{
+	graph->edgeCount = 0;
+	for (uint32_t i = 0; i < graph->accessCount; i++)
+	{
+		const struct GraphAccess* write = &graph->accesses[i];
+		if (!write->isWrite)
+			continue;
+		for (uint32_t j = 0; j < graph->accessCount; j++)
+		{
+			const struct GraphAccess* other = &graph->accesses[j];
+			if (other->resource != write->resource || other->pass == write->pass)
+				continue;
+			const bool isAfter = other->isWrite ? other->pass > write->pass : !writes(graph, other->pass, other->resource);
+			if (!isAfter || !grow((void**)&graph->edges, &graph->edgeCapacity, graph->edgeCount, sizeof * graph->edges))
+				continue;
+			graph->edges[graph->edgeCount++] = (struct GraphEdge){ .before = write->pass, .after = other->pass };
+		}
+	}
+
+	for (uint32_t p = 0; p < graph->passCount; p++)
+	{
+		graph->passes[p].isScheduled = false;
+		graph->passes[p].waiting = 0;
+	}
+	for (uint32_t i = 0; i < graph->edgeCount; i++)
+		graph->passes[graph->edges[i].after].waiting++;
+
+	for (uint32_t position = 0; position < graph->passCount; position++)
+	{
+		uint32_t next = UINT32_MAX;
+		uint32_t first = UINT32_MAX;
+		for (uint32_t p = 0; next == UINT32_MAX && p < graph->passCount; p++)
+		{
+			if (graph->passes[p].isScheduled)
+				continue;
+			if (first == UINT32_MAX)
+				first = p;
+			if (graph->passes[p].waiting == 0)
+				next = p;
+		}
+		if (next == UINT32_MAX)
+		{
+			glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 0, GL_DEBUG_SEVERITY_MEDIUM, -1,
+				"Render graph passes depend on each other in a cycle, running them in declaration order");
+			next = first;
+		}
+
+		struct GraphPass* pass = &graph->passes[next];
+		pass->isScheduled = true;
+		pass->position = position;
+		graph->order[position] = next;
+		for (uint32_t i = 0; i < graph->edgeCount; i++)
+			if (graph->edges[i].before == next && graph->passes[graph->edges[i].after].waiting > 0)
+				graph->passes[graph->edges[i].after].waiting--;
+	}
+}
+
+static void cullPasses(_Inout_ RenderGraph* graph)
+//
+// Backwards from the side effects: a pass runs if it is kept, writes outside the graph or writes what a running pass reads.
+// Writes don't retire earlier producers, a pass may well update only part of a resource.
+//
+{
+	for (uint32_t position = graph->passCount; position-- > 0;)
+	{
+		const uint32_t p = graph->order[position];
+		struct GraphPass* pass = &graph->passes[p];
+		pass->isNeeded = pass->keep;
+		for (uint32_t i = 0; !pass->isNeeded && i < graph->accessCount; i++)
+		{
+			const struct GraphAccess* access = &graph->accesses[i];
+			const struct GraphResource* resource = &graph->resources[access->resource];
+			pass->isNeeded = access->pass == p && access->isWrite && (resource->isImported || resource->isRequired);
+		}
+		if (!pass->isNeeded)
+			continue;
+
+		for (uint32_t i = 0; i < graph->accessCount; i++)
+			if (graph->accesses[i].pass == p && !graph->accesses[i].isWrite)
+				graph->resources[graph->accesses[i].resource].isRequired = true;
+	}
+}
+
+static void deleteFramebuffersUsing(_Inout_ RenderGraph* graph, _In_ GLuint texture)
+{
+	for (uint32_t i = 0; i < graph->framebufferCount;)
+	{
+		struct CachedFramebuffer* cached = &graph->framebuffers[i];
+		bool isUsing = false;
+		for (uint32_t j = 0; j < cached->count; j++)
+			isUsing = isUsing || cached->textures[j] == texture;
+		if (!isUsing)
+		{
+			i++;
+			continue;
+		}
+		glDeleteFramebuffers(1, &cached->framebuffer);
+		*cached = graph->framebuffers[--graph->framebufferCount];
+	}
+}
+
+static void deletePooled(_Inout_ RenderGraph* graph, _Inout_ struct PooledTexture* pooled)
+{
+	for (uint32_t i = 0; i < pooled->viewCount; i++)
+	{
+		deleteFramebuffersUsing(graph, pooled->views[i].texture);
+		glDeleteTextures(1, &pooled->views[i].texture);
+	}
+	deleteFramebuffersUsing(graph, pooled->texture);
+	glDeleteTextures(1, &pooled->texture);
+}
+
+static void allocateTransients(_Inout_ RenderGraph* graph)
+//
+// Transients in order of first use take the first pooled texture that is free by then and can hold them.
+// GL can't place differently shaped textures in the same memory, but the same shape in a format of the same view class
+// shares the storage through a texture view.
+//
+{
+	for (uint32_t i = 0; i < graph->poolCount; i++)
+		graph->pool[i].busyUntil = -1;
+
+	for (uint32_t r = 0; r < graph->resourceCount; r++)
+	{
+		struct GraphResource* resource = &graph->resources[r];
+		resource->firstPass = UINT32_MAX;
+		resource->lastPass = 0;
+	}
+	for (uint32_t i = 0; i < graph->accessCount; i++)
+	{
+		const struct GraphAccess* access = &graph->accesses[i];
+		if (!graph->passes[access->pass].isNeeded)
+			continue;
+		struct GraphResource* resource = &graph->resources[access->resource];
+		const uint32_t position = graph->passes[access->pass].position;
+		if (position < resource->firstPass)
+			resource->firstPass = position;
+		if (position > resource->lastPass)
+			resource->lastPass = position;
+	}
+
+	for (uint32_t position = 0; position < graph->passCount; position++)
+	{
+		for (uint32_t r = 0; r < graph->resourceCount; r++)
+		{
+			struct GraphResource* resource = &graph->resources[r];
+			if (resource->isImported || resource->kind != RESOURCE_TEXTURE || resource->firstPass != position)
+				continue;
+
+			// The storage's own format first, then views, then new storage.
+			struct PooledTexture* pooled = NULL;
+			GLuint texture = 0;
+			for (uint32_t round = 0; round < 2 && texture == 0; round++)
+			{
+				for (uint32_t i = 0; texture == 0 && i < graph->poolCount; i++)
+				{
+					pooled = &graph->pool[i];
+					const bool isFit = round == 0
+						? pooled->desc.format == resource->desc.format
+						: isViewable(pooled->desc.format, resource->desc.format);
+					if (isFit && pooled->busyUntil < (int64_t)position && isSameShape(&pooled->desc, &resource->desc))
+						texture = viewAs(pooled, resource->desc.format);
+				}
+			}
+
+			if (texture == 0)
+			{
+				if (!grow((void**)&graph->pool, &graph->poolCapacity, graph->poolCount, sizeof * graph->pool))
+					continue;
+				pooled = &graph->pool[graph->poolCount++];
+				*pooled = (struct PooledTexture){ .desc = resource->desc };
+				glCreateTextures(GL_TEXTURE_2D, 1, &pooled->texture);
+				glTextureStorage2D(pooled->texture, resource->desc.levels, resource->desc.format, resource->desc.width, resource->desc.height);
+				texture = pooled->texture;
+			}
+			pooled->busyUntil = resource->lastPass;
+			pooled->lastFrame = graph->frame;
+			resource->object = texture;
+			NAME_OBJECT(GL_TEXTURE, texture, resource->name);
+		}
+	}
+
+	for (uint32_t i = 0; i < graph->poolCount;)
+	{
+		struct PooledTexture* pooled = &graph->pool[i];
+		if (graph->frame - pooled->lastFrame < RENDERGRAPH_IDLE_FRAMES)
+		{
+			i++;
+			continue;
+		}
+		deletePooled(graph, pooled);
+		*pooled = graph->pool[--graph->poolCount];
+	}
+}
+
+static GLuint framebufferFor(_Inout_ RenderGraph* graph, _In_ uint32_t count, _In_reads_(count) const GLenum* attachments, _In_reads_(count) const GLuint* textures)
+{
+	for (uint32_t i = 0; i < graph->framebufferCount; i++)
+	{
+		const struct CachedFramebuffer* cached = &graph->framebuffers[i];
+		if (cached->count == count
+			&& memcmp(cached->attachments, attachments, count * sizeof * attachments) == 0
+			&& memcmp(cached->textures, textures, count * sizeof * textures) == 0)
+			return cached->framebuffer;
+	}
+
+	if (!grow((void**)&graph->framebuffers, &graph->framebufferCapacity, graph->framebufferCount, sizeof * graph->framebuffers))
+		return 0;
+	struct CachedFramebuffer* cached = &graph->framebuffers[graph->framebufferCount++];
+	cached->count = count;
+	memcpy(cached->attachments, attachments, count * sizeof * attachments);
+	memcpy(cached->textures, textures, count * sizeof * textures);
+
+	GLenum drawBuffers[RENDERGRAPH_MAX_ATTACHMENTS];
+	GLsizei drawBufferCount = 0;
+	glCreateFramebuffers(1, &cached->framebuffer);
+	for (uint32_t i = 0; i < count; i++)
+	{
+		glNamedFramebufferTexture(cached->framebuffer, attachments[i], textures[i], 0);
+		if (attachments[i] >= GL_COLOR_ATTACHMENT0 && attachments[i] < GL_COLOR_ATTACHMENT0 + RENDERGRAPH_MAX_ATTACHMENTS)
+			drawBuffers[drawBufferCount++] = attachments[i];
+	}
+	glNamedFramebufferDrawBuffers(cached->framebuffer, drawBufferCount, drawBuffers);
+	return cached->framebuffer;
+}
+
+static void bindAttachments(_Inout_ RenderGraph* graph, _In_ uint32_t pass)
+{
+	GLenum attachments[RENDERGRAPH_MAX_ATTACHMENTS];
+	GLuint textures[RENDERGRAPH_MAX_ATTACHMENTS];
+	uint32_t count = 0;
+	uint32_t width = 0, height = 0;
+
+	for (uint32_t i = 0; i < graph->accessCount; i++)
+	{
+		const struct GraphAccess* access = &graph->accesses[i];
+		if (access->pass != pass || access->access != RENDER_ACCESS_ATTACHMENT)
+			continue;
+
+		const struct GraphResource* resource = &graph->resources[access->resource];
+		if (resource->kind == RESOURCE_FRAMEBUFFER)
+		{
+			// A whole framebuffer wins over loose attachments, a pass can't render to both.
+			glBindFramebuffer(GL_DRAW_FRAMEBUFFER, resource->object);
+			glViewport(0, 0, resource->desc.width, resource->desc.height);
+			return;
+		}
+		if (count < RENDERGRAPH_MAX_ATTACHMENTS && access->attachment != GL_NONE)
+		{
+			attachments[count] = access->attachment;
+			textures[count] = resource->object;
+			count++;
+			width = resource->desc.width;
+			height = resource->desc.height;
+		}
+	}
+	if (count == 0)
+		return;
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebufferFor(graph, count, attachments, textures));
+	glViewport(0, 0, width, height);
+}
+
+static void insertBarrier(_Inout_ RenderGraph* graph, _In_ uint32_t pass)
+//
+// One barrier for the whole pass, only with the bits for incoherent writes not made visible to that kind of access yet.
+//
+{
+	GLbitfield bits = 0;
+	for (uint32_t i = 0; i < graph->accessCount; i++)
+	{
+		const struct GraphAccess* access = &graph->accesses[i];
+		const struct GraphResource* resource = &graph->resources[access->resource];
+		if (access->pass == pass && resource->isIncoherent)
+			bits |= barrierFor(access->access) & ~resource->barriers;
+	}
+	if (bits == 0)
+		return;
+
+	glMemoryBarrier(bits);
+	// A barrier isn't tied to a resource, it covers every write before it.
+	for (uint32_t r = 0; r < graph->resourceCount; r++)
+		if (graph->resources[r].isIncoherent)
+			graph->resources[r].barriers |= bits;
+}
+
+static void recordWrites(_Inout_ RenderGraph* graph, _In_ uint32_t pass)
+{
+	for (uint32_t i = 0; i < graph->accessCount; i++)
+	{
+		const struct GraphAccess* access = &graph->accesses[i];
+		if (access->pass != pass || !access->isWrite)
+			continue;
+		struct GraphResource* resource = &graph->resources[access->resource];
+		resource->isIncoherent = access->access == RENDER_ACCESS_IMAGE || access->access == RENDER_ACCESS_STORAGE;
+		resource->barriers = 0;
+	}
+}
+
+
+RenderGraph* rendergraph_create(void)
+{
+	return calloc(1, sizeof(RenderGraph));
+}
+
+void rendergraph_destroy(_In_opt_ RenderGraph* graph)
+{
+	if (graph == NULL)
+		return;
+
+	// Pooled textures take their framebuffers with them.
+	for (uint32_t i = 0; i < graph->poolCount; i++)
+		deletePooled(graph, &graph->pool[i]);
+	for (uint32_t i = 0; i < graph->framebufferCount; i++)
+		glDeleteFramebuffers(1, &graph->framebuffers[i].framebuffer);
+	free(graph->framebuffers);
+	free(graph->pool);
+	free(graph->order);
+	free(graph->edges);
+	free(graph->accesses);
+	free(graph->passes);
+	free(graph->resources);
+	free(graph);
+}
+
+void rendergraph_begin(_Inout_ RenderGraph* graph)
+{
+	graph->resourceCount = 0;
+	graph->passCount = 0;
+	graph->accessCount = 0;
+	graph->frame++;
+}
+
+RenderResource rendergraph_createTexture(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ const struct RenderTextureDesc* desc)
+{
+	struct GraphResource resource = { .name = name, .kind = RESOURCE_TEXTURE, .desc = *desc };
+	if (resource.desc.levels == 0)
+		resource.desc.levels = 1;
+	return addResource(graph, &resource);
+}
+
+RenderResource rendergraph_importTexture(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ GLuint texture, _In_ uint32_t width, _In_ uint32_t height)
+{
+	return addResource(graph, &(struct GraphResource){
+		.name = name,
+		.kind = RESOURCE_TEXTURE,
+		.isImported = true,
+		.desc = { .width = width, .height = height },
+		.object = texture,
+	});
+}
+
+RenderResource rendergraph_importBuffer(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ GLuint buffer)
+{
+	return addResource(graph, &(struct GraphResource){ .name = name, .kind = RESOURCE_BUFFER, .isImported = true, .object = buffer });
+}
+
+RenderResource rendergraph_importFramebuffer(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ GLuint framebuffer, _In_ uint32_t width, _In_ uint32_t height)
+{
+	return addResource(graph, &(struct GraphResource){
+		.name = name,
+		.kind = RESOURCE_FRAMEBUFFER,
+		.isImported = true,
+		.desc = { .width = width, .height = height },
+		.object = framebuffer,
+	});
+}
+
+uint32_t rendergraph_addPass(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ RenderPassProc execute, _In_opt_ void* user)
+{
+	if (!grow((void**)&graph->passes, &graph->passCapacity, graph->passCount, sizeof * graph->passes) ||
+		!grow((void**)&graph->order, &graph->orderCapacity, graph->passCount, sizeof * graph->order))
+		return UINT32_MAX;
+	graph->passes[graph->passCount] = (struct GraphPass){ .name = name, .execute = execute, .user = user };
+	return graph->passCount++;
+}
+
+void rendergraph_read(_Inout_ RenderGraph* graph, _In_ uint32_t pass, _In_ RenderResource resource, _In_ enum RenderAccess access)
+{
+	addAccess(graph, &(struct GraphAccess){ .pass = pass, .resource = resource, .access = access, .isWrite = false, .attachment = GL_NONE });
+}
+
+void rendergraph_write(_Inout_ RenderGraph* graph, _In_ uint32_t pass, _In_ RenderResource resource, _In_ enum RenderAccess access)
+{
+	addAccess(graph, &(struct GraphAccess){ .pass = pass, .resource = resource, .access = access, .isWrite = true, .attachment = GL_NONE });
+}
+
+void rendergraph_attach(_Inout_ RenderGraph* graph, _In_ uint32_t pass, _In_ RenderResource texture, _In_ GLenum attachment)
+{
+	addAccess(graph, &(struct GraphAccess){ .pass = pass, .resource = texture, .access = RENDER_ACCESS_ATTACHMENT, .isWrite = true, .attachment = attachment });
+}
+
+void rendergraph_keep(_Inout_ RenderGraph* graph, _In_ uint32_t pass)
+{
+	if (pass < graph->passCount)
+		graph->passes[pass].keep = true;
+}
+
+void rendergraph_execute(_Inout_ RenderGraph* graph, _Inout_opt_ Profiler* profiler)
+{
+	sortPasses(graph);
+	cullPasses(graph);
+	allocateTransients(graph);
+
+	GLint framebuffer = 0;
+	GLint viewport[4];
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	for (uint32_t position = 0; position < graph->passCount; position++)
+	{
+		const uint32_t p = graph->order[position];
+		const struct GraphPass* pass = &graph->passes[p];
+		if (!pass->isNeeded)
+			continue;
+
+		profiler_push(profiler, pass->name);
+		insertBarrier(graph, p);
+		bindAttachments(graph, p);
+		pass->execute(graph, pass->user);
+		recordWrites(graph, p);
+		profiler_pop(profiler);
+	}
+
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, framebuffer);
+	glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+GLuint rendergraph_texture(_In_ const RenderGraph* graph, _In_ RenderResource resource)
+{
+	return resource < graph->resourceCount && graph->resources[resource].kind == RESOURCE_TEXTURE ? graph->resources[resource].object : 0;
+}
+
+GLuint rendergraph_buffer(_In_ const RenderGraph* graph, _In_ RenderResource resource)
+{
+	return resource < graph->resourceCount && graph->resources[resource].kind == RESOURCE_BUFFER ? graph->resources[resource].object : 0;
+}
+
+GLuint rendergraph_framebuffer(_In_ const RenderGraph* graph, _In_ RenderResource resource)
+{
+	return resource < graph->resourceCount && graph->resources[resource].kind == RESOURCE_FRAMEBUFFER ? graph->resources[resource].object : 0;
+}
@@ -0,0 +1,93 @@
+/**
+
+    @file      rendergraph.h
+    @brief     Per-frame graph of render passes and the resources they touch
+    @details   Passes are declared every frame together with what they read and
+               write. Executing the graph skips passes whose results nobody
+               uses, issues one glMemoryBarrier before a pass with exactly the
+               bits its reads of incoherently written resources need, and backs
+               transient textures with pooled textures that are reused by
+               every transient of the same size whose lifetime doesn't overlap,
+               through a texture view when the format differs but shares its
+               view class. Passes are sorted by what they access: a pass that
+               only reads a resource runs after every pass writing it and
+               passes writing the same resource keep their declaration order,
+               which otherwise only breaks ties.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "profiler.h"
+
+
+#define RENDER_RESOURCE_NONE UINT32_MAX
+
+// How a pass touches a resource, decides which barrier bit a later access needs.
+enum RenderAccess
+{
+	RENDER_ACCESS_SAMPLED,		// texture fetches
+	RENDER_ACCESS_IMAGE,		// image load/store, incoherent when written
+	RENDER_ACCESS_STORAGE,		// shader storage and atomics, incoherent when written
+	RENDER_ACCESS_UNIFORM,
+	RENDER_ACCESS_VERTEX,
+	RENDER_ACCESS_INDEX,
+	RENDER_ACCESS_INDIRECT,		// draw and dispatch commands, indirect parameters
+	RENDER_ACCESS_ATTACHMENT,	// framebuffer attachment, the graph binds the framebuffer
+	RENDER_ACCESS_TRANSFER,		// copies, glReadPixels, glTexSubImage and the like
+};
+
+struct RenderTextureDesc
+{
+	uint32_t width;
+	uint32_t height;
+	GLenum format;				// sized internal format
+	uint32_t levels;			// 0 is treated as 1
+};
+
+typedef uint32_t RenderResource;
+typedef struct RenderGraph RenderGraph;
+
+typedef void (*RenderPassProc)(_Inout_ RenderGraph* graph, _In_opt_ void* user);
+
+RenderGraph* rendergraph_create(void);
+
+//deletes the pooled textures and framebuffers.
+void rendergraph_destroy(_In_opt_ RenderGraph* graph);
+
+//forgets the passes and resources of the previous frame, the texture pool is kept.
+void rendergraph_begin(_Inout_ RenderGraph* graph);
+
+//a texture that only lives within the frame. Its contents are undefined when first written, passes clear or overwrite it.
+RenderResource rendergraph_createTexture(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ const struct RenderTextureDesc* desc);
+
+//resources owned elsewhere. Writing to one is a side effect, the writing pass always runs.
+RenderResource rendergraph_importTexture(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ GLuint texture, _In_ uint32_t width, _In_ uint32_t height);
+RenderResource rendergraph_importBuffer(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ GLuint buffer);
+RenderResource rendergraph_importFramebuffer(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ GLuint framebuffer, _In_ uint32_t width, _In_ uint32_t height);
+
+/**
+	@brief  Declares a pass, names must outlive the frame.
+	@param  execute - issues the pass' GL work, the attachments it declared are bound already
+	@retval         - pass index for the accesses below
+**/
+uint32_t rendergraph_addPass(_Inout_ RenderGraph* graph, _In_z_ const char* name, _In_ RenderPassProc execute, _In_opt_ void* user);
+
+void rendergraph_read(_Inout_ RenderGraph* graph, _In_ uint32_t pass, _In_ RenderResource resource, _In_ enum RenderAccess access);
+void rendergraph_write(_Inout_ RenderGraph* graph, _In_ uint32_t pass, _In_ RenderResource resource, _In_ enum RenderAccess access);
+
+//renders into a texture, the graph builds and caches the framebuffer. Counts as a write.
+void rendergraph_attach(_Inout_ RenderGraph* graph, _In_ uint32_t pass, _In_ RenderResource texture, _In_ GLenum attachment);
+
+//runs the pass even though nothing in the graph reads what it writes.
+void rendergraph_keep(_Inout_ RenderGraph* graph, _In_ uint32_t pass);
+
+//culls, allocates and runs the passes, each in its own profiler scope. Restores the framebuffer and viewport afterwards.
+void rendergraph_execute(_Inout_ RenderGraph* graph, _Inout_opt_ Profiler* profiler);
+
+//the GL name behind a resource, only valid while the graph executes.
+GLuint rendergraph_texture(_In_ const RenderGraph* graph, _In_ RenderResource resource);
+GLuint rendergraph_buffer(_In_ const RenderGraph* graph, _In_ RenderResource resource);
+GLuint rendergraph_framebuffer(_In_ const RenderGraph* graph, _In_ RenderResource resource);
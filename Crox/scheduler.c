@@ -0,0 +1,503 @@
+/**
+
+    @file      scheduler.c
+    @brief     Work-stealing task scheduler shared by every subsystem
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "scheduler.h"
+#include "platform/Threads.h"
+
+
+#define DEQUE_CAPACITY		1024	// per thread, a power of two. A full deque spills into the injection queue.
+#define INJECTION_CAPACITY	4096	// a power of two
+#define TASKS_PER_THREAD	4		// parallelFor's tasks, enough to even out uneven ones
+#define SPIN_COUNT			64		// empty searches before a worker goes to sleep
+#define CACHE_LINE			64
+
+// A counter's pending holds its tasks in the low half and the tasks finishing right now in the high half.
+#define COUNTER_TASKS		0xffffffffll
+#define COUNTER_FINISHING	0x100000000ll
+
+struct Task
+{
+	TaskProc proc;
+	void* user;
+	uint32_t first;
+	uint32_t count;
+	TaskCounter* counter;
+	struct Task* next;		// in a counter's waiting list or a pinned list
+	enum TaskAffinity affinity;
+};
+
+// Chase-Lev, fixed size. The owner pushes and pops at the bottom, everyone else steals from the top.
+struct Deque
+{
+	volatile int64_t top;
+	uint8_t padding[CACHE_LINE - sizeof(int64_t)];
+	volatile int64_t bottom;
+	struct Task* volatile tasks[DEQUE_CAPACITY];
+};
+
+// Bounded multi-producer multi-consumer queue, every cell's sequence says whose turn it is.
+struct InjectionCell
+{
+	volatile int64_t sequence;
+	struct Task* task;
+};
+
+struct InjectionQueue
+{
+	volatile int64_t enqueued;
+	uint8_t padding[CACHE_LINE - sizeof(int64_t)];
+	volatile int64_t dequeued;
+	uint8_t padding2[CACHE_LINE - sizeof(int64_t)];
+	struct InjectionCell cells[INJECTION_CAPACITY];
+};
+
+struct Worker
+{
+	Scheduler* scheduler;
+	uint32_t index;
+	uint32_t nextVictim;		// owner only, spreads steals over the other threads
+	struct Deque deque;
+};
+
+struct Scheduler
+{
+	struct Worker* workers;		// the creating thread's first
+	uint32_t dequeCount;		// fixed before any worker starts, unlike threadCount
+	uint32_t threadCount;
+	Thread* threads;
+	struct InjectionQueue injection;
+
+	Mutex mutex;				// sleeping workers, the pinned lists and every counter's waiting list
+	CondVar wake;
+	volatile int64_t sleeping;
+	volatile int64_t quitting;
+	struct PinnedList
+	{
+		struct Task* head;
+		struct Task* tail;
+	} pinned[TASK_AFFINITY_COUNT];	// TASK_ANY_THREAD's stays empty
+};
+
+static THREAD_LOCAL struct Worker* currentWorker;
+
+
+static bool dequePush(_Inout_ struct Deque* deque, _In_ struct Task* task)
+{
+	const int64_t bottom = deque->bottom;
+	const int64_t top = atomic_load64(&deque->top);
+	if (bottom - top >= DEQUE_CAPACITY)
+		return false;
+	atomic_storePointer((void* volatile*)&deque->tasks[bottom & (DEQUE_CAPACITY - 1)], task);
+	atomic_store64(&deque->bottom, bottom + 1);
+	return true;
+}
+
+static struct Task* dequePop(_Inout_ struct Deque* deque)
+{
+	const int64_t bottom = deque->bottom - 1;
+	atomic_store64(&deque->bottom, bottom);
+	atomic_fence();
+	const int64_t top = atomic_load64(&deque->top);
+	if (top > bottom)
+	{
+		atomic_store64(&deque->bottom, bottom + 1);
+		return NULL;
+	}
+
+	struct Task* task = atomic_loadPointer((void* const volatile*)&deque->tasks[bottom & (DEQUE_CAPACITY - 1)]);
+	if (top == bottom)
+	{
+		// The last one, a thief may be taking it at the same time.
+		if (!atomic_compareExchange64(&deque->top, top, top + 1))
+			task = NULL;
+		atomic_store64(&deque->bottom, bottom + 1);
+	}
+	return task;
+}
+
+static struct Task* dequeSteal(_Inout_ struct Deque* deque)
+{
+	const int64_t top = atomic_load64(&deque->top);
+	atomic_fence();
+	const int64_t bottom = atomic_load64(&deque->bottom);
+	if (top >= bottom)
+		return NULL;
+
+	// The slot can't be reused before top moves past it, which makes the exchange fail.
+	struct Task* task = atomic_loadPointer((void* const volatile*)&deque->tasks[top & (DEQUE_CAPACITY - 1)]);
+	return atomic_compareExchange64(&deque->top, top, top + 1) ? task : NULL;
+}
+
+static bool injectionPush(_Inout_ struct InjectionQueue* queue, _In_ struct Task* task)
+{
+	int64_t position = atomic_load64(&queue->enqueued);
+	for (;;)
+	{
+		struct InjectionCell* cell = &queue->cells[position & (INJECTION_CAPACITY - 1)];
+		const int64_t difference = atomic_load64(&cell->sequence) - position;
+		if (difference == 0 && atomic_compareExchange64(&queue->enqueued, position, position + 1))
+		{
+			cell->task = task;
+			atomic_store64(&cell->sequence, position + 1);
+			return true;
+		}
+		if (difference < 0)
+			return false;
+		position = atomic_load64(&queue->enqueued);
+	}
+}
+
+static struct Task* injectionPop(_Inout_ struct InjectionQueue* queue)
+{
+	int64_t position = atomic_load64(&queue->dequeued);
+	for (;;)
+	{
+		struct InjectionCell* cell = &queue->cells[position & (INJECTION_CAPACITY - 1)];
+		const int64_t difference = atomic_load64(&cell->sequence) - (position + 1);
+		if (difference == 0 && atomic_compareExchange64(&queue->dequeued, position, position + 1))
+		{
+			struct Task* task = cell->task;
+			atomic_store64(&cell->sequence, position + INJECTION_CAPACITY);
+			return task;
+		}
+		if (difference < 0)
+			return NULL;
+		position = atomic_load64(&queue->dequeued);
+	}
+}
+
+static struct Worker* workerOf(_In_ const Scheduler* scheduler)
+{
+	return currentWorker && currentWorker->scheduler == scheduler ? currentWorker : NULL;
+}
+
+static bool hasWork(_In_ Scheduler* scheduler)
+{
+	if (atomic_load64(&scheduler->injection.dequeued) < atomic_load64(&scheduler->injection.enqueued))
+		return true;
+	for (uint32_t i = 0; i < scheduler->dequeCount; i++)
+	{
+		struct Deque* deque = &scheduler->workers[i].deque;
+		if (atomic_load64(&deque->top) < atomic_load64(&deque->bottom))
+			return true;
+	}
+	return false;
+}
+
+static void wakeOne(_Inout_ Scheduler* scheduler)
+//
+// Pairs with the fence in workerMain, either the worker sees the task or this sees the worker.
+//
+{
+	atomic_fence();
+	if (atomic_load64(&scheduler->sleeping) == 0)
+		return;
+	mutex_lock(&scheduler->mutex);
+	condvar_signal(&scheduler->wake);
+	mutex_unlock(&scheduler->mutex);
+}
+
+static void runTask(_Inout_ Scheduler* scheduler, _In_ struct Task* task);
+
+static void enqueue(_Inout_ Scheduler* scheduler, _In_ struct Task* task)
+{
+	if (task->affinity != TASK_ANY_THREAD)
+	{
+		struct PinnedList* list = &scheduler->pinned[task->affinity];
+		mutex_lock(&scheduler->mutex);
+		task->next = NULL;
+		if (list->tail)
+			list->tail->next = task;
+		else
+			list->head = task;
+		list->tail = task;
+		mutex_unlock(&scheduler->mutex);
+		return;
+	}
+
+	struct Worker* worker = workerOf(scheduler);
+	if ((worker && dequePush(&worker->deque, task)) || injectionPush(&scheduler->injection, task))
+		wakeOne(scheduler);
+	else
+		runTask(scheduler, task);	// everything is full, the submitter does it
+}
+
+static struct Task* findTask(_Inout_ Scheduler* scheduler, _Inout_opt_ struct Worker* worker)
+{
+	struct Task* task = worker ? dequePop(&worker->deque) : NULL;
+	if (task == NULL)
+		task = injectionPop(&scheduler->injection);
+
+	const uint32_t start = worker ? worker->nextVictim++ : 0;
+	for (uint32_t i = 0; task == NULL && i < scheduler->dequeCount; i++)
+	{
+		const uint32_t victim = (start + i) % scheduler->dequeCount;
+		if (worker == NULL || victim != worker->index)
+			task = dequeSteal(&scheduler->workers[victim].deque);
+	}
+	return task;
+}
+
+static struct Task* popPinned(_Inout_ Scheduler* scheduler, _In_ enum TaskAffinity affinity)
+{
+	struct PinnedList* list = &scheduler->pinned[affinity];
+	mutex_lock(&scheduler->mutex);
+	struct Task* task = list->head;
+	if (task)
+	{
+		list->head = task->next;
+		if (list->head == NULL)
+			list->tail = NULL;
+	}
+	mutex_unlock(&scheduler->mutex);
+	return task;
+}
+
+static void release(_Inout_ Scheduler* scheduler, _Inout_ TaskCounter* counter)
+//
+// The counter reached zero, what was held back by it may run.
+//
+{
+	mutex_lock(&scheduler->mutex);
+	struct Task* waiting = counter->waiting;
+	counter->waiting = NULL;
+	mutex_unlock(&scheduler->mutex);
+
+	while (waiting)
+	{
+		struct Task* next = waiting->next;
+		enqueue(scheduler, waiting);
+		waiting = next;
+	}
+}
+
+static void runTask(_Inout_ Scheduler* scheduler, _In_ struct Task* task)
+{
+	task->proc(task->user, task->first, task->count);
+
+	// Waiters only return once no task is finishing either, the counter stays valid until the last touch here.
+	TaskCounter* counter = task->counter;
+	free(task);
+	if (counter == NULL)
+		return;
+	const int64_t pending = atomic_add64(&counter->pending, COUNTER_FINISHING - 1);
+	if ((pending & COUNTER_TASKS) == 0)
+		release(scheduler, counter);
+	atomic_add64(&counter->pending, -COUNTER_FINISHING);
+}
+
+static int workerMain(void* arg)
+{
+	struct Worker* worker = arg;
+	Scheduler* scheduler = worker->scheduler;
+	currentWorker = worker;
+
+	uint32_t idle = 0;
+	for (;;)
+	{
+		struct Task* task = findTask(scheduler, worker);
+		if (task)
+		{
+			runTask(scheduler, task);
+			idle = 0;
+			continue;
+		}
+		if (atomic_load64(&scheduler->quitting))
+			break;
+		if (++idle < SPIN_COUNT)
+		{
+			thread_yield();
+			continue;
+		}
+
+		mutex_lock(&scheduler->mutex);
+		atomic_add64(&scheduler->sleeping, 1);
+		atomic_fence();
+		if (!hasWork(scheduler) && !atomic_load64(&scheduler->quitting))
+			condvar_wait(&scheduler->wake, &scheduler->mutex);
+		atomic_add64(&scheduler->sleeping, -1);
+		mutex_unlock(&scheduler->mutex);
+		idle = 0;
+	}
+	return 0;
+}
+
+
+Scheduler* scheduler_create(_In_ uint32_t threads)
+{
+	assert(currentWorker == NULL);
+	if (threads == 0)
+		threads = thread_hardwareConcurrency();
+	if (threads < 2)
+		threads = 2;
+
+	Scheduler* scheduler = calloc(1, sizeof * scheduler);
+	if (scheduler == NULL)
+		return NULL;
+	scheduler->workers = calloc(threads, sizeof * scheduler->workers);
+	scheduler->threads = calloc(threads - 1, sizeof * scheduler->threads);
+	if (scheduler->workers == NULL || scheduler->threads == NULL)
+	{
+		free(scheduler->threads);
+		free(scheduler->workers);
+		free(scheduler);
+		return NULL;
+	}
+
+	mutex_init(&scheduler->mutex);
+	condvar_init(&scheduler->wake);
+	for (uint32_t i = 0; i < INJECTION_CAPACITY; i++)
+		scheduler->injection.cells[i].sequence = i;
+	scheduler->dequeCount = threads;
+	for (uint32_t i = 0; i < threads; i++)
+		scheduler->workers[i] = (struct Worker){ .scheduler = scheduler, .index = i, .nextVictim = i + 1 };
+	currentWorker = &scheduler->workers[0];
+
+	// Whatever couldn't be started leaves fewer threads, their deques just stay empty.
+	uint32_t started = 0;
+	while (started + 1 < threads && thread_create(&scheduler->threads[started], workerMain, &scheduler->workers[started + 1]))
+		started++;
+	scheduler->threadCount = started + 1;
+	if (started == 0)
+	{
+		scheduler_destroy(scheduler);
+		return NULL;
+	}
+	return scheduler;
+}
+
+void scheduler_destroy(_In_opt_ Scheduler* scheduler)
+{
+	if (scheduler == NULL)
+		return;
+	assert(workerOf(scheduler) == &scheduler->workers[0]);
+
+	// Workers drain the queues before they see quitting, pinned tasks and stragglers are run here after.
+	mutex_lock(&scheduler->mutex);
+	atomic_store64(&scheduler->quitting, 1);
+	condvar_broadcast(&scheduler->wake);
+	mutex_unlock(&scheduler->mutex);
+	for (uint32_t i = 0; i + 1 < scheduler->threadCount; i++)
+		thread_join(scheduler->threads[i]);
+
+	// Held back tasks whose counter never reaches zero are lost. GL tasks expect the context back on this thread.
+	for (struct Task* task; (task = findTask(scheduler, &scheduler->workers[0])) ||
+		(task = popPinned(scheduler, TASK_CREATOR_THREAD)) || (task = popPinned(scheduler, TASK_GL_THREAD));)
+		runTask(scheduler, task);
+
+	currentWorker = NULL;
+	condvar_destroy(&scheduler->wake);
+	mutex_destroy(&scheduler->mutex);
+	free(scheduler->threads);
+	free(scheduler->workers);
+	free(scheduler);
+}
+
+uint32_t scheduler_threadCount(_In_ const Scheduler* scheduler)
+{
+	return scheduler->threadCount;
+}
+
+uint32_t scheduler_threadIndex(_In_ const Scheduler* scheduler)
+{
+	const struct Worker* worker = workerOf(scheduler);
+	return worker ? worker->index : SCHEDULER_NOT_A_THREAD;
+}
+
+bool scheduler_submit(_Inout_ Scheduler* scheduler, _In_ const struct TaskDesc* desc)
+{
+	struct Task* task = malloc(sizeof * task);
+	if (task == NULL)
+		return false;
+	*task = (struct Task){
+		.proc = desc->proc,
+		.user = desc->user,
+		.first = desc->first,
+		.count = desc->count,
+		.counter = desc->counter,
+		.affinity = desc->affinity,
+	};
+	if (desc->counter)
+		atomic_add64(&desc->counter->pending, 1);
+
+	if (desc->after)
+	{
+		// Checked under the lock release takes, so the task is either seen by it or doesn't wait at all.
+		mutex_lock(&scheduler->mutex);
+		const bool isHeld = (atomic_load64(&desc->after->pending) & COUNTER_TASKS) != 0;
+		if (isHeld)
+		{
+			task->next = desc->after->waiting;
+			desc->after->waiting = task;
+		}
+		mutex_unlock(&scheduler->mutex);
+		if (isHeld)
+			return true;
+	}
+
+	enqueue(scheduler, task);
+	return true;
+}
+
+void scheduler_parallelFor(_Inout_ Scheduler* scheduler, _In_ uint32_t count, _In_ uint32_t minBatch, _In_ TaskProc proc, _In_opt_ void* user,
+	_Inout_ TaskCounter* counter)
+{
+	const uint32_t maxTasks = scheduler->threadCount * TASKS_PER_THREAD;
+	uint32_t batch = (count + maxTasks - 1) / maxTasks;
+	if (batch < minBatch)
+		batch = minBatch;
+	if (batch == 0)
+		batch = 1;
+
+	for (uint32_t first = 0; first < count; first += batch)
+	{
+		const uint32_t n = count - first < batch ? count - first : batch;
+		if (!scheduler_submit(scheduler, &(struct TaskDesc){ .proc = proc, .user = user, .first = first, .count = n, .counter = counter }))
+			proc(user, first, n);	// out of memory, done right here instead
+	}
+}
+
+void scheduler_wait(_Inout_ Scheduler* scheduler, _Inout_ TaskCounter* counter)
+{
+	struct Worker* worker = workerOf(scheduler);
+	const bool isCreator = worker && worker->index == 0;
+	while (atomic_load64(&counter->pending) != 0)
+	{
+		struct Task* task = findTask(scheduler, worker);
+		if (task == NULL && isCreator)
+			task = popPinned(scheduler, TASK_CREATOR_THREAD);
+		if (task)
+			runTask(scheduler, task);
+		else
+			thread_yield();
+	}
+}
+
+uint32_t scheduler_runPinned(_Inout_ Scheduler* scheduler, _In_ enum TaskAffinity affinity)
+{
+	assert(affinity == TASK_GL_THREAD || (affinity == TASK_CREATOR_THREAD && workerOf(scheduler) == &scheduler->workers[0]));
+
+	// Only what is there now, tasks these submit wait for the next call.
+	struct PinnedList* list = &scheduler->pinned[affinity];
+	mutex_lock(&scheduler->mutex);
+	struct Task* task = list->head;
+	list->head = list->tail = NULL;
+	mutex_unlock(&scheduler->mutex);
+
+	uint32_t ran = 0;
+	while (task)
+	{
+		struct Task* next = task->next;
+		runTask(scheduler, task);
+		task = next;
+		ran++;
+	}
+	return ran;
+}
@@ -0,0 +1,96 @@
+/**
+
+    @file      scheduler.h
+    @brief     Work-stealing task scheduler shared by every subsystem
+    @details   One worker per core besides the thread that creates the
+               scheduler, which takes part whenever it waits. Every thread
+               taking part has a Chase-Lev deque: tasks it submits go to its
+               own end, idle threads steal from the other. Threads outside the
+               scheduler submit through a lock-free injection queue. Tasks
+               count down a TaskCounter when they return, can be held back
+               until another counter reaches zero, and can be pinned for work
+               that has to stay on one thread: window calls to the creating
+               thread, GL calls to whichever thread has the context current,
+               which drains them with scheduler_runPinned. In Crox that is the
+               render thread, not the creating one.
+               Waiting on a counter runs tasks until it reaches zero rather
+               than blocking, so waits nest inside tasks without deadlock.
+               Tasks should not block on anything but counters; long blocking
+               work such as driver compiles keeps its own threads.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+
+#define SCHEDULER_NOT_A_THREAD UINT32_MAX
+
+typedef struct Scheduler Scheduler;
+
+//runs items [first, first + count), single tasks get 0 and 1.
+typedef void (*TaskProc)(_In_opt_ void* user, _In_ uint32_t first, _In_ uint32_t count);
+
+// Tasks not yet finished. Zero initialized, must outlive its tasks and anything submitted after it.
+typedef struct TaskCounter
+{
+	volatile int64_t pending;
+	struct Task* waiting;		// held back until pending reaches zero, guarded by the scheduler
+} TaskCounter;
+
+// Where a task may run, workers only take TASK_ANY_THREAD.
+enum TaskAffinity
+{
+	TASK_ANY_THREAD,
+	TASK_CREATOR_THREAD,	// window calls, no GL context there in Crox
+	TASK_GL_THREAD,			// GL calls, run by the thread the context is current on
+	TASK_AFFINITY_COUNT
+};
+
+struct TaskDesc
+{
+	_In_ TaskProc proc;
+	_In_opt_ void* user;
+	uint32_t first;
+	uint32_t count;
+	_Inout_opt_ TaskCounter* counter;	// counted up now, down once the task returned
+	_Inout_opt_ TaskCounter* after;		// the task is held back until this one reaches zero
+	enum TaskAffinity affinity;			// pinned ones only run from scheduler_runPinned, and creator tasks in the creator's waits
+};
+
+/**
+	@brief  Starts the workers, the calling thread becomes thread 0.
+	@param  threads - threads taking part, the calling one included. 0 picks one per core. At least one worker is always started.
+	@retval         - NULL on failure
+**/
+Scheduler* scheduler_create(_In_ uint32_t threads);
+
+//runs what is left, pinned tasks included, then joins the workers. Call from the creating thread, with the GL context current if GL tasks may be left.
+void scheduler_destroy(_In_opt_ Scheduler* scheduler);
+
+//threads taking part, the creating one included.
+uint32_t scheduler_threadCount(_In_ const Scheduler* scheduler);
+
+//0 on the creating thread, 1 to threadCount - 1 on workers, SCHEDULER_NOT_A_THREAD elsewhere.
+uint32_t scheduler_threadIndex(_In_ const Scheduler* scheduler);
+
+//from any thread. Returns false if the task couldn't be allocated, nothing was queued or counted then.
+bool scheduler_submit(_Inout_ Scheduler* scheduler, _In_ const struct TaskDesc* task);
+
+/**
+	@brief  Cuts [0, count) into tasks, a few per thread so uneven ones still balance out.
+	@param  minBatch - items below which a task isn't worth its overhead
+	@param  counter  - counted up by the number of tasks, waited on to know they are done
+**/
+void scheduler_parallelFor(_Inout_ Scheduler* scheduler, _In_ uint32_t count, _In_ uint32_t minBatch, _In_ TaskProc proc, _In_opt_ void* user,
+	_Inout_ TaskCounter* counter);
+
+//runs tasks until counter reaches zero, creator tasks too when called from the creating thread. GL tasks only run from scheduler_runPinned.
+void scheduler_wait(_Inout_ Scheduler* scheduler, _Inout_ TaskCounter* counter);
+
+/**
+	@brief  Runs the tasks pinned to affinity submitted so far, once per frame. Returns how many ran.
+	@param  affinity - TASK_CREATOR_THREAD from the creating thread, TASK_GL_THREAD from the one thread the GL context is current on
+**/
+uint32_t scheduler_runPinned(_Inout_ Scheduler* scheduler, _In_ enum TaskAffinity affinity);
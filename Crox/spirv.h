@@ -0,0 +1,49 @@
+/**
+
+    @file      spirv.h
+    @brief     Precompiled SPIR-V modules and their specialization constants
+    @details   API neutral, the same mapped modules and constants feed
+               ARB_gl_spirv and Vulkan shader modules.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "platform/MappedFile.h"
+
+
+#define SPIRV_MAGIC 0x07230203u
+
+// Raw 32 bits, floats and bools are bit cast by the caller just like the APIs expect.
+struct SpecConstant
+{
+	uint32_t id;		// layout(constant_id = ...)
+	uint32_t value;
+};
+
+struct SpirvStage
+{
+	uint32_t type;						// GLenum shader type or VkShaderStageFlagBits, depending on the consumer
+	_In_z_ const char* path;			// .spv file
+	_In_opt_z_ const char* entryPoint;	// "main" when NULL
+	uint32_t constantCount;
+	_In_reads_opt_(constantCount) const struct SpecConstant* constants;
+};
+
+
+//maps a .spv file and checks that it looks like a SPIR-V module.
+static inline bool spirv_map(_Out_ MappedFile* module, _In_z_ const char* path)
+{
+	if (!mappedfile_open(module, path))
+		return false;
+
+	// Header is 5 words, the code must be whole words and start with the magic number in native byte order.
+	const uint32_t* words = module->data;
+	if (module->size < 5 * sizeof(uint32_t) || module->size % sizeof(uint32_t) != 0 || words[0] != SPIRV_MAGIC)
+	{
+		mappedfile_close(module);
+		return false;
+	}
+	return true;
+}
@@ -1,11 +1,19 @@
 #define _CRT_SECURE_NO_WARNINGS
+#ifdef _WIN32
 #include <crtdbg.h>
+#endif // _WIN32
 
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb_image.h>
 
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#include <stb_image_write.h>
+
+// Nuklear's font baking keeps a private copy, this is the one atlas.c packs with.
+#define STB_RECT_PACK_IMPLEMENTATION
+#include <stb_rect_pack.h>
+
 #define STB_DS_IMPLEMTNATION
 #include <stb_ds.h>
 
-#define STB_INCLUDE_IMPLEMENTATION
-#include <stb_include.h>
\ No newline at end of file
+// STB_INCLUDE_IMPLEMENTATION lives in includecache.c, which reuses its directive scanner.
\ No newline at end of file
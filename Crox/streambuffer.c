@@ -0,0 +1,163 @@
+/**
+
+    @file      streambuffer.c
+    @brief     Persistently mapped ring for per-frame vertex, index and uniform data
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "streambuffer.h"
+
+
+// Long enough to never trip on a busy GPU, short enough to notice a hang.
+#define STREAM_FENCE_TIMEOUT_NS 1000000000ull
+
+struct StreamBuffer
+{
+	GLuint buffer;
+	uint8_t* mapped;
+	GLsizeiptr frameSize;
+	GLsizeiptr uniformAlignment;
+	GLsizeiptr storageAlignment;
+	uint32_t frameCount;
+
+	uint32_t frame;			// region being written
+	GLsizeiptr used;		// within that region
+	bool isExhausted;		// reported once per frame
+	GLsync fences[STREAM_MAX_FRAMES];
+};
+
+
+StreamBuffer* streambuffer_create(_In_ GLsizeiptr frameSize, _In_ uint32_t frames)
+{
+	if (frames == 0)
+		frames = STREAM_DEFAULT_FRAMES;
+	if (frames > STREAM_MAX_FRAMES || frameSize <= 0)
+		return NULL;
+
+	StreamBuffer* stream = calloc(1, sizeof * stream);
+	if (stream == NULL)
+		return NULL;
+
+	GLint uniformAlignment = 256; // the largest any implementation asks for
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &uniformAlignment);
+	stream->uniformAlignment = uniformAlignment;
+	GLint storageAlignment = 256;
+	glGetIntegerv(GL_SHADER_STORAGE_BUFFER_OFFSET_ALIGNMENT, &storageAlignment);
+	stream->storageAlignment = storageAlignment;
+
+	// Keeps every region start aligned for any use.
+	frameSize = (frameSize + 255) & ~(GLsizeiptr)255;
+	stream->frameSize = frameSize;
+	stream->frameCount = frames;
+	stream->frame = frames - 1; // the first beginFrame moves to region 0
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &stream->buffer);
+	NAME_OBJECT(GL_BUFFER, stream->buffer, "Stream Buffer");
+	glNamedBufferStorage(stream->buffer, frameSize * frames, NULL, flags);
+	stream->mapped = glMapNamedBufferRange(stream->buffer, 0, frameSize * frames, flags);
+	if (stream->mapped == NULL)
+	{
+		streambuffer_destroy(stream);
+		return NULL;
+	}
+	return stream;
+}
+
+void streambuffer_destroy(_In_opt_ StreamBuffer* stream)
+{
+	if (stream == NULL)
+		return;
+
+	for (uint32_t i = 0; i < stream->frameCount; i++)
+		if (stream->fences[i])
+			glDeleteSync(stream->fences[i]);
+	if (stream->mapped)
+		glUnmapNamedBuffer(stream->buffer);
+	glDeleteBuffers(1, &stream->buffer);
+	free(stream);
+}
+
+void streambuffer_beginFrame(_Inout_opt_ StreamBuffer* stream)
+{
+	if (stream == NULL)
+		return;
+
+	stream->frame = (stream->frame + 1) % stream->frameCount;
+	stream->used = 0;
+	stream->isExhausted = false;
+
+	GLsync fence = stream->fences[stream->frame];
+	if (fence == NULL)
+		return;
+
+	// Flushing on the first try only, the fence is guaranteed to be submitted after that.
+	GLenum status = glClientWaitSync(fence, 0, 0);
+	if (status == GL_TIMEOUT_EXPIRED)
+	{
+		GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+		do
+		{
+			status = glClientWaitSync(fence, flags, STREAM_FENCE_TIMEOUT_NS);
+			flags = 0;
+		} while (status == GL_TIMEOUT_EXPIRED);
+	}
+	glDeleteSync(fence);
+	stream->fences[stream->frame] = NULL;
+}
+
+void streambuffer_endFrame(_Inout_opt_ StreamBuffer* stream)
+{
+	if (stream == NULL || stream->used == 0)
+		return;
+	stream->fences[stream->frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+bool streambuffer_allocate(_Inout_ StreamBuffer* stream, _In_ GLsizeiptr size, _In_ GLsizeiptr alignment, _Out_ struct StreamAllocation* allocation)
+{
+	assert(alignment > 0);
+
+	// Aligned within the whole buffer, so a vertex stride alignment makes offset / stride a valid base vertex.
+	const GLsizeiptr base = (GLsizeiptr)stream->frame * stream->frameSize;
+	GLsizeiptr offset = (base + stream->used + alignment - 1) / alignment * alignment;
+	if (size <= 0 || offset - base + size > stream->frameSize)
+	{
+		if (!stream->isExhausted)
+		{
+			glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_PERFORMANCE, 0, GL_DEBUG_SEVERITY_MEDIUM, -1,
+				"Stream buffer region exhausted, draws are dropped this frame");
+			stream->isExhausted = true;
+		}
+		*allocation = (struct StreamAllocation){ .data = NULL, .buffer = 0, .offset = 0, .size = 0 };
+		return false;
+	}
+	stream->used = offset - base + size;
+
+	*allocation = (struct StreamAllocation){
+		.data = stream->mapped + offset,
+		.buffer = stream->buffer,
+		.offset = offset,
+		.size = size,
+	};
+	return true;
+}
+
+bool streambuffer_allocateUniform(_Inout_ StreamBuffer* stream, _In_ GLsizeiptr size, _Out_ struct StreamAllocation* allocation)
+{
+	return streambuffer_allocate(stream, size, stream->uniformAlignment, allocation);
+}
+
+bool streambuffer_allocateStorage(_Inout_ StreamBuffer* stream, _In_ GLsizeiptr size, _In_ GLsizeiptr elementSize, _Out_ struct StreamAllocation* allocation)
+{
+	// Both are powers of two in practice, the larger is a multiple of the smaller.
+	GLsizeiptr alignment = stream->storageAlignment > elementSize ? stream->storageAlignment : elementSize;
+	return streambuffer_allocate(stream, size, alignment, allocation);
+}
+
+GLuint streambuffer_buffer(_In_ const StreamBuffer* stream)
+{
+	return stream->buffer;
+}
@@ -0,0 +1,65 @@
+/**
+
+    @file      streambuffer.h
+    @brief     Persistently mapped ring for per-frame vertex, index and uniform data
+    @details   One immutable buffer is mapped coherently for its whole lifetime
+               and split into a region per frame in flight. Each frame writes
+               straight into its own region, a fence per region makes the CPU
+               wait only when it laps the GPU. Nothing is ever respecified with
+               glBufferData or copied with glBufferSubData, so streaming doesn't
+               synchronize with the draws still reading last frame's data.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+
+
+// Triple buffering, the CPU may run two frames ahead of the GPU before it waits.
+#define STREAM_DEFAULT_FRAMES	3
+#define STREAM_MAX_FRAMES		4
+
+typedef struct StreamBuffer StreamBuffer;
+
+struct StreamAllocation
+{
+	void* data;				// write only, visible to the GPU without flushing
+	GLuint buffer;			// bind as vertex, index or uniform buffer
+	GLintptr offset;		// of data within buffer
+	GLsizeiptr size;
+};
+
+/**
+	@brief  Creates and maps the ring.
+	@param  frameSize - bytes available to each frame
+	@param  frames    - frames in flight, 0 picks STREAM_DEFAULT_FRAMES
+	@retval           - NULL on failure
+**/
+StreamBuffer* streambuffer_create(_In_ GLsizeiptr frameSize, _In_ uint32_t frames);
+
+//unmaps and deletes the buffer, the GPU must be done with it.
+void streambuffer_destroy(_In_opt_ StreamBuffer* stream);
+
+//moves on to the next region, waiting for the GPU if it still reads from it.
+void streambuffer_beginFrame(_Inout_opt_ StreamBuffer* stream);
+
+//fences the region written this frame, call after the last draw using it.
+void streambuffer_endFrame(_Inout_opt_ StreamBuffer* stream);
+
+/**
+	@brief  Sub-allocates from the current frame's region, valid until the frame ends.
+	@param  alignment - in bytes, not necessarily a power of two. Aligning to the vertex stride makes offset / stride a base vertex.
+	@retval           - false when the region is exhausted
+**/
+bool streambuffer_allocate(_Inout_ StreamBuffer* stream, _In_ GLsizeiptr size, _In_ GLsizeiptr alignment, _Out_ struct StreamAllocation* allocation);
+
+//allocates with the alignment uniform buffer bindings need.
+bool streambuffer_allocateUniform(_Inout_ StreamBuffer* stream, _In_ GLsizeiptr size, _Out_ struct StreamAllocation* allocation);
+
+//allocates with the alignment shader storage bindings need, and at a multiple of elementSize so offset / elementSize is an element index.
+bool streambuffer_allocateStorage(_Inout_ StreamBuffer* stream, _In_ GLsizeiptr size, _In_ GLsizeiptr elementSize, _Out_ struct StreamAllocation* allocation);
+
+//the one buffer every allocation comes from, stays the same for the stream's lifetime.
+GLuint streambuffer_buffer(_In_ const StreamBuffer* stream);
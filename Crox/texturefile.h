@@ -0,0 +1,88 @@
+/**
+
+    @file      texturefile.h
+    @brief     Container for block compressed textures, written by crox_texcook
+    @details   A fixed size header followed by every mip level's blocks exactly
+               as glCompressedTextureSubImage2D takes them, so a mapped file
+               uploads without any decoding. Levels start on
+               TEXTURE_FILE_ALIGNMENT byte boundaries. Little endian only.
+               Header only.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+
+#define TEXTURE_FILE_MAGIC		0x58544343u	// "CCTX"
+#define TEXTURE_FILE_VERSION	1
+#define TEXTURE_FILE_MAX_LEVELS	16
+#define TEXTURE_FILE_ALIGNMENT	16
+
+enum TextureFileFormat
+{
+	TEXTURE_FILE_BC1 = 1,		// RGB, 8 bytes per 4x4 block
+	TEXTURE_FILE_BC3 = 3,		// RGBA, 16 bytes per 4x4 block
+};
+
+enum TextureFileFlags
+{
+	TEXTURE_FILE_SRGB = 1 << 0,	// color data, mips were filtered in linear light
+};
+
+struct TextureFileLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint64_t offset;			// from the start of the file
+	uint64_t size;
+};
+
+struct TextureFileHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint32_t format;			// enum TextureFileFormat
+	uint32_t flags;				// enum TextureFileFlags
+	uint32_t width;
+	uint32_t height;
+	uint32_t levelCount;
+	uint32_t padding;
+	struct TextureFileLevel levels[TEXTURE_FILE_MAX_LEVELS];
+};
+
+
+static inline uint32_t texturefile_blockSize(_In_ uint32_t format)
+{
+	return format == TEXTURE_FILE_BC1 ? 8 : format == TEXTURE_FILE_BC3 ? 16 : 0;
+}
+
+//bytes of one level, whole blocks even where the level is smaller than a block.
+static inline uint64_t texturefile_levelSize(_In_ uint32_t format, _In_ uint32_t width, _In_ uint32_t height)
+{
+	return (uint64_t)((width + 3) / 4) * ((height + 3) / 4) * texturefile_blockSize(format);
+}
+
+//the header if data is a complete container, NULL otherwise. Every level lies within size afterwards.
+static inline const struct TextureFileHeader* texturefile_validate(_In_reads_bytes_(size) const void* data, _In_ size_t size)
+{
+	const struct TextureFileHeader* header = data;
+	if (size < sizeof * header || header->magic != TEXTURE_FILE_MAGIC || header->version != TEXTURE_FILE_VERSION)
+		return NULL;
+	if (texturefile_blockSize(header->format) == 0 || header->levelCount == 0 || header->levelCount > TEXTURE_FILE_MAX_LEVELS)
+		return NULL;
+
+	uint32_t width = header->width, height = header->height;
+	for (uint32_t i = 0; i < header->levelCount; i++)
+	{
+		const struct TextureFileLevel* level = &header->levels[i];
+		if (level->width != width || level->height != height
+			|| level->size != texturefile_levelSize(header->format, width, height)
+			|| level->offset > size || level->size > size - level->offset)
+			return NULL;
+		width = width > 1 ? width / 2 : 1;
+		height = height > 1 ? height / 2 : 1;
+	}
+	return header;
+}
@@ -0,0 +1,611 @@
+/**
+
+    @file      texturestream.c
+    @brief     Asynchronous image loading and texture upload
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "texturestream.h"
+#include "platform/Threads.h"
+#include "platform/MappedFile.h"
+#include "texturefile.h"
+
+#include <stb_image.h>
+#include <string.h>
+#include <limits.h>
+
+
+#define STAGING_ALIGNMENT		16
+#define TEXTURE_CHANNELS		4
+
+// Long enough to never trip on a busy GPU, short enough to notice a hang.
+#define TEXTURE_FENCE_TIMEOUT_NS 1000000000ull
+
+struct StagingRange
+{
+	size_t offset;
+	size_t size;
+};
+
+struct TextureRequest
+{
+	struct TextureRequest* next;		// every request of the stream
+	struct TextureRequest* nextWork;	// in the work, decoded or retiring list
+	char* path;
+	enum TextureState state;			// GL thread only
+	bool isDecodeFailed;				// set by the decoding task before the request is decoded
+
+	uint32_t width;
+	uint32_t height;
+	GLenum format;						// sized internal format
+	uint32_t blockSize;					// bytes per 4x4 block, 0 when uncompressed
+	uint32_t levelCount;				// levels in staging, the rest are generated
+	size_t levelOffsets[TEXTURE_FILE_MAX_LEVELS];	// into staging
+	struct StagingRange staging;		// size 0 when nothing is held
+	uint32_t uploadedLevels;
+	uint32_t uploadedRows;				// of the level being uploaded
+	GLuint texture;
+	GLsync fence;						// after the last upload, staging is freed once it passes
+};
+
+struct RequestList
+{
+	struct TextureRequest* head;
+	struct TextureRequest* tail;
+};
+
+enum DecodeResult
+{
+	DECODE_DONE,
+	DECODE_FAILED,
+	DECODE_DEFERRED,					// the staging buffer is full, nothing was changed
+};
+
+struct TextureStream
+{
+	GLuint staging;
+	uint8_t* mapped;
+	size_t stagingSize;
+	size_t uploadBudget;
+
+	Scheduler* scheduler;
+	TaskCounter decodes;
+	uint32_t maxDecodes;
+
+	Mutex mutex;
+	struct RequestList work;
+	struct RequestList decoded;
+	struct StagingRange* ranges;		// live staging allocations sorted by offset
+	uint32_t rangeCount;
+	uint32_t rangeCapacity;
+	uint32_t decoding;					// tasks taking requests from the work list
+	bool quitting;
+
+	// GL thread only.
+	struct TextureRequest* requests;
+	struct TextureRequest* uploading;	// partly uploaded, continues next update
+	struct RequestList retiring;
+	uint32_t pending;					// neither ready nor failed
+};
+
+
+static void pushRequest(_Inout_ struct RequestList* list, _Inout_ struct TextureRequest* request)
+{
+	request->nextWork = NULL;
+	if (list->tail)
+		list->tail->nextWork = request;
+	else
+		list->head = request;
+	list->tail = request;
+}
+
+static struct TextureRequest* popRequest(_Inout_ struct RequestList* list)
+{
+	struct TextureRequest* request = list->head;
+	if (request == NULL)
+		return NULL;
+	list->head = request->nextWork;
+	if (list->head == NULL)
+		list->tail = NULL;
+	return request;
+}
+
+static bool allocateStaging(_Inout_ TextureStream* stream, _In_ size_t size, _Out_ struct StagingRange* range)
+//
+// First fit between the live ranges, uploads finish in about the order they were decoded so the gaps stay few.
+// Called with the mutex held.
+//
+{
+	size = (size + STAGING_ALIGNMENT - 1) & ~(size_t)(STAGING_ALIGNMENT - 1);
+	*range = (struct StagingRange){ .offset = 0, .size = 0 };
+	if (stream->rangeCount == stream->rangeCapacity)
+	{
+		uint32_t capacity = stream->rangeCapacity ? stream->rangeCapacity * 2 : 16;
+		struct StagingRange* ranges = realloc(stream->ranges, capacity * sizeof * ranges);
+		if (ranges == NULL)
+			return false;
+		stream->ranges = ranges;
+		stream->rangeCapacity = capacity;
+	}
+
+	size_t offset = 0;
+	uint32_t index = 0;
+	for (; index < stream->rangeCount; index++)
+	{
+		if (stream->ranges[index].offset - offset >= size)
+			break;
+		offset = stream->ranges[index].offset + stream->ranges[index].size;
+	}
+	if (stream->stagingSize - offset < size)
+		return false;
+
+	memmove(stream->ranges + index + 1, stream->ranges + index, (stream->rangeCount - index) * sizeof * stream->ranges);
+	stream->ranges[index] = (struct StagingRange){ .offset = offset, .size = size };
+	stream->rangeCount++;
+	*range = stream->ranges[index];
+	return true;
+}
+
+static void freeStaging(_Inout_ TextureStream* stream, _Inout_ struct StagingRange* range)
+//
+// Called with the mutex held.
+//
+{
+	for (uint32_t i = 0; i < stream->rangeCount; i++)
+	{
+		if (stream->ranges[i].offset != range->offset)
+			continue;
+		memmove(stream->ranges + i, stream->ranges + i + 1, (stream->rangeCount - i - 1) * sizeof * stream->ranges);
+		stream->rangeCount--;
+		break;
+	}
+	range->size = 0;
+}
+
+static void reportFailure(_In_z_ const char* path, _In_z_ const char* reason)
+{
+	// Not on the GL thread, so no glDebugMessageInsert here.
+	OutputDebugStringA(path);
+	OutputDebugStringA(": ");
+	OutputDebugStringA(reason);
+	OutputDebugStringA("\n");
+}
+
+static enum DecodeResult reserveStaging(_Inout_ TextureStream* stream, _Inout_ struct TextureRequest* request, _In_ size_t size)
+//
+// Reserved before decoding, a full staging buffer defers the request instead of piling up decoded images.
+//
+{
+	if (size > stream->stagingSize)
+	{
+		reportFailure(request->path, "larger than the staging buffer");
+		return DECODE_FAILED;
+	}
+	mutex_lock(&stream->mutex);
+	const bool isReserved = allocateStaging(stream, size, &request->staging);
+	mutex_unlock(&stream->mutex);
+	return isReserved ? DECODE_DONE : DECODE_DEFERRED;
+}
+
+static GLenum compressedFormat(_In_ const struct TextureFileHeader* header)
+{
+	const bool isSRGB = header->flags & TEXTURE_FILE_SRGB;
+	if (header->format == TEXTURE_FILE_BC1)
+		return isSRGB ? GL_COMPRESSED_SRGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+	return isSRGB ? GL_COMPRESSED_SRGB_ALPHA_S3TC_DXT5_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+}
+
+static enum DecodeResult copyContainer(_Inout_ TextureStream* stream, _Inout_ struct TextureRequest* request, _In_ const MappedFile* file, _In_ const struct TextureFileHeader* header)
+//
+// Cooked blocks go to staging as they are, the CPU never decodes them.
+//
+{
+	size_t size = 0;
+	for (uint32_t i = 0; i < header->levelCount; i++)
+		size += ((size_t)header->levels[i].size + STAGING_ALIGNMENT - 1) & ~(size_t)(STAGING_ALIGNMENT - 1);
+	const enum DecodeResult reserved = reserveStaging(stream, request, size);
+	if (reserved != DECODE_DONE)
+		return reserved;
+
+	size_t offset = request->staging.offset;
+	for (uint32_t i = 0; i < header->levelCount; i++)
+	{
+		const struct TextureFileLevel* level = &header->levels[i];
+		memcpy(stream->mapped + offset, (const uint8_t*)file->data + level->offset, (size_t)level->size);
+		request->levelOffsets[i] = offset;
+		offset += ((size_t)level->size + STAGING_ALIGNMENT - 1) & ~(size_t)(STAGING_ALIGNMENT - 1);
+	}
+	request->width = header->width;
+	request->height = header->height;
+	request->format = compressedFormat(header);
+	request->blockSize = texturefile_blockSize(header->format);
+	request->levelCount = header->levelCount;
+	return DECODE_DONE;
+}
+
+static enum DecodeResult decodeImage(_Inout_ TextureStream* stream, _Inout_ struct TextureRequest* request, _In_ const MappedFile* file)
+{
+	int width = 0, height = 0, channels = 0;
+	if (file->size > INT_MAX || !stbi_info_from_memory(file->data, (int)file->size, &width, &height, &channels))
+	{
+		reportFailure(request->path, file->size > INT_MAX ? "too large" : stbi_failure_reason());
+		return DECODE_FAILED;
+	}
+	const size_t size = (size_t)width * (size_t)height * TEXTURE_CHANNELS;
+	const enum DecodeResult reserved = reserveStaging(stream, request, size);
+	if (reserved != DECODE_DONE)
+		return reserved;
+
+	// stb_image always allocates its own output, one copy into staging is as direct as it gets.
+	stbi_uc* pixels = stbi_load_from_memory(file->data, (int)file->size, &width, &height, &channels, TEXTURE_CHANNELS);
+	if (pixels == NULL)
+	{
+		reportFailure(request->path, stbi_failure_reason());
+		mutex_lock(&stream->mutex);
+		freeStaging(stream, &request->staging);
+		mutex_unlock(&stream->mutex);
+		return DECODE_FAILED;
+	}
+	memcpy(stream->mapped + request->staging.offset, pixels, size);
+	stbi_image_free(pixels);
+	request->width = (uint32_t)width;
+	request->height = (uint32_t)height;
+	request->format = GL_RGBA8;
+	request->levelCount = 1;
+	request->levelOffsets[0] = request->staging.offset;
+	return DECODE_DONE;
+}
+
+static enum DecodeResult decode(_Inout_ TextureStream* stream, _Inout_ struct TextureRequest* request)
+{
+	MappedFile file;
+	if (!mappedfile_open(&file, request->path))
+	{
+		reportFailure(request->path, "can't be opened");
+		request->isDecodeFailed = true;
+		return DECODE_FAILED;
+	}
+
+	const struct TextureFileHeader* header = texturefile_validate(file.data, file.size);
+	const enum DecodeResult result = header
+		? copyContainer(stream, request, &file, header)
+		: decodeImage(stream, request, &file);
+	request->isDecodeFailed = result == DECODE_FAILED;
+	mappedfile_close(&file);
+	return result;
+}
+
+static void decodeTask(_In_opt_ void* user, _In_ uint32_t first, _In_ uint32_t count)
+//
+// Takes requests until none are left, so the stream never holds more of the scheduler's threads than it may.
+// Tasks don't wait for staging space, a deferred request goes back to the work list and the task returns its thread.
+//
+{
+	(void)first;
+	(void)count;
+	TextureStream* stream = user;
+
+	mutex_lock(&stream->mutex);
+	for (;;)
+	{
+		struct TextureRequest* request = stream->quitting ? NULL : popRequest(&stream->work);
+		if (request == NULL)
+			break;
+		mutex_unlock(&stream->mutex);
+
+		const enum DecodeResult result = decode(stream, request);
+
+		mutex_lock(&stream->mutex);
+		if (result == DECODE_DEFERRED)
+		{
+			// The next update starts a task again, by then it has freed staging space.
+			pushRequest(&stream->work, request);
+			break;
+		}
+		pushRequest(&stream->decoded, request);
+	}
+	stream->decoding--;
+	mutex_unlock(&stream->mutex);
+}
+
+static void startDecode(_Inout_ TextureStream* stream)
+//
+// Starts a task if requests are waiting and fewer than maxDecodes are running. Called from the GL thread.
+//
+{
+	mutex_lock(&stream->mutex);
+	const bool isStarting = stream->work.head && stream->decoding < stream->maxDecodes;
+	if (isStarting)
+		stream->decoding++;
+	mutex_unlock(&stream->mutex);
+
+	if (isStarting && !scheduler_submit(stream->scheduler, &(struct TaskDesc){ .proc = decodeTask, .user = stream, .count = 1, .counter = &stream->decodes }))
+	{
+		// Without a task left to take them, whatever is queued fails on the next update.
+		mutex_lock(&stream->mutex);
+		if (--stream->decoding == 0)
+		{
+			for (struct TextureRequest* failed; (failed = popRequest(&stream->work));)
+			{
+				reportFailure(failed->path, "no task to decode it");
+				failed->isDecodeFailed = true;
+				pushRequest(&stream->decoded, failed);
+			}
+		}
+		mutex_unlock(&stream->mutex);
+	}
+}
+
+static uint32_t mipLevels(_In_ uint32_t width, _In_ uint32_t height)
+{
+	uint32_t levels = 1;
+	for (uint32_t size = width > height ? width : height; size > 1; size /= 2)
+		levels++;
+	return levels;
+}
+
+static void complete(_Inout_ TextureStream* stream, _Inout_ struct TextureRequest* request, _In_ enum TextureState state)
+{
+	request->state = state;
+	stream->pending--;
+}
+
+static bool upload(_Inout_ struct TextureRequest* request, _Inout_ size_t* budget)
+//
+// Uploads rows, of blocks when compressed, until the request is done or the budget is spent. The first rows of an update always go through.
+// Returns true once every level is in.
+//
+{
+	if (request->texture == 0)
+	{
+		const uint32_t levels = request->blockSize ? request->levelCount : mipLevels(request->width, request->height);
+		glCreateTextures(GL_TEXTURE_2D, 1, &request->texture);
+		NAME_OBJECT(GL_TEXTURE, request->texture, request->path);
+		glTextureStorage2D(request->texture, levels, request->format, request->width, request->height);
+		glTextureParameteri(request->texture, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+		glTextureParameteri(request->texture, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	}
+
+	const uint32_t blockHeight = request->blockSize ? 4 : 1;
+	while (request->uploadedLevels < request->levelCount && *budget > 0)
+	{
+		const uint32_t level = request->uploadedLevels;
+		const uint32_t width = request->width >> level ? request->width >> level : 1;
+		const uint32_t height = request->height >> level ? request->height >> level : 1;
+		// Tightly packed RGBA8 rows are always 4 byte aligned, the default unpack state fits.
+		const size_t rowSize = request->blockSize
+			? (size_t)(width + 3) / 4 * request->blockSize
+			: (size_t)width * TEXTURE_CHANNELS;
+
+		uint32_t blockRows = (height - request->uploadedRows + blockHeight - 1) / blockHeight;
+		if ((size_t)blockRows * rowSize > *budget)
+			blockRows = *budget / rowSize > 0 ? (uint32_t)(*budget / rowSize) : 1;
+		const size_t size = (size_t)blockRows * rowSize;
+		*budget = size < *budget ? *budget - size : 0;
+
+		uint32_t rows = blockRows * blockHeight;
+		if (rows > height - request->uploadedRows)
+			rows = height - request->uploadedRows;
+		const void* offset = (const void*)(GLintptr)(request->levelOffsets[level] + (size_t)(request->uploadedRows / blockHeight) * rowSize);
+		if (request->blockSize)
+			glCompressedTextureSubImage2D(request->texture, level, 0, (GLint)request->uploadedRows, width, rows, request->format, (GLsizei)size, offset);
+		else
+			glTextureSubImage2D(request->texture, level, 0, (GLint)request->uploadedRows, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, offset);
+
+		request->uploadedRows += rows;
+		if (request->uploadedRows == height)
+		{
+			request->uploadedLevels++;
+			request->uploadedRows = 0;
+		}
+	}
+	if (request->uploadedLevels < request->levelCount)
+		return false;
+
+	if (request->blockSize == 0)
+		glGenerateTextureMipmap(request->texture);
+	request->fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	return true;
+}
+
+static bool isSupported(_In_ GLenum format)
+{
+	GLint supported = GL_FALSE;
+	glGetInternalformativ(GL_TEXTURE_2D, format, GL_INTERNALFORMAT_SUPPORTED, 1, &supported);
+	return supported == GL_TRUE;
+}
+
+static void retire(_Inout_ TextureStream* stream, _In_ bool wait)
+//
+// Frees the staging space of uploads the GPU has consumed, in upload order.
+//
+{
+	while (stream->retiring.head)
+	{
+		struct TextureRequest* request = stream->retiring.head;
+		GLenum status = glClientWaitSync(request->fence, wait ? GL_SYNC_FLUSH_COMMANDS_BIT : 0, wait ? TEXTURE_FENCE_TIMEOUT_NS : 0);
+		if (status == GL_TIMEOUT_EXPIRED)
+			break;
+		glDeleteSync(request->fence);
+		request->fence = NULL;
+		popRequest(&stream->retiring);
+
+		mutex_lock(&stream->mutex);
+		freeStaging(stream, &request->staging);
+		mutex_unlock(&stream->mutex);
+	}
+}
+
+static void update(_Inout_ TextureStream* stream, _In_ size_t budget)
+{
+	retire(stream, false);
+	startDecode(stream);
+
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, stream->staging);
+	while (budget > 0)
+	{
+		if (stream->uploading == NULL)
+		{
+			mutex_lock(&stream->mutex);
+			stream->uploading = popRequest(&stream->decoded);
+			mutex_unlock(&stream->mutex);
+			if (stream->uploading == NULL)
+				break;
+			if (!stream->uploading->isDecodeFailed && stream->uploading->blockSize && !isSupported(stream->uploading->format))
+			{
+				glDebugMessageInsert(GL_DEBUG_SOURCE_APPLICATION, GL_DEBUG_TYPE_ERROR, 0, GL_DEBUG_SEVERITY_MEDIUM, -1,
+					"Texture compression format not supported, cooked texture dropped");
+				mutex_lock(&stream->mutex);
+				freeStaging(stream, &stream->uploading->staging);
+				mutex_unlock(&stream->mutex);
+				stream->uploading->isDecodeFailed = true;
+			}
+			if (stream->uploading->isDecodeFailed)
+			{
+				complete(stream, stream->uploading, TEXTURE_FAILED);
+				stream->uploading = NULL;
+				continue;
+			}
+		}
+
+		if (!upload(stream->uploading, &budget))
+			break;
+		complete(stream, stream->uploading, TEXTURE_READY);
+		pushRequest(&stream->retiring, stream->uploading);
+		stream->uploading = NULL;
+	}
+	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+}
+
+static void freeRequest(_Inout_ struct TextureRequest* request)
+{
+	if (request->fence)
+		glDeleteSync(request->fence);
+	if (request->texture)
+		glDeleteTextures(1, &request->texture);
+	free(request->path);
+	free(request);
+}
+
+
+TextureStream* texturestream_create(_In_ size_t stagingSize, _In_ size_t uploadBudget, _In_ Scheduler* scheduler, _In_ uint32_t decodes)
+{
+	if (stagingSize == 0)
+		return NULL;
+
+	TextureStream* stream = calloc(1, sizeof * stream);
+	if (stream == NULL)
+		return NULL;
+
+	stream->stagingSize = stagingSize;
+	stream->uploadBudget = uploadBudget > 0 ? uploadBudget : 1;
+	stream->scheduler = scheduler;
+	stream->maxDecodes = decodes ? decodes : TEXTURE_DEFAULT_DECODES;
+
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glCreateBuffers(1, &stream->staging);
+	NAME_OBJECT(GL_BUFFER, stream->staging, "Texture Staging");
+	glNamedBufferStorage(stream->staging, (GLsizeiptr)stagingSize, NULL, flags);
+	stream->mapped = glMapNamedBufferRange(stream->staging, 0, (GLsizeiptr)stagingSize, flags);
+
+	mutex_init(&stream->mutex);
+	if (stream->mapped == NULL)
+	{
+		texturestream_destroy(stream);
+		return NULL;
+	}
+
+	return stream;
+}
+
+void texturestream_destroy(_In_opt_ TextureStream* stream)
+{
+	if (stream == NULL)
+		return;
+
+	// Running tasks finish the request in hand and take no other.
+	mutex_lock(&stream->mutex);
+	stream->quitting = true;
+	mutex_unlock(&stream->mutex);
+	if (stream->scheduler)
+		scheduler_wait(stream->scheduler, &stream->decodes);
+
+	while (stream->requests)
+	{
+		struct TextureRequest* next = stream->requests->next;
+		freeRequest(stream->requests);
+		stream->requests = next;
+	}
+
+	if (stream->mapped)
+		glUnmapNamedBuffer(stream->staging);
+	glDeleteBuffers(1, &stream->staging);
+	free(stream->ranges);
+	mutex_destroy(&stream->mutex);
+	free(stream);
+}
+
+TextureRequest* texturestream_load(_Inout_ TextureStream* stream, _In_z_ const char* path)
+{
+	struct TextureRequest* request = calloc(1, sizeof * request);
+	if (request == NULL)
+		return NULL;
+	request->path = malloc(strlen(path) + 1);
+	if (request->path == NULL)
+	{
+		free(request);
+		return NULL;
+	}
+	strcpy(request->path, path);
+	request->state = TEXTURE_PENDING;
+
+	request->next = stream->requests;
+	stream->requests = request;
+	stream->pending++;
+
+	mutex_lock(&stream->mutex);
+	pushRequest(&stream->work, request);
+	mutex_unlock(&stream->mutex);
+	startDecode(stream);
+	return request;
+}
+
+void texturestream_update(_Inout_opt_ TextureStream* stream)
+{
+	if (stream == NULL)
+		return;
+	update(stream, stream->uploadBudget);
+}
+
+bool texturestream_finish(_Inout_ TextureStream* stream)
+{
+	for (;;)
+	{
+		update(stream, SIZE_MAX);
+		// Deferred requests need the staging space these uploads hold, the next update starts them again.
+		retire(stream, true);
+		if (stream->pending == 0)
+			break;
+
+		// Every task returns whether its decodes worked or not, so this can't hang on a failed one.
+		scheduler_wait(stream->scheduler, &stream->decodes);
+	}
+
+	bool success = true;
+	for (const struct TextureRequest* request = stream->requests; request; request = request->next)
+		success = success && request->state == TEXTURE_READY;
+	return success;
+}
+
+enum TextureState texturestream_state(_In_ const TextureRequest* request)
+{
+	return request->state;
+}
+
+GLuint texturestream_texture(_In_opt_ const TextureRequest* request, _In_ GLuint fallback)
+{
+	return request && request->state == TEXTURE_READY ? request->texture : fallback;
+}
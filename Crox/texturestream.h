@@ -0,0 +1,67 @@
+/**
+
+    @file      texturestream.h
+    @brief     Asynchronous image loading and texture upload
+    @details   Scheduler tasks map and decode image files with stb_image and
+               copy the pixels into a persistently mapped staging buffer. Only
+               a few decode at once. While the staging buffer is full a task
+               puts its request back and returns its thread, the next update
+               starts one again. The GL thread uploads from that buffer as a
+               pixel unpack buffer, a few rows at a time within a per-frame
+               byte budget, so neither decoding nor a large upload ever stalls
+               a frame. Staging space is recycled once a fence says the upload
+               has been consumed.
+               Containers cooked by crox_texcook skip decoding, their block
+               compressed levels are copied to staging as they are.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "scheduler.h"
+
+
+#define TEXTURE_DEFAULT_DECODES 2
+
+typedef struct TextureStream TextureStream;
+typedef struct TextureRequest TextureRequest;
+
+enum TextureState
+{
+	TEXTURE_PENDING,
+	TEXTURE_READY,
+	TEXTURE_FAILED,
+};
+
+/**
+	@brief  Creates the staging buffer, decoding runs on the scheduler's threads.
+	@param  stagingSize  - bytes of decoded pixels in flight, also the largest image that can load
+	@param  uploadBudget - bytes uploaded per update, at least one row always goes through
+	@param  scheduler    - must outlive the stream
+	@param  decodes      - images decoding at once, 0 picks TEXTURE_DEFAULT_DECODES
+	@retval              - NULL on failure
+**/
+TextureStream* texturestream_create(_In_ size_t stagingSize, _In_ size_t uploadBudget, _In_ Scheduler* scheduler, _In_ uint32_t decodes);
+
+//waits for the decoding tasks and deletes every texture the stream created.
+void texturestream_destroy(_In_opt_ TextureStream* stream);
+
+/**
+	@brief  Queues an image file, decoded to RGBA8 with a full mip chain, or a texturefile.h container with its cooked levels.
+	@retval - handle owned by the stream, NULL on failure
+**/
+TextureRequest* texturestream_load(_Inout_ TextureStream* stream, _In_z_ const char* path);
+
+//uploads within the budget and recycles staging space. Call once per frame from the GL thread.
+void texturestream_update(_Inout_opt_ TextureStream* stream);
+
+//uploads everything queued, ignoring the budget. Returns false if any load failed.
+bool texturestream_finish(_Inout_ TextureStream* stream);
+
+//only changes during updates.
+enum TextureState texturestream_state(_In_ const TextureRequest* request);
+
+//the texture once ready, fallback until then or if it failed.
+GLuint texturestream_texture(_In_opt_ const TextureRequest* request, _In_ GLuint fallback);
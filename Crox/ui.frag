@@ -0,0 +1,14 @@
+#version 450 core
+
+layout(location = 0) out vec4 fragColor;
+
+// GL_R8 coverage, text and untextured shapes alike.
+layout(binding = 0) uniform sampler2D atlas;
+
+in vec2 uv;
+in vec4 color;
+
+void main()
+{
+	fragColor = vec4(color.rgb, color.a * texture(atlas, uv).r);
+}
\ No newline at end of file
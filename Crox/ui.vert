@@ -0,0 +1,16 @@
+#version 450 core
+
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec2 aUV;
+layout(location = 2) in vec4 aColor;	// normalized RGBA8
+
+layout(location = 0) uniform mat4 projection;	// client area pixels, top left origin
+
+out vec2 uv;
+out vec4 color;
+
+void main(){
+	gl_Position = projection * vec4(aPos, 0, 1.0f);
+	uv = aUV;
+	color = aColor;
+}
\ No newline at end of file
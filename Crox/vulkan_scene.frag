@@ -0,0 +1,24 @@
+#version 450 core
+// The Vulkan backend has no material table yet, the checkerboards of Crox.c's materials are computed instead.
+
+layout(location = 0) in vec3 color;
+layout(location = 1) in vec2 uv;
+layout(location = 2) flat in uint material;
+
+layout(location = 0) out vec4 fragColor;
+
+// The flat permutation is what draws until the checkered one is compiled.
+layout(constant_id = 0) const bool CHECKERED = true;
+
+void main()
+{
+	if (!CHECKERED)
+	{
+		fragColor = vec4(color, 1.0f);
+		return;
+	}
+	float cells = float(2u << material);
+	ivec2 cell = ivec2(floor(uv * cells));
+	float value = ((cell.x + cell.y) & 1) != 0 ? 1.0f : 96.0f / 255.0f;
+	fragColor = vec4(color * value, 1.0f);
+}
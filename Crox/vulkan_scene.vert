@@ -0,0 +1,20 @@
+#version 450 core
+// The Vulkan backend's counterpart of default.vert, compiled to vulkan_scene.vert.spv at build time.
+
+layout(location = 0) in vec2 aPos;
+layout(location = 1) in vec3 aRGB;
+layout(location = 2) in vec2 aOffset;	// per instance
+layout(location = 3) in vec2 aUV;
+layout(location = 4) in uint aMaterial;	// per instance
+
+layout(location = 0) out vec3 color;
+layout(location = 1) out vec2 uv;
+layout(location = 2) flat out uint material;
+
+void main(){
+	// Vulkan's clip space points down, flipped so the scene comes out the same way up as on GL.
+	gl_Position = vec4(aPos.x + aOffset.x, -(aPos.y + aOffset.y), 0, 1.0f);
+	color = aRGB;
+	uv = aUV;
+	material = aMaterial;
+}
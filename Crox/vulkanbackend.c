@@ -0,0 +1,626 @@
+/**
+
+    @file      vulkanbackend.c
+    @brief     Frame loop of the Vulkan backend
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "framework_opengl.h"
+#include "vulkanbackend.h"
+#include "vulkandevice.h"
+#include "vulkanrecorder.h"
+#include "vulkanpipelines.h"
+#include "capture.h"
+#include "platform/Platform.h"
+
+#include <math.h>
+
+
+#define FRAMES_IN_FLIGHT		2
+#define TARGET_FORMAT			VK_FORMAT_R8G8B8A8_UNORM
+#define DRAWS_PER_JOB			64		// at least, fewer aren't worth a secondary buffer
+#define INSTANCES_PER_TASK		1024	// at least, written per scene task
+
+// Same scene as Crox.c draws, more instances are added as further columns.
+#define SCENE_ROWS		4
+#define SCENE_COLUMNS	16
+#define SCENE_INSTANCES	(SCENE_ROWS * SCENE_COLUMNS)
+#define SCENE_RADIUS	0.15f
+#define SCENE_MATERIALS	4
+
+// Permutations of the scene pipeline, by vulkan_scene.frag's CHECKERED constant.
+enum ScenePipeline
+{
+	SCENE_FLAT,
+	SCENE_CHECKERED,
+	SCENE_PIPELINE_COUNT,
+};
+
+// Matches vulkan_scene.vert.
+struct SceneVertex
+{
+	float pos[2];
+	float rgb[3];
+	float uv[2];
+};
+
+struct SceneInstance
+{
+	float offset[2];
+	uint32_t material;
+};
+
+struct SceneGeometry
+{
+	struct SceneVertex vertices[3];
+	struct SceneInstance instances[];	// one per draw
+};
+
+struct Frame
+{
+	VkImage target;
+	VmaAllocation targetMemory;
+	VkImageView targetView;
+	VkFramebuffer framebuffer;
+
+	VkBuffer geometry;
+	VmaAllocation geometryMemory;
+	struct SceneGeometry* mapped;
+
+	VkBuffer readback;
+	VmaAllocation readbackMemory;
+	const uint8_t* pixels;
+
+	VkCommandPool pool;
+	VkCommandBuffer commands;
+	VkFence fence;
+	bool isPending;		// submitted and not presented yet
+};
+
+struct Renderer
+{
+	VulkanDevice* device;
+	uint32_t width;
+	uint32_t height;
+	VkRenderPass renderPass;
+	VkPipelineLayout layout;
+	VulkanPipelines* pipelines;
+	uint32_t scenePipelines[SCENE_PIPELINE_COUNT];
+	struct Frame frames[FRAMES_IN_FLIGHT];
+	Scheduler* scheduler;
+	VulkanRecorder* recorder;
+	uint32_t drawCount;
+	uint64_t recordTime;			// nanoseconds spent recording, over all frames
+
+	// The GL side, finished frames are uploaded here and blitted to wherever they are presented.
+	GLuint texture;
+	GLuint readFramebuffer;
+};
+
+
+static VkRenderPass makeRenderPass(_In_ const VulkanDevice* device)
+//
+// Leaves the target ready to be copied back.
+//
+{
+	const VkAttachmentDescription attachment = {
+		.format = TARGET_FORMAT,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
+		.storeOp = VK_ATTACHMENT_STORE_OP_STORE,
+		.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+		.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+		.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	};
+	const VkAttachmentReference color = { .attachment = 0, .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+	const VkSubpassDescription subpass = {
+		.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+		.colorAttachmentCount = 1,
+		.pColorAttachments = &color,
+	};
+	const VkSubpassDependency dependencies[] = {
+		{
+			// The previous copy out of this target.
+			.srcSubpass = VK_SUBPASS_EXTERNAL,
+			.dstSubpass = 0,
+			.srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.srcAccessMask = 0,
+			.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+		},
+		{
+			.srcSubpass = 0,
+			.dstSubpass = VK_SUBPASS_EXTERNAL,
+			.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+			.dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT,
+			.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+			.dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT,
+		},
+	};
+	const VkRenderPassCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+		.attachmentCount = 1,
+		.pAttachments = &attachment,
+		.subpassCount = 1,
+		.pSubpasses = &subpass,
+		.dependencyCount = sizeof dependencies / sizeof * dependencies,
+		.pDependencies = dependencies,
+	};
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	vkCreateRenderPass(device->device, &info, NULL, &renderPass);
+	return renderPass;
+}
+
+static bool addScenePipelines(_Inout_ struct Renderer* renderer)
+{
+	const VkVertexInputBindingDescription bindings[] = {
+		{ .binding = 0, .stride = sizeof(struct SceneVertex), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX },
+		{ .binding = 1, .stride = sizeof(struct SceneInstance), .inputRate = VK_VERTEX_INPUT_RATE_INSTANCE },
+	};
+	const VkVertexInputAttributeDescription attributes[] = {
+		{ .location = 0, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT, .offset = offsetof(struct SceneVertex, pos) },
+		{ .location = 1, .binding = 0, .format = VK_FORMAT_R32G32B32_SFLOAT, .offset = offsetof(struct SceneVertex, rgb) },
+		{ .location = 2, .binding = 1, .format = VK_FORMAT_R32G32_SFLOAT, .offset = offsetof(struct SceneInstance, offset) },
+		{ .location = 3, .binding = 0, .format = VK_FORMAT_R32G32_SFLOAT, .offset = offsetof(struct SceneVertex, uv) },
+		{ .location = 4, .binding = 1, .format = VK_FORMAT_R32_UINT, .offset = offsetof(struct SceneInstance, material) },
+	};
+	const VkPipelineVertexInputStateCreateInfo vertexInput = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO,
+		.vertexBindingDescriptionCount = sizeof bindings / sizeof * bindings,
+		.pVertexBindingDescriptions = bindings,
+		.vertexAttributeDescriptionCount = sizeof attributes / sizeof * attributes,
+		.pVertexAttributeDescriptions = attributes,
+	};
+
+	// The flat permutation goes first, it is the one wanted soonest.
+	for (uint32_t i = 0; i < SCENE_PIPELINE_COUNT; i++)
+	{
+		const struct SpecConstant checkered = { .id = 0, .value = i == SCENE_CHECKERED };
+		const struct SpirvStage stages[] = {
+			{ .type = VK_SHADER_STAGE_VERTEX_BIT, .path = "vulkan_scene.vert.spv" },
+			{ .type = VK_SHADER_STAGE_FRAGMENT_BIT, .path = "vulkan_scene.frag.spv", .constantCount = 1, .constants = &checkered },
+		};
+		const struct VulkanPipelineDesc desc = {
+			.stageCount = sizeof stages / sizeof * stages,
+			.stages = stages,
+			.vertexInput = &vertexInput,
+			.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST,
+			.cullMode = VK_CULL_MODE_NONE,
+			.layout = renderer->layout,
+			.renderPass = renderer->renderPass,
+			.subpass = 0,
+		};
+		renderer->scenePipelines[i] = vulkanpipelines_add(renderer->pipelines, &desc);
+		if (renderer->scenePipelines[i] == VULKANPIPELINE_NONE)
+			return false;
+	}
+	return true;
+}
+
+static bool createFrame(_In_ const struct Renderer* renderer, _Out_ struct Frame* frame)
+{
+	const VulkanDevice* device = renderer->device;
+	*frame = (struct Frame){ 0 };
+
+	const VkImageCreateInfo imageInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+		.imageType = VK_IMAGE_TYPE_2D,
+		.format = TARGET_FORMAT,
+		.extent = { renderer->width, renderer->height, 1 },
+		.mipLevels = 1,
+		.arrayLayers = 1,
+		.samples = VK_SAMPLE_COUNT_1_BIT,
+		.tiling = VK_IMAGE_TILING_OPTIMAL,
+		.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT,
+		.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+	};
+	const VmaAllocationCreateInfo targetAlloc = {
+		.usage = VMA_MEMORY_USAGE_AUTO_PREFER_DEVICE,
+		.flags = VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT,
+	};
+	if (vmaCreateImage(device->allocator, &imageInfo, &targetAlloc, &frame->target, &frame->targetMemory, NULL) != VK_SUCCESS)
+		return false;
+
+	const VkImageViewCreateInfo viewInfo = {
+		.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+		.image = frame->target,
+		.viewType = VK_IMAGE_VIEW_TYPE_2D,
+		.format = TARGET_FORMAT,
+		.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 },
+	};
+	if (vkCreateImageView(device->device, &viewInfo, NULL, &frame->targetView) != VK_SUCCESS)
+		return false;
+
+	const VkFramebufferCreateInfo framebufferInfo = {
+		.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+		.renderPass = renderer->renderPass,
+		.attachmentCount = 1,
+		.pAttachments = &frame->targetView,
+		.width = renderer->width,
+		.height = renderer->height,
+		.layers = 1,
+	};
+	if (vkCreateFramebuffer(device->device, &framebufferInfo, NULL, &frame->framebuffer) != VK_SUCCESS)
+		return false;
+
+	// Written by the CPU every frame and read once by the GPU, wherever VMA finds host visible memory.
+	const VkBufferCreateInfo geometryInfo = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		.size = sizeof(struct SceneGeometry) + renderer->drawCount * sizeof(struct SceneInstance),
+		.usage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+	};
+	const VmaAllocationCreateInfo geometryAlloc = {
+		.usage = VMA_MEMORY_USAGE_AUTO,
+		.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+	};
+	VmaAllocationInfo allocation;
+	if (vmaCreateBuffer(device->allocator, &geometryInfo, &geometryAlloc, &frame->geometry, &frame->geometryMemory, &allocation) != VK_SUCCESS)
+		return false;
+	frame->mapped = allocation.pMappedData;
+
+	const VkBufferCreateInfo readbackInfo = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO,
+		.size = (VkDeviceSize)renderer->width * renderer->height * 4,
+		.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+	};
+	const VmaAllocationCreateInfo readbackAlloc = {
+		.usage = VMA_MEMORY_USAGE_AUTO,
+		.flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_RANDOM_BIT | VMA_ALLOCATION_CREATE_MAPPED_BIT,
+	};
+	if (vmaCreateBuffer(device->allocator, &readbackInfo, &readbackAlloc, &frame->readback, &frame->readbackMemory, &allocation) != VK_SUCCESS)
+		return false;
+	frame->pixels = allocation.pMappedData;
+
+	const VkCommandPoolCreateInfo poolInfo = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+		.queueFamilyIndex = device->queueFamily,
+	};
+	if (vkCreateCommandPool(device->device, &poolInfo, NULL, &frame->pool) != VK_SUCCESS)
+		return false;
+	const VkCommandBufferAllocateInfo commandsInfo = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+		.commandPool = frame->pool,
+		.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+		.commandBufferCount = 1,
+	};
+	if (vkAllocateCommandBuffers(device->device, &commandsInfo, &frame->commands) != VK_SUCCESS)
+		return false;
+
+	const VkFenceCreateInfo fenceInfo = { .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO };
+	return vkCreateFence(device->device, &fenceInfo, NULL, &frame->fence) == VK_SUCCESS;
+}
+
+static void destroyFrame(_In_ const struct Renderer* renderer, _Inout_ struct Frame* frame)
+{
+	const VulkanDevice* device = renderer->device;
+	vkDestroyFence(device->device, frame->fence, NULL);
+	vkDestroyCommandPool(device->device, frame->pool, NULL);
+	vmaDestroyBuffer(device->allocator, frame->readback, frame->readbackMemory);
+	vmaDestroyBuffer(device->allocator, frame->geometry, frame->geometryMemory);
+	vkDestroyFramebuffer(device->device, frame->framebuffer, NULL);
+	vkDestroyImageView(device->device, frame->targetView, NULL);
+	vmaDestroyImage(device->allocator, frame->target, frame->targetMemory);
+}
+
+struct SceneWrite
+{
+	struct SceneGeometry* geometry;
+	uint32_t frame;
+};
+
+static void writeInstances(_In_opt_ void* user, _In_ uint32_t first, _In_ uint32_t count)
+{
+	const struct SceneWrite* write = user;
+	const uint32_t frame = write->frame;
+	for (uint32_t i = first; i < first + count; i++)
+	{
+		const uint32_t row = i / SCENE_COLUMNS % SCENE_ROWS;
+		const uint32_t column = i % SCENE_COLUMNS + i / SCENE_INSTANCES * SCENE_COLUMNS;
+		write->geometry->instances[i] = (struct SceneInstance){
+			.offset = {
+				fmodf((float)column * 0.5f + (float)frame * 0.004f * (float)(row + 1), 8.0f) - 4.0f,
+				-0.75f + (float)row * 0.5f,
+			},
+			.material = (row + column) % SCENE_MATERIALS,
+		};
+	}
+}
+
+static void writeScene(_Inout_ Scheduler* scheduler, _Out_ struct SceneGeometry* geometry, _In_ uint32_t frame, _In_ uint32_t drawCount)
+//
+// Animated by frame rather than time, exactly like Crox.c's updateScene. Instances are written on every thread.
+//
+{
+	const float angle = (float)frame * 0.01f;
+	for (uint32_t i = 0; i < 3; i++)
+	{
+		const float corner = angle + (float)i * 2.0943951f; // 120 degrees apart
+		geometry->vertices[i] = (struct SceneVertex){
+			.pos = { SCENE_RADIUS * sinf(corner), SCENE_RADIUS * cosf(corner) },
+			.rgb = { i == 0, i == 1, i == 2 },
+			.uv = { 0.5f + 0.5f * sinf((float)i * 2.0943951f), 0.5f + 0.5f * cosf((float)i * 2.0943951f) },
+		};
+	}
+
+	struct SceneWrite write = { .geometry = geometry, .frame = frame };
+	TaskCounter written = { 0 };
+	scheduler_parallelFor(scheduler, drawCount, INSTANCES_PER_TASK, writeInstances, &write, &written);
+	scheduler_wait(scheduler, &written);
+}
+
+struct SceneRecording
+{
+	const struct Renderer* renderer;
+	const struct Frame* frame;
+	VkPipeline pipeline;
+};
+
+static void recordDraws(_In_ VkCommandBuffer commands, _In_ uint32_t first, _In_ uint32_t count, _In_opt_ void* user)
+//
+// Runs on any of the scheduler's threads, every job sets its own state.
+//
+{
+	const struct SceneRecording* recording = user;
+	const struct Renderer* renderer = recording->renderer;
+
+	const VkViewport viewport = { 0.0f, 0.0f, (float)renderer->width, (float)renderer->height, 0.0f, 1.0f };
+	const VkRect2D scissor = { { 0, 0 }, { renderer->width, renderer->height } };
+	vkCmdSetViewport(commands, 0, 1, &viewport);
+	vkCmdSetScissor(commands, 0, 1, &scissor);
+	vkCmdBindPipeline(commands, VK_PIPELINE_BIND_POINT_GRAPHICS, recording->pipeline);
+
+	const VkBuffer buffers[] = { recording->frame->geometry, recording->frame->geometry };
+	const VkDeviceSize offsets[] = { offsetof(struct SceneGeometry, vertices), offsetof(struct SceneGeometry, instances) };
+	vkCmdBindVertexBuffers(commands, 0, 2, buffers, offsets);
+
+	for (uint32_t i = first; i < first + count; i++)
+		vkCmdDraw(commands, 3, 1, 0, i);
+}
+
+static bool recordFrame(_Inout_ struct Renderer* renderer, _In_ uint32_t slot)
+{
+	struct Frame* frame = &renderer->frames[slot];
+	VkCommandBuffer commands = frame->commands;
+	vkResetCommandPool(renderer->device->device, frame->pool, 0);
+	const VkCommandBufferBeginInfo begin = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+	};
+	vkBeginCommandBuffer(commands, &begin);
+
+	const VkClearValue clear = { .color = { .float32 = { 0.0f, 0.0f, 0.0f, 1.0f } } };
+	const VkRenderPassBeginInfo pass = {
+		.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+		.renderPass = renderer->renderPass,
+		.framebuffer = frame->framebuffer,
+		.renderArea = { { 0, 0 }, { renderer->width, renderer->height } },
+		.clearValueCount = 1,
+		.pClearValues = &clear,
+	};
+	vkCmdBeginRenderPass(commands, &pass, VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+	const VkCommandBufferInheritanceInfo inheritance = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO,
+		.renderPass = renderer->renderPass,
+		.subpass = 0,
+		.framebuffer = frame->framebuffer,
+	};
+
+	// Whichever permutation is ready, nothing is drawn before the first one is.
+	VkPipeline pipeline = vulkanpipelines_pipeline(renderer->pipelines, renderer->scenePipelines[SCENE_CHECKERED]);
+	if (pipeline == VK_NULL_HANDLE)
+		pipeline = vulkanpipelines_pipeline(renderer->pipelines, renderer->scenePipelines[SCENE_FLAT]);
+	const uint32_t drawCount = pipeline ? renderer->drawCount : 0;
+
+	const uint64_t start = platform_getTime();
+	const bool recorded = vulkanrecorder_record(renderer->recorder, slot, &inheritance, drawCount, DRAWS_PER_JOB, recordDraws,
+		&(struct SceneRecording){ .renderer = renderer, .frame = frame, .pipeline = pipeline }, commands);
+	renderer->recordTime += platform_getTime() - start;
+	vkCmdEndRenderPass(commands);
+
+	const VkBufferImageCopy region = {
+		.imageSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 },
+		.imageExtent = { renderer->width, renderer->height, 1 },
+	};
+	vkCmdCopyImageToBuffer(commands, frame->target, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, frame->readback, 1, &region);
+	const VkBufferMemoryBarrier toHost = {
+		.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+		.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+		.dstAccessMask = VK_ACCESS_HOST_READ_BIT,
+		.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+		.buffer = frame->readback,
+		.size = VK_WHOLE_SIZE,
+	};
+	vkCmdPipelineBarrier(commands, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, NULL, 1, &toHost, 0, NULL);
+	return vkEndCommandBuffer(commands) == VK_SUCCESS && recorded;
+}
+
+static bool presentFrame(_Inout_ struct Renderer* renderer, _Inout_ struct Frame* frame, _In_ NkContext* ctx, _In_opt_ Capture* capture, _In_ GLuint backbuffer)
+//
+// Waits for the frame, then hands its pixels to GL. Rows arrive top first, the blit turns them around.
+//
+{
+	vkWaitForFences(renderer->device->device, 1, &frame->fence, VK_TRUE, UINT64_MAX);
+	frame->isPending = false;
+	vmaInvalidateAllocation(renderer->device->allocator, frame->readbackMemory, 0, VK_WHOLE_SIZE);
+
+	const GLint w = (GLint)renderer->width;
+	const GLint h = (GLint)renderer->height;
+	glTextureSubImage2D(renderer->texture, 0, 0, 0, w, h, GL_RGBA, GL_UNSIGNED_BYTE, frame->pixels);
+	const GLuint target = capture ? capture_framebuffer(capture) : backbuffer;
+	glBlitNamedFramebuffer(renderer->readFramebuffer, target, 0, 0, w, h, 0, h, w, 0, GL_COLOR_BUFFER_BIT, GL_NEAREST);
+
+	if (capture)
+	{
+		capture_endFrame(capture);
+		return true;
+	}
+	return platform_swapBuffers(ctx);
+}
+
+static bool createRenderer(_Out_ struct Renderer* renderer, _In_ uint32_t width, _In_ uint32_t height, _In_z_ const char* cacheDirectory,
+	_In_ uint32_t drawCount, _In_ Scheduler* scheduler)
+{
+	*renderer = (struct Renderer){ .width = width, .height = height, .drawCount = drawCount, .scheduler = scheduler };
+
+	glCreateTextures(GL_TEXTURE_2D, 1, &renderer->texture);
+	NAME_OBJECT(GL_TEXTURE, renderer->texture, "Vulkan Frame");
+	glTextureStorage2D(renderer->texture, 1, GL_RGBA8, width, height);
+	glCreateFramebuffers(1, &renderer->readFramebuffer);
+	glNamedFramebufferTexture(renderer->readFramebuffer, GL_COLOR_ATTACHMENT0, renderer->texture, 0);
+	glNamedFramebufferReadBuffer(renderer->readFramebuffer, GL_COLOR_ATTACHMENT0);
+
+	renderer->device = vulkandevice_create();
+	if (renderer->device == NULL)
+		return false;
+	const VulkanDevice* device = renderer->device;
+
+	renderer->renderPass = makeRenderPass(device);
+	const VkPipelineLayoutCreateInfo layoutInfo = { .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO };
+	vkCreatePipelineLayout(device->device, &layoutInfo, NULL, &renderer->layout);
+	if (renderer->renderPass == VK_NULL_HANDLE || renderer->layout == VK_NULL_HANDLE)
+		return false;
+
+	// Compiles on its own threads while the rest is set up.
+	renderer->pipelines = vulkanpipelines_create(device, cacheDirectory, 0);
+	if (renderer->pipelines == NULL || !addScenePipelines(renderer))
+		return false;
+
+	for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+		if (!createFrame(renderer, &renderer->frames[i]))
+			return false;
+
+	renderer->recorder = vulkanrecorder_create(device, scheduler, FRAMES_IN_FLIGHT);
+	return renderer->recorder != NULL;
+}
+
+static void destroyRenderer(_Inout_ struct Renderer* renderer)
+{
+	const VulkanDevice* device = renderer->device;
+	if (device)
+	{
+		vkDeviceWaitIdle(device->device);
+
+		vulkanrecorder_destroy(renderer->recorder);
+		for (uint32_t i = 0; i < FRAMES_IN_FLIGHT; i++)
+			destroyFrame(renderer, &renderer->frames[i]);
+
+		vulkanpipelines_destroy(renderer->pipelines);
+		vkDestroyPipelineLayout(device->device, renderer->layout, NULL);
+		vkDestroyRenderPass(device->device, renderer->renderPass, NULL);
+		vulkandevice_destroy(renderer->device);
+	}
+
+	glDeleteFramebuffers(1, &renderer->readFramebuffer);
+	glDeleteTextures(1, &renderer->texture);
+}
+
+
+int vulkanbackend_run(_In_ NkContext* ctx, _In_ const struct VulkanOptions* options)
+{
+	uint32_t width = 0;
+	uint32_t height = 0;
+	platform_getDimensions(ctx, &width, &height);
+	assert(width != 0 && height != 0);
+
+	struct Renderer renderer;
+	const uint32_t drawCount = options->drawCount ? options->drawCount : SCENE_INSTANCES;
+	const uint64_t createStart = platform_getTime();
+	bool running = createRenderer(&renderer, width, height, options->cacheDirectory, drawCount, options->scheduler);
+
+	Capture* capture = NULL;
+	if (running && options->capturePattern)
+	{
+		capture = capture_create(width, height, options->capturePattern, 0);
+		assert(capture != NULL);
+		running = capture != NULL;
+	}
+
+	// Captures see the real scene from the first frame, a window shows whatever is ready.
+	if (running && capture)
+	{
+		running = vulkanpipelines_finish(renderer.pipelines);
+		char report[128];
+		snprintf(report, sizeof report, "Pipelines ready %.3f ms after startup, %s\n", (double)(platform_getTime() - createStart) * 1e-6,
+			vulkanpipelines_usesLibraries(renderer.pipelines) ? "linked from pipeline libraries" : "compiled whole");
+		OutputDebugStringA(report);
+	}
+
+	// Whatever is bound here is what the frame presents, surfaceless contexts bring their own framebuffer.
+	GLint backbuffer = 0;
+	glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &backbuffer);
+
+	if (!capture)
+		platform_show(ctx);
+
+	int result = running ? 0 : -1;
+	uint32_t frame = 0;
+	for (; running; frame++)
+	{
+		running = platform_pollMessages(ctx, &result);
+		if (!running) break;
+		scheduler_runPinned(options->scheduler, TASK_CREATOR_THREAD);
+
+		// The slot's previous frame has had a whole frame to finish, it is presented now.
+		const uint32_t slot = frame % FRAMES_IN_FLIGHT;
+		struct Frame* current = &renderer.frames[slot];
+		if (current->isPending && !presentFrame(&renderer, current, ctx, capture, (GLuint)backbuffer))
+		{
+			result = -1;
+			break;
+		}
+
+		writeScene(options->scheduler, current->mapped, frame, drawCount);
+		vmaFlushAllocation(renderer.device->allocator, current->geometryMemory, 0, VK_WHOLE_SIZE);
+		if (!recordFrame(&renderer, slot))
+		{
+			result = -1;
+			break;
+		}
+
+		vkResetFences(renderer.device->device, 1, &current->fence);
+		const VkSubmitInfo submit = {
+			.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+			.commandBufferCount = 1,
+			.pCommandBuffers = &current->commands,
+		};
+		if (vkQueueSubmit(renderer.device->queue, 1, &submit, current->fence) != VK_SUCCESS)
+		{
+			result = -1;
+			break;
+		}
+		current->isPending = true;
+
+		nk_clear(ctx);
+
+		if (options->frameCount != 0 && frame + 1 >= options->frameCount)
+			running = false;
+	}
+
+	// The frames still in flight, oldest first, so captures end up complete. Without one there is nothing left to present to.
+	for (uint32_t i = 0; capture && i < FRAMES_IN_FLIGHT; i++)
+	{
+		struct Frame* pending = &renderer.frames[(frame + i) % FRAMES_IN_FLIGHT];
+		if (pending->isPending && !presentFrame(&renderer, pending, ctx, capture, (GLuint)backbuffer) && result == 0)
+			result = -1;
+	}
+
+	if (capture && !capture_destroy(capture) && result == 0)
+		result = -1;
+
+	if (frame != 0 && renderer.recorder)
+	{
+		char report[128];
+		snprintf(report, sizeof report, "Recorded %u draws on %u threads in %.3f ms per frame\n",
+			drawCount, scheduler_threadCount(options->scheduler), (double)renderer.recordTime / frame * 1e-6);
+		OutputDebugStringA(report);
+	}
+	destroyRenderer(&renderer);
+	return result;
+}
@@ -0,0 +1,35 @@
+/**
+
+    @file      vulkanbackend.h
+    @brief     Frame loop of the Vulkan backend
+    @details   Renders the same animated scene as the GL path into offscreen
+               images, one per frame in flight. The scene is written and its
+               draws are recorded by tasks on every core, the main thread
+               only stitches the jobs' secondary buffers into the primary one.
+               Finished frames are copied back and handed to the platform's GL
+               context, which presents or captures them, so the backend runs
+               headless and windowed alike without needing a surface of its
+               own.
+               Pipelines are precompiled at startup by vulkanpipelines, the
+               scene draws flat shaded until its real pipeline is ready.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_nuklear.h"
+#include "scheduler.h"
+
+
+struct VulkanOptions
+{
+	_In_opt_z_ const char* capturePattern;	// write every frame to disk instead of presenting it, see capture_create
+	_In_z_ const char* cacheDirectory;		// pipeline cache files go in here
+	uint32_t frameCount;					// 0 runs until the platform asks to quit
+	uint32_t drawCount;						// draws per frame, 0 draws the same scene as the GL path
+	_In_ Scheduler* scheduler;				// created on the calling thread, writes and records the scene
+};
+
+//runs the frame loop on the calling thread, whose GL context presents. Returns the exit code for main.
+int vulkanbackend_run(_In_ NkContext* ctx, _In_ const struct VulkanOptions* options);
@@ -0,0 +1,367 @@
+/**
+
+    @file      vulkandevice.c
+    @brief     Vulkan instance, device and memory allocator
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "vulkandevice.h"
+#include "platform/MappedFile.h"
+
+#include <string.h>
+
+
+#define VALIDATION_LAYER "VK_LAYER_KHRONOS_validation"
+
+
+#ifdef _DEBUG
+static VKAPI_ATTR VkBool32 VKAPI_CALL debugMessenger(
+	_In_ VkDebugUtilsMessageSeverityFlagBitsEXT severity,
+	_In_ VkDebugUtilsMessageTypeFlagsEXT type,
+	_In_ const VkDebugUtilsMessengerCallbackDataEXT* data,
+	_In_opt_ void* user)
+{
+	OutputDebugStringA(data->pMessage);
+	OutputDebugString(TEXT("\n"));
+	return VK_FALSE;
+}
+
+static bool hasLayer(_In_z_ const char* name)
+{
+	uint32_t count = 0;
+	vkEnumerateInstanceLayerProperties(&count, NULL);
+	VkLayerProperties* layers = malloc(count * sizeof * layers + 1);
+	if (layers == NULL)
+		return false;
+	vkEnumerateInstanceLayerProperties(&count, layers);
+
+	bool found = false;
+	for (uint32_t i = 0; i < count && !found; i++)
+		found = strcmp(layers[i].layerName, name) == 0;
+	free(layers);
+	return found;
+}
+
+static bool hasInstanceExtension(_In_z_ const char* name)
+{
+	uint32_t count = 0;
+	vkEnumerateInstanceExtensionProperties(NULL, &count, NULL);
+	VkExtensionProperties* extensions = malloc(count * sizeof * extensions + 1);
+	if (extensions == NULL)
+		return false;
+	vkEnumerateInstanceExtensionProperties(NULL, &count, extensions);
+
+	bool found = false;
+	for (uint32_t i = 0; i < count && !found; i++)
+		found = strcmp(extensions[i].extensionName, name) == 0;
+	free(extensions);
+	return found;
+}
+#endif // _DEBUG
+
+static VkInstance createInstance(void)
+{
+	const char* layers[1];
+	const char* extensions[1];
+	uint32_t layerCount = 0;
+	uint32_t extensionCount = 0;
+#ifdef _DEBUG
+	if (hasLayer(VALIDATION_LAYER))
+		layers[layerCount++] = VALIDATION_LAYER;
+	if (hasInstanceExtension(VK_EXT_DEBUG_UTILS_EXTENSION_NAME))
+		extensions[extensionCount++] = VK_EXT_DEBUG_UTILS_EXTENSION_NAME;
+#endif // _DEBUG
+
+	const VkApplicationInfo application = {
+		.sType = VK_STRUCTURE_TYPE_APPLICATION_INFO,
+		.pApplicationName = "Crox",
+		.pEngineName = "Crox",
+		.apiVersion = VULKAN_API_VERSION,
+	};
+	const VkInstanceCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO,
+		.pApplicationInfo = &application,
+		.enabledLayerCount = layerCount,
+		.ppEnabledLayerNames = layers,
+		.enabledExtensionCount = extensionCount,
+		.ppEnabledExtensionNames = extensions,
+	};
+
+	VkInstance instance = VK_NULL_HANDLE;
+	if (vkCreateInstance(&info, NULL, &instance) != VK_SUCCESS)
+		return VK_NULL_HANDLE;
+	volkLoadInstance(instance);
+	return instance;
+}
+
+static bool hasDeviceExtension(_In_ VkPhysicalDevice physical, _In_z_ const char* name)
+{
+	uint32_t count = 0;
+	vkEnumerateDeviceExtensionProperties(physical, NULL, &count, NULL);
+	VkExtensionProperties* extensions = malloc(count * sizeof * extensions + 1);
+	if (extensions == NULL)
+		return false;
+	vkEnumerateDeviceExtensionProperties(physical, NULL, &count, extensions);
+
+	bool found = false;
+	for (uint32_t i = 0; i < count && !found; i++)
+		found = strcmp(extensions[i].extensionName, name) == 0;
+	free(extensions);
+	return found;
+}
+
+static void checkPipelineLibrary(_Inout_ VulkanDevice* device)
+{
+	if (!hasDeviceExtension(device->physicalDevice, VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME) ||
+		!hasDeviceExtension(device->physicalDevice, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME))
+		return;
+
+	VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT features = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+	};
+	VkPhysicalDeviceFeatures2 features2 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &features };
+	vkGetPhysicalDeviceFeatures2(device->physicalDevice, &features2);
+
+	VkPhysicalDeviceGraphicsPipelineLibraryPropertiesEXT properties = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_PROPERTIES_EXT,
+	};
+	VkPhysicalDeviceProperties2 properties2 = { .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &properties };
+	vkGetPhysicalDeviceProperties2(device->physicalDevice, &properties2);
+
+	device->hasPipelineLibrary = features.graphicsPipelineLibrary;
+	device->hasFastLinking = device->hasPipelineLibrary && properties.graphicsPipelineLibraryFastLinking;
+}
+
+static uint32_t rateDevice(_In_ VkPhysicalDevice physical, _Out_ uint32_t* queueFamily)
+//
+// 0 when unusable, otherwise higher is better. Anything at all beats having no device, CPU devices included.
+//
+{
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(physical, &properties);
+	if (properties.apiVersion < VULKAN_API_VERSION)
+		return 0;
+
+	uint32_t count = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical, &count, NULL);
+	VkQueueFamilyProperties* families = malloc(count * sizeof * families + 1);
+	if (families == NULL)
+		return 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(physical, &count, families);
+
+	// Graphics families support transfers implicitly, compute is wanted for later.
+	const VkQueueFlags required = VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+	bool found = false;
+	for (uint32_t i = 0; i < count && !found; i++)
+	{
+		if ((families[i].queueFlags & required) == required && families[i].queueCount > 0)
+		{
+			*queueFamily = i;
+			found = true;
+		}
+	}
+	free(families);
+	if (!found)
+		return 0;
+
+	switch (properties.deviceType)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU:		return 4;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU:	return 3;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU:		return 2;
+	default:										return 1;
+	}
+}
+
+static bool pickDevice(_Inout_ VulkanDevice* device)
+{
+	uint32_t count = 0;
+	vkEnumeratePhysicalDevices(device->instance, &count, NULL);
+	VkPhysicalDevice* physicals = malloc(count * sizeof * physicals + 1);
+	if (physicals == NULL)
+		return false;
+	vkEnumeratePhysicalDevices(device->instance, &count, physicals);
+
+	uint32_t bestScore = 0;
+	for (uint32_t i = 0; i < count; i++)
+	{
+		uint32_t family = 0;
+		uint32_t score = rateDevice(physicals[i], &family);
+		if (score > bestScore)
+		{
+			bestScore = score;
+			device->physicalDevice = physicals[i];
+			device->queueFamily = family;
+		}
+	}
+	free(physicals);
+	if (bestScore == 0)
+		return false;
+
+	vkGetPhysicalDeviceProperties(device->physicalDevice, &device->properties);
+	return true;
+}
+
+
+VulkanDevice* vulkandevice_create(void)
+{
+	if (volkInitialize() != VK_SUCCESS)
+	{
+		OutputDebugString(TEXT("No Vulkan loader\n"));
+		return NULL;
+	}
+
+	VulkanDevice* device = calloc(1, sizeof * device);
+	if (device == NULL)
+		return NULL;
+
+	device->instance = createInstance();
+	if (device->instance == VK_NULL_HANDLE)
+	{
+		free(device);
+		return NULL;
+	}
+
+#ifdef _DEBUG
+	if (vkCreateDebugUtilsMessengerEXT)
+	{
+		const VkDebugUtilsMessengerCreateInfoEXT info = {
+			.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT,
+			.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT,
+			.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT,
+			.pfnUserCallback = debugMessenger,
+		};
+		vkCreateDebugUtilsMessengerEXT(device->instance, &info, NULL, &device->messenger);
+	}
+#endif // _DEBUG
+
+	if (!pickDevice(device))
+	{
+		OutputDebugString(TEXT("No Vulkan device with a graphics queue\n"));
+		vulkandevice_destroy(device);
+		return NULL;
+	}
+
+	checkPipelineLibrary(device);
+	const char* extensions[] = { VK_KHR_PIPELINE_LIBRARY_EXTENSION_NAME, VK_EXT_GRAPHICS_PIPELINE_LIBRARY_EXTENSION_NAME };
+	const VkPhysicalDeviceGraphicsPipelineLibraryFeaturesEXT pipelineLibrary = {
+		.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_GRAPHICS_PIPELINE_LIBRARY_FEATURES_EXT,
+		.graphicsPipelineLibrary = VK_TRUE,
+	};
+
+	const float priority = 1.0f;
+	const VkDeviceQueueCreateInfo queue = {
+		.sType = VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO,
+		.queueFamilyIndex = device->queueFamily,
+		.queueCount = 1,
+		.pQueuePriorities = &priority,
+	};
+	const VkDeviceCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO,
+		.pNext = device->hasPipelineLibrary ? &pipelineLibrary : NULL,
+		.queueCreateInfoCount = 1,
+		.pQueueCreateInfos = &queue,
+		.enabledExtensionCount = device->hasPipelineLibrary ? sizeof extensions / sizeof * extensions : 0,
+		.ppEnabledExtensionNames = extensions,
+	};
+	if (vkCreateDevice(device->physicalDevice, &info, NULL, &device->device) != VK_SUCCESS)
+	{
+		vulkandevice_destroy(device);
+		return NULL;
+	}
+	// Calls go straight to the driver instead of through the loader's dispatch.
+	volkLoadDevice(device->device);
+	vkGetDeviceQueue(device->device, device->queueFamily, 0, &device->queue);
+
+	// VMA finds the rest of the entry points itself.
+	const VmaVulkanFunctions functions = {
+		.vkGetInstanceProcAddr = vkGetInstanceProcAddr,
+		.vkGetDeviceProcAddr = vkGetDeviceProcAddr,
+	};
+	const VmaAllocatorCreateInfo allocatorInfo = {
+		.physicalDevice = device->physicalDevice,
+		.device = device->device,
+		.instance = device->instance,
+		.vulkanApiVersion = VULKAN_API_VERSION,
+		.pVulkanFunctions = &functions,
+	};
+	if (vmaCreateAllocator(&allocatorInfo, &device->allocator) != VK_SUCCESS)
+	{
+		vulkandevice_destroy(device);
+		return NULL;
+	}
+
+	OutputDebugStringA(device->properties.deviceName);
+	OutputDebugString(TEXT("\n"));
+	return device;
+}
+
+void vulkandevice_destroy(_In_opt_ VulkanDevice* device)
+{
+	if (device == NULL)
+		return;
+
+	if (device->allocator)
+		vmaDestroyAllocator(device->allocator);
+	if (device->device)
+		vkDestroyDevice(device->device, NULL);
+	if (device->messenger)
+		vkDestroyDebugUtilsMessengerEXT(device->instance, device->messenger, NULL);
+	vkDestroyInstance(device->instance, NULL);
+	free(device);
+}
+
+VkPipelineCache vulkandevice_loadPipelineCache(_In_ const VulkanDevice* device, _In_z_ const char* path)
+{
+	// Drivers are supposed to reject foreign data, not all of them do, so the header is checked here as well.
+	MappedFile file;
+	bool isValid = false;
+	if (mappedfile_open(&file, path))
+	{
+		const VkPipelineCacheHeaderVersionOne* header = file.data;
+		isValid = file.size >= sizeof * header &&
+			header->headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+			header->vendorID == device->properties.vendorID &&
+			header->deviceID == device->properties.deviceID &&
+			memcmp(header->pipelineCacheUUID, device->properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+		if (!isValid)
+			mappedfile_close(&file);
+	}
+
+	const VkPipelineCacheCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+		.initialDataSize = isValid ? file.size : 0,
+		.pInitialData = isValid ? file.data : NULL,
+	};
+	VkPipelineCache cache = VK_NULL_HANDLE;
+	vkCreatePipelineCache(device->device, &info, NULL, &cache);
+	if (isValid)
+		mappedfile_close(&file);
+	return cache;
+}
+
+bool vulkandevice_savePipelineCache(_In_ const VulkanDevice* device, _In_ VkPipelineCache cache, _In_z_ const char* path)
+{
+	if (cache == VK_NULL_HANDLE)
+		return false;
+
+	// Pipelines created on other threads may grow the cache between sizing and copying, VK_INCOMPLETE asks again.
+	void* data = NULL;
+	VkResult result = VK_INCOMPLETE;
+	size_t size = 0;
+	while (result == VK_INCOMPLETE)
+	{
+		free(data);
+		data = NULL;
+		if (vkGetPipelineCacheData(device->device, cache, &size, NULL) != VK_SUCCESS || size == 0 || (data = malloc(size)) == NULL)
+			break;
+		result = vkGetPipelineCacheData(device->device, cache, &size, data);
+	}
+
+	const bool success = result == VK_SUCCESS && mappedfile_replace(path, NULL, 0, data, size);
+	free(data);
+	return success;
+}
@@ -0,0 +1,49 @@
+/**
+
+    @file      vulkandevice.h
+    @brief     Vulkan instance, device and memory allocator
+    @details   Entry points are loaded through volk, nothing links against the
+               Vulkan loader. Any device with a graphics queue is accepted:
+               discrete GPUs are preferred and CPU implementations like Mesa's
+               lavapipe come last, so the Vulkan backend still runs on machines
+               without a GPU. Debug builds enable the validation layer when it
+               is installed and route its messages to the debug output.
+               VK_EXT_graphics_pipeline_library is enabled where the driver
+               has it, see vulkanpipelines.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "framework_vulkan.h"
+
+
+#define VULKAN_API_VERSION VK_API_VERSION_1_1
+
+// Read only after creation.
+typedef struct VulkanDevice
+{
+	VkInstance instance;
+	VkDebugUtilsMessengerEXT messenger;
+	VkPhysicalDevice physicalDevice;
+	VkPhysicalDeviceProperties properties;
+	VkDevice device;
+	uint32_t queueFamily;
+	VkQueue queue;			// graphics, compute and transfer
+	VmaAllocator allocator;
+	bool hasPipelineLibrary;	// VK_EXT_graphics_pipeline_library is enabled
+	bool hasFastLinking;		// linking its libraries without optimization is cheap enough to do on demand
+} VulkanDevice;
+
+//NULL if there is no loader or no usable device.
+VulkanDevice* vulkandevice_create(void);
+
+//the device must be idle.
+void vulkandevice_destroy(_In_opt_ VulkanDevice* device);
+
+//creates a pipeline cache seeded from path if the file was written for this device. A missing or foreign file gives an empty cache.
+VkPipelineCache vulkandevice_loadPipelineCache(_In_ const VulkanDevice* device, _In_z_ const char* path);
+
+//writes the cache's contents to path, replacing the file in one step.
+bool vulkandevice_savePipelineCache(_In_ const VulkanDevice* device, _In_ VkPipelineCache cache, _In_z_ const char* path);
@@ -0,0 +1,773 @@
+/**
+
+    @file      vulkanpipelines.c
+    @brief     Pipeline cache on disk and pipeline precompilation at startup
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "vulkanpipelines.h"
+#include "platform/Threads.h"
+
+#include <hashmap.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <direct.h>
+#define makeDirectory(path) _mkdir(path)
+#else
+#include <sys/stat.h>
+#define makeDirectory(path) mkdir((path), 0755)
+#endif // _WIN32
+
+
+#define CACHE_FILE_PATTERN	"%s/vulkan_%08x_%08x_%08x_%s.bin"	// vendor, device, driver version, cache UUID
+#define PART_SEED			0x70617274u
+#define ALIGN8(size)		(((size) + 7) & ~(size_t)7)
+
+enum PartKind
+{
+	PART_VERTEX_INPUT,
+	PART_PRE_RASTERIZATION,
+	PART_FRAGMENT_SHADER,
+	PART_FRAGMENT_OUTPUT,
+	PART_COUNT,
+};
+
+enum TaskKind
+{
+	TASK_COMPILE,		// the whole pipeline at once, without libraries
+	TASK_LINK,			// from the parts, optimized unless fast linking is available
+	TASK_OPTIMIZE,		// from the parts again, replacing the fast link
+};
+
+struct PipelineEntry
+{
+	struct VulkanPipelineDesc desc;		// points into storage
+	void* storage;
+	VkSpecializationInfo specializations[VULKANPIPELINES_MAX_STAGES];
+	uint32_t parts[PART_COUNT];
+	VkPipeline linked;
+	VkPipeline optimized;
+	enum VulkanPipelineState state;
+};
+
+// One graphics pipeline library, shared by every permutation with the same state for its part.
+struct PipelinePart
+{
+	uint64_t key;
+	enum PartKind kind;
+	const struct PipelineEntry* source;	// the first permutation using the part, it is built from its desc
+	VkPipeline library;
+	enum VulkanPipelineState state;
+	bool isBuilding;
+};
+
+struct PipelineTask
+{
+	struct PipelineEntry* entry;
+	enum TaskKind kind;
+};
+
+// The fixed function state of a permutation, every library takes the bits of it its part needs.
+struct PipelineState
+{
+	VkPipelineShaderStageCreateInfo stages[VULKANPIPELINES_MAX_STAGES];
+	uint32_t stageCount;
+	VkPipelineInputAssemblyStateCreateInfo inputAssembly;
+	VkPipelineViewportStateCreateInfo viewport;
+	VkPipelineRasterizationStateCreateInfo rasterization;
+	VkPipelineMultisampleStateCreateInfo multisample;
+	VkPipelineDepthStencilStateCreateInfo depthStencil;
+	VkPipelineColorBlendAttachmentState blendAttachment;
+	VkPipelineColorBlendStateCreateInfo blend;
+	VkPipelineDynamicStateCreateInfo dynamic;
+};
+
+struct VulkanPipelines
+{
+	const VulkanDevice* device;
+	VkPipelineCache cache;				// internally synchronized, shared by all workers
+	char* cachePath;
+	bool usesLibraries;
+	bool fastLinking;
+
+	// Entries and parts never move once added, only the arrays of them do. Guarded by the mutex.
+	struct PipelineEntry** entries;
+	uint32_t entryCapacity;
+	uint32_t entryCount;
+	struct PipelinePart** parts;
+	uint32_t partCapacity;
+	uint32_t partCount;
+
+	Thread* workers;
+	uint32_t workerCount;
+	Mutex mutex;
+	CondVar work;
+	CondVar changed;					// an entry or a part finished
+	struct PipelineTask* tasks;			// [taskHead, taskCount) are waiting, in order
+	uint32_t taskCapacity;
+	uint32_t taskHead;
+	uint32_t taskCount;
+	bool quitting;
+};
+
+static const VkDynamicState dynamicStates[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+static const VkGraphicsPipelineLibraryFlagsEXT partFlags[PART_COUNT] = {
+	[PART_VERTEX_INPUT] = VK_GRAPHICS_PIPELINE_LIBRARY_VERTEX_INPUT_INTERFACE_BIT_EXT,
+	[PART_PRE_RASTERIZATION] = VK_GRAPHICS_PIPELINE_LIBRARY_PRE_RASTERIZATION_SHADERS_BIT_EXT,
+	[PART_FRAGMENT_SHADER] = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_SHADER_BIT_EXT,
+	[PART_FRAGMENT_OUTPUT] = VK_GRAPHICS_PIPELINE_LIBRARY_FRAGMENT_OUTPUT_INTERFACE_BIT_EXT,
+};
+
+
+static bool grow(_Inout_ void** array, _Inout_ uint32_t* capacity, _In_ uint32_t count, _In_ size_t elementSize)
+{
+	if (count < *capacity)
+		return true;
+	uint32_t newCapacity = *capacity ? *capacity * 2 : 16;
+	while (newCapacity <= count)
+		newCapacity *= 2;
+	void* newArray = realloc(*array, newCapacity * elementSize);
+	if (newArray == NULL)
+		return false;
+	*array = newArray;
+	*capacity = newCapacity;
+	return true;
+}
+
+static const char* entryPoint(_In_ const struct SpirvStage* stage)
+{
+	return stage->entryPoint ? stage->entryPoint : "main";
+}
+
+static void* take(_Inout_ uint8_t** cursor, _In_reads_bytes_(size) const void* source, _In_ size_t size)
+{
+	void* copy = *cursor;
+	if (size)
+		memcpy(copy, source, size);
+	*cursor += ALIGN8(size);
+	return copy;
+}
+
+static bool copyDesc(_Inout_ struct PipelineEntry* entry, _In_ const struct VulkanPipelineDesc* desc)
+//
+// Everything desc points to goes into one block, the workers read it long after the caller's copy is gone.
+//
+{
+	const VkPipelineVertexInputStateCreateInfo* input = desc->vertexInput;
+	const size_t bindingSize = input->vertexBindingDescriptionCount * sizeof * input->pVertexBindingDescriptions;
+	const size_t attributeSize = input->vertexAttributeDescriptionCount * sizeof * input->pVertexAttributeDescriptions;
+	size_t size = ALIGN8(desc->stageCount * sizeof * desc->stages) + ALIGN8(sizeof * input) + ALIGN8(bindingSize) + ALIGN8(attributeSize);
+	for (uint32_t i = 0; i < desc->stageCount; i++)
+	{
+		const struct SpirvStage* stage = &desc->stages[i];
+		size += ALIGN8(strlen(stage->path) + 1) + ALIGN8(strlen(entryPoint(stage)) + 1);
+		size += ALIGN8(stage->constantCount * sizeof * stage->constants) + ALIGN8(stage->constantCount * sizeof(VkSpecializationMapEntry));
+	}
+
+	uint8_t* cursor = entry->storage = malloc(size + 1);
+	if (cursor == NULL)
+		return false;
+
+	entry->desc = *desc;
+	struct SpirvStage* stages = take(&cursor, desc->stages, desc->stageCount * sizeof * desc->stages);
+	VkPipelineVertexInputStateCreateInfo* vertexInput = take(&cursor, input, sizeof * input);
+	vertexInput->pNext = NULL;
+	vertexInput->pVertexBindingDescriptions = take(&cursor, input->pVertexBindingDescriptions, bindingSize);
+	vertexInput->pVertexAttributeDescriptions = take(&cursor, input->pVertexAttributeDescriptions, attributeSize);
+	entry->desc.stages = stages;
+	entry->desc.vertexInput = vertexInput;
+
+	for (uint32_t i = 0; i < desc->stageCount; i++)
+	{
+		const struct SpirvStage* stage = &desc->stages[i];
+		stages[i].path = take(&cursor, stage->path, strlen(stage->path) + 1);
+		stages[i].entryPoint = take(&cursor, entryPoint(stage), strlen(entryPoint(stage)) + 1);
+		stages[i].constants = take(&cursor, stage->constants, stage->constantCount * sizeof * stage->constants);
+
+		// Constants are read straight out of the copied SpecConstant array.
+		VkSpecializationMapEntry* mapEntries = (VkSpecializationMapEntry*)cursor;
+		cursor += ALIGN8(stage->constantCount * sizeof * mapEntries);
+		for (uint32_t c = 0; c < stage->constantCount; c++)
+		{
+			mapEntries[c] = (VkSpecializationMapEntry){
+				.constantID = stage->constants[c].id,
+				.offset = (uint32_t)(c * sizeof(struct SpecConstant) + offsetof(struct SpecConstant, value)),
+				.size = sizeof(uint32_t),
+			};
+		}
+		entry->specializations[i] = (VkSpecializationInfo){
+			.mapEntryCount = stage->constantCount,
+			.pMapEntries = mapEntries,
+			.dataSize = stage->constantCount * sizeof(struct SpecConstant),
+			.pData = stages[i].constants,
+		};
+	}
+	return true;
+}
+
+static uint64_t hashBytes(_In_reads_bytes_(size) const void* data, _In_ size_t size, _In_ uint64_t seed)
+{
+	return hashmap_sip(data, size, seed, PART_SEED);
+}
+
+static uint64_t hashStages(_In_ const struct VulkanPipelineDesc* desc, _In_ VkShaderStageFlags mask, _In_ uint64_t seed)
+{
+	for (uint32_t i = 0; i < desc->stageCount; i++)
+	{
+		const struct SpirvStage* stage = &desc->stages[i];
+		if ((stage->type & mask) == 0)
+			continue;
+		seed = hashBytes(&stage->type, sizeof stage->type, seed);
+		seed = hashBytes(stage->path, strlen(stage->path) + 1, seed);
+		seed = hashBytes(stage->entryPoint, strlen(stage->entryPoint) + 1, seed);
+		seed = hashBytes(stage->constants, stage->constantCount * sizeof * stage->constants, seed);
+	}
+	return seed;
+}
+
+static uint64_t partKey(_In_ const struct VulkanPipelineDesc* desc, _In_ enum PartKind kind)
+//
+// Only what the part's library is built from goes into its key.
+//
+{
+	const VkPipelineVertexInputStateCreateInfo* input = desc->vertexInput;
+	uint64_t key = hashBytes(&kind, sizeof kind, 0);
+	switch (kind)
+	{
+	case PART_VERTEX_INPUT:
+		key = hashBytes(input->pVertexBindingDescriptions, input->vertexBindingDescriptionCount * sizeof * input->pVertexBindingDescriptions, key);
+		key = hashBytes(input->pVertexAttributeDescriptions, input->vertexAttributeDescriptionCount * sizeof * input->pVertexAttributeDescriptions, key);
+		return hashBytes(&desc->topology, sizeof desc->topology, key);
+	case PART_PRE_RASTERIZATION:
+		key = hashStages(desc, VK_SHADER_STAGE_ALL_GRAPHICS & ~VK_SHADER_STAGE_FRAGMENT_BIT, key);
+		key = hashBytes(&desc->cullMode, sizeof desc->cullMode, key);
+		break;
+	case PART_FRAGMENT_SHADER:
+		key = hashStages(desc, VK_SHADER_STAGE_FRAGMENT_BIT, key);
+		break;
+	case PART_FRAGMENT_OUTPUT:
+		key = hashBytes(&desc->blend, sizeof desc->blend, key);
+		break;
+	default:
+		break;
+	}
+	key = hashBytes(&desc->layout, sizeof desc->layout, key);
+	key = hashBytes(&desc->renderPass, sizeof desc->renderPass, key);
+	return hashBytes(&desc->subpass, sizeof desc->subpass, key);
+}
+
+static void describeState(_In_ const struct VulkanPipelineDesc* desc, _Out_ struct PipelineState* state)
+{
+	*state = (struct PipelineState){
+		.inputAssembly = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO,
+			.topology = desc->topology,
+		},
+		.viewport = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+			.viewportCount = 1,
+			.scissorCount = 1,
+		},
+		.rasterization = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO,
+			.polygonMode = VK_POLYGON_MODE_FILL,
+			.cullMode = desc->cullMode,
+			.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE,
+			.lineWidth = 1.0f,
+		},
+		.multisample = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO,
+			.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT,
+		},
+		.depthStencil = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_DEPTH_STENCIL_STATE_CREATE_INFO,
+		},
+		.blendAttachment = {
+			.blendEnable = desc->blend,
+			.srcColorBlendFactor = VK_BLEND_FACTOR_ONE,
+			.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+			.colorBlendOp = VK_BLEND_OP_ADD,
+			.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE,
+			.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA,
+			.alphaBlendOp = VK_BLEND_OP_ADD,
+			.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT,
+		},
+		.blend = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO,
+			.attachmentCount = 1,
+		},
+		.dynamic = {
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+			.dynamicStateCount = sizeof dynamicStates / sizeof * dynamicStates,
+			.pDynamicStates = dynamicStates,
+		},
+	};
+	state->blend.pAttachments = &state->blendAttachment;
+}
+
+static void unloadStages(_In_ const VulkanPipelines* pipelines, _Inout_ struct PipelineState* state)
+{
+	for (uint32_t i = 0; i < state->stageCount; i++)
+		vkDestroyShaderModule(pipelines->device->device, state->stages[i].module, NULL);
+	state->stageCount = 0;
+}
+
+static bool loadStages(_In_ const VulkanPipelines* pipelines, _In_ const struct PipelineEntry* entry, _In_ VkShaderStageFlags mask,
+	_Inout_ struct PipelineState* state)
+//
+// Creates the modules of the entry's stages in mask, unloadStages destroys them once the pipeline or library is made.
+//
+{
+	for (uint32_t i = 0; i < entry->desc.stageCount; i++)
+	{
+		const struct SpirvStage* stage = &entry->desc.stages[i];
+		if ((stage->type & mask) == 0)
+			continue;
+
+		MappedFile module;
+		if (!spirv_map(&module, stage->path))
+		{
+			OutputDebugStringA(stage->path);
+			OutputDebugString(TEXT(": not a SPIR-V module\n"));
+			unloadStages(pipelines, state);
+			return false;
+		}
+		const VkShaderModuleCreateInfo info = {
+			.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+			.codeSize = module.size,
+			.pCode = module.data,
+		};
+		VkShaderModule shader = VK_NULL_HANDLE;
+		const VkResult result = vkCreateShaderModule(pipelines->device->device, &info, NULL, &shader);
+		mappedfile_close(&module);
+		if (result != VK_SUCCESS)
+		{
+			unloadStages(pipelines, state);
+			return false;
+		}
+
+		state->stages[state->stageCount++] = (VkPipelineShaderStageCreateInfo){
+			.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
+			.stage = (VkShaderStageFlagBits)stage->type,
+			.module = shader,
+			.pName = stage->entryPoint,
+			.pSpecializationInfo = stage->constantCount ? &entry->specializations[i] : NULL,
+		};
+	}
+	return true;
+}
+
+static VkPipeline compile(_In_ const VulkanPipelines* pipelines, _In_ const struct PipelineEntry* entry)
+{
+	const struct VulkanPipelineDesc* desc = &entry->desc;
+	struct PipelineState state;
+	describeState(desc, &state);
+	if (!loadStages(pipelines, entry, VK_SHADER_STAGE_ALL_GRAPHICS, &state))
+		return VK_NULL_HANDLE;
+
+	const VkGraphicsPipelineCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+		.stageCount = state.stageCount,
+		.pStages = state.stages,
+		.pVertexInputState = desc->vertexInput,
+		.pInputAssemblyState = &state.inputAssembly,
+		.pViewportState = &state.viewport,
+		.pRasterizationState = &state.rasterization,
+		.pMultisampleState = &state.multisample,
+		.pDepthStencilState = &state.depthStencil,
+		.pColorBlendState = &state.blend,
+		.pDynamicState = &state.dynamic,
+		.layout = desc->layout,
+		.renderPass = desc->renderPass,
+		.subpass = desc->subpass,
+	};
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if (vkCreateGraphicsPipelines(pipelines->device->device, pipelines->cache, 1, &info, NULL, &pipeline) != VK_SUCCESS)
+		pipeline = VK_NULL_HANDLE;
+	unloadStages(pipelines, &state);
+	return pipeline;
+}
+
+static VkPipeline buildPart(_In_ const VulkanPipelines* pipelines, _In_ const struct PipelinePart* part)
+//
+// Libraries keep what an optimized link needs, the fast link alone wouldn't.
+//
+{
+	const struct PipelineEntry* entry = part->source;
+	const struct VulkanPipelineDesc* desc = &entry->desc;
+	struct PipelineState state;
+	describeState(desc, &state);
+
+	const VkGraphicsPipelineLibraryCreateInfoEXT library = {
+		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_LIBRARY_CREATE_INFO_EXT,
+		.flags = partFlags[part->kind],
+	};
+	VkGraphicsPipelineCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+		.pNext = &library,
+		.flags = VK_PIPELINE_CREATE_LIBRARY_BIT_KHR | VK_PIPELINE_CREATE_RETAIN_LINK_TIME_OPTIMIZATION_INFO_BIT_EXT,
+	};
+
+	switch (part->kind)
+	{
+	case PART_VERTEX_INPUT:
+		info.pVertexInputState = desc->vertexInput;
+		info.pInputAssemblyState = &state.inputAssembly;
+		break;
+	case PART_PRE_RASTERIZATION:
+		if (!loadStages(pipelines, entry, VK_SHADER_STAGE_ALL_GRAPHICS & ~VK_SHADER_STAGE_FRAGMENT_BIT, &state))
+			return VK_NULL_HANDLE;
+		info.pViewportState = &state.viewport;
+		info.pRasterizationState = &state.rasterization;
+		info.pDynamicState = &state.dynamic;
+		break;
+	case PART_FRAGMENT_SHADER:
+		if (!loadStages(pipelines, entry, VK_SHADER_STAGE_FRAGMENT_BIT, &state))
+			return VK_NULL_HANDLE;
+		info.pMultisampleState = &state.multisample;
+		info.pDepthStencilState = &state.depthStencil;
+		break;
+	case PART_FRAGMENT_OUTPUT:
+		info.pMultisampleState = &state.multisample;
+		info.pColorBlendState = &state.blend;
+		break;
+	default:
+		return VK_NULL_HANDLE;
+	}
+	if (part->kind != PART_VERTEX_INPUT)
+	{
+		info.layout = desc->layout;
+		info.renderPass = desc->renderPass;
+		info.subpass = desc->subpass;
+	}
+	info.stageCount = state.stageCount;
+	info.pStages = state.stages;
+
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if (vkCreateGraphicsPipelines(pipelines->device->device, pipelines->cache, 1, &info, NULL, &pipeline) != VK_SUCCESS)
+		pipeline = VK_NULL_HANDLE;
+	unloadStages(pipelines, &state);
+	return pipeline;
+}
+
+static VkPipeline acquirePart(_Inout_ VulkanPipelines* pipelines, _In_ uint32_t index)
+//
+// Builds the part on the calling worker unless another one already is, then it waits for that one.
+//
+{
+	mutex_lock(&pipelines->mutex);
+	struct PipelinePart* part = pipelines->parts[index];
+	while (part->isBuilding)
+		condvar_wait(&pipelines->changed, &pipelines->mutex);
+	if (part->state == VULKAN_PIPELINE_PENDING)
+	{
+		part->isBuilding = true;
+		mutex_unlock(&pipelines->mutex);
+		const VkPipeline library = buildPart(pipelines, part);
+		mutex_lock(&pipelines->mutex);
+		part->library = library;
+		part->state = library ? VULKAN_PIPELINE_READY : VULKAN_PIPELINE_FAILED;
+		part->isBuilding = false;
+		condvar_broadcast(&pipelines->changed);
+	}
+	const VkPipeline library = part->library;
+	mutex_unlock(&pipelines->mutex);
+	return library;
+}
+
+static VkPipeline linkParts(_Inout_ VulkanPipelines* pipelines, _In_ const struct PipelineEntry* entry, _In_ bool optimize)
+{
+	VkPipeline libraries[PART_COUNT];
+	for (uint32_t i = 0; i < PART_COUNT; i++)
+	{
+		libraries[i] = acquirePart(pipelines, entry->parts[i]);
+		if (libraries[i] == VK_NULL_HANDLE)
+			return VK_NULL_HANDLE;
+	}
+
+	const VkPipelineLibraryCreateInfoKHR linking = {
+		.sType = VK_STRUCTURE_TYPE_PIPELINE_LIBRARY_CREATE_INFO_KHR,
+		.libraryCount = PART_COUNT,
+		.pLibraries = libraries,
+	};
+	const VkGraphicsPipelineCreateInfo info = {
+		.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
+		.pNext = &linking,
+		.flags = optimize ? VK_PIPELINE_CREATE_LINK_TIME_OPTIMIZATION_BIT_EXT : 0,
+		.layout = entry->desc.layout,
+	};
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	if (vkCreateGraphicsPipelines(pipelines->device->device, pipelines->cache, 1, &info, NULL, &pipeline) != VK_SUCCESS)
+		pipeline = VK_NULL_HANDLE;
+	return pipeline;
+}
+
+static bool pushTask(_Inout_ VulkanPipelines* pipelines, _In_ struct PipelineEntry* entry, _In_ enum TaskKind kind)
+//
+// The mutex is held.
+//
+{
+	if (pipelines->taskHead == pipelines->taskCount)
+		pipelines->taskHead = pipelines->taskCount = 0;
+	if (!grow((void**)&pipelines->tasks, &pipelines->taskCapacity, pipelines->taskCount, sizeof * pipelines->tasks))
+		return false;
+	pipelines->tasks[pipelines->taskCount++] = (struct PipelineTask){ .entry = entry, .kind = kind };
+	condvar_signal(&pipelines->work);
+	return true;
+}
+
+static void runTask(_Inout_ VulkanPipelines* pipelines, _In_ struct PipelineTask task)
+{
+	struct PipelineEntry* entry = task.entry;
+	VkPipeline pipeline = VK_NULL_HANDLE;
+	switch (task.kind)
+	{
+	case TASK_COMPILE:	pipeline = compile(pipelines, entry); break;
+	case TASK_LINK:		pipeline = linkParts(pipelines, entry, !pipelines->fastLinking); break;
+	case TASK_OPTIMIZE:	pipeline = linkParts(pipelines, entry, true); break;
+	}
+
+	mutex_lock(&pipelines->mutex);
+	if (task.kind == TASK_OPTIMIZE)
+	{
+		// The fast link may still be bound by frames in flight, it stays until the end.
+		entry->optimized = pipeline;
+	}
+	else
+	{
+		entry->linked = pipeline;
+		entry->state = pipeline ? VULKAN_PIPELINE_READY : VULKAN_PIPELINE_FAILED;
+		condvar_broadcast(&pipelines->changed);
+
+		// Behind every first link still waiting, those are what rendering is held up by.
+		if (pipeline && task.kind == TASK_LINK && pipelines->fastLinking)
+			pushTask(pipelines, entry, TASK_OPTIMIZE);
+	}
+	mutex_unlock(&pipelines->mutex);
+}
+
+static int workerMain(void* arg)
+{
+	VulkanPipelines* pipelines = arg;
+	mutex_lock(&pipelines->mutex);
+	for (;;)
+	{
+		while (!pipelines->quitting && pipelines->taskHead == pipelines->taskCount)
+			condvar_wait(&pipelines->work, &pipelines->mutex);
+		if (pipelines->quitting)
+			break;
+		const struct PipelineTask task = pipelines->tasks[pipelines->taskHead++];
+		mutex_unlock(&pipelines->mutex);
+
+		runTask(pipelines, task);
+
+		mutex_lock(&pipelines->mutex);
+	}
+	mutex_unlock(&pipelines->mutex);
+	return 0;
+}
+
+static uint32_t findPart(_Inout_ VulkanPipelines* pipelines, _In_ const struct PipelineEntry* entry, _In_ enum PartKind kind)
+//
+// The mutex is held. UINT32_MAX if a new part couldn't be added.
+//
+{
+	const uint64_t key = partKey(&entry->desc, kind);
+	for (uint32_t i = 0; i < pipelines->partCount; i++)
+		if (pipelines->parts[i]->key == key)
+			return i;
+
+	if (!grow((void**)&pipelines->parts, &pipelines->partCapacity, pipelines->partCount, sizeof * pipelines->parts))
+		return UINT32_MAX;
+	struct PipelinePart* part = calloc(1, sizeof * part);
+	if (part == NULL)
+		return UINT32_MAX;
+	*part = (struct PipelinePart){ .key = key, .kind = kind, .source = entry, .state = VULKAN_PIPELINE_PENDING };
+	pipelines->parts[pipelines->partCount] = part;
+	return pipelines->partCount++;
+}
+
+static char* makeCachePath(_In_ const VulkanDevice* device, _In_z_ const char* directory)
+{
+	const VkPhysicalDeviceProperties* properties = &device->properties;
+	char uuid[2 * VK_UUID_SIZE + 1];
+	for (uint32_t i = 0; i < VK_UUID_SIZE; i++)
+		snprintf(uuid + 2 * i, 3, "%02x", properties->pipelineCacheUUID[i]);
+
+	const int length = snprintf(NULL, 0, CACHE_FILE_PATTERN, directory, properties->vendorID, properties->deviceID, properties->driverVersion, uuid);
+	char* path = length > 0 ? malloc((size_t)length + 1) : NULL;
+	if (path)
+		snprintf(path, (size_t)length + 1, CACHE_FILE_PATTERN, directory, properties->vendorID, properties->deviceID, properties->driverVersion, uuid);
+	return path;
+}
+
+
+VulkanPipelines* vulkanpipelines_create(_In_ const VulkanDevice* device, _In_z_ const char* cacheDirectory, _In_ uint32_t workers)
+{
+	if (workers == 0)
+		workers = thread_hardwareConcurrency();
+
+	VulkanPipelines* pipelines = calloc(1, sizeof * pipelines);
+	if (pipelines == NULL)
+		return NULL;
+	pipelines->device = device;
+	pipelines->usesLibraries = device->hasPipelineLibrary;
+	pipelines->fastLinking = device->hasFastLinking;
+	mutex_init(&pipelines->mutex);
+	condvar_init(&pipelines->work);
+	condvar_init(&pipelines->changed);
+
+	makeDirectory(cacheDirectory);
+	pipelines->cachePath = makeCachePath(device, cacheDirectory);
+	if (pipelines->cachePath)
+		pipelines->cache = vulkandevice_loadPipelineCache(device, pipelines->cachePath);
+
+	pipelines->workers = calloc(workers, sizeof * pipelines->workers);
+	if (pipelines->workers == NULL)
+	{
+		vulkanpipelines_destroy(pipelines);
+		return NULL;
+	}
+	while (pipelines->workerCount < workers && thread_create(&pipelines->workers[pipelines->workerCount], workerMain, pipelines))
+		pipelines->workerCount++;
+
+	// Nothing would ever compile.
+	if (pipelines->workerCount == 0)
+	{
+		vulkanpipelines_destroy(pipelines);
+		return NULL;
+	}
+	return pipelines;
+}
+
+void vulkanpipelines_destroy(_In_opt_ VulkanPipelines* pipelines)
+{
+	if (pipelines == NULL)
+		return;
+
+	// Queued optimizations are dropped, whatever a worker is compiling right now is finished first.
+	mutex_lock(&pipelines->mutex);
+	pipelines->quitting = true;
+	condvar_broadcast(&pipelines->work);
+	mutex_unlock(&pipelines->mutex);
+	for (uint32_t i = 0; i < pipelines->workerCount; i++)
+		thread_join(pipelines->workers[i]);
+
+	const VulkanDevice* device = pipelines->device;
+	if (pipelines->cache && !vulkandevice_savePipelineCache(device, pipelines->cache, pipelines->cachePath))
+		OutputDebugString(TEXT("Couldn't save the Vulkan pipeline cache\n"));
+
+	for (uint32_t i = 0; i < pipelines->entryCount; i++)
+	{
+		struct PipelineEntry* entry = pipelines->entries[i];
+		vkDestroyPipeline(device->device, entry->optimized, NULL);
+		vkDestroyPipeline(device->device, entry->linked, NULL);
+		free(entry->storage);
+		free(entry);
+	}
+	for (uint32_t i = 0; i < pipelines->partCount; i++)
+	{
+		vkDestroyPipeline(device->device, pipelines->parts[i]->library, NULL);
+		free(pipelines->parts[i]);
+	}
+	vkDestroyPipelineCache(device->device, pipelines->cache, NULL);
+
+	free(pipelines->tasks);
+	free(pipelines->parts);
+	free(pipelines->entries);
+	free(pipelines->workers);
+	free(pipelines->cachePath);
+	condvar_destroy(&pipelines->changed);
+	condvar_destroy(&pipelines->work);
+	mutex_destroy(&pipelines->mutex);
+	free(pipelines);
+}
+
+uint32_t vulkanpipelines_add(_Inout_ VulkanPipelines* pipelines, _In_ const struct VulkanPipelineDesc* desc)
+{
+	assert(desc->stageCount <= VULKANPIPELINES_MAX_STAGES);
+	if (desc->stageCount > VULKANPIPELINES_MAX_STAGES)
+		return VULKANPIPELINE_NONE;
+
+	struct PipelineEntry* entry = calloc(1, sizeof * entry);
+	if (entry == NULL)
+		return VULKANPIPELINE_NONE;
+	if (!copyDesc(entry, desc))
+	{
+		free(entry);
+		return VULKANPIPELINE_NONE;
+	}
+	entry->state = VULKAN_PIPELINE_PENDING;
+
+	mutex_lock(&pipelines->mutex);
+	if (!grow((void**)&pipelines->entries, &pipelines->entryCapacity, pipelines->entryCount, sizeof * pipelines->entries))
+	{
+		mutex_unlock(&pipelines->mutex);
+		free(entry->storage);
+		free(entry);
+		return VULKANPIPELINE_NONE;
+	}
+	// Added either way, parts may already be built from it.
+	pipelines->entries[pipelines->entryCount++] = entry;
+	const uint32_t id = pipelines->entryCount;
+
+	bool success = true;
+	for (uint32_t i = 0; success && pipelines->usesLibraries && i < PART_COUNT; i++)
+	{
+		entry->parts[i] = findPart(pipelines, entry, (enum PartKind)i);
+		success = entry->parts[i] != UINT32_MAX;
+	}
+	success = success && pushTask(pipelines, entry, pipelines->usesLibraries ? TASK_LINK : TASK_COMPILE);
+	if (!success)
+		entry->state = VULKAN_PIPELINE_FAILED;
+	mutex_unlock(&pipelines->mutex);
+	return success ? id : VULKANPIPELINE_NONE;
+}
+
+VkPipeline vulkanpipelines_pipeline(_In_ VulkanPipelines* pipelines, _In_ uint32_t id)
+{
+	if (id == VULKANPIPELINE_NONE)
+		return VK_NULL_HANDLE;
+
+	mutex_lock(&pipelines->mutex);
+	assert(id <= pipelines->entryCount);
+	const struct PipelineEntry* entry = pipelines->entries[id - 1];
+	const VkPipeline pipeline = entry->optimized ? entry->optimized : entry->linked;
+	mutex_unlock(&pipelines->mutex);
+	return pipeline;
+}
+
+enum VulkanPipelineState vulkanpipelines_state(_In_ VulkanPipelines* pipelines, _In_ uint32_t id)
+{
+	if (id == VULKANPIPELINE_NONE)
+		return VULKAN_PIPELINE_FAILED;
+
+	mutex_lock(&pipelines->mutex);
+	assert(id <= pipelines->entryCount);
+	const enum VulkanPipelineState state = pipelines->entries[id - 1]->state;
+	mutex_unlock(&pipelines->mutex);
+	return state;
+}
+
+bool vulkanpipelines_finish(_Inout_ VulkanPipelines* pipelines)
+{
+	bool success = true;
+	mutex_lock(&pipelines->mutex);
+	for (uint32_t i = 0; i < pipelines->entryCount; i++)
+	{
+		while (pipelines->entries[i]->state == VULKAN_PIPELINE_PENDING)
+			condvar_wait(&pipelines->changed, &pipelines->mutex);
+		success = success && pipelines->entries[i]->state == VULKAN_PIPELINE_READY;
+	}
+	mutex_unlock(&pipelines->mutex);
+	return success;
+}
+
+bool vulkanpipelines_usesLibraries(_In_ const VulkanPipelines* pipelines)
+{
+	return pipelines->usesLibraries;
+}
@@ -0,0 +1,75 @@
+/**
+
+    @file      vulkanpipelines.h
+    @brief     Pipeline cache on disk and pipeline precompilation at startup
+    @details   Every pipeline permutation the renderer knows of is added up
+               front and compiled by worker threads, so none is compiled on the
+               frame that first draws with it. The pipeline cache is read from
+               and written back to a file named after the device, its driver
+               version and its cache UUID, a driver update starts a new file
+               rather than feeding the old one to the new compiler.
+               With VK_EXT_graphics_pipeline_library each pipeline is cut into
+               its vertex input, pre-rasterization, fragment shader and
+               fragment output parts. The parts are compiled once and shared by
+               every permutation using them, a pipeline is first linked from
+               them without optimization, which is quick, and an optimized link
+               replaces it in the background.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "vulkandevice.h"
+#include "spirv.h"
+
+
+#define VULKANPIPELINES_MAX_STAGES 5
+#define VULKANPIPELINE_NONE 0
+
+typedef struct VulkanPipelines VulkanPipelines;
+
+enum VulkanPipelineState
+{
+	VULKAN_PIPELINE_PENDING,
+	VULKAN_PIPELINE_READY,		// usable, possibly not optimized yet
+	VULKAN_PIPELINE_FAILED,
+};
+
+// Everything a permutation is made of. Viewport and scissor are always dynamic.
+struct VulkanPipelineDesc
+{
+	uint32_t stageCount;
+	_In_reads_(stageCount) const struct SpirvStage* stages;	// type is the VkShaderStageFlagBits
+	_In_ const VkPipelineVertexInputStateCreateInfo* vertexInput;
+	VkPrimitiveTopology topology;
+	VkCullModeFlags cullMode;
+	bool blend;						// premultiplied alpha over the target
+	VkPipelineLayout layout;
+	VkRenderPass renderPass;
+	uint32_t subpass;
+};
+
+/**
+	@brief  Loads the device's pipeline cache from cacheDirectory and starts the compiling threads.
+	@param  workers - compiling threads, 0 picks one per core
+	@retval         - NULL on failure
+**/
+VulkanPipelines* vulkanpipelines_create(_In_ const VulkanDevice* device, _In_z_ const char* cacheDirectory, _In_ uint32_t workers);
+
+//joins the workers, writes the cache back and destroys every pipeline. None of them may still be in use.
+void vulkanpipelines_destroy(_In_opt_ VulkanPipelines* pipelines);
+
+//queues a permutation for compilation. desc is copied, layout and render pass must outlive the pipelines. VULKANPIPELINE_NONE on failure.
+uint32_t vulkanpipelines_add(_Inout_ VulkanPipelines* pipelines, _In_ const struct VulkanPipelineDesc* desc);
+
+//the best pipeline compiled so far, VK_NULL_HANDLE while pending or if it failed. May change between calls, bind what it returns.
+VkPipeline vulkanpipelines_pipeline(_In_ VulkanPipelines* pipelines, _In_ uint32_t id);
+
+enum VulkanPipelineState vulkanpipelines_state(_In_ VulkanPipelines* pipelines, _In_ uint32_t id);
+
+//blocks until every pipeline added is usable or failed. Returns false if any failed.
+bool vulkanpipelines_finish(_Inout_ VulkanPipelines* pipelines);
+
+//whether pipelines are linked from graphics pipeline libraries.
+bool vulkanpipelines_usesLibraries(_In_ const VulkanPipelines* pipelines);
@@ -0,0 +1,234 @@
+/**
+
+    @file      vulkanrecorder.c
+    @brief     Multi-threaded recording of secondary command buffers
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "vulkanrecorder.h"
+
+#include <string.h>
+
+
+#define JOBS_PER_THREAD 4
+
+
+// One thread's pool for one frame in flight. Buffers are kept across resets and handed out again.
+struct RecorderPool
+{
+	VkCommandPool pool;
+	VkCommandBuffer* buffers;
+	uint32_t capacity;
+	uint32_t allocated;
+	uint32_t used;
+};
+
+struct RecorderThread
+{
+	struct RecorderPool* pools;		// one per frame in flight
+	bool failed;					// a buffer couldn't be allocated during the current record
+};
+
+struct VulkanRecorder
+{
+	const VulkanDevice* device;
+	Scheduler* scheduler;
+	uint32_t framesInFlight;
+
+	struct RecorderThread* threads;	// indexed by scheduler thread
+	uint32_t threadCount;
+
+	// The current record, only written while no job runs.
+	uint32_t frame;
+	const VkCommandBufferInheritanceInfo* inheritance;
+	uint32_t count;
+	uint32_t batch;
+	VulkanRecordProc proc;
+	void* user;
+	VkCommandBuffer* results;		// one per job, in job order
+	uint32_t resultCapacity;
+};
+
+
+static bool grow(_Inout_ void** array, _Inout_ uint32_t* capacity, _In_ uint32_t count, _In_ size_t elementSize)
+{
+	if (count < *capacity)
+		return true;
+	uint32_t newCapacity = *capacity ? *capacity * 2 : 16;
+	while (newCapacity <= count)
+		newCapacity *= 2;
+	void* newArray = realloc(*array, newCapacity * elementSize);
+	if (newArray == NULL)
+		return false;
+	*array = newArray;
+	*capacity = newCapacity;
+	return true;
+}
+
+static VkCommandBuffer nextBuffer(_In_ const VulkanRecorder* recorder, _Inout_ struct RecorderPool* pool)
+{
+	if (pool->used == pool->allocated)
+	{
+		if (!grow((void**)&pool->buffers, &pool->capacity, pool->allocated, sizeof * pool->buffers))
+			return VK_NULL_HANDLE;
+
+		const VkCommandBufferAllocateInfo info = {
+			.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+			.commandPool = pool->pool,
+			.level = VK_COMMAND_BUFFER_LEVEL_SECONDARY,
+			.commandBufferCount = 1,
+		};
+		if (vkAllocateCommandBuffers(recorder->device->device, &info, &pool->buffers[pool->allocated]) != VK_SUCCESS)
+			return VK_NULL_HANDLE;
+		pool->allocated++;
+	}
+	return pool->buffers[pool->used++];
+}
+
+static void recordJobs(_In_opt_ void* user, _In_ uint32_t firstJob, _In_ uint32_t jobCount)
+{
+	VulkanRecorder* recorder = user;
+	const uint32_t index = scheduler_threadIndex(recorder->scheduler);
+	assert(index < recorder->threadCount);
+	struct RecorderThread* thread = &recorder->threads[index];
+	struct RecorderPool* pool = &thread->pools[recorder->frame];
+	const VkCommandBufferBeginInfo begin = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+		.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT | VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT,
+		.pInheritanceInfo = recorder->inheritance,
+	};
+
+	for (uint32_t job = firstJob; job < firstJob + jobCount; job++)
+	{
+		VkCommandBuffer commands = nextBuffer(recorder, pool);
+		recorder->results[job] = commands;
+		if (commands == VK_NULL_HANDLE)
+		{
+			thread->failed = true;
+			continue;
+		}
+
+		const uint32_t first = job * recorder->batch;
+		const uint32_t count = recorder->count - first < recorder->batch ? recorder->count - first : recorder->batch;
+		vkBeginCommandBuffer(commands, &begin);
+		recorder->proc(commands, first, count, recorder->user);
+		vkEndCommandBuffer(commands);
+	}
+}
+
+
+VulkanRecorder* vulkanrecorder_create(_In_ const VulkanDevice* device, _In_ Scheduler* scheduler, _In_ uint32_t framesInFlight)
+{
+	VulkanRecorder* recorder = calloc(1, sizeof * recorder);
+	if (recorder == NULL)
+		return NULL;
+	recorder->device = device;
+	recorder->scheduler = scheduler;
+	recorder->framesInFlight = framesInFlight;
+
+	const uint32_t threads = scheduler_threadCount(scheduler);
+	recorder->threads = calloc(threads, sizeof * recorder->threads);
+	if (recorder->threads == NULL)
+	{
+		vulkanrecorder_destroy(recorder);
+		return NULL;
+	}
+	recorder->threadCount = threads;
+
+	const VkCommandPoolCreateInfo poolInfo = {
+		.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO,
+		.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT,
+		.queueFamilyIndex = device->queueFamily,
+	};
+	for (uint32_t i = 0; i < threads; i++)
+	{
+		struct RecorderThread* thread = &recorder->threads[i];
+		thread->pools = calloc(framesInFlight, sizeof * thread->pools);
+		bool success = thread->pools != NULL;
+		for (uint32_t frame = 0; success && frame < framesInFlight; frame++)
+			success = vkCreateCommandPool(device->device, &poolInfo, NULL, &thread->pools[frame].pool) == VK_SUCCESS;
+		if (!success)
+		{
+			vulkanrecorder_destroy(recorder);
+			return NULL;
+		}
+	}
+	return recorder;
+}
+
+void vulkanrecorder_destroy(_In_opt_ VulkanRecorder* recorder)
+{
+	if (recorder == NULL)
+		return;
+
+	// Destroying a pool frees its buffers.
+	for (uint32_t i = 0; i < recorder->threadCount; i++)
+	{
+		struct RecorderThread* thread = &recorder->threads[i];
+		for (uint32_t frame = 0; thread->pools && frame < recorder->framesInFlight; frame++)
+		{
+			vkDestroyCommandPool(recorder->device->device, thread->pools[frame].pool, NULL);
+			free(thread->pools[frame].buffers);
+		}
+		free(thread->pools);
+	}
+
+	free(recorder->results);
+	free(recorder->threads);
+	free(recorder);
+}
+
+bool vulkanrecorder_record(_Inout_ VulkanRecorder* recorder, _In_ uint32_t frame, _In_ const VkCommandBufferInheritanceInfo* inheritance,
+	_In_ uint32_t count, _In_ uint32_t minBatch, _In_ VulkanRecordProc proc, _In_opt_ void* user, _In_ VkCommandBuffer primary)
+{
+	assert(frame < recorder->framesInFlight);
+	if (count == 0)
+		return true;
+
+	// Enough jobs to even out, never so small they cost more than they record.
+	const uint32_t maxJobs = recorder->threadCount * JOBS_PER_THREAD;
+	uint32_t batch = (count + maxJobs - 1) / maxJobs;
+	if (batch < minBatch)
+		batch = minBatch;
+	if (batch == 0)
+		batch = 1;
+	const uint32_t jobCount = (count + batch - 1) / batch;
+	if (!grow((void**)&recorder->results, &recorder->resultCapacity, jobCount, sizeof * recorder->results))
+		return false;
+
+	// No job runs between records, this thread may reset every pool.
+	for (uint32_t i = 0; i < recorder->threadCount; i++)
+	{
+		struct RecorderPool* pool = &recorder->threads[i].pools[frame];
+		vkResetCommandPool(recorder->device->device, pool->pool, 0);
+		pool->used = 0;
+		recorder->threads[i].failed = false;
+	}
+
+	recorder->frame = frame;
+	recorder->inheritance = inheritance;
+	recorder->count = count;
+	recorder->batch = batch;
+	recorder->proc = proc;
+	recorder->user = user;
+
+	// One job per task, a single one isn't worth handing to another thread.
+	TaskCounter jobs = { 0 };
+	if (jobCount > 1)
+	{
+		scheduler_parallelFor(recorder->scheduler, jobCount, 1, recordJobs, recorder, &jobs);
+		scheduler_wait(recorder->scheduler, &jobs);
+	}
+	else
+		recordJobs(recorder, 0, 1);
+
+	for (uint32_t i = 0; i < recorder->threadCount; i++)
+		if (recorder->threads[i].failed)
+			return false;
+
+	vkCmdExecuteCommands(primary, jobCount, recorder->results);
+	return true;
+}
@@ -0,0 +1,49 @@
+/**
+
+    @file      vulkanrecorder.h
+    @brief     Multi-threaded recording of secondary command buffers
+    @details   A draw list is cut into jobs of consecutive draws, a few per
+               thread so that uneven jobs still balance out, and the jobs run
+               as scheduler tasks, the calling thread helping while it waits.
+               Every scheduler thread records into buffers from its own
+               command pool, one per frame in flight, so no pool is ever
+               touched by two threads and a frame's pools are only reset once
+               it retired.
+               The jobs' buffers are executed into the primary buffer in job
+               order, the draws keep the order of the list.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+#include "vulkandevice.h"
+#include "scheduler.h"
+
+
+typedef struct VulkanRecorder VulkanRecorder;
+
+//records draws [first, first + count) of the list. Secondary buffers inherit no state, everything has to be bound again.
+typedef void (*VulkanRecordProc)(_In_ VkCommandBuffer commands, _In_ uint32_t first, _In_ uint32_t count, _In_opt_ void* user);
+
+/**
+	@brief  Creates a command pool for every scheduler thread and frame in flight.
+	@param  scheduler      - must outlive the recorder
+	@param  framesInFlight - frames whose buffers may be pending at once
+	@retval                - NULL on failure
+**/
+VulkanRecorder* vulkanrecorder_create(_In_ const VulkanDevice* device, _In_ Scheduler* scheduler, _In_ uint32_t framesInFlight);
+
+//the buffers recorded must no longer be pending.
+void vulkanrecorder_destroy(_In_opt_ VulkanRecorder* recorder);
+
+/**
+	@brief  Records count draws on all threads and executes them into primary, which must be inside a render pass begun for secondary buffers.
+	@details One record at a time and from a scheduler thread, it resets every thread's pools for the frame.
+	@param  frame       - frame in flight slot, its previous buffers must have retired
+	@param  inheritance - render pass, subpass and framebuffer of the primary
+	@param  minBatch    - draws below which a job isn't worth a buffer of its own
+	@retval             - false if buffers or memory ran out, nothing was executed then
+**/
+bool vulkanrecorder_record(_Inout_ VulkanRecorder* recorder, _In_ uint32_t frame, _In_ const VkCommandBufferInheritanceInfo* inheritance,
+	_In_ uint32_t count, _In_ uint32_t minBatch, _In_ VulkanRecordProc proc, _In_opt_ void* user, _In_ VkCommandBuffer primary);
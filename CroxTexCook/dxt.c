@@ -0,0 +1,242 @@
+/**
+
+    @file      dxt.c
+    @brief     BC1/BC3 compression of whole blocks and images over stb_dxt
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "dxt.h"
+#include "platform/Threads.h"
+
+#include <string.h>
+
+#define STB_DXT_IMPLEMENTATION
+#include <stb_dxt.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define DXT_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+// MSVC takes every intrinsic regardless of /arch, the paths are only entered once the CPU is checked.
+#define DXT_TARGET_SSE41
+#define DXT_TARGET_AVX2
+#else
+#define DXT_TARGET_SSE41	__attribute__((target("sse4.1")))
+#define DXT_TARGET_AVX2		__attribute__((target("avx2")))
+#endif // _MSC_VER
+#endif // x86
+
+
+#define DXT_BLOCK_TEXELS	64		// bytes of one 4x4 RGBA8 block
+#define DXT_BAND_ROWS		8		// block rows a worker compresses at a time
+
+#ifdef DXT_X86
+#define DXT_KERNEL_WIDTH 4
+#include "dxt_kernel.h"
+#define DXT_KERNEL_WIDTH 8
+#include "dxt_kernel.h"
+#endif // DXT_X86
+
+struct DxtImage
+{
+	enum DxtPath path;
+	uint8_t* dest;
+	const uint8_t* pixels;
+	uint32_t width;
+	uint32_t height;
+	bool alpha;
+	int mode;
+
+	Mutex mutex;
+	uint32_t nextRow;		// next band to hand out
+};
+
+struct DxtWorker
+{
+	struct DxtImage* image;
+	uint8_t* texels;		// one block row
+};
+
+
+static void compressAlpha(_Out_ uint8_t* dest, _In_ const uint8_t* texels, _In_ size_t count)
+{
+	for (size_t i = 0; i < count; i++)
+		stb__CompressAlphaBlock(dest + i * 16, (unsigned char*)texels + i * DXT_BLOCK_TEXELS + 3, 4);
+}
+
+static void gatherRow(_In_ const struct DxtImage* image, _In_ uint32_t by, _Out_ uint8_t* texels)
+//
+// Edge blocks repeat the last row and column, the texels past the image are never sampled.
+//
+{
+	const uint32_t blocksWide = (image->width + 3) / 4;
+	for (uint32_t y = 0; y < 4; y++)
+	{
+		const uint32_t sy = by * 4 + y < image->height ? by * 4 + y : image->height - 1;
+		const uint8_t* row = image->pixels + (size_t)sy * image->width * 4;
+		for (uint32_t bx = 0; bx < blocksWide; bx++)
+			for (uint32_t x = 0; x < 4; x++)
+			{
+				const uint32_t sx = bx * 4 + x < image->width ? bx * 4 + x : image->width - 1;
+				memcpy(texels + (size_t)bx * DXT_BLOCK_TEXELS + (y * 4 + x) * 4, row + (size_t)sx * 4, 4);
+			}
+	}
+}
+
+static int compressWorker(void* arg)
+{
+	struct DxtWorker* worker = arg;
+	struct DxtImage* image = worker->image;
+	const uint32_t blocksWide = (image->width + 3) / 4;
+	const uint32_t blocksHigh = (image->height + 3) / 4;
+	const size_t rowSize = (size_t)blocksWide * (image->alpha ? 16 : 8);
+
+	for (;;)
+	{
+		mutex_lock(&image->mutex);
+		const uint32_t row = image->nextRow;
+		image->nextRow += DXT_BAND_ROWS;
+		mutex_unlock(&image->mutex);
+		if (row >= blocksHigh)
+			return 0;
+
+		const uint32_t end = row + DXT_BAND_ROWS < blocksHigh ? row + DXT_BAND_ROWS : blocksHigh;
+		for (uint32_t by = row; by < end; by++)
+		{
+			gatherRow(image, by, worker->texels);
+			dxt_compressBlocks(image->path, image->dest + by * rowSize, worker->texels, blocksWide, image->alpha, image->mode);
+		}
+	}
+}
+
+
+bool dxt_isSupported(_In_ enum DxtPath path)
+{
+#ifdef DXT_X86
+#ifdef _MSC_VER
+	int info[4];
+	__cpuid(info, 1);
+	const bool hasSse41 = (info[2] & (1 << 19)) != 0;
+	// AVX needs the OS to save the upper halves too.
+	const bool hasAvx = (info[2] & (1 << 27)) && (info[2] & (1 << 28)) && (_xgetbv(0) & 6) == 6;
+	__cpuidex(info, 7, 0);
+	const bool hasAvx2 = hasAvx && (info[1] & (1 << 5)) != 0;
+#else
+	__builtin_cpu_init();
+	const bool hasSse41 = __builtin_cpu_supports("sse4.1");
+	const bool hasAvx2 = __builtin_cpu_supports("avx2");
+#endif // _MSC_VER
+	switch (path)
+	{
+	case DXT_SCALAR: return true;
+	case DXT_SSE41: return hasSse41;
+	case DXT_AVX2: return hasAvx2;
+	default: return false;
+	}
+#else
+	return path == DXT_SCALAR;
+#endif // DXT_X86
+}
+
+enum DxtPath dxt_bestPath(void)
+{
+	for (enum DxtPath path = DXT_PATH_COUNT - 1; path > DXT_SCALAR; path--)
+		if (dxt_isSupported(path))
+			return path;
+	return DXT_SCALAR;
+}
+
+const char* dxt_pathName(_In_ enum DxtPath path)
+{
+	switch (path)
+	{
+	case DXT_SCALAR: return "scalar";
+	case DXT_SSE41: return "sse4.1";
+	case DXT_AVX2: return "avx2";
+	default: return "unknown";
+	}
+}
+
+void dxt_compressBlocks(_In_ enum DxtPath path, _Out_ uint8_t* dest, _In_ const uint8_t* texels, _In_ size_t count, _In_ bool alpha, _In_ int mode)
+{
+	const size_t stride = alpha ? 16 : 8;
+	uint8_t* colors = alpha ? dest + 8 : dest;
+	const int refineCount = (mode & STB_DXT_HIGHQUAL) ? 2 : 1;
+
+	switch (path)
+	{
+#ifdef DXT_X86
+	case DXT_SSE41:
+		if (alpha)
+			compressAlpha(dest, texels, count);
+		for (size_t i = 0; i < count; i += 4)
+			compressColors_sse41(colors + i * stride, stride, texels + i * DXT_BLOCK_TEXELS, count - i < 4 ? count - i : 4, alpha, refineCount);
+		break;
+
+	case DXT_AVX2:
+		if (alpha)
+			compressAlpha(dest, texels, count);
+		for (size_t i = 0; i < count; i += 8)
+			compressColors_avx2(colors + i * stride, stride, texels + i * DXT_BLOCK_TEXELS, count - i < 8 ? count - i : 8, alpha, refineCount);
+		break;
+#endif // DXT_X86
+
+	default:
+		for (size_t i = 0; i < count; i++)
+			stb_compress_dxt_block(dest + i * stride, texels + i * DXT_BLOCK_TEXELS, alpha, mode);
+		break;
+	}
+}
+
+bool dxt_compressImage(_In_ enum DxtPath path, _Out_ uint8_t* dest, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height,
+	_In_ bool alpha, _In_ int mode, _In_ uint32_t workers)
+{
+	struct DxtImage image = {
+		.path = dxt_isSupported(path) ? path : DXT_SCALAR,
+		.dest = dest,
+		.pixels = pixels,
+		.width = width,
+		.height = height,
+		.alpha = alpha,
+		.mode = mode,
+		.nextRow = 0,
+	};
+
+	// Small images don't have a band for every thread.
+	const uint32_t bands = ((height + 3) / 4 + DXT_BAND_ROWS - 1) / DXT_BAND_ROWS;
+	if (workers > bands - 1)
+		workers = bands - 1;
+
+	const size_t rowTexels = (size_t)((width + 3) / 4) * DXT_BLOCK_TEXELS;
+	uint8_t* texels = malloc(rowTexels * (workers + 1));
+	struct DxtWorker* states = calloc(workers + 1, sizeof * states);
+	Thread* threads = calloc(workers + 1, sizeof * threads);
+	if (texels == NULL || states == NULL || threads == NULL)
+	{
+		free(texels);
+		free(states);
+		free(threads);
+		return false;
+	}
+	for (uint32_t i = 0; i <= workers; i++)
+		states[i] = (struct DxtWorker){ .image = &image, .texels = texels + i * rowTexels };
+
+	mutex_init(&image.mutex);
+	uint32_t started = 0;
+	while (started < workers && thread_create(&threads[started], compressWorker, &states[started + 1]))
+		started++;
+	// Whatever couldn't be started is done here.
+	compressWorker(&states[0]);
+	for (uint32_t i = 0; i < started; i++)
+		thread_join(threads[i]);
+	mutex_destroy(&image.mutex);
+
+	free(texels);
+	free(states);
+	free(threads);
+	return true;
+}
@@ -0,0 +1,50 @@
+/**
+
+    @file      dxt.h
+    @brief     BC1/BC3 compression of whole blocks and images over stb_dxt
+    @details   The SSE4.1 and AVX2 paths run stb_dxt's color encoder on 4 or 8
+               blocks at once, one block per lane, and write the same blocks
+               as stb_compress_dxt_block. The best path the CPU supports is
+               picked at runtime, the others stay selectable for comparison.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#pragma once
+#include "framework_crt.h"
+
+#include <stb_dxt.h>
+
+
+enum DxtPath
+{
+	DXT_SCALAR,
+	DXT_SSE41,
+	DXT_AVX2,
+
+	DXT_PATH_COUNT
+};
+
+//the fastest path this CPU and OS can run.
+enum DxtPath dxt_bestPath(void);
+
+bool dxt_isSupported(_In_ enum DxtPath path);
+
+const char* dxt_pathName(_In_ enum DxtPath path);
+
+/**
+	@brief  Compresses count 4x4 blocks, each 16 RGBA8 texels in row-major order laid out one after the other.
+	@param  dest  - 8 bytes per block for BC1, 16 with alpha for BC3
+	@param  alpha - BC3 rather than BC1
+	@param  mode  - STB_DXT_NORMAL or STB_DXT_HIGHQUAL
+**/
+void dxt_compressBlocks(_In_ enum DxtPath path, _Out_ uint8_t* dest, _In_ const uint8_t* texels, _In_ size_t count, _In_ bool alpha, _In_ int mode);
+
+/**
+	@brief  Compresses an RGBA8 image block row by block row, edge blocks repeat the last row and column.
+	@param  dest    - ((width + 3) / 4) * ((height + 3) / 4) blocks
+	@param  workers - threads in addition to the calling one
+	@retval         - false if memory ran out, dest is incomplete then
+**/
+bool dxt_compressImage(_In_ enum DxtPath path, _Out_ uint8_t* dest, _In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height,
+	_In_ bool alpha, _In_ int mode, _In_ uint32_t workers);
@@ -0,0 +1,426 @@
+/**
+
+    @file      dxt_kernel.h
+    @brief     stb_dxt's color block encoder, one block per SIMD lane
+    @details   Included by dxt.c once per DXT_KERNEL_WIDTH, 4 for SSE4.1 and 8
+               for AVX2, after stb_dxt's implementation, whose tables it reads.
+               Every step mirrors stb__CompressColorBlock, including its float
+               and double rounding, so the output matches it block for block.
+               The lanes of a block that stb would have stopped refining keep
+               computing but no longer take the results.
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#if DXT_KERNEL_WIDTH == 4
+
+#define VI						__m128i
+#define VF						__m128
+#define V_TARGET				DXT_TARGET_SSE41
+#define V_NAME(name)			name##_sse41
+#define V_SET(x)				_mm_set1_epi32(x)
+#define V_LOAD(p)				_mm_loadu_si128((const __m128i*)(p))
+#define V_STORE(p, a)			_mm_storeu_si128((__m128i*)(p), a)
+#define V_ADD(a, b)				_mm_add_epi32(a, b)
+#define V_SUB(a, b)				_mm_sub_epi32(a, b)
+#define V_MUL(a, b)				_mm_mullo_epi32(a, b)
+#define V_AND(a, b)				_mm_and_si128(a, b)
+#define V_ANDNOT(a, b)			_mm_andnot_si128(a, b)
+#define V_OR(a, b)				_mm_or_si128(a, b)
+#define V_XOR(a, b)				_mm_xor_si128(a, b)
+#define V_SLL(a, n)				_mm_slli_epi32(a, n)
+#define V_SRL(a, n)				_mm_srli_epi32(a, n)
+#define V_MIN(a, b)				_mm_min_epi32(a, b)
+#define V_MAX(a, b)				_mm_max_epi32(a, b)
+#define V_EQ(a, b)				_mm_cmpeq_epi32(a, b)
+#define V_GT(a, b)				_mm_cmpgt_epi32(a, b)
+#define V_SELECT(m, a, b)		_mm_blendv_epi8(b, a, m)
+#define V_ANY(m)				(_mm_movemask_epi8(m) != 0)
+#define V_TOF(a)				_mm_cvtepi32_ps(a)
+#define V_TOI(a)				_mm_cvttps_epi32(a)
+#define VF_SET(x)				_mm_set1_ps(x)
+#define VF_STORE(p, a)			_mm_storeu_ps(p, a)
+#define VF_ADD(a, b)			_mm_add_ps(a, b)
+#define VF_MUL(a, b)			_mm_mul_ps(a, b)
+#define VF_DIV(a, b)			_mm_div_ps(a, b)
+#define VF_MIN(a, b)			_mm_min_ps(a, b)
+#define VF_MAX(a, b)			_mm_max_ps(a, b)
+#define VF_GT(a, b)				_mm_castps_si128(_mm_cmpgt_ps(a, b))
+#define VF_GATHER(table, i)		_mm_set_ps((table)[_mm_extract_epi32(i, 3)], (table)[_mm_extract_epi32(i, 2)], \
+									(table)[_mm_extract_epi32(i, 1)], (table)[_mm_extract_epi32(i, 0)])
+
+#elif DXT_KERNEL_WIDTH == 8
+
+#define VI						__m256i
+#define VF						__m256
+#define V_TARGET				DXT_TARGET_AVX2
+#define V_NAME(name)			name##_avx2
+#define V_SET(x)				_mm256_set1_epi32(x)
+#define V_LOAD(p)				_mm256_loadu_si256((const __m256i*)(p))
+#define V_STORE(p, a)			_mm256_storeu_si256((__m256i*)(p), a)
+#define V_ADD(a, b)				_mm256_add_epi32(a, b)
+#define V_SUB(a, b)				_mm256_sub_epi32(a, b)
+#define V_MUL(a, b)				_mm256_mullo_epi32(a, b)
+#define V_AND(a, b)				_mm256_and_si256(a, b)
+#define V_ANDNOT(a, b)			_mm256_andnot_si256(a, b)
+#define V_OR(a, b)				_mm256_or_si256(a, b)
+#define V_XOR(a, b)				_mm256_xor_si256(a, b)
+#define V_SLL(a, n)				_mm256_slli_epi32(a, n)
+#define V_SRL(a, n)				_mm256_srli_epi32(a, n)
+#define V_MIN(a, b)				_mm256_min_epi32(a, b)
+#define V_MAX(a, b)				_mm256_max_epi32(a, b)
+#define V_EQ(a, b)				_mm256_cmpeq_epi32(a, b)
+#define V_GT(a, b)				_mm256_cmpgt_epi32(a, b)
+#define V_SELECT(m, a, b)		_mm256_blendv_epi8(b, a, m)
+#define V_ANY(m)				(_mm256_movemask_epi8(m) != 0)
+#define V_TOF(a)				_mm256_cvtepi32_ps(a)
+#define V_TOI(a)				_mm256_cvttps_epi32(a)
+#define VF_SET(x)				_mm256_set1_ps(x)
+#define VF_STORE(p, a)			_mm256_storeu_ps(p, a)
+#define VF_ADD(a, b)			_mm256_add_ps(a, b)
+#define VF_MUL(a, b)			_mm256_mul_ps(a, b)
+#define VF_DIV(a, b)			_mm256_div_ps(a, b)
+#define VF_MIN(a, b)			_mm256_min_ps(a, b)
+#define VF_MAX(a, b)			_mm256_max_ps(a, b)
+#define VF_GT(a, b)				_mm256_castps_si256(_mm256_cmp_ps(a, b, _CMP_GT_OQ))
+#define VF_GATHER(table, i)		_mm256_i32gather_ps(table, i, 4)
+
+#else
+#error DXT_KERNEL_WIDTH must be 4 or 8
+#endif
+
+#define V_LANES					DXT_KERNEL_WIDTH
+#define V_ZERO					V_SET(0)
+#define V_DOT(r, g, b, v)		V_ADD(V_ADD(V_MUL(r, (v)[0]), V_MUL(g, (v)[1])), V_MUL(b, (v)[2]))
+// (2a + b) / 3 without a divide, exact for 8 bit channels.
+#define V_LERP13(a, b)			V_SRL(V_MUL(V_ADD(V_ADD(a, a), b), V_SET(0xaaab)), 17)
+
+
+// stb__Mul8Bit
+static V_TARGET VI V_NAME(mul8Bit)(_In_ VI a, _In_ int b)
+{
+	const VI t = V_ADD(V_MUL(a, V_SET(b)), V_SET(128));
+	return V_SRL(V_ADD(t, V_SRL(t, 8)), 8);
+}
+
+// stb__As16Bit
+static V_TARGET VI V_NAME(as16Bit)(_In_reads_(3) const VI* rgb)
+{
+	return V_OR(V_OR(V_SLL(V_NAME(mul8Bit)(rgb[0], 31), 11), V_SLL(V_NAME(mul8Bit)(rgb[1], 63), 5)), V_NAME(mul8Bit)(rgb[2], 31));
+}
+
+// stb__From16Bit
+static V_TARGET void V_NAME(from16Bit)(_In_ const VI* color, _Out_writes_(3) VI* rgb)
+{
+	rgb[0] = V_SRL(V_MUL(V_SRL(*color, 11), V_SET(33)), 2);
+	rgb[1] = V_SRL(V_MUL(V_AND(V_SRL(*color, 5), V_SET(63)), V_SET(65)), 4);
+	rgb[2] = V_SRL(V_MUL(V_AND(*color, V_SET(31)), V_SET(33)), 2);
+}
+
+// stb__Quantize5 and stb__Quantize6
+static V_TARGET VI V_NAME(quantize)(_In_ VF x, _In_ float scale, _In_ const float* midpoints)
+{
+	x = VF_MIN(VF_MAX(x, VF_SET(0.0f)), VF_SET(1.0f));
+	const VI q = V_TOI(VF_MUL(x, VF_SET(scale)));
+	return V_SUB(q, VF_GT(x, VF_GATHER(midpoints, q)));
+}
+
+// stb__EvalColors and stb__MatchColorsBlock
+static V_TARGET VI V_NAME(matchColors)(_In_reads_(16) const VI* r, _In_reads_(16) const VI* g, _In_reads_(16) const VI* b,
+	_In_ const VI* max16, _In_ const VI* min16)
+{
+	VI color[4][3];
+	V_NAME(from16Bit)(max16, color[0]);
+	V_NAME(from16Bit)(min16, color[1]);
+	for (int ch = 0; ch < 3; ch++)
+	{
+		color[2][ch] = V_LERP13(color[0][ch], color[1][ch]);
+		color[3][ch] = V_LERP13(color[1][ch], color[0][ch]);
+	}
+
+	const VI dir[3] = { V_SUB(color[0][0], color[1][0]), V_SUB(color[0][1], color[1][1]), V_SUB(color[0][2], color[1][2]) };
+	VI stops[4];
+	for (int i = 0; i < 4; i++)
+		stops[i] = V_DOT(color[i][0], color[i][1], color[i][2], dir);
+
+	const VI c0Point = V_ADD(stops[1], stops[3]);
+	const VI halfPoint = V_ADD(stops[3], stops[2]);
+	const VI c3Point = V_ADD(stops[2], stops[0]);
+
+	VI mask = V_ZERO;
+	for (int i = 15; i >= 0; i--)
+	{
+		VI dot = V_DOT(r[i], g[i], b[i], dir);
+		dot = V_ADD(dot, dot);
+		const VI lower = V_SELECT(V_GT(c0Point, dot), V_SET(1), V_SET(3));
+		const VI upper = V_SELECT(V_GT(c3Point, dot), V_SET(2), V_ZERO);
+		mask = V_OR(V_SLL(mask, 2), V_SELECT(V_GT(halfPoint, dot), lower, upper));
+	}
+	return mask;
+}
+
+// stb__OptimizeColorsBlock, minus the averages and extremes the caller already has.
+static V_TARGET void V_NAME(optimizeColors)(_In_reads_(16) const VI* r, _In_reads_(16) const VI* g, _In_reads_(16) const VI* b,
+	_In_reads_(3) const VI* mu, _In_reads_(3) const VI* min, _In_reads_(3) const VI* max, _Out_ VI* max16, _Out_ VI* min16)
+{
+	VI cov[6] = { V_ZERO, V_ZERO, V_ZERO, V_ZERO, V_ZERO, V_ZERO };
+	for (int i = 0; i < 16; i++)
+	{
+		const VI dr = V_SUB(r[i], mu[0]);
+		const VI dg = V_SUB(g[i], mu[1]);
+		const VI db = V_SUB(b[i], mu[2]);
+		cov[0] = V_ADD(cov[0], V_MUL(dr, dr));
+		cov[1] = V_ADD(cov[1], V_MUL(dr, dg));
+		cov[2] = V_ADD(cov[2], V_MUL(dr, db));
+		cov[3] = V_ADD(cov[3], V_MUL(dg, dg));
+		cov[4] = V_ADD(cov[4], V_MUL(dg, db));
+		cov[5] = V_ADD(cov[5], V_MUL(db, db));
+	}
+
+	VF covf[6];
+	for (int i = 0; i < 6; i++)
+		covf[i] = VF_DIV(V_TOF(cov[i]), VF_SET(255.0f));
+
+	VF vfr = V_TOF(V_SUB(max[0], min[0]));
+	VF vfg = V_TOF(V_SUB(max[1], min[1]));
+	VF vfb = V_TOF(V_SUB(max[2], min[2]));
+	for (int iter = 0; iter < 4; iter++)
+	{
+		const VF pr = VF_ADD(VF_ADD(VF_MUL(vfr, covf[0]), VF_MUL(vfg, covf[1])), VF_MUL(vfb, covf[2]));
+		const VF pg = VF_ADD(VF_ADD(VF_MUL(vfr, covf[1]), VF_MUL(vfg, covf[3])), VF_MUL(vfb, covf[4]));
+		const VF pb = VF_ADD(VF_ADD(VF_MUL(vfr, covf[2]), VF_MUL(vfg, covf[4])), VF_MUL(vfb, covf[5]));
+		vfr = pr;
+		vfg = pg;
+		vfb = pb;
+	}
+
+	// stb normalizes the axis in double, the lanes go through it one by one to round the same way.
+	float axis[3][V_LANES];
+	int32_t v[3][V_LANES];
+	VF_STORE(axis[0], vfr);
+	VF_STORE(axis[1], vfg);
+	VF_STORE(axis[2], vfb);
+	for (int lane = 0; lane < V_LANES; lane++)
+	{
+		double magn = STBD_FABS(axis[0][lane]);
+		if (STBD_FABS(axis[1][lane]) > magn) magn = STBD_FABS(axis[1][lane]);
+		if (STBD_FABS(axis[2][lane]) > magn) magn = STBD_FABS(axis[2][lane]);
+
+		if (magn < 4.0f)
+		{
+			v[0][lane] = 299;
+			v[1][lane] = 587;
+			v[2][lane] = 114;
+		}
+		else
+		{
+			magn = 512.0 / magn;
+			for (int ch = 0; ch < 3; ch++)
+				v[ch][lane] = (int32_t)(axis[ch][lane] * magn);
+		}
+	}
+	const VI dir[3] = { V_LOAD(v[0]), V_LOAD(v[1]), V_LOAD(v[2]) };
+
+	// The first texel wins ties, like stb's strict comparisons.
+	VI minDot = V_DOT(r[0], g[0], b[0], dir), maxDot = minDot;
+	VI minColor[3] = { r[0], g[0], b[0] }, maxColor[3] = { r[0], g[0], b[0] };
+	for (int i = 1; i < 16; i++)
+	{
+		const VI dot = V_DOT(r[i], g[i], b[i], dir);
+		const VI isMin = V_GT(minDot, dot);
+		const VI isMax = V_GT(dot, maxDot);
+		minDot = V_SELECT(isMin, dot, minDot);
+		maxDot = V_SELECT(isMax, dot, maxDot);
+		const VI texel[3] = { r[i], g[i], b[i] };
+		for (int ch = 0; ch < 3; ch++)
+		{
+			minColor[ch] = V_SELECT(isMin, texel[ch], minColor[ch]);
+			maxColor[ch] = V_SELECT(isMax, texel[ch], maxColor[ch]);
+		}
+	}
+
+	*max16 = V_NAME(as16Bit)(maxColor);
+	*min16 = V_NAME(as16Bit)(minColor);
+}
+
+// stb__RefineBlock, single is the optimal match of the average color for blocks whose texels share one index.
+static V_TARGET void V_NAME(refine)(_In_reads_(16) const VI* r, _In_reads_(16) const VI* g, _In_reads_(16) const VI* b,
+	_In_reads_(3) const VI* sum, _In_reads_(2) const VI* single, _In_ const VI* mask, _Out_ VI* max16, _Out_ VI* min16)
+{
+	VI xx = V_ZERO, yy = V_ZERO, xy = V_ZERO;
+	VI at1[3] = { V_ZERO, V_ZERO, V_ZERO };
+	VI cm = *mask;
+	for (int i = 0; i < 16; i++, cm = V_SRL(cm, 2))
+	{
+		// w1Tab = { 3, 0, 2, 1 }
+		const VI step = V_AND(cm, V_SET(3));
+		const VI high = V_SRL(step, 1);
+		const VI w1 = V_SELECT(V_EQ(V_AND(step, V_SET(1)), V_ZERO), V_SUB(V_SET(3), high), high);
+		const VI w2 = V_SUB(V_SET(3), w1);
+		xx = V_ADD(xx, V_MUL(w1, w1));
+		yy = V_ADD(yy, V_MUL(w2, w2));
+		xy = V_ADD(xy, V_MUL(w1, w2));
+		at1[0] = V_ADD(at1[0], V_MUL(w1, r[i]));
+		at1[1] = V_ADD(at1[1], V_MUL(w1, g[i]));
+		at1[2] = V_ADD(at1[2], V_MUL(w1, b[i]));
+	}
+
+	// Single index lanes divide by zero here and are replaced below.
+	const VF f = VF_DIV(VF_SET(3.0f / 255.0f), V_TOF(V_SUB(V_MUL(xx, yy), V_MUL(xy, xy))));
+	VI high[3], low[3];
+	for (int ch = 0; ch < 3; ch++)
+	{
+		const VI at2 = V_SUB(V_MUL(V_SET(3), sum[ch]), at1[ch]);
+		const float scale = ch == 1 ? 63.0f : 31.0f;
+		const float* midpoints = ch == 1 ? stb__midpoints6 : stb__midpoints5;
+		high[ch] = V_NAME(quantize)(VF_MUL(V_TOF(V_SUB(V_MUL(at1[ch], yy), V_MUL(at2, xy))), f), scale, midpoints);
+		low[ch] = V_NAME(quantize)(VF_MUL(V_TOF(V_SUB(V_MUL(at2, xx), V_MUL(at1[ch], xy))), f), scale, midpoints);
+	}
+
+	const VI isSingle = V_EQ(V_ANDNOT(V_SET(3), V_XOR(*mask, V_SLL(*mask, 2))), V_ZERO);
+	*max16 = V_SELECT(isSingle, single[0], V_OR(V_OR(V_SLL(high[0], 11), V_SLL(high[1], 5)), high[2]));
+	*min16 = V_SELECT(isSingle, single[1], V_OR(V_OR(V_SLL(low[0], 11), V_SLL(low[1], 5)), low[2]));
+}
+
+// stb__CompressColorBlock on up to V_LANES blocks, padded by repeating the last one.
+static V_TARGET void V_NAME(compressColors)(_Out_ uint8_t* dest, _In_ size_t stride, _In_ const uint8_t* texels, _In_ size_t count,
+	_In_ bool alpha, _In_ int refineCount)
+{
+	int32_t words[16][V_LANES];
+	for (size_t lane = 0; lane < V_LANES; lane++)
+	{
+		const uint8_t* block = texels + (lane < count ? lane : count - 1) * 64;
+		for (int i = 0; i < 16; i++)
+			memcpy(&words[i][lane], block + i * 4, 4);
+	}
+
+	// stb forces alpha opaque before its constant check when there is an alpha block.
+	const VI constantBits = V_SET(alpha ? 0x00ffffff : -1);
+	const VI first = V_AND(V_LOAD(words[0]), constantBits);
+	VI isConstant = V_SET(-1);
+	VI r[16], g[16], b[16];
+	for (int i = 0; i < 16; i++)
+	{
+		const VI word = V_LOAD(words[i]);
+		r[i] = V_AND(word, V_SET(0xff));
+		g[i] = V_AND(V_SRL(word, 8), V_SET(0xff));
+		b[i] = V_AND(V_SRL(word, 16), V_SET(0xff));
+		isConstant = V_AND(isConstant, V_EQ(V_AND(word, constantBits), first));
+	}
+
+	VI sum[3] = { r[0], g[0], b[0] };
+	VI min[3] = { r[0], g[0], b[0] }, max[3] = { r[0], g[0], b[0] };
+	for (int i = 1; i < 16; i++)
+	{
+		const VI texel[3] = { r[i], g[i], b[i] };
+		for (int ch = 0; ch < 3; ch++)
+		{
+			sum[ch] = V_ADD(sum[ch], texel[ch]);
+			min[ch] = V_MIN(min[ch], texel[ch]);
+			max[ch] = V_MAX(max[ch], texel[ch]);
+		}
+	}
+	const VI mu[3] = { V_SRL(V_ADD(sum[0], V_SET(8)), 4), V_SRL(V_ADD(sum[1], V_SET(8)), 4), V_SRL(V_ADD(sum[2], V_SET(8)), 4) };
+
+	// Constant blocks and single index refinements both use the optimal match of the average.
+	int32_t average[3][V_LANES], match[2][V_LANES];
+	for (int ch = 0; ch < 3; ch++)
+		V_STORE(average[ch], mu[ch]);
+	for (int lane = 0; lane < V_LANES; lane++)
+		for (int i = 0; i < 2; i++)
+			match[i][lane] = (stb__OMatch5[average[0][lane]][i] << 11) | (stb__OMatch6[average[1][lane]][i] << 5) | stb__OMatch5[average[2][lane]][i];
+	const VI single[2] = { V_LOAD(match[0]), V_LOAD(match[1]) };
+
+	// Flat areas often fill whole groups, those skip straight to the single color match.
+	VI max16 = single[0], min16 = single[1];
+	VI mask = V_SET((int32_t)0xaaaaaaaa);
+	VI isRefining = V_XOR(isConstant, V_SET(-1));
+	if (V_ANY(isRefining))
+	{
+		VI pcaMax16, pcaMin16;
+		V_NAME(optimizeColors)(r, g, b, mu, min, max, &pcaMax16, &pcaMin16);
+		const VI pcaMask = V_ANDNOT(V_EQ(pcaMax16, pcaMin16), V_NAME(matchColors)(r, g, b, &pcaMax16, &pcaMin16));
+		max16 = V_SELECT(isConstant, max16, pcaMax16);
+		min16 = V_SELECT(isConstant, min16, pcaMin16);
+		mask = V_SELECT(isConstant, mask, pcaMask);
+	}
+
+	for (int i = 0; i < refineCount && V_ANY(isRefining); i++)
+	{
+		VI refinedMax, refinedMin;
+		V_NAME(refine)(r, g, b, sum, single, &mask, &refinedMax, &refinedMin);
+
+		const VI isChanged = V_AND(isRefining, V_XOR(V_AND(V_EQ(refinedMax, max16), V_EQ(refinedMin, min16)), V_SET(-1)));
+		const VI isDegenerate = V_AND(isChanged, V_EQ(refinedMax, refinedMin));
+		max16 = V_SELECT(isRefining, refinedMax, max16);
+		min16 = V_SELECT(isRefining, refinedMin, min16);
+
+		const VI refinedMask = V_ANDNOT(isDegenerate, V_NAME(matchColors)(r, g, b, &refinedMax, &refinedMin));
+		const VI isSettled = V_OR(isDegenerate, V_EQ(refinedMask, mask));
+		mask = V_SELECT(isChanged, refinedMask, mask);
+		isRefining = V_ANDNOT(V_OR(isSettled, V_XOR(isChanged, V_SET(-1))), isRefining);
+	}
+
+	const VI isSwapped = V_GT(min16, max16);
+	const VI swappedMax = V_SELECT(isSwapped, min16, max16);
+	min16 = V_SELECT(isSwapped, max16, min16);
+	max16 = swappedMax;
+	mask = V_XOR(mask, V_AND(isSwapped, V_SET(0x55555555)));
+
+	int32_t outMax[V_LANES], outMin[V_LANES], outMask[V_LANES];
+	V_STORE(outMax, max16);
+	V_STORE(outMin, min16);
+	V_STORE(outMask, mask);
+	for (size_t lane = 0; lane < count; lane++)
+	{
+		uint8_t* block = dest + lane * stride;
+		block[0] = (uint8_t)outMax[lane];
+		block[1] = (uint8_t)(outMax[lane] >> 8);
+		block[2] = (uint8_t)outMin[lane];
+		block[3] = (uint8_t)(outMin[lane] >> 8);
+		block[4] = (uint8_t)outMask[lane];
+		block[5] = (uint8_t)(outMask[lane] >> 8);
+		block[6] = (uint8_t)(outMask[lane] >> 16);
+		block[7] = (uint8_t)(outMask[lane] >> 24);
+	}
+}
+
+
+#undef VI
+#undef VF
+#undef V_TARGET
+#undef V_NAME
+#undef V_SET
+#undef V_LOAD
+#undef V_STORE
+#undef V_ADD
+#undef V_SUB
+#undef V_MUL
+#undef V_AND
+#undef V_ANDNOT
+#undef V_OR
+#undef V_XOR
+#undef V_SLL
+#undef V_SRL
+#undef V_MIN
+#undef V_MAX
+#undef V_EQ
+#undef V_GT
+#undef V_SELECT
+#undef V_ANY
+#undef V_TOF
+#undef V_TOI
+#undef VF_SET
+#undef VF_STORE
+#undef VF_ADD
+#undef VF_MUL
+#undef VF_DIV
+#undef VF_MIN
+#undef VF_MAX
+#undef VF_GT
+#undef VF_GATHER
+#undef V_LANES
+#undef V_ZERO
+#undef V_DOT
+#undef V_LERP13
+#undef DXT_KERNEL_WIDTH
@@ -0,0 +1,386 @@
+/**
+
+    @file      texcook.c
+    @brief     crox_texcook, offline mip generation and BC1/BC3 compression
+    @details   ~
+    @author    Jakob Kristersson <jakob.kristerrson@bredband.net> [Kss0N]
+    @date      16.10.2026
+
+**/
+#include "framework_crt.h"
+#include "texturefile.h"
+#include "platform/Threads.h"
+#include "dxt.h"
+
+#include <stb_image.h>
+#define STB_IMAGE_RESIZE_IMPLEMENTATION
+#include <stb_image_resize.h>
+
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+
+#define COOK_EXTENSION		".ctex"
+#define BENCH_RUNS			3	// the fastest run counts
+
+struct CookLevel
+{
+	uint32_t width;
+	uint32_t height;
+	uint8_t* pixels;		// RGBA8
+	uint8_t* blocks;
+	size_t size;
+};
+
+struct Cook
+{
+	uint32_t format;
+	uint32_t levelCount;
+	struct CookLevel levels[TEXTURE_FILE_MAX_LEVELS];
+	int mode;				// STB_DXT_*
+};
+
+struct Options
+{
+	uint32_t format;		// --bc1 or --bc3, 0 picks BC3 only when there is alpha
+	bool isLinear;			// --linear, data rather than color, no sRGB filtering
+	bool isFast;			// --fast, skips stb_dxt's refinement
+	uint32_t workers;		// --workers <N>, 0 uses every core
+	bool isBench;			// --bench, compares the compression paths instead of writing
+};
+
+
+static uint32_t pickFormat(_In_ const uint8_t* pixels, _In_ size_t texels, _In_ const struct Options* options)
+{
+	if (options->format)
+		return options->format;
+	for (size_t i = 0; i < texels; i++)
+		if (pixels[i * 4 + 3] != 255)
+			return TEXTURE_FILE_BC3;
+	return TEXTURE_FILE_BC1;
+}
+
+static bool buildLevels(_Inout_ struct Cook* cook, _In_ const struct Options* options)
+//
+// Every level is filtered from the one above it, in linear light for color.
+//
+{
+	for (uint32_t i = 1; i < TEXTURE_FILE_MAX_LEVELS; i++)
+	{
+		const struct CookLevel* above = &cook->levels[i - 1];
+		if (above->width == 1 && above->height == 1)
+			break;
+
+		struct CookLevel* level = &cook->levels[i];
+		level->width = above->width > 1 ? above->width / 2 : 1;
+		level->height = above->height > 1 ? above->height / 2 : 1;
+		level->pixels = malloc((size_t)level->width * level->height * 4);
+		if (level->pixels == NULL)
+			return false;
+		cook->levelCount = i + 1;
+
+		const int success = options->isLinear
+			? stbir_resize_uint8(above->pixels, above->width, above->height, 0, level->pixels, level->width, level->height, 0, 4)
+			: stbir_resize_uint8_srgb(above->pixels, above->width, above->height, 0, level->pixels, level->width, level->height, 0, 4, 3, 0);
+		if (!success)
+			return false;
+	}
+	return true;
+}
+
+static bool compress(_Inout_ struct Cook* cook, _In_ uint32_t workers)
+{
+	const enum DxtPath path = dxt_bestPath();
+	for (uint32_t i = 0; i < cook->levelCount; i++)
+	{
+		struct CookLevel* level = &cook->levels[i];
+		level->size = (size_t)texturefile_levelSize(cook->format, level->width, level->height);
+		level->blocks = malloc(level->size);
+		if (level->blocks == NULL
+			|| !dxt_compressImage(path, level->blocks, level->pixels, level->width, level->height, cook->format == TEXTURE_FILE_BC3, cook->mode, workers))
+			return false;
+	}
+	return true;
+}
+
+static bool writeContainer(_In_ const struct Cook* cook, _In_ uint32_t flags, _In_z_ const char* path)
+{
+	struct TextureFileHeader header = {
+		.magic = TEXTURE_FILE_MAGIC,
+		.version = TEXTURE_FILE_VERSION,
+		.format = cook->format,
+		.flags = flags,
+		.width = cook->levels[0].width,
+		.height = cook->levels[0].height,
+		.levelCount = cook->levelCount,
+	};
+	uint64_t offset = sizeof header;
+	for (uint32_t i = 0; i < cook->levelCount; i++)
+	{
+		offset = (offset + TEXTURE_FILE_ALIGNMENT - 1) & ~(uint64_t)(TEXTURE_FILE_ALIGNMENT - 1);
+		header.levels[i] = (struct TextureFileLevel){
+			.width = cook->levels[i].width,
+			.height = cook->levels[i].height,
+			.offset = offset,
+			.size = cook->levels[i].size,
+		};
+		offset += cook->levels[i].size;
+	}
+
+	FILE* file = fopen(path, "wb");
+	if (file == NULL)
+		return false;
+	static const uint8_t PADDING[TEXTURE_FILE_ALIGNMENT] = { 0 };
+	bool success = fwrite(&header, sizeof header, 1, file) == 1;
+	uint64_t written = sizeof header;
+	for (uint32_t i = 0; success && i < cook->levelCount; i++)
+	{
+		const size_t padding = (size_t)(header.levels[i].offset - written);
+		success = fwrite(PADDING, 1, padding, file) == padding
+			&& fwrite(cook->levels[i].blocks, 1, cook->levels[i].size, file) == cook->levels[i].size;
+		written = header.levels[i].offset + header.levels[i].size;
+	}
+	return fclose(file) == 0 && success;
+}
+
+static char* outputPath(_In_z_ const char* input)
+{
+	const char* extension = strrchr(input, '.');
+	const char* separator = strpbrk(extension ? extension : input, "/\\");
+	const size_t stem = extension && separator == NULL ? (size_t)(extension - input) : strlen(input);
+	char* path = malloc(stem + sizeof COOK_EXTENSION);
+	if (path == NULL)
+		return NULL;
+	memcpy(path, input, stem);
+	memcpy(path + stem, COOK_EXTENSION, sizeof COOK_EXTENSION);
+	return path;
+}
+
+static bool cookFile(_In_z_ const char* input, _In_ const struct Options* options)
+{
+	struct Cook cook = { .levelCount = 1, .mode = options->isFast ? STB_DXT_NORMAL : STB_DXT_HIGHQUAL };
+	int width = 0, height = 0, channels = 0;
+	cook.levels[0].pixels = stbi_load(input, &width, &height, &channels, 4);
+	if (cook.levels[0].pixels == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", input, stbi_failure_reason());
+		return false;
+	}
+	cook.levels[0].width = (uint32_t)width;
+	cook.levels[0].height = (uint32_t)height;
+
+	cook.format = pickFormat(cook.levels[0].pixels, (size_t)width * height, options);
+
+	uint32_t workers = options->workers ? options->workers : thread_hardwareConcurrency();
+	char* output = outputPath(input);
+	bool success = output != NULL
+		&& buildLevels(&cook, options)
+		&& compress(&cook, workers > 1 ? workers - 1 : 0)
+		&& writeContainer(&cook, options->isLinear ? 0 : TEXTURE_FILE_SRGB, output);
+
+	if (success)
+	{
+		size_t size = 0;
+		for (uint32_t i = 0; i < cook.levelCount; i++)
+			size += cook.levels[i].size;
+		printf("%s -> %s: %ux%u BC%u, %u levels, %zu KiB\n", input, output, cook.levels[0].width, cook.levels[0].height, cook.format, cook.levelCount, size / 1024);
+	}
+	else
+		fprintf(stderr, "%s: cooking failed\n", input);
+
+	free(output);
+	stbi_image_free(cook.levels[0].pixels);
+	for (uint32_t i = 0; i < cook.levelCount; i++)
+	{
+		if (i > 0)
+			free(cook.levels[i].pixels);
+		free(cook.levels[i].blocks);
+	}
+	return success;
+}
+
+
+static double seconds(void)
+{
+	struct timespec now;
+	timespec_get(&now, TIME_UTC);
+	return (double)now.tv_sec + (double)now.tv_nsec * 1e-9;
+}
+
+static void decodeColors(_In_ const uint8_t* block, _Out_writes_(64) uint8_t* texels)
+//
+// Interpolates without rounding bias, like stb_dxt assumes.
+//
+{
+	const uint32_t c0 = block[0] | block[1] << 8, c1 = block[2] | block[3] << 8;
+	int palette[4][3] = {
+		{ ((c0 >> 11) * 33) >> 2, (((c0 >> 5) & 63) * 65) >> 4, ((c0 & 31) * 33) >> 2 },
+		{ ((c1 >> 11) * 33) >> 2, (((c1 >> 5) & 63) * 65) >> 4, ((c1 & 31) * 33) >> 2 },
+	};
+	for (int ch = 0; ch < 3; ch++)
+	{
+		palette[2][ch] = c0 > c1 ? (2 * palette[0][ch] + palette[1][ch]) / 3 : (palette[0][ch] + palette[1][ch]) / 2;
+		palette[3][ch] = c0 > c1 ? (palette[0][ch] + 2 * palette[1][ch]) / 3 : 0;
+	}
+
+	const uint32_t indices = block[4] | block[5] << 8 | block[6] << 16 | (uint32_t)block[7] << 24;
+	for (int i = 0; i < 16; i++)
+	{
+		const int* color = palette[(indices >> (i * 2)) & 3];
+		texels[i * 4 + 0] = (uint8_t)color[0];
+		texels[i * 4 + 1] = (uint8_t)color[1];
+		texels[i * 4 + 2] = (uint8_t)color[2];
+		texels[i * 4 + 3] = 255;
+	}
+}
+
+static void decodeAlpha(_In_ const uint8_t* block, _Inout_ uint8_t* texels)
+{
+	const int a0 = block[0], a1 = block[1];
+	int palette[8] = { a0, a1 };
+	for (int i = 2; i < 8; i++)
+		palette[i] = a0 > a1 ? ((8 - i) * a0 + (i - 1) * a1) / 7
+			: i < 6 ? ((6 - i) * a0 + (i - 1) * a1) / 5
+			: i == 6 ? 0 : 255;
+
+	uint64_t indices = 0;
+	for (int i = 0; i < 6; i++)
+		indices |= (uint64_t)block[2 + i] << (i * 8);
+	for (int i = 0; i < 16; i++)
+		texels[i * 4 + 3] = (uint8_t)palette[(indices >> (i * 3)) & 7];
+}
+
+static double rootMeanSquareError(_In_ const uint8_t* pixels, _In_ uint32_t width, _In_ uint32_t height, _In_ const uint8_t* blocks, _In_ uint32_t format)
+//
+// Over the channels the format stores, RGB for BC1 and RGBA for BC3.
+//
+{
+	const uint32_t blockSize = texturefile_blockSize(format);
+	const uint32_t channels = format == TEXTURE_FILE_BC3 ? 4 : 3;
+	const uint32_t blocksWide = (width + 3) / 4;
+	double error = 0.0;
+	for (uint32_t by = 0; by < (height + 3) / 4; by++)
+		for (uint32_t bx = 0; bx < blocksWide; bx++)
+		{
+			const uint8_t* block = blocks + ((size_t)by * blocksWide + bx) * blockSize;
+			uint8_t texels[16 * 4];
+			decodeColors(format == TEXTURE_FILE_BC3 ? block + 8 : block, texels);
+			if (format == TEXTURE_FILE_BC3)
+				decodeAlpha(block, texels);
+
+			for (uint32_t y = 0; y < 4 && by * 4 + y < height; y++)
+				for (uint32_t x = 0; x < 4 && bx * 4 + x < width; x++)
+				{
+					const uint8_t* source = pixels + ((size_t)(by * 4 + y) * width + bx * 4 + x) * 4;
+					for (uint32_t ch = 0; ch < channels; ch++)
+					{
+						const double difference = (double)texels[(y * 4 + x) * 4 + ch] - source[ch];
+						error += difference * difference;
+					}
+				}
+		}
+	return sqrt(error / ((double)width * height * channels));
+}
+
+static bool benchFile(_In_z_ const char* input, _In_ const struct Options* options)
+//
+// Compresses the first level with every path, on one thread and on all of them, against the scalar path's blocks.
+//
+{
+	int width = 0, height = 0, channels = 0;
+	uint8_t* pixels = stbi_load(input, &width, &height, &channels, 4);
+	if (pixels == NULL)
+	{
+		fprintf(stderr, "%s: %s\n", input, stbi_failure_reason());
+		return false;
+	}
+
+	const uint32_t format = pickFormat(pixels, (size_t)width * height, options);
+	const int mode = options->isFast ? STB_DXT_NORMAL : STB_DXT_HIGHQUAL;
+	const uint32_t workers = options->workers ? options->workers : thread_hardwareConcurrency();
+	const size_t size = (size_t)texturefile_levelSize(format, (uint32_t)width, (uint32_t)height);
+	const size_t blockCount = size / texturefile_blockSize(format);
+	uint8_t* reference = malloc(size);
+	uint8_t* blocks = malloc(size);
+	bool success = reference != NULL && blocks != NULL;
+
+	printf("%s: %dx%d BC%u, %s\n", input, width, height, format, options->isFast ? "fast" : "high quality");
+	for (enum DxtPath path = DXT_SCALAR; success && path < DXT_PATH_COUNT; path++)
+	{
+		if (!dxt_isSupported(path))
+		{
+			printf("  %-8s unsupported\n", dxt_pathName(path));
+			continue;
+		}
+
+		for (uint32_t threads = 1; success; threads = workers)
+		{
+			double best = DBL_MAX;
+			for (int run = 0; success && run < BENCH_RUNS; run++)
+			{
+				const double start = seconds();
+				success = dxt_compressImage(path, blocks, pixels, (uint32_t)width, (uint32_t)height, format == TEXTURE_FILE_BC3, mode, threads - 1);
+				const double elapsed = seconds() - start;
+				best = elapsed < best ? elapsed : best;
+			}
+			if (path == DXT_SCALAR && threads == 1)
+				memcpy(reference, blocks, size);
+
+			size_t differing = 0;
+			const uint32_t blockSize = texturefile_blockSize(format);
+			for (size_t i = 0; i < blockCount; i++)
+				differing += memcmp(blocks + i * blockSize, reference + i * blockSize, blockSize) != 0;
+
+			printf("  %-8s %3u thread%s %9.2f Mtexels/s  RMSE %.4f  %zu blocks differ from scalar\n",
+				dxt_pathName(path), threads, threads == 1 ? " " : "s", (double)width * height / best * 1e-6,
+				rootMeanSquareError(pixels, (uint32_t)width, (uint32_t)height, blocks, format), differing);
+			if (threads == workers)
+				break;
+		}
+	}
+	if (!success)
+		fprintf(stderr, "%s: benchmark failed\n", input);
+
+	free(reference);
+	free(blocks);
+	stbi_image_free(pixels);
+	return success;
+}
+
+
+int main(int argc, char** argv)
+{
+	struct Options options = { .format = 0, .isLinear = false, .isFast = false, .workers = 0, .isBench = false };
+	int first = 1;
+	for (; first < argc && strncmp(argv[first], "--", 2) == 0; first++)
+	{
+		if (strcmp(argv[first], "--bc1") == 0)
+			options.format = TEXTURE_FILE_BC1;
+		else if (strcmp(argv[first], "--bc3") == 0)
+			options.format = TEXTURE_FILE_BC3;
+		else if (strcmp(argv[first], "--linear") == 0)
+			options.isLinear = true;
+		else if (strcmp(argv[first], "--fast") == 0)
+			options.isFast = true;
+		else if (strcmp(argv[first], "--workers") == 0 && first + 1 < argc)
+			options.workers = (uint32_t)strtoul(argv[++first], NULL, 10);
+		else if (strcmp(argv[first], "--bench") == 0)
+			options.isBench = true;
+		else
+			break;
+	}
+	if (first >= argc)
+	{
+		fprintf(stderr, "Usage: crox_texcook [--bc1 | --bc3] [--linear] [--fast] [--workers <N>] [--bench] <image>...\n"
+			"Writes every image with its extension replaced by " COOK_EXTENSION ",\n"
+			"or with --bench compares the speed and error of each compression path on it.\n");
+		return -1;
+	}
+
+	int result = 0;
+	for (int i = first; i < argc; i++)
+		if (!(options.isBench ? benchFile(argv[i], &options) : cookFile(argv[i], &options)))
+			result = -1;
+	return result;
+}